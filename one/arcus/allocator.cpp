@@ -1,6 +1,13 @@
 #include <one/arcus/allocator.h>
 
+#include <one/arcus/internal/pool.h>
+
 #include <assert.h>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 
 namespace i3d {
 namespace one {
@@ -9,12 +16,10 @@ namespace allocator {
 
 namespace {
 
-// Wrapper to allow assignment to the std::function.
 void *default_alloc(size_t bytes) {
     return std::malloc(bytes);
 }
 
-// Wrapper to allow assignment to the std::function.
 void default_free(void *p) {
     std::free(p);
 }
@@ -23,45 +28,243 @@ void *default_realloc(void *p, size_t bytes) {
     return std::realloc(p, bytes);
 }
 
+constexpr size_t category_count = static_cast<size_t>(Category::count);
+
+// Tracking state. The map uses the standard allocator so that tracking does
+// not recurse into itself.
+struct Tracking {
+    struct Allocation {
+        size_t size;
+        Category category;
+    };
+
+    std::atomic<bool> is_enabled{false};
+    std::mutex mutex;
+    std::unordered_map<void *, Allocation> allocations;
+    Statistics categories[category_count];
+    Statistics total;
+};
+
+// Never destroyed, as memory may be freed during static destruction.
+Tracking &tracking() {
+    static Tracking *instance = new Tracking();
+    return *instance;
+}
+
+thread_local Category _scoped_category = Category::general;
+
+Category resolve(Category category) {
+    return (category == Category::general) ? _scoped_category : category;
+}
+
+void add(Statistics &statistics, size_t size) {
+    statistics.live_bytes += size;
+    statistics.live_allocations++;
+    statistics.allocations++;
+    statistics.size_classes[size_class(size)]++;
+    if (statistics.live_bytes > statistics.peak_bytes) {
+        statistics.peak_bytes = statistics.live_bytes;
+    }
+}
+
+void remove(Statistics &statistics, size_t size) {
+    statistics.live_bytes -= size;
+    statistics.live_allocations--;
+    statistics.frees++;
+}
+
+// Must be called with the tracking mutex locked.
+void track(Tracking &state, void *p, size_t size, Category category) {
+    if (p == nullptr) {
+        return;
+    }
+    state.allocations[p] = {size, category};
+    add(state.categories[static_cast<size_t>(category)], size);
+    add(state.total, size);
+}
+
+// Must be called with the tracking mutex locked.
+void untrack(Tracking &state, void *p) {
+    auto it = state.allocations.find(p);
+    if (it == state.allocations.end()) {
+        return;
+    }
+    const auto &allocation = it->second;
+    remove(state.categories[static_cast<size_t>(allocation.category)], allocation.size);
+    remove(state.total, allocation.size);
+    state.allocations.erase(it);
+}
+
 }  // namespace
 
-// Global allocation overridable functions.
-std::function<void *(size_t)> _alloc = default_alloc;
-std::function<void(void *)> _free = default_free;
-std::function<void *(void *, size_t)> _realloc = default_realloc;
+// Global allocation overridable functions. Callables that are not plain
+// functions are kept aside and called through the wrappers below.
+void *(*_alloc)(size_t) = default_alloc;
+void (*_free)(void *) = default_free;
+void *(*_realloc)(void *, size_t) = default_realloc;
+
+namespace {
+
+std::function<void *(size_t)> _wrapped_alloc;
+std::function<void(void *)> _wrapped_free;
+std::function<void *(void *, size_t)> _wrapped_realloc;
 
-void set_alloc(std::function<void *(size_t)> fn) {
-    _alloc = fn;
+void *call_wrapped_alloc(size_t bytes) {
+    return _wrapped_alloc(bytes);
 }
 
-void set_free(std::function<void(void *)> fn) {
-    _free = fn;
+void call_wrapped_free(void *p) {
+    _wrapped_free(p);
 }
 
-void set_realloc(std::function<void *(void *, size_t)> fn) {
-    _realloc = fn;
+void *call_wrapped_realloc(void *p, size_t bytes) {
+    return _wrapped_realloc(p, bytes);
+}
+
+}  // namespace
+
+void set_alloc(Callback<void *(size_t)> fn) {
+    _wrapped_alloc = fn.wrapped();
+    _alloc = (fn.function() != nullptr || !fn) ? fn.function() : call_wrapped_alloc;
+}
+
+void set_free(Callback<void(void *)> fn) {
+    _wrapped_free = fn.wrapped();
+    _free = (fn.function() != nullptr || !fn) ? fn.function() : call_wrapped_free;
+}
+
+void set_realloc(Callback<void *(void *, size_t)> fn) {
+    _wrapped_realloc = fn.wrapped();
+    _realloc = (fn.function() != nullptr || !fn) ? fn.function() : call_wrapped_realloc;
 }
 
 void reset_overrides() {
     _alloc = default_alloc;
     _free = default_free;
     _realloc = default_realloc;
+    _wrapped_alloc = nullptr;
+    _wrapped_free = nullptr;
+    _wrapped_realloc = nullptr;
+}
+
+void use_pool() {
+    reset_overrides();
+    _alloc = pool::alloc;
+    _free = pool::free;
+    _realloc = pool::realloc;
+}
+
+bool is_pool() {
+    return _alloc == pool::alloc;
 }
 
 void *alloc(size_t bytes) {
-    assert(_alloc);
-    void *p = _alloc(bytes);
-    assert(p != nullptr);
-    return p;
+    return alloc(bytes, Category::general);
 }
 
 void free(void *p) {
     assert(_free);
+    auto &state = tracking();
+    if (state.is_enabled.load(std::memory_order_relaxed)) {
+        // Untracked before being freed, so that the address cannot be reused
+        // by another thread and tracked first.
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        untrack(state, p);
+    }
     _free(p);
 }
 
 void *realloc(void *p, size_t s) {
-    return _realloc(p, s);
+    return realloc(p, s, Category::general);
+}
+
+size_t size_class(size_t bytes) {
+    size_t result = 0;
+    size_t limit = 16;
+    while (bytes > limit && result < size_class_count - 1) {
+        limit <<= 1;
+        ++result;
+    }
+    return result;
+}
+
+void set_tracking(bool enabled) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    if (enabled) {
+        std::memset(state.categories, 0, sizeof(state.categories));
+        std::memset(&state.total, 0, sizeof(state.total));
+    }
+    state.allocations.clear();
+    state.is_enabled = enabled;
+}
+
+bool is_tracking() {
+    return tracking().is_enabled;
+}
+
+void statistics(Category category, Statistics &statistics) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    const auto index = static_cast<size_t>(category);
+    if (index >= category_count) {
+        std::memset(&statistics, 0, sizeof(statistics));
+        return;
+    }
+    statistics = state.categories[index];
+}
+
+void total_statistics(Statistics &statistics) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    statistics = state.total;
+}
+
+void *alloc(size_t bytes, Category category) {
+    assert(_alloc);
+    void *p = _alloc(bytes);
+    assert(p != nullptr);
+    auto &state = tracking();
+    if (state.is_enabled.load(std::memory_order_relaxed)) {
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        track(state, p, bytes, resolve(category));
+    }
+    return p;
+}
+
+void *realloc(void *p, size_t s, Category category) {
+    auto &state = tracking();
+    if (!state.is_enabled.load(std::memory_order_relaxed)) {
+        return _realloc(p, s);
+    }
+
+    // Locked across the reallocation, for the same reason as in free.
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.allocations.find(p);
+    if (it != state.allocations.end()) {
+        // Keeps the category of the original allocation.
+        category = it->second.category;
+    } else {
+        category = resolve(category);
+    }
+    void *reallocated = _realloc(p, s);
+    if (reallocated == nullptr && s != 0) {
+        // The original memory is left untouched.
+        return nullptr;
+    }
+    if (p != nullptr) {
+        untrack(state, p);
+    }
+    track(state, reallocated, s, category);
+    return reallocated;
+}
+
+ScopedCategory::ScopedCategory(Category category) : _previous(_scoped_category) {
+    _scoped_category = category;
+}
+
+ScopedCategory::~ScopedCategory() {
+    _scoped_category = _previous;
 }
 
 }  // namespace allocator
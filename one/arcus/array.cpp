@@ -6,9 +6,16 @@
 namespace i3d {
 namespace one {
 
-Array::Array() : _doc(rapidjson::kArrayType) {}
+namespace {
 
-Array::Array(const Array &other) {
+// Stateless, shared so that each document does not allocate its own.
+rapidjson::CrtAllocator shared_allocator;
+
+}  // namespace
+
+Array::Array() : _doc(rapidjson::kArrayType, &shared_allocator) {}
+
+Array::Array(const Array &other) : _doc(&shared_allocator) {
     _doc.CopyFrom(other.get(), _doc.GetAllocator());
 }
 
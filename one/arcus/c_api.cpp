@@ -3,6 +3,7 @@
 #include <one/arcus/allocator.h>
 #include <one/arcus/array.h>
 #include <one/arcus/error.h>
+#include <one/arcus/internal/json.h>
 #include <one/arcus/logger.h>
 #include <one/arcus/message.h>
 #include <one/arcus/object.h>
@@ -779,7 +780,66 @@ OneError object_set_val_object(OneObjectPtr object, const char *key, OneObjectPt
     return o->set_val_object(key, *v);
 }
 
-OneError server_create(unsigned int port, OneServerPtr *server) {
+OneError set_server_options(const ConnectionOptions &source,
+                            OneServerOptions *options) {
+    if (options == nullptr) {
+        return ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR;
+    }
+
+    options->max_incoming_messages =
+        static_cast<unsigned int>(source.max_incoming_messages);
+    options->max_outgoing_messages =
+        static_cast<unsigned int>(source.max_outgoing_messages);
+    options->initial_stream_size = static_cast<unsigned int>(source.initial_stream_size);
+    options->max_stream_size = static_cast<unsigned int>(source.max_stream_size);
+
+    const auto &socket = source.socket;
+    options->no_delay = socket.is_no_delay;
+    options->send_buffer_size = socket.send_buffer_size;
+    options->receive_buffer_size = socket.receive_buffer_size;
+    options->keepalive = socket.is_keepalive_enabled;
+    options->keepalive_idle_seconds = socket.keepalive_idle_seconds;
+    options->keepalive_interval_seconds = socket.keepalive_interval_seconds;
+    options->keepalive_count = socket.keepalive_count;
+    options->user_timeout_ms = socket.user_timeout_ms;
+    options->busy_poll_us = socket.busy_poll_us;
+    options->io_backend = static_cast<OneIoBackend>(source.io_backend);
+
+    const auto &health = source.health;
+    options->health_send_interval_ms = health.send_interval_ms;
+    options->health_receive_timeout_ms = health.receive_timeout_ms;
+    options->health_adaptive = health.is_adaptive;
+    options->health_min_receive_timeout_ms = health.min_receive_timeout_ms;
+    options->kernel_liveness = health.liveness == Liveness::kernel;
+    options->session_replay_size = static_cast<unsigned int>(source.session_replay_size);
+    options->shared_memory_capacity =
+        static_cast<unsigned int>(source.shared_memory_capacity);
+
+    const auto &retry = source.retry;
+    options->retry_initial_delay_ms = retry.initial_delay_ms;
+    options->retry_max_delay_ms = retry.max_delay_ms;
+    options->retry_multiplier = retry.multiplier;
+    options->retry_jitter_percent = retry.jitter_percent;
+    return ONE_ERROR_NONE;
+}
+
+OneError server_default_options(OneServerOptions *options) {
+    return set_server_options(ConnectionOptions(), options);
+}
+
+OneError server_small_footprint_options(OneServerOptions *options) {
+    return set_server_options(ConnectionOptions::small_footprint(), options);
+}
+
+OneError server_fast_failover_options(OneServerOptions *options) {
+    ConnectionOptions source;
+    source.health = HealthOptions::fast_failover();
+    return set_server_options(source, options);
+}
+
+// Listens on the Unix domain socket at path if not null, on port otherwise.
+OneError server_create(const char *path, unsigned int port,
+                       const ConnectionOptions &options, OneServerPtr *server) {
     if (server == nullptr) {
         return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
     }
@@ -789,7 +849,7 @@ OneError server_create(unsigned int port, OneServerPtr *server) {
         return ONE_ERROR_SERVER_ALLOCATION_FAILED;
     }
 
-    auto err = s->init(port);
+    auto err = (path != nullptr) ? s->init_local(path, options) : s->init(port, options);
     if (is_error(err)) {
         allocator::destroy<Server>(s);
         return err;
@@ -799,21 +859,133 @@ OneError server_create(unsigned int port, OneServerPtr *server) {
     return ONE_ERROR_NONE;
 }
 
+ConnectionOptions connection_options(const OneServerOptions &options) {
+    ConnectionOptions converted;
+    converted.max_incoming_messages = options.max_incoming_messages;
+    converted.max_outgoing_messages = options.max_outgoing_messages;
+    converted.initial_stream_size = options.initial_stream_size;
+    converted.max_stream_size = options.max_stream_size;
+
+    auto &socket = converted.socket;
+    socket.is_no_delay = options.no_delay;
+    socket.send_buffer_size = options.send_buffer_size;
+    socket.receive_buffer_size = options.receive_buffer_size;
+    socket.is_keepalive_enabled = options.keepalive;
+    socket.keepalive_idle_seconds = options.keepalive_idle_seconds;
+    socket.keepalive_interval_seconds = options.keepalive_interval_seconds;
+    socket.keepalive_count = options.keepalive_count;
+    socket.user_timeout_ms = options.user_timeout_ms;
+    socket.busy_poll_us = options.busy_poll_us;
+    converted.io_backend = static_cast<IoBackend>(options.io_backend);
+
+    auto &health = converted.health;
+    health.send_interval_ms = options.health_send_interval_ms;
+    health.receive_timeout_ms = options.health_receive_timeout_ms;
+    health.is_adaptive = options.health_adaptive;
+    health.min_receive_timeout_ms = options.health_min_receive_timeout_ms;
+    health.liveness =
+        options.kernel_liveness ? Liveness::kernel : Liveness::health_messages;
+    converted.session_replay_size = options.session_replay_size;
+    converted.shared_memory_capacity = options.shared_memory_capacity;
+
+    auto &retry = converted.retry;
+    retry.initial_delay_ms = options.retry_initial_delay_ms;
+    retry.max_delay_ms = options.retry_max_delay_ms;
+    retry.multiplier = options.retry_multiplier;
+    retry.jitter_percent = options.retry_jitter_percent;
+    return converted;
+}
+
+OneError server_create_with_options(unsigned int port, const OneServerOptions *options,
+                                    OneServerPtr *server) {
+    if (options == nullptr) {
+        return ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR;
+    }
+
+    return server_create(nullptr, port, connection_options(*options), server);
+}
+
+OneError server_create_local(const char *path, const ConnectionOptions &options,
+                             OneServerPtr *server) {
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+
+    return server_create(path, 0, options, server);
+}
+
+OneError server_create_local_with_options(const char *path,
+                                          const OneServerOptions *options,
+                                          OneServerPtr *server) {
+    if (options == nullptr) {
+        return ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR;
+    }
+
+    return server_create_local(path, connection_options(*options), server);
+}
+
 OneError server_set_logger(OneServerPtr server, OneLogFn log_cb, void *userdata) {
     if (server == nullptr) {
         return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
     }
 
+    auto s = (Server *)(server);
+    if (log_cb == nullptr) {
+        s->set_logger(Logger());
+        return ONE_ERROR_NONE;
+    }
+
     auto wrapper = [log_cb](void *userdata, LogLevel level, const String &message) {
         log_cb(userdata, static_cast<OneLogLevel>(level), message.c_str());
     };
     Logger logger(wrapper, userdata);
 
-    auto s = (Server *)(server);
     s->set_logger(logger);
     return ONE_ERROR_NONE;
 }
 
+OneError server_set_log_level(OneServerPtr server, OneLogLevel level) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+    if (level < ONE_LOG_LEVEL_INFO || level > ONE_LOG_LEVEL_ERROR) {
+        return ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID;
+    }
+
+    auto s = (Server *)(server);
+    s->set_log_level(static_cast<LogLevel>(level));
+    return ONE_ERROR_NONE;
+}
+
+OneError server_set_async_logging(OneServerPtr server, bool enabled) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    return s->set_async_logging(enabled);
+}
+
+OneError server_enable_capture(OneServerPtr server, const char *path,
+                               unsigned int max_file_size, unsigned int max_files) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    return s->enable_capture(path, max_file_size, max_files);
+}
+
+OneError server_disable_capture(OneServerPtr server) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    s->disable_capture();
+    return ONE_ERROR_NONE;
+}
+
 void server_destroy(OneServerPtr server) {
     if (server == nullptr) {
         return;
@@ -846,6 +1018,128 @@ OneError server_status(OneServerPtr const server, OneServerStatus *status) {
     return ONE_ERROR_NONE;
 }
 
+OneError server_set_live_state_delta(OneServerPtr server, bool enabled) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    s->set_live_state_delta(enabled);
+    return ONE_ERROR_NONE;
+}
+
+OneError server_set_min_send_interval(OneServerPtr server, unsigned int milliseconds) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    s->set_min_send_interval(milliseconds);
+    return ONE_ERROR_NONE;
+}
+
+OneError server_flush(OneServerPtr server) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    return s->flush();
+}
+
+OneError server_queue_pressure(OneServerPtr server, OneQueuePressure *pressure) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+    if (pressure == nullptr) {
+        return ONE_ERROR_VALIDATION_QUEUE_PRESSURE_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    QueuePressure p;
+    auto err = s->queue_pressure(p);
+    if (is_error(err)) {
+        return err;
+    }
+
+    pressure->incoming = static_cast<unsigned int>(p.incoming);
+    pressure->incoming_capacity = static_cast<unsigned int>(p.incoming_capacity);
+    pressure->outgoing_control =
+        static_cast<unsigned int>(p.outgoing[static_cast<size_t>(Priority::control)]);
+    pressure->outgoing_state =
+        static_cast<unsigned int>(p.outgoing[static_cast<size_t>(Priority::state)]);
+    pressure->outgoing_bulk =
+        static_cast<unsigned int>(p.outgoing[static_cast<size_t>(Priority::bulk)]);
+    pressure->outgoing_capacity = static_cast<unsigned int>(p.outgoing_capacity);
+    pressure->is_reading_paused = p.is_reading_paused;
+    return ONE_ERROR_NONE;
+}
+
+OneError server_memory_footprint(OneServerPtr server, OneMemoryFootprint *footprint) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+    if (footprint == nullptr) {
+        return ONE_ERROR_VALIDATION_FOOTPRINT_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    MemoryFootprint f;
+    auto err = s->memory_footprint(f);
+    if (is_error(err)) {
+        return err;
+    }
+
+    footprint->instance = static_cast<unsigned int>(f.instance);
+    footprint->streams = static_cast<unsigned int>(f.streams);
+    footprint->queues = static_cast<unsigned int>(f.queues);
+    footprint->messages = static_cast<unsigned int>(f.messages);
+    footprint->state = static_cast<unsigned int>(f.state);
+    footprint->json_cache = static_cast<unsigned int>(f.json_cache);
+    footprint->total = static_cast<unsigned int>(f.total());
+    return ONE_ERROR_NONE;
+}
+
+OneError server_io_backend(OneServerPtr server, OneIoBackend *backend) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+    if (backend == nullptr) {
+        return ONE_ERROR_VALIDATION_IO_BACKEND_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    *backend = static_cast<OneIoBackend>(s->io_backend());
+    return ONE_ERROR_NONE;
+}
+
+OneError server_is_shared_memory(OneServerPtr server, bool *result) {
+    if (server == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+    if (result == nullptr) {
+        return ONE_ERROR_VALIDATION_RESULT_IS_NULLPTR;
+    }
+
+    auto s = (Server *)(server);
+    *result = s->is_shared_memory();
+    return ONE_ERROR_NONE;
+}
+
+OneError server_set_writable_callback(OneServerPtr server, void (*callback)(void *),
+                                      void *userdata) {
+    auto s = (Server *)server;
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    if (callback == nullptr) {
+        return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
+    }
+
+    return s->set_writable_callback(callback, userdata);
+}
+
 OneError server_set_live_state(OneServerPtr server, int players, int max_players,
                                const char *name, const char *map, const char *mode,
                                const char *version, OneObjectPtr additional_data) {
@@ -878,6 +1172,69 @@ OneError server_set_live_state(OneServerPtr server, int players, int max_players
     return s->set_live_state(players, max_players, name, map, mode, version, object);
 }
 
+OneError server_set_players(OneServerPtr server, int players) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_players(players);
+}
+
+OneError server_set_max_players(OneServerPtr server, int max_players) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_max_players(max_players);
+}
+
+OneError server_set_name(OneServerPtr server, const char *name) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_name(name);
+}
+
+OneError server_set_map(OneServerPtr server, const char *map) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_map(map);
+}
+
+OneError server_set_mode(OneServerPtr server, const char *mode) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_mode(mode);
+}
+
+OneError server_set_version(OneServerPtr server, const char *version) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_version(version);
+}
+
+OneError server_set_additional_data(OneServerPtr server, OneObjectPtr additional_data) {
+    auto s = reinterpret_cast<Server *>(server);
+    if (s == nullptr) {
+        return ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR;
+    }
+
+    return s->set_additional_data(reinterpret_cast<Object *>(additional_data));
+}
+
 OneError server_send_reverse_metadata(OneServerPtr server, OneArrayPtr data) {
     auto s = reinterpret_cast<Server *>(server);
     if (s == nullptr) {
@@ -903,6 +1260,18 @@ OneError server_set_application_instance_status(OneServerPtr server,
         static_cast<Server::ApplicationInstanceStatus>(status));
 }
 
+// The C callbacks receive arrays and objects as void pointers. They are
+// converted to function pointers taking the Array or Object pointer, which are
+// passed the same way, so that the server calls them directly rather than
+// through a std::function.
+void (*as_array_callback(void (*callback)(void *, void *)))(void *, Array *) {
+    return reinterpret_cast<void (*)(void *, Array *)>(callback);
+}
+
+void (*as_object_callback(void (*callback)(void *, void *)))(void *, Object *) {
+    return reinterpret_cast<void (*)(void *, Object *)>(callback);
+}
+
 OneError server_set_soft_stop_callback(OneServerPtr server, void (*callback)(void *, int),
                                        void *userdata) {
     auto s = (Server *)server;
@@ -929,7 +1298,7 @@ OneError server_set_allocated_callback(OneServerPtr server,
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
-    s->set_allocated_callback(callback, userdata);
+    s->set_allocated_callback(as_array_callback(callback), userdata);
     return ONE_ERROR_NONE;
 }
 
@@ -944,7 +1313,7 @@ OneError server_set_metadata_callback(OneServerPtr server,
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
-    s->set_metadata_callback(callback, userdata);
+    s->set_metadata_callback(as_array_callback(callback), userdata);
     return ONE_ERROR_NONE;
 }
 
@@ -960,7 +1329,7 @@ OneError server_set_host_information_callback(OneServerPtr server,
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
-    s->set_host_information_callback(callback, userdata);
+    s->set_host_information_callback(as_object_callback(callback), userdata);
     return ONE_ERROR_NONE;
 }
 
@@ -975,7 +1344,8 @@ OneError server_set_application_instance_information_callback(
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
-    s->set_application_instance_information_callback(callback, userdata);
+    s->set_application_instance_information_callback(as_object_callback(callback),
+                                                     userdata);
     return ONE_ERROR_NONE;
 }
 
@@ -991,16 +1361,27 @@ OneError server_set_custom_command_callback(OneServerPtr server,
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
-    s->set_custom_command_callback(callback, userdata);
+    s->set_custom_command_callback(as_array_callback(callback), userdata);
     return ONE_ERROR_NONE;
 }
 
+// The C overrides take unsigned int sizes. They are called through plain
+// wrapper functions rather than capturing lambdas, so that the allocator keeps
+// calling function pointers directly.
+void *(*_c_alloc)(unsigned int size) = nullptr;
+void *(*_c_realloc)(void *, unsigned int size) = nullptr;
+
+void *c_alloc(size_t size) {
+    return _c_alloc(static_cast<unsigned int>(size));
+}
+
+void *c_realloc(void *p, size_t size) {
+    return _c_realloc(p, static_cast<unsigned int>(size));
+}
+
 void allocator_set_alloc(void *(*callback)(unsigned int size)) {
-    // Wrapper for size_t.
-    auto wrapper = [callback](size_t size) -> void * {
-        return callback(static_cast<unsigned int>(size));
-    };
-    allocator::set_alloc(wrapper);
+    _c_alloc = callback;
+    allocator::set_alloc(c_alloc);
 }
 
 void allocator_set_free(void(callback)(void *)) {
@@ -1008,11 +1389,54 @@ void allocator_set_free(void(callback)(void *)) {
 }
 
 void allocator_set_realloc(void *(*callback)(void *, unsigned int size)) {
-    // Wrapper for size_t.
-    auto wrapper = [callback](void *p, size_t size) -> void * {
-        return callback(p, static_cast<unsigned int>(size));
-    };
-    allocator::set_realloc(wrapper);
+    _c_realloc = callback;
+    allocator::set_realloc(c_realloc);
+}
+
+void allocator_use_pool() {
+    allocator::use_pool();
+}
+
+void allocator_flush_json_cache() {
+    json::flush();
+}
+
+static_assert(static_cast<int>(allocator::Category::count) ==
+                  ONE_ALLOCATION_CATEGORY_TOTAL,
+              "allocation categories must match");
+static_assert(allocator::size_class_count == ONE_ALLOCATION_SIZE_CLASS_COUNT,
+              "allocation size classes must match");
+
+void allocator_set_tracking(bool enabled) {
+    allocator::set_tracking(enabled);
+}
+
+OneError allocator_statistics(OneAllocationCategory category,
+                              OneAllocationStatistics *statistics) {
+    if (statistics == nullptr) {
+        return ONE_ERROR_VALIDATION_STATISTICS_IS_NULLPTR;
+    }
+    if (category < ONE_ALLOCATION_CATEGORY_GENERAL ||
+        category > ONE_ALLOCATION_CATEGORY_TOTAL) {
+        return ONE_ERROR_VALIDATION_CATEGORY_IS_INVALID;
+    }
+
+    allocator::Statistics result;
+    if (category == ONE_ALLOCATION_CATEGORY_TOTAL) {
+        allocator::total_statistics(result);
+    } else {
+        allocator::statistics(static_cast<allocator::Category>(category), result);
+    }
+
+    statistics->live_bytes = result.live_bytes;
+    statistics->peak_bytes = result.peak_bytes;
+    statistics->live_allocations = result.live_allocations;
+    statistics->allocations = result.allocations;
+    statistics->frees = result.frees;
+    for (size_t i = 0; i < allocator::size_class_count; ++i) {
+        statistics->size_classes[i] = result.size_classes[i];
+    }
+    return ONE_ERROR_NONE;
 }
 
 }  // Unnamed namespace.
@@ -1230,13 +1654,58 @@ OneError one_object_set_val_object(OneObjectPtr object, const char *key,
 }
 
 OneError one_server_create(unsigned int port, OneServerPtr *server) {
-    return one::server_create(port, server);
+    return one::server_create(nullptr, port, one::ConnectionOptions(), server);
+}
+
+OneError one_server_default_options(OneServerOptions *options) {
+    return one::server_default_options(options);
+}
+
+OneError one_server_small_footprint_options(OneServerOptions *options) {
+    return one::server_small_footprint_options(options);
+}
+
+OneError one_server_fast_failover_options(OneServerOptions *options) {
+    return one::server_fast_failover_options(options);
+}
+
+OneError one_server_create_with_options(unsigned int port,
+                                        const OneServerOptions *options,
+                                        OneServerPtr *server) {
+    return one::server_create_with_options(port, options, server);
+}
+
+OneError one_server_create_local(const char *path, OneServerPtr *server) {
+    return one::server_create_local(path, one::ConnectionOptions(), server);
+}
+
+OneError one_server_create_local_with_options(const char *path,
+                                              const OneServerOptions *options,
+                                              OneServerPtr *server) {
+    return one::server_create_local_with_options(path, options, server);
 }
 
 OneError one_server_set_logger(OneServerPtr server, OneLogFn log_cb, void *userdata) {
     return one::server_set_logger(server, log_cb, userdata);
 }
 
+OneError one_server_set_log_level(OneServerPtr server, OneLogLevel level) {
+    return one::server_set_log_level(server, level);
+}
+
+OneError one_server_set_async_logging(OneServerPtr server, bool enabled) {
+    return one::server_set_async_logging(server, enabled);
+}
+
+OneError one_server_enable_capture(OneServerPtr server, const char *path,
+                                   unsigned int max_file_size, unsigned int max_files) {
+    return one::server_enable_capture(server, path, max_file_size, max_files);
+}
+
+OneError one_server_disable_capture(OneServerPtr server) {
+    return one::server_disable_capture(server);
+}
+
 void one_server_destroy(OneServerPtr server) {
     return one::server_destroy(server);
 }
@@ -1249,6 +1718,10 @@ OneError one_server_status(OneServerPtr const server, OneServerStatus *status) {
     return one::server_status(server, status);
 }
 
+OneError one_server_set_live_state_delta(OneServerPtr server, bool enabled) {
+    return one::server_set_live_state_delta(server, enabled);
+}
+
 OneError one_server_set_live_state(OneServerPtr server, int players, int max_players,
                                    const char *name, const char *map, const char *mode,
                                    const char *version, OneObjectPtr additional_data) {
@@ -1256,10 +1729,71 @@ OneError one_server_set_live_state(OneServerPtr server, int players, int max_pla
                                       version, additional_data);
 }
 
+OneError one_server_set_players(OneServerPtr server, int players) {
+    return one::server_set_players(server, players);
+}
+
+OneError one_server_set_max_players(OneServerPtr server, int max_players) {
+    return one::server_set_max_players(server, max_players);
+}
+
+OneError one_server_set_name(OneServerPtr server, const char *name) {
+    return one::server_set_name(server, name);
+}
+
+OneError one_server_set_map(OneServerPtr server, const char *map) {
+    return one::server_set_map(server, map);
+}
+
+OneError one_server_set_mode(OneServerPtr server, const char *mode) {
+    return one::server_set_mode(server, mode);
+}
+
+OneError one_server_set_version(OneServerPtr server, const char *version) {
+    return one::server_set_version(server, version);
+}
+
+OneError one_server_set_additional_data(OneServerPtr server,
+                                        OneObjectPtr additional_data) {
+    return one::server_set_additional_data(server, additional_data);
+}
+
 OneError one_server_send_reverse_metadata(OneServerPtr server, OneArrayPtr data) {
     return one::server_send_reverse_metadata(server, data);
 }
 
+OneError one_server_set_min_send_interval(OneServerPtr server,
+                                          unsigned int milliseconds) {
+    return one::server_set_min_send_interval(server, milliseconds);
+}
+
+OneError one_server_flush(OneServerPtr server) {
+    return one::server_flush(server);
+}
+
+OneError one_server_queue_pressure(OneServerPtr server, OneQueuePressure *pressure) {
+    return one::server_queue_pressure(server, pressure);
+}
+
+OneError one_server_memory_footprint(OneServerPtr server,
+                                     OneMemoryFootprint *footprint) {
+    return one::server_memory_footprint(server, footprint);
+}
+
+OneError one_server_io_backend(OneServerPtr server, OneIoBackend *backend) {
+    return one::server_io_backend(server, backend);
+}
+
+OneError one_server_is_shared_memory(OneServerPtr server, bool *result) {
+    return one::server_is_shared_memory(server, result);
+}
+
+OneError one_server_set_writable_callback(OneServerPtr server,
+                                          void (*callback)(void *userdata),
+                                          void *userdata) {
+    return one::server_set_writable_callback(server, callback, userdata);
+}
+
 OneError one_server_set_application_instance_status(OneServerPtr server,
                                                     OneApplicationInstanceStatus status) {
     return one::server_set_application_instance_status(server, status);
@@ -1312,4 +1846,21 @@ void one_allocator_set_realloc(void *(*callback)(void *, unsigned int size)) {
     one::allocator_set_realloc(callback);
 }
 
+void one_allocator_use_pool() {
+    one::allocator_use_pool();
+}
+
+void one_allocator_flush_json_cache() {
+    one::allocator_flush_json_cache();
+}
+
+void one_allocator_set_tracking(bool enabled) {
+    one::allocator_set_tracking(enabled);
+}
+
+OneError one_allocator_statistics(OneAllocationCategory category,
+                                  OneAllocationStatistics *statistics) {
+    return one::allocator_statistics(category, statistics);
+}
+
 };  // extern "C"
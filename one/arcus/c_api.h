@@ -107,6 +107,64 @@ ONE_EXPORT void one_allocator_set_free(void (*callback)(void *));
 /// the standard c realloc requirements for behavior.
 ONE_EXPORT void one_allocator_set_realloc(void *(*callback)(void *, unsigned int size));
 
+/// Optional built-in pool allocator, replacing the default or custom alloc,
+/// free and realloc functions. Allocations up to 32 KiB are served from power
+/// of two size classes, cached per thread and refilled in batches, which makes
+/// the many small allocations of messages and strings cheaper and avoids lock
+/// contention between threads. Memory is retained by the pool for reuse rather
+/// than returned to the system. If used, must be called at init time, before
+/// using any other APIs.
+ONE_EXPORT void one_allocator_use_pool(void);
+
+/// Messages cache the memory of their JSON values per thread for reuse, up to
+/// 16 KiB per thread, until the thread exits. This releases the cache of the
+/// calling thread, e.g. once a thread stops handling messages. Shutting down or
+/// destroying a server does so for the calling thread.
+ONE_EXPORT void one_allocator_flush_json_cache(void);
+
+/// Subsystems that memory allocations are attributed to by allocation tracking.
+/// @sa one_allocator_statistics
+typedef enum OneAllocationCategory {
+    ONE_ALLOCATION_CATEGORY_GENERAL = 0,
+    ONE_ALLOCATION_CATEGORY_CONNECTION,  ///< Connection stream buffers and queues.
+    ONE_ALLOCATION_CATEGORY_JSON,        ///< Message payload JSON documents.
+    ONE_ALLOCATION_CATEGORY_STRING,      ///< Strings.
+    ONE_ALLOCATION_CATEGORY_TOTAL        ///< All categories, for statistics.
+} OneAllocationCategory;
+
+/// Number of allocation size classes. Class 0 counts allocations of up to 16
+/// bytes, class i allocations of up to 16 << i bytes and the last class all
+/// larger allocations.
+#define ONE_ALLOCATION_SIZE_CLASS_COUNT 14
+
+/// Allocation statistics of a category, since tracking was enabled.
+typedef struct OneAllocationStatistics {
+    size_t live_bytes;        ///< Bytes currently allocated.
+    size_t peak_bytes;        ///< Highest live_bytes value.
+    size_t live_allocations;  ///< Allocations not yet freed.
+    size_t allocations;       ///< Number of allocations.
+    size_t frees;             ///< Number of frees.
+    /// Allocations per size class.
+    size_t size_classes[ONE_ALLOCATION_SIZE_CLASS_COUNT];
+} OneAllocationStatistics;
+
+/// Optional allocation tracking, for diagnostics. When enabled, every allocation
+/// made by the SDK is accounted per category, whether or not custom allocation
+/// functions are set. Enabling resets the statistics, which remain readable
+/// after disabling. Memory allocated while tracking is disabled is not accounted.
+/// Tracking adds a lock and a hash table update to each allocation and free, so
+/// it should not be left enabled in production. Thread-safe.
+/// @param enabled Whether to track allocations.
+ONE_EXPORT void one_allocator_set_tracking(bool enabled);
+
+/// Copies the allocation statistics of the given category. Statistics of
+/// allocations made between two calls can be obtained by subtracting the
+/// results, e.g. to find which update phases allocate. Thread-safe.
+/// @param category The category, or ONE_ALLOCATION_CATEGORY_TOTAL for all categories.
+/// @param statistics A non-null pointer to the statistics to set.
+ONE_EXPORT OneError one_allocator_statistics(OneAllocationCategory category,
+                                            OneAllocationStatistics *statistics);
+
 //------------------------------------------------------------------------------
 ///@}
 ///@name Server interface.
@@ -138,6 +196,140 @@ typedef enum OneLogLevel { ONE_LOG_LEVEL_INFO = 0, ONE_LOG_LEVEL_ERROR } OneLogL
 /// \sa one_server_status
 ONE_EXPORT OneError one_server_create(unsigned int port, OneServerPtr *server);
 
+/// How the socket connected to the agent is read and written.
+/// \sa OneServerOptions
+typedef enum OneIoBackend {
+    /// Non blocking system calls, polled with select on each update.
+    ONE_IO_BACKEND_SELECT = 0,
+    /// io_uring on Linux 6.0 and later, receiving without system calls into
+    /// buffers the kernel fills as data arrives and batching sends. Falls back
+    /// to ONE_IO_BACKEND_SELECT where unavailable.
+    ONE_IO_BACKEND_IO_URING
+} OneIoBackend;
+
+/// Sizing of the connection to the agent, given at creation. Hosts running many
+/// game servers can lower it to reduce memory use.
+/// \sa one_server_create_with_options
+typedef struct OneServerOptions {
+    /// Received messages waiting to be processed by one_server_update.
+    unsigned int max_incoming_messages;
+    /// Queued outgoing messages, for each priority class.
+    unsigned int max_outgoing_messages;
+    /// The send and receive buffers each start with initial_stream_size bytes
+    /// and double in size as needed, up to max_stream_size. Messages that do
+    /// not fit in max_stream_size cannot be exchanged.
+    unsigned int initial_stream_size;
+    unsigned int max_stream_size;
+    /// TCP_NODELAY, sending small messages without waiting for the previous
+    /// ones to be acknowledged. Lowers the tail latency of messages, at the cost
+    /// of more packets. Disabled by default.
+    bool no_delay;
+    /// SO_SNDBUF and SO_RCVBUF in bytes, 0 for the system default.
+    unsigned int send_buffer_size;
+    unsigned int receive_buffer_size;
+    /// SO_KEEPALIVE, with the idle time before probing, the probe interval and
+    /// the unanswered probes before dropping the connection. 0 keeps the system
+    /// default.
+    bool keepalive;
+    unsigned int keepalive_idle_seconds;
+    unsigned int keepalive_interval_seconds;
+    unsigned int keepalive_count;
+    /// TCP_USER_TIMEOUT in milliseconds, Linux only. 0 for the system default.
+    unsigned int user_timeout_ms;
+    /// SO_BUSY_POLL in microseconds, Linux only. 0 to disable.
+    unsigned int busy_poll_us;
+    /// Requested backend, ONE_IO_BACKEND_SELECT by default.
+    /// \sa one_server_io_backend
+    OneIoBackend io_backend;
+    /// Health checking. A health message is sent when nothing else was sent for
+    /// health_send_interval_ms, and the connection fails when nothing was
+    /// received for health_receive_timeout_ms, 5000 and 20000 by default. When
+    /// health_adaptive is set, the receive timeout is lowered to three times the
+    /// longest interval between the health messages of the agent, but not below
+    /// health_min_receive_timeout_ms.
+    unsigned int health_send_interval_ms;
+    unsigned int health_receive_timeout_ms;
+    bool health_adaptive;
+    unsigned int health_min_receive_timeout_ms;
+    /// Requests that failures be detected by kernel TCP keepalive and
+    /// TCP_USER_TIMEOUT instead of health messages, set from the health
+    /// intervals. Used only if the agent also requests it during the handshake.
+    /// Linux only, ONE_ERROR_SOCKET_OPTION_UNSUPPORTED is returned elsewhere.
+    bool kernel_liveness;
+    /// Session resumption when not 0, keeping up to this many bytes of the
+    /// last messages sent. When the agent reconnects after the connection
+    /// dropped and also enabled it, only the messages it did not receive are
+    /// sent again, rather than the whole state. At most half of
+    /// max_stream_size, 0 by default.
+    unsigned int session_replay_size;
+    /// Shared memory when not 0. After the handshake, messages go through two
+    /// rings of this many bytes created by the server instead of the socket,
+    /// if the agent also enabled it and could open them, i.e. runs on the same
+    /// host. kernel_liveness is then not used. A power of two from 64 bytes to
+    /// 1 GB, 0 by default. Not available on Windows, where the socket is kept.
+    /// \sa one_server_is_shared_memory
+    unsigned int shared_memory_capacity;
+    /// Delay before binding the port again after it failed, in milliseconds,
+    /// starting at retry_initial_delay_ms and multiplied by retry_multiplier
+    /// after each failure up to retry_max_delay_ms, 50, 2 and 5000 by default.
+    /// Each delay is shortened at random by up to retry_jitter_percent, 50 by
+    /// default, so that servers restarting together do not retry in step.
+    unsigned int retry_initial_delay_ms;
+    unsigned int retry_max_delay_ms;
+    unsigned int retry_multiplier;
+    unsigned int retry_jitter_percent;
+} OneServerOptions;
+
+/// Sets the options to their defaults, as used by one_server_create.
+/// @param options A non-null pointer to the options to set.
+ONE_EXPORT OneError one_server_default_options(OneServerOptions *options);
+
+/// Sets the options to a profile for hosts running many game servers, keeping
+/// an idle connected server below 32 KB. Queues are shallow and the buffers
+/// start small, growing only to fit large messages.
+/// @param options A non-null pointer to the options to set.
+/// \sa one_server_memory_footprint
+ONE_EXPORT OneError one_server_small_footprint_options(OneServerOptions *options);
+
+/// Sets the options to their defaults, with health checking detecting a failed
+/// agent within a second instead of 20 seconds. The agent must send health
+/// messages at least every 250 milliseconds.
+/// @param options A non-null pointer to the options to set.
+ONE_EXPORT OneError one_server_fast_failover_options(OneServerOptions *options);
+
+/// Same as one_server_create, with the given connection sizing and socket
+/// tuning. ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID is returned if a queue depth
+/// or the initial stream size is zero, or if the initial stream size is larger
+/// than the maximum. ONE_ERROR_SOCKET_OPTION_UNSUPPORTED is returned if a socket
+/// option is set that the platform does not support.
+/// @param port The port to bind to and listen on for incoming Client connections.
+/// @param options A non-null pointer to the options.
+/// @param server A null server pointer, which will be set to a new server.
+ONE_EXPORT OneError one_server_create_with_options(unsigned int port,
+                                                   const OneServerOptions *options,
+                                                   OneServerPtr *server);
+
+/// Same as one_server_create, listening on a Unix domain socket instead of a TCP
+/// port, for an agent running on the same host. Messages and the handshake are
+/// the same as over TCP. A socket file left at path by a previous server is
+/// replaced, unless that server is still listening on it, in which case
+/// listening fails with ONE_ERROR_SOCKET_BIND_FAILED. The file is removed when
+/// the server is shut down.
+/// ONE_ERROR_SOCKET_PATH_TOO_LONG is returned if the path is 104 bytes or more,
+/// and ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED on Windows.
+/// @param path The file system path of the socket to listen on.
+/// @param server A null server pointer, which will be set to a new server.
+ONE_EXPORT OneError one_server_create_local(const char *path, OneServerPtr *server);
+
+/// Same as one_server_create_local, with the given connection sizing. Only the
+/// buffer sizes of the socket options apply.
+/// @param path The file system path of the socket to listen on.
+/// @param options A non-null pointer to the options.
+/// @param server A null server pointer, which will be set to a new server.
+ONE_EXPORT OneError one_server_create_local_with_options(const char *path,
+                                                         const OneServerOptions *options,
+                                                         OneServerPtr *server);
+
 /// Log callback function to allow the integration to handle internal ONE Server
 /// logs with its own logger.
 /// @param userdata Optional user data that will be passed back to the callback.
@@ -154,6 +346,40 @@ typedef void (*OneLogFn)(void *userdata, OneLogLevel level, const char *message)
 ONE_EXPORT OneError one_server_set_logger(OneServerPtr server, OneLogFn log_cb,
                                           void *userdata);
 
+/// Sets the minimum level of the logs passed to the log callback. Messages
+/// below the level are discarded before being formatted. Default is
+/// ONE_LOG_LEVEL_INFO.
+/// @param server A non-null server pointer.
+/// @param level The minimum level to log. Other values return
+/// ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID.
+ONE_EXPORT OneError one_server_set_log_level(OneServerPtr server, OneLogLevel level);
+
+/// Enables or disables asynchronous logging. When enabled, logging only copies
+/// the message into a bounded queue and the log callback is called from a
+/// background thread. Long messages are truncated and messages are dropped
+/// if the queue is full. Disabled by default.
+/// @param server A non-null server pointer.
+/// @param enabled Whether to log asynchronously.
+ONE_EXPORT OneError one_server_set_async_logging(OneServerPtr server, bool enabled);
+
+/// Records every Arcus frame exchanged with the agent into a binary capture
+/// file, for troubleshooting and traffic replay. The file is rotated once it
+/// exceeds max_file_size bytes: the current file is renamed with a ".1" suffix,
+/// older ones shifted up, keeping at most max_files files. Disabled by default.
+/// @param server A non-null server pointer.
+/// @param path A non-null path to the capture file. Existing files are replaced.
+/// @param max_file_size The size in bytes after which the file is rotated.
+/// @param max_files The maximum number of capture files kept, including the
+/// current one.
+/// \sa one_server_disable_capture
+ONE_EXPORT OneError one_server_enable_capture(OneServerPtr server, const char *path,
+                                              unsigned int max_file_size,
+                                              unsigned int max_files);
+
+/// Flushes and closes the capture file enabled by one_server_enable_capture.
+/// @param server A non-null server pointer.
+ONE_EXPORT OneError one_server_disable_capture(OneServerPtr server);
+
 /// Destroys a server instance created via one_server_create. Destroy will
 /// shutdown the server first, if it is active. Note although other server functions
 /// are thread safe, this one is not. A server must not be destroyed or interacted
@@ -429,6 +655,14 @@ ONE_EXPORT OneError one_object_set_val_object(OneObjectPtr object, const char *k
 /// for more information.
 ///@{
 
+/// Enables sending live states as deltas. Once the connected agent offers it,
+/// live states only hold the fields and additional data keys that changed
+/// since the previous one, after an initial full live state. Agents that do
+/// not offer it keep receiving full live states. Disabled by default.
+/// @param server A non-null server pointer.
+/// @param enabled Whether to send deltas when the agent supports them.
+ONE_EXPORT OneError one_server_set_live_state_delta(OneServerPtr server, bool enabled);
+
 /// Set the live game state information about the game server. This should be
 /// called at the least when the state changes, but it is safe to call more
 /// often if it is more convenient to do so - data is only sent out if there are
@@ -441,6 +675,7 @@ ONE_EXPORT OneError one_object_set_val_object(OneObjectPtr object, const char *k
 /// @param mode Actively hosted game mode.
 /// @param version The version of the game software.
 /// @param additional_data Any key/value pairs set on this object will be added.
+/// Unlike the per-field setters below, strings of any length are accepted.
 ONE_EXPORT OneError one_server_set_live_state(OneServerPtr server, int players,
                                               int max_players, const char *name,
                                               const char *map, const char *mode,
@@ -455,6 +690,112 @@ ONE_EXPORT OneError one_server_set_live_state(OneServerPtr server, int players,
 ONE_EXPORT OneError one_server_send_reverse_metadata(OneServerPtr server,
                                                      OneArrayPtr data);
 
+/// Per-field live state setters. Each only marks its field as changed if the
+/// value differs from the current one, and the live state is then sent by a
+/// later one_server_update. Updating a single field, e.g. the player count,
+/// does not allocate. Strings are copied and must not be longer than 255
+/// characters, or ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG is returned.
+/// one_server_set_live_state sets all fields at once. Thread-safe.
+/// @param server A non-null server pointer.
+ONE_EXPORT OneError one_server_set_players(OneServerPtr server, int players);
+ONE_EXPORT OneError one_server_set_max_players(OneServerPtr server, int max_players);
+ONE_EXPORT OneError one_server_set_name(OneServerPtr server, const char *name);
+ONE_EXPORT OneError one_server_set_map(OneServerPtr server, const char *map);
+ONE_EXPORT OneError one_server_set_mode(OneServerPtr server, const char *mode);
+ONE_EXPORT OneError one_server_set_version(OneServerPtr server, const char *version);
+/// The additional data is copied, or removed if additional_data is null.
+ONE_EXPORT OneError one_server_set_additional_data(OneServerPtr server,
+                                                   OneObjectPtr additional_data);
+
+/// Sets the minimum interval between two live states, and between two
+/// application instance statuses, sent to the agent. Changes made in between
+/// are coalesced and only the latest one is sent once the interval has passed.
+/// Zero, the default, sends changes on the next update. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param milliseconds The minimum send interval.
+ONE_EXPORT OneError one_server_set_min_send_interval(OneServerPtr server,
+                                                     unsigned int milliseconds);
+
+/// Sends the pending live state and application instance status now, regardless
+/// of the minimum send interval. Meant for critical transitions, e.g. becoming
+/// allocated. They are written to the agent during the next one_server_update.
+/// Nothing is sent while no agent connection is ready. Thread-safe.
+/// @param server A non-null server pointer.
+ONE_EXPORT OneError one_server_flush(OneServerPtr server);
+
+/// Fill levels of the message queues of the agent connection.
+/// \sa one_server_queue_pressure
+typedef struct OneQueuePressure {
+    /// Received messages waiting to be processed by one_server_update.
+    unsigned int incoming;
+    unsigned int incoming_capacity;
+    /// Queued outgoing messages of each priority class.
+    unsigned int outgoing_control;
+    unsigned int outgoing_state;
+    unsigned int outgoing_bulk;
+    /// Capacity of each priority class.
+    unsigned int outgoing_capacity;
+    /// Reading from the agent is paused until the received messages are
+    /// processed, which slows the agent down rather than dropping it.
+    bool is_reading_paused;
+} OneQueuePressure;
+
+/// Reports the fill levels of the message queues, so that the game can send
+/// less before sends fail with a full queue. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param pressure A non-null pointer to the pressure to set.
+ONE_EXPORT OneError one_server_queue_pressure(OneServerPtr server,
+                                              OneQueuePressure *pressure);
+
+/// Memory held by a server, in bytes allocated through the ONE allocator.
+/// \sa one_server_memory_footprint
+typedef struct OneMemoryFootprint {
+    /// The server, its connection and sockets.
+    unsigned int instance;
+    /// Send and receive buffers.
+    unsigned int streams;
+    /// Message queue slots, allocated on first use.
+    unsigned int queues;
+    /// JSON values of the messages in the queue slots.
+    unsigned int messages;
+    /// JSON values and strings kept by the server, e.g. the additional data.
+    unsigned int state;
+    /// Sum of the above.
+    unsigned int total;
+    /// Blocks cached for reuse by the JSON allocator of the calling thread,
+    /// shared by everything using JSON on the thread. Not part of the total.
+    unsigned int json_cache;
+} OneMemoryFootprint;
+
+/// Reports the memory held by the server, broken down by use. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param footprint A non-null pointer to the footprint to set.
+ONE_EXPORT OneError one_server_memory_footprint(OneServerPtr server,
+                                                OneMemoryFootprint *footprint);
+
+/// Reports the backend in use, which is ONE_IO_BACKEND_SELECT if io_uring was
+/// requested but is unavailable. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param backend A non-null pointer to the backend to set.
+ONE_EXPORT OneError one_server_io_backend(OneServerPtr server, OneIoBackend *backend);
+
+/// Reports whether messages go through shared memory with the connected agent
+/// instead of the socket. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param result A non-null pointer to the result to set.
+ONE_EXPORT OneError one_server_is_shared_memory(OneServerPtr server, bool *result);
+
+/// Registers a callback to be called once during one_server_update after a
+/// send failed with ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE and
+/// the queue has drained to half of its capacity. Messages can be sent from the
+/// callback. Thread-safe.
+/// @param server A non-null server pointer.
+/// @param callback Callback to be called when messages can be sent again.
+/// @param userdata Optional user data that will be passed back to the callback.
+ONE_EXPORT OneError one_server_set_writable_callback(OneServerPtr server,
+                                                     void (*callback)(void *userdata),
+                                                     void *userdata);
+
 /// This should be called at the least when the state changes, but it is safe to
 /// call more often if it is more convenient to do so - data is only sent out if
 /// there are changes from the previous call. Thread-safe.
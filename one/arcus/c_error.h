@@ -57,6 +57,13 @@ typedef enum OneError {
     ONE_ERROR_CONNECTION_UNKNOWN_STATUS = 423,
     ONE_ERROR_CONNECTION_UPDATE_AFTER_ERROR = 424,
     ONE_ERROR_CONNECTION_UPDATE_READY_FAIL = 425,
+    ONE_ERROR_CONNECTION_PRIORITY_IS_INVALID = 426,
+    ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED = 427,
+    ONE_ERROR_CONNECTION_QUEUE_ALLOCATION_FAILED = 428,
+    ONE_ERROR_CONNECTION_SESSION_RECEIVE_FAILED = 429,
+    ONE_ERROR_CONNECTION_SESSION_SEND_FAILED = 430,
+    ONE_ERROR_CONNECTION_SHARED_MEMORY_RECEIVE_FAILED = 431,
+    ONE_ERROR_CONNECTION_SHARED_MEMORY_SEND_FAILED = 432,
     ONE_ERROR_MESSAGE_ALLOCATION_FAILED = 500,
     ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR = 501,
     ONE_ERROR_MESSAGE_IS_NULLPTR = 502,
@@ -72,6 +79,9 @@ typedef enum OneError {
     ONE_ERROR_MESSAGE_OPCODE_PAYLOAD_NOT_EMPTY = 511,
     ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_REVERSE_METADATA = 512,
     ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_CUSTOM_COMMAND = 513,
+    ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_LIVE_STATE_DELTA = 514,
+    ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_FEATURES = 515,
+    ONE_ERROR_MESSAGE_LIVE_STATE_DELTA_WITHOUT_SNAPSHOT = 516,
     ONE_ERROR_OBJECT_ALLOCATION_FAILED = 600,
     ONE_ERROR_OBJECT_KEY_NOT_FOUND = 601,
     ONE_ERROR_OBJECT_KEY_IS_NULLPTR = 602,
@@ -120,6 +130,10 @@ typedef enum OneError {
     ONE_ERROR_SOCKET_SOCKET_OPTIONS_FAILED = 916,
     ONE_ERROR_SOCKET_SYSTEM_CLEANUP_FAIL = 917,
     ONE_ERROR_SOCKET_SYSTEM_INIT_FAIL = 918,
+    ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED = 919,
+    ONE_ERROR_SOCKET_PATH_TOO_LONG = 920,
+    ONE_ERROR_SOCKET_OPTION_UNSUPPORTED = 921,
+    ONE_ERROR_SOCKET_ADDRESS_INVALID = 922,
     ONE_ERROR_VALIDATION_ARRAY_IS_NULLPTR = 1000,
     ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR = 1001,
     ONE_ERROR_VALIDATION_CAPACITY_IS_NULLPTR = 1002,
@@ -142,7 +156,38 @@ typedef enum OneError {
     ONE_ERROR_VALIDATION_SIZE_IS_NULLPTR = 1019,
     ONE_ERROR_VALIDATION_VAL_IS_NULLPTR = 1020,
     ONE_ERROR_VALIDATION_VAL_SIZE_IS_TOO_SMALL = 1021,
-    ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR = 1022
+    ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR = 1022,
+    ONE_ERROR_VALIDATION_PATH_IS_NULLPTR = 1023,
+    ONE_ERROR_VALIDATION_STATISTICS_IS_NULLPTR = 1024,
+    ONE_ERROR_VALIDATION_CATEGORY_IS_INVALID = 1025,
+    ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG = 1026,
+    ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID = 1027,
+    ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR = 1028,
+    ONE_ERROR_VALIDATION_QUEUE_PRESSURE_IS_NULLPTR = 1029,
+    ONE_ERROR_VALIDATION_FOOTPRINT_IS_NULLPTR = 1030,
+    ONE_ERROR_VALIDATION_IO_BACKEND_IS_NULLPTR = 1031,
+    ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID = 1032,
+    ONE_ERROR_LOGGER_ALREADY_INITIALIZED = 1100,
+    ONE_ERROR_LOGGER_CAPACITY_IS_ZERO = 1101,
+    ONE_ERROR_LOGGER_ALLOCATION_FAILED = 1102,
+    ONE_ERROR_CAPTURE_ALLOCATION_FAILED = 1200,
+    ONE_ERROR_CAPTURE_ALREADY_OPEN = 1201,
+    ONE_ERROR_CAPTURE_INVALID_FILE = 1202,
+    ONE_ERROR_CAPTURE_NOT_OPEN = 1203,
+    ONE_ERROR_CAPTURE_OPEN_FAILED = 1204,
+    ONE_ERROR_CAPTURE_ROTATION_FAILED = 1205,
+    ONE_ERROR_CAPTURE_WRITE_FAILED = 1206,
+    ONE_ERROR_TRANSPORT_UNSUPPORTED = 1400,
+    ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED = 1401,
+    ONE_ERROR_TRANSPORT_NOT_INITIALIZED = 1402,
+    ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID = 1403,
+    ONE_ERROR_TRANSPORT_CREATE_FAILED = 1404,
+    ONE_ERROR_TRANSPORT_OPEN_FAILED = 1405,
+    ONE_ERROR_TRANSPORT_INVALID_REGION = 1406,
+    ONE_ERROR_TRANSPORT_PEER_CLOSED = 1407,
+    ONE_ERROR_TRANSPORT_WAIT_FAILED = 1408,
+    ONE_ERROR_TRANSPORT_ALLOCATION_FAILED = 1409,
+    ONE_ERROR_TRANSPORT_SUBMIT_FAILED = 1410
 } OneError;
 
 ONE_EXPORT bool one_is_error(OneError err);
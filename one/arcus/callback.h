@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace i3d {
+namespace one {
+
+template <class Signature>
+class Callback;
+
+// Callable used for the allocator overrides and the message callbacks.
+//
+// Plain functions, including those passed through the C API and lambdas
+// without captures, are stored as a function pointer and called directly. Any
+// other callable is kept in a std::function as a C++ convenience, which costs
+// a type-erased call and possibly an allocation when set.
+template <class R, class... Args>
+class Callback<R(Args...)> final {
+public:
+    using Function = R (*)(Args...);
+
+    Callback() : _function(nullptr) {}
+    Callback(std::nullptr_t) : _function(nullptr) {}
+
+    template <class F, class = typename std::enable_if<!std::is_same<
+                           typename std::decay<F>::type, Callback>::value>::type>
+    Callback(F &&callable) : _function(nullptr) {
+        assign(std::forward<F>(callable), std::is_convertible<F, Function>());
+    }
+
+    explicit operator bool() const {
+        return _function != nullptr || static_cast<bool>(_wrapped);
+    }
+
+    R operator()(Args... args) const {
+        if (_function != nullptr) {
+            return _function(std::forward<Args>(args)...);
+        }
+        return _wrapped(std::forward<Args>(args)...);
+    }
+
+    // The function pointer, or nullptr if a std::function is used.
+    Function function() const {
+        return _function;
+    }
+
+    const std::function<R(Args...)> &wrapped() const {
+        return _wrapped;
+    }
+
+private:
+    template <class F>
+    void assign(F &&callable, std::true_type) {
+        _function = callable;
+    }
+
+    template <class F>
+    void assign(F &&callable, std::false_type) {
+        _wrapped = std::forward<F>(callable);
+    }
+
+    Function _function;
+    std::function<R(Args...)> _wrapped;
+};
+
+}  // namespace one
+}  // namespace i3d
@@ -1,12 +1,20 @@
 #include <one/arcus/client.h>
 
 #include <one/arcus/allocator.h>
+#include <one/arcus/internal/capture.h>
 #include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/io_uring.h>
+#include <one/arcus/internal/json.h>
 #include <one/arcus/internal/messages.h>
+#include <one/arcus/internal/mutex.h>
 #include <one/arcus/opcode.h>
 #include <one/arcus/internal/socket.h>
+#include <one/arcus/internal/time.h>
+#include <one/arcus/internal/transport.h>
 #include <one/arcus/message.h>
 
+#include <cstring>
+
 //#define ONE_ARCUS_CLIENT_LOGGING
 
 #ifdef ONE_ARCUS_CLIENT_LOGGING
@@ -16,10 +24,6 @@
 namespace i3d {
 namespace one {
 
-namespace {
-constexpr size_t connection_retry_delay_seconds = 5;
-}
-
 // See: https://en.cppreference.com/w/cpp/language/value_initialization
 // C++11 Value initialization
 Client::Client()
@@ -27,20 +31,96 @@ Client::Client()
     , _server_port(0)
     , _socket(nullptr)
     , _connection(nullptr)
+    , _io_uring(nullptr)
+    , _transport(nullptr)
+    , _capture(nullptr)
     , _is_connected(false)
     , _callbacks{}
-    , _last_connection_attempt_time(steady_clock::duration::zero()) {}
+    , _connect_backoff(nullptr)
+    , _is_live_state_delta_enabled(false)
+    , _has_sent_features(false)
+    , _live_state(nullptr)
+    , _has_live_state(false) {}
 
 Client::~Client() {
     shutdown();
+    disable_capture();
 }
 
-OneError Client::init(const char *address, unsigned int port) {
+OneError Client::init(const char *address, unsigned int port,
+                      const ConnectionOptions &options) {
     const std::lock_guard<std::mutex> lock(_client);
 
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
+    }
+
     _server_address = address;
     _server_port = port;
+    _server_path.clear();
+    return init_endpoint(options);
+}
+
+OneError Client::init_local(const char *path, const ConnectionOptions &options) {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (std::strlen(path) >= Socket::local_path_size) {
+        return ONE_ERROR_SOCKET_PATH_TOO_LONG;
+    }
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
+    }
+
+    _server_address.clear();
+    _server_port = 0;
+    _server_path = path;
+    return init_endpoint(options);
+}
+
+OneError Client::init_transport(Transport &transport, const ConnectionOptions &options) {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
+    }
+    if (_connection != nullptr) {
+        return ONE_ERROR_VALIDATION_CONNECTION_IS_NULLPTR;
+    }
+    if (!transport.is_initialized()) {
+        return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    }
+
+    auto err = init_socket_system();
+    if (is_error(err)) {
+        return err;
+    }
 
+    _connection = allocator::create<Connection>(options);
+    if (_connection == nullptr) {
+        shutdown_locked();
+        return ONE_ERROR_VALIDATION_CONNECTION_IS_NULLPTR;
+    }
+    _connection->set_capture(_capture);
+
+    _transport = &transport;
+    _connection->init(transport);
+    _is_connected = true;
+    return ONE_ERROR_NONE;
+}
+
+OneError Client::init_endpoint(const ConnectionOptions &options) {
     if (_socket != nullptr) {
         return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
     }
@@ -54,44 +134,136 @@ OneError Client::init(const char *address, unsigned int port) {
         return err;
     }
 
+    // Those of kernel liveness apply once the server agrees.
+    _socket_options = options.applied_socket_options(Liveness::health_messages);
+    _kernel_socket_options = options.applied_socket_options(Liveness::kernel);
+    if (options.health.liveness == Liveness::kernel && _server_path.empty() &&
+        !Socket::is_supported(_kernel_socket_options)) {
+        shutdown_locked();
+        return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
+    }
+    _connect_backoff = allocator::create<Backoff>(options.retry);
+    if (_connect_backoff == nullptr) {
+        shutdown_locked();
+        return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
+    }
     _socket = allocator::create<Socket>();
     if (_socket == nullptr) {
-        shutdown();
+        shutdown_locked();
         return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
     }
 
-    err = _socket->init();
+    err = init_socket();
     if (is_error(err)) {
-        shutdown();
+        shutdown_locked();
         return err;
     }
 
-    const auto max_incoming = Connection::max_message_default;
-    const auto max_outgoing = Connection::max_message_default;
-    _connection = allocator::create<Connection>(max_incoming, max_outgoing);
+    _connection = allocator::create<Connection>(options);
     if (_connection == nullptr) {
-        shutdown();
+        shutdown_locked();
         return ONE_ERROR_VALIDATION_CONNECTION_IS_NULLPTR;
     }
+    _connection->set_capture(_capture);
+
+    // Falls back to select where io_uring is unavailable.
+    if (options.io_backend == IoBackend::io_uring && IoUringTransport::is_supported()) {
+        _io_uring = allocator::create<IoUringTransport>();
+        if (_io_uring == nullptr) {
+            shutdown_locked();
+            return ONE_ERROR_VALIDATION_SOCKET_IS_NULLPTR;
+        }
+        if (is_error(_io_uring->init())) {
+            allocator::destroy<IoUringTransport>(_io_uring);
+            _io_uring = nullptr;
+        }
+    }
 
     return ONE_ERROR_NONE;
 }
 
+OneError Client::enable_capture(const char *path, size_t max_file_size,
+                                size_t max_files) {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (_capture != nullptr) {
+        return ONE_ERROR_CAPTURE_ALREADY_OPEN;
+    }
+
+    _capture = allocator::create<CaptureWriter>();
+    if (_capture == nullptr) {
+        return ONE_ERROR_CAPTURE_ALLOCATION_FAILED;
+    }
+
+    auto err = _capture->open(path, max_file_size, max_files);
+    if (is_error(err)) {
+        allocator::destroy<CaptureWriter>(_capture);
+        _capture = nullptr;
+        return err;
+    }
+
+    if (_connection != nullptr) {
+        _connection->set_capture(_capture);
+    }
+    return ONE_ERROR_NONE;
+}
+
+void Client::disable_capture() {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (_capture == nullptr) {
+        return;
+    }
+
+    if (_connection != nullptr) {
+        _connection->set_capture(nullptr);
+    }
+    allocator::destroy<CaptureWriter>(_capture);
+    _capture = nullptr;
+}
+
 void Client::shutdown() {
     const std::lock_guard<std::mutex> lock(_client);
+    shutdown_locked();
+    json::flush();
+}
 
+void Client::shutdown_locked() {
     _is_connected = false;
 
+    // Before the socket, which it reads and writes.
+    if (_io_uring != nullptr) {
+        allocator::destroy<IoUringTransport>(_io_uring);
+        _io_uring = nullptr;
+    }
+
     if (_socket != nullptr) {
         allocator::destroy<Socket>(_socket);
         _socket = nullptr;
     }
+    // Owned by the caller of init_transport.
+    _transport = nullptr;
 
     if (_connection != nullptr) {
         allocator::destroy<Connection>(_connection);
         _connection = nullptr;
     }
 
+    if (_connect_backoff != nullptr) {
+        allocator::destroy<Backoff>(_connect_backoff);
+        _connect_backoff = nullptr;
+    }
+
+    if (_live_state != nullptr) {
+        allocator::destroy<Message>(_live_state);
+        _live_state = nullptr;
+    }
+    _has_live_state = false;
+    _has_sent_features = false;
+
     shutdown_socket_system();
 
     // See: https://en.cppreference.com/w/cpp/language/value_initialization
@@ -106,15 +278,16 @@ OneError Client::update() {
         return ONE_ERROR_CLIENT_NOT_INITIALIZED;
     }
     assert(_connection != nullptr);
-    assert(_socket != nullptr);
+    assert(_transport != nullptr || _socket != nullptr);
 
-    // If not connected, attempt to connect at an interval.
+    // A failed transport is not reconnected.
+    if (!_is_connected && _transport != nullptr) {
+        return ONE_ERROR_NONE;
+    }
+
+    // If not connected, attempt to connect, backing off while it fails.
     if (!_is_connected) {
-        const auto now = steady_clock::now();
-        const size_t delta =
-            duration_cast<seconds>(now - _last_connection_attempt_time).count();
-        if (delta > connection_retry_delay_seconds) {
-            _last_connection_attempt_time = now;
+        if (_connect_backoff->update()) {
             auto error = connect();
             // If connection fails, then nothing else to update. Return the error.
             if (is_error(error)) {
@@ -130,26 +303,69 @@ OneError Client::update() {
 #ifdef ONE_ARCUS_CLIENT_LOGGING
         String ip;
         unsigned int port;
-        _socket->address(ip, port);
+        if (_transport != nullptr) {
+            _transport->address(ip, port);
+        } else {
+            _socket->address(ip, port);
+        }
         std::cout << "ip: " << ip << ", port: " << port << ", closing client"
                   << std::endl;
 #endif
 
-        _connection->shutdown();
-        _socket->close();
+        // The session is kept for the next connection to resume, if enabled.
+        _connection->suspend();
         _is_connected = false;
-        _last_connection_attempt_time =
-            steady_clock::time_point(steady_clock::duration::zero());
-        _socket->init();
+        if (_transport != nullptr) {
+            return passthrough_err;
+        }
+        if (_io_uring != nullptr) {
+            _io_uring->detach();
+        }
+        _socket->close();
+        init_socket();
         return passthrough_err;
     };
 
+    const bool was_ready = _connection->status() == Connection::Status::ready;
     auto err = _connection->update();
     // In the case of any error, reset the socket for reconnection attempt.
     if (is_error(err)) {
         return close_client(err);
     }
 
+    // Once connected, a dropped connection is retried immediately. Unless the
+    // session was resumed, the features are negotiated again and the server
+    // sends its state in full.
+    if (!was_ready && _connection->status() == Connection::Status::ready) {
+        if (_connect_backoff != nullptr) {
+            _connect_backoff->reset();
+        }
+        if (_transport == nullptr && _connection->liveness() == Liveness::kernel) {
+            err = _socket->set_options(_kernel_socket_options);
+            if (is_error(err)) {
+                return close_client(err);
+            }
+        }
+        if (!_connection->is_resumed()) {
+            _has_sent_features = false;
+            _has_live_state = false;
+        }
+    }
+
+    if (_is_live_state_delta_enabled && !_has_sent_features &&
+        _connection->status() == Connection::Status::ready) {
+        Message message;
+        err = messages::prepare_features(true, message);
+        if (is_error(err)) {
+            return err;
+        }
+        err = process_outgoing_message(message);
+        if (is_error(err)) {
+            return close_client(err);
+        }
+        _has_sent_features = true;
+    }
+
     // Read pending incoming messages.
     while (true) {
         unsigned int count = 0;
@@ -162,6 +378,12 @@ OneError Client::update() {
         if (is_error(err)) return close_client(err);
     }
 
+    if (_connection->take_writable() && _callbacks._writable) {
+        // Unlocked so that the callback can send messages.
+        const ReverseLockGuard<std::mutex> reverse_lock(_client);
+        _callbacks._writable(_callbacks._writable_userdata);
+    }
+
     return ONE_ERROR_NONE;
 }
 
@@ -188,14 +410,18 @@ Client::Status Client::status() const {
         return Status::uninitialized;
     }
     if (!_is_connected) {
-        return Status::connecting;
+        // A failed transport is not reconnected.
+        return _transport != nullptr ? Status::error : Status::connecting;
     }
 
     const auto status = _connection->status();
     switch (status) {
         case Connection::Status::handshake_not_started:
+        case Connection::Status::handshake_hello_received:
         case Connection::Status::handshake_hello_scheduled:
         case Connection::Status::handshake_hello_sent:
+        case Connection::Status::handshake_shared_memory:
+        case Connection::Status::handshake_session:
             return Status::handshake;
         case Connection::Status::ready:
             return Status::ready;
@@ -283,13 +509,13 @@ OneError Client::send_custom_command(Array &data) {
 }
 
 OneError Client::set_live_state_callback(
-    std::function<void(void *, int, int, const String &, const String &, const String &,
-                       const String &)>
+    Callback<void(void *, int, int, const String &, const String &, const String &,
+                  const String &)>
         callback,
     void *userdata) {
     const std::lock_guard<std::mutex> lock(_client);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
@@ -299,10 +525,10 @@ OneError Client::set_live_state_callback(
 }
 
 OneError Client::set_reverse_metadata_callback(
-    std::function<void(void *, Array *)> callback, void *userdata) {
+    Callback<void(void *, Array *)> callback, void *userdata) {
     const std::lock_guard<std::mutex> lock(_client);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
@@ -312,10 +538,10 @@ OneError Client::set_reverse_metadata_callback(
 }
 
 OneError Client::set_application_instance_status_callback(
-    std::function<void(void *, int)> callback, void *userdata) {
+    Callback<void(void *, int)> callback, void *userdata) {
     const std::lock_guard<std::mutex> lock(_client);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
     }
 
@@ -324,24 +550,148 @@ OneError Client::set_application_instance_status_callback(
     return ONE_ERROR_NONE;
 }
 
+void Client::set_live_state_delta(bool enabled) {
+    const std::lock_guard<std::mutex> lock(_client);
+    _is_live_state_delta_enabled = enabled;
+}
+
+OneError Client::set_outgoing_policy(Opcode code, Priority priority,
+                                     bool replace_in_queue) {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (_connection == nullptr) {
+        return ONE_ERROR_CLIENT_NOT_INITIALIZED;
+    }
+
+    return _connection->set_outgoing_policy(code, priority, replace_in_queue);
+}
+
+OneError Client::queue_pressure(QueuePressure &pressure) const {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (_connection == nullptr) {
+        return ONE_ERROR_CLIENT_NOT_INITIALIZED;
+    }
+
+    // The incoming count is left at zero while not connected.
+    unsigned int incoming = 0;
+    _connection->incoming_count(incoming);
+    pressure.incoming = incoming;
+    pressure.incoming_capacity = _connection->incoming_capacity();
+    for (size_t i = 0; i < priority_count; ++i) {
+        pressure.outgoing[i] = _connection->outgoing_count(static_cast<Priority>(i));
+    }
+    pressure.outgoing_capacity = _connection->outgoing_capacity();
+    pressure.is_reading_paused = _connection->is_reading_paused();
+    return ONE_ERROR_NONE;
+}
+
+OneError Client::memory_footprint(MemoryFootprint &footprint) const {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (_connection == nullptr) {
+        return ONE_ERROR_CLIENT_NOT_INITIALIZED;
+    }
+
+    footprint = MemoryFootprint();
+    footprint.instance = sizeof(Client);
+    if (_socket != nullptr) {
+        footprint.instance += sizeof(Socket) + sizeof(Backoff);
+    }
+    if (_capture != nullptr) {
+        footprint.instance += sizeof(CaptureWriter);
+    }
+    if (_io_uring != nullptr) {
+        footprint.instance += sizeof(IoUringTransport);
+        footprint.streams += _io_uring->footprint();
+    }
+    _connection->footprint(footprint);
+    if (_live_state != nullptr) {
+        footprint.state += sizeof(Message) + _live_state->footprint();
+    }
+
+    footprint.json_cache = json::cached_size();
+    return ONE_ERROR_NONE;
+}
+
+IoBackend Client::io_backend() const {
+    const std::lock_guard<std::mutex> lock(_client);
+    return _io_uring != nullptr ? IoBackend::io_uring : IoBackend::select;
+}
+
+bool Client::is_shared_memory() const {
+    const std::lock_guard<std::mutex> lock(_client);
+    return _connection != nullptr && _connection->is_shared_memory();
+}
+
+OneError Client::set_writable_callback(Callback<void(void *)> callback,
+                                       void *userdata) {
+    const std::lock_guard<std::mutex> lock(_client);
+
+    if (!callback) {
+        return ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR;
+    }
+
+    _callbacks._writable = callback;
+    _callbacks._writable_userdata = userdata;
+    return ONE_ERROR_NONE;
+}
+
+OneError Client::process_live_state(const Message &message) {
+    if (_is_live_state_delta_enabled) {
+        // Kept for the deltas that follow.
+        if (_live_state == nullptr) {
+            _live_state = allocator::create<Message>();
+            if (_live_state == nullptr) {
+                return ONE_ERROR_MESSAGE_ALLOCATION_FAILED;
+            }
+        }
+        *_live_state = message;
+        _has_live_state = true;
+    }
+
+    if (!_callbacks._live_state) {
+        return ONE_ERROR_NONE;
+    }
+
+    return invocation::live_state(message, _callbacks._live_state,
+                                  _callbacks._live_state_userdata);
+}
+
+OneError Client::process_live_state_delta(const Message &message) {
+    if (_live_state == nullptr || !_has_live_state) {
+        return ONE_ERROR_MESSAGE_LIVE_STATE_DELTA_WITHOUT_SNAPSHOT;
+    }
+
+    auto err = _live_state->payload().apply_delta(message.payload(),
+                                                  messages::live_state_removed_key);
+    if (is_error(err)) {
+        return err;
+    }
+
+    if (!_callbacks._live_state) {
+        return ONE_ERROR_NONE;
+    }
+
+    return invocation::live_state(*_live_state, _callbacks._live_state,
+                                  _callbacks._live_state_userdata);
+}
+
 OneError Client::process_incoming_message(const Message &message) {
     switch (message.code()) {
         case Opcode::live_state:
-            if (_callbacks._live_state == nullptr) {
-                return ONE_ERROR_NONE;
-            }
-
-            return invocation::live_state(message, _callbacks._live_state,
-                                          _callbacks._live_state_userdata);
+            return process_live_state(message);
+        case Opcode::live_state_delta:
+            return process_live_state_delta(message);
         case Opcode::reverse_metadata:
-            if (_callbacks._reverse_metadata == nullptr) {
+            if (!_callbacks._reverse_metadata) {
                 return ONE_ERROR_NONE;
             }
 
             return invocation::reverse_metadata(message, _callbacks._reverse_metadata,
                                                 _callbacks._reverse_metadata_userdata);
         case Opcode::application_instance_status:
-            if (_callbacks._application_instance_status == nullptr) {
+            if (!_callbacks._application_instance_status) {
                 return ONE_ERROR_NONE;
             }
 
@@ -410,6 +760,15 @@ OneError Client::process_outgoing_message(const Message &message) {
 
             break;
         }
+        case Opcode::features: {
+            params::FeaturesRequest params;
+            err = validation::features(message, params);
+            if (is_error(err)) {
+                return err;
+            }
+
+            break;
+        }
         default:
             return ONE_ERROR_NONE;
     }
@@ -431,6 +790,14 @@ OneError Client::process_outgoing_message(const Message &message) {
     return ONE_ERROR_NONE;
 }
 
+OneError Client::init_socket() {
+    auto err = _server_path.empty() ? _socket->init() : _socket->init_local();
+    if (is_error(err)) {
+        return err;
+    }
+    return _socket->set_options(_socket_options);
+}
+
 OneError Client::connect() {
     if (!is_initialized()) {
         return ONE_ERROR_CLIENT_NOT_INITIALIZED;
@@ -442,12 +809,18 @@ OneError Client::connect() {
         return ONE_ERROR_CLIENT_NOT_INITIALIZED;
     }
 
-    auto err = _socket->connect(_server_address.c_str(), _server_port);
+    auto err = _server_path.empty()
+                   ? _socket->connect(_server_address.c_str(), _server_port)
+                   : _socket->connect_local(_server_path.c_str());
     if (is_error(err)) {
         return err;
     }
 
-    _connection->init(*_socket);
+    if (_io_uring != nullptr && !is_error(_io_uring->attach(*_socket))) {
+        _connection->init(*_io_uring);
+    } else {
+        _connection->init(*_socket);
+    }
     _is_connected = true;
     return ONE_ERROR_NONE;
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <chrono>
-#include <functional>
 #include <mutex>
 
+#include <one/arcus/callback.h>
 #include <one/arcus/error.h>
+#include <one/arcus/opcode.h>
+#include <one/arcus/options.h>
 #include <one/arcus/types.h>
 
 using namespace std::chrono;
@@ -13,20 +15,29 @@ namespace i3d {
 namespace one {
 
 class Array;
-class Connection;
+class Backoff;
+class CaptureWriter;
+struct DefaultConnectionPolicy;
+template <class Policy>
+class BasicConnection;
+using Connection = BasicConnection<DefaultConnectionPolicy>;
+class IoUringTransport;
 class Message;
 class Object;
 class Socket;
+class Transport;
 
 struct ClientCallbacks {
-    std::function<void(void *, int, int, const String &, const String &, const String &,
-                       const String &)>
+    Callback<void(void *, int, int, const String &, const String &, const String &,
+                  const String &)>
         _live_state;
     void *_live_state_userdata;
-    std::function<void(void *, Array *)> _reverse_metadata;
+    Callback<void(void *, Array *)> _reverse_metadata;
     void *_reverse_metadata_userdata;
-    std::function<void(void *, int)> _application_instance_status;
+    Callback<void(void *, int)> _application_instance_status;
     void *_application_instance_status_userdata;
+    Callback<void(void *)> _writable;
+    void *_writable_userdata;
 };
 
 // The Arcus Client is used by an Arcus One Agent to connect to an Arcus Server.
@@ -37,8 +48,30 @@ public:
     Client &operator=(const Client &) = delete;
     ~Client();
 
-    OneError init(const char *address, unsigned int port);
+    // The options size the queues and stream buffers of the connection and
+    // tune its socket, ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID is returned if
+    // they are not valid.
+    OneError init(const char *address, unsigned int port,
+                  const ConnectionOptions &options = ConnectionOptions());
+    // Same as init, connecting to a server listening on a Unix domain socket
+    // at path, see Server::init_local.
+    OneError init_local(const char *path,
+                        const ConnectionOptions &options = ConnectionOptions());
+    // Same as init, over a transport already connected to the server, see
+    // Server::init_transport. Once the connection fails, the status is error
+    // until shutdown.
+    OneError init_transport(Transport &transport,
+                            const ConnectionOptions &options = ConnectionOptions());
+    // Also releases the JSON blocks cached for reuse by the calling thread.
     void shutdown();
+
+    // Records every Arcus frame exchanged with the server into a capture file
+    // at path. The file is rotated once it exceeds max_file_size bytes, keeping
+    // at most max_files files. Capturing stays enabled across reconnections and
+    // shutdown until disabled.
+    OneError enable_capture(const char *path, size_t max_file_size, size_t max_files);
+    // Flushes and closes the capture file, if any.
+    void disable_capture();
     OneError update();
 
     enum class Status { uninitialized, connecting, handshake, ready, error };
@@ -46,6 +79,34 @@ public:
 
     Status status() const;
 
+    // When enabled, the client offers live state deltas to the server once
+    // connected. If the server accepts, live states are received as deltas and
+    // merged into the last full state before calling the live state callback.
+    // Disabled by default, as servers that predate it close the connection.
+    void set_live_state_delta(bool enabled);
+
+    // Sets the priority class of outgoing messages with the opcode, and whether
+    // a queued one is replaced by a newer one instead of being queued after it.
+    // See default_priority and default_replace_in_queue for the defaults. Must
+    // be called after init, and is kept across connections until shutdown.
+    OneError set_outgoing_policy(Opcode code, Priority priority, bool replace_in_queue);
+
+    // Reports the fill levels of the message queues of the connection. Must
+    // be called after init.
+    OneError queue_pressure(QueuePressure &pressure) const;
+
+    // Reports the memory held by the client, see MemoryFootprint. Must be
+    // called after init.
+    OneError memory_footprint(MemoryFootprint &footprint) const;
+
+    // The backend reading and writing the socket. IoBackend::select until
+    // init, or if io_uring was requested but is unavailable.
+    IoBackend io_backend() const;
+
+    // Whether messages go through shared memory with the server instead of
+    // the socket. See ConnectionOptions::shared_memory_capacity.
+    bool is_shared_memory() const;
+
     //-------------------
     // Outgoing Messages.
 
@@ -64,8 +125,8 @@ public:
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
     OneError set_live_state_callback(
-        std::function<void(void *, int, int, const String &, const String &,
-                           const String &, const String &)>
+        Callback<void(void *, int, int, const String &, const String &,
+                      const String &, const String &)>
             callback,
         void *userdata);
 
@@ -73,7 +134,7 @@ public:
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_reverse_metadata_callback(std::function<void(void *, Array *)> callback,
+    OneError set_reverse_metadata_callback(Callback<void(void *, Array *)> callback,
                                            void *userdata);
 
     // set the callback for when an application_instance_status message in
@@ -81,10 +142,17 @@ public:
     // argument of the callback when invoked. The `data` can be nullptr, the callback is
     // responsible to use the data properly.
     OneError set_application_instance_status_callback(
-        std::function<void(void *, int)> callback, void *userdata);
+        Callback<void(void *, int)> callback, void *userdata);
+
+    // set the callback for when outgoing messages can be sent again, once the
+    // queue of a priority class that rejected a send has drained to half of
+    // its capacity. It is invoked during update without the client lock held.
+    OneError set_writable_callback(Callback<void(void *)> callback, void *userdata);
 
 private:
     OneError process_incoming_message(const Message &message);
+    OneError process_live_state(const Message &message);
+    OneError process_live_state_delta(const Message &message);
     // The server must have an active and ready listen connection in order to
     // send outgoing messages. If not, either ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR or
     // ONE_ERROR_SERVER_CONNECTION_NOT_READY is returned and the message is
@@ -92,21 +160,40 @@ private:
     OneError process_outgoing_message(const Message &message);
 
     bool is_initialized() const {
-        return _socket != nullptr;
+        return _socket != nullptr || _transport != nullptr;
     }
 
+    // Creates the socket and connection, after the endpoint is set.
+    OneError init_endpoint(const ConnectionOptions &options);
+    // Shutdown, with the client mutex held.
+    void shutdown_locked();
+    // Initializes the socket for the endpoint, TCP or Unix domain, and applies
+    // the socket options.
+    OneError init_socket();
     OneError connect();
 
     mutable std::mutex _client;
 
     String _server_address;
     unsigned int _server_port;
+    String _server_path;  // Unix domain socket path, empty when using TCP.
 
     Socket *_socket;
+    SocketOptions _socket_options;
+    SocketOptions _kernel_socket_options;  // Once kernel liveness is agreed.
     Connection *_connection;
+    IoUringTransport *_io_uring;  // Null unless the io_uring backend is used.
+    Transport *_transport;        // Set by init_transport, instead of the socket.
+    CaptureWriter *_capture;
     bool _is_connected;
     ClientCallbacks _callbacks;
-    steady_clock::time_point _last_connection_attempt_time;
+    Backoff *_connect_backoff;  // Delays connecting again after a failure.
+
+    bool _is_live_state_delta_enabled;
+    bool _has_sent_features;
+    // Full live state that deltas are merged into, created on first use.
+    Message *_live_state;
+    bool _has_live_state;
 };
 
 }  // namespace one
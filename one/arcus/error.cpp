@@ -56,6 +56,13 @@ const char *error_text(OneError err) {
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_UNKNOWN_STATUS)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_UPDATE_AFTER_ERROR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_UPDATE_READY_FAIL)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_PRIORITY_IS_INVALID)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_QUEUE_ALLOCATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_SESSION_RECEIVE_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_SESSION_SEND_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_SHARED_MEMORY_RECEIVE_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CONNECTION_SHARED_MEMORY_SEND_FAILED)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_MESSAGE_ALLOCATION_FAILED)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_MESSAGE_IS_NULLPTR)},
@@ -79,6 +86,10 @@ const char *error_text(OneError err) {
             ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_REVERSE_METADATA)},
         {ONE_SYMBOL_STRING_PAIR(
             ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_CUSTOM_COMMAND)},
+        {ONE_SYMBOL_STRING_PAIR(
+            ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_LIVE_STATE_DELTA)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_FEATURES)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_MESSAGE_LIVE_STATE_DELTA_WITHOUT_SNAPSHOT)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_OBJECT_ALLOCATION_FAILED)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_OBJECT_KEY_NOT_FOUND)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_OBJECT_KEY_IS_NULLPTR)},
@@ -127,6 +138,10 @@ const char *error_text(OneError err) {
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_SOCKET_OPTIONS_FAILED)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_SYSTEM_CLEANUP_FAIL)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_SYSTEM_INIT_FAIL)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_PATH_TOO_LONG)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_OPTION_UNSUPPORTED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_SOCKET_ADDRESS_INVALID)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_ARRAY_IS_NULLPTR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_CALLBACK_IS_NULLPTR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_CAPACITY_IS_NULLPTR)},
@@ -149,7 +164,38 @@ const char *error_text(OneError err) {
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_SIZE_IS_NULLPTR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_VAL_IS_NULLPTR)},
         {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_VAL_SIZE_IS_TOO_SMALL)},
-        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR)}};
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_PATH_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_STATISTICS_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_CATEGORY_IS_INVALID)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_QUEUE_PRESSURE_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_FOOTPRINT_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_IO_BACKEND_IS_NULLPTR)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_LOGGER_ALREADY_INITIALIZED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_LOGGER_CAPACITY_IS_ZERO)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_LOGGER_ALLOCATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_ALLOCATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_ALREADY_OPEN)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_INVALID_FILE)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_NOT_OPEN)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_OPEN_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_ROTATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_CAPTURE_WRITE_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_UNSUPPORTED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_NOT_INITIALIZED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_CREATE_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_OPEN_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_INVALID_REGION)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_PEER_CLOSED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_WAIT_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_ALLOCATION_FAILED)},
+        {ONE_SYMBOL_STRING_PAIR(ONE_ERROR_TRANSPORT_SUBMIT_FAILED)}};
     auto it = lookup.find(err);
     if (it == lookup.end()) {
         return "";
@@ -8,8 +8,14 @@
 namespace i3d {
 namespace one {
 
-Accumulator::Accumulator(size_t capacity) : _capacity(capacity), _size(0) {
-    void *p = allocator::alloc(sizeof(char) * capacity);
+Accumulator::Accumulator(size_t capacity) : Accumulator(capacity, capacity) {}
+
+Accumulator::Accumulator(size_t initial_capacity, size_t max_capacity)
+    : _capacity(max_capacity), _reserved(initial_capacity), _size(0) {
+    assert(initial_capacity > 0);
+    assert(initial_capacity <= max_capacity);
+    void *p = allocator::alloc(sizeof(char) * initial_capacity,
+                               allocator::Category::connection);
     assert(p);
     _buffer = reinterpret_cast<char *>(p);
 }
@@ -21,16 +27,37 @@ Accumulator::~Accumulator() {
     }
 }
 
-void Accumulator::put(const void *data, size_t length) {
+bool Accumulator::put(const void *data, size_t length) {
     if (_buffer == nullptr) {
-        return;
+        return false;
     }
     if (length == 0) {
-        return;
+        return true;
     }
     assert(_size + length <= _capacity);
+
+    const size_t needed = _size + length;
+    if (needed > _reserved) {
+        size_t reserved = _reserved;
+        while (reserved < needed) {
+            reserved *= 2;
+        }
+        if (reserved > _capacity) {
+            reserved = _capacity;
+        }
+
+        void *p = allocator::realloc(_buffer, sizeof(char) * reserved,
+                                     allocator::Category::connection);
+        if (p == nullptr) {
+            return false;
+        }
+        _buffer = reinterpret_cast<char *>(p);
+        _reserved = reserved;
+    }
+
     memcpy(_buffer + _size, data, length);
     _size += length;
+    return true;
 }
 
 void Accumulator::peek(size_t length, void **data) {
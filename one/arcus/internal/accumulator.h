@@ -1,20 +1,32 @@
 #pragma once
 
+#include <assert.h>
 #include <stddef.h>
+#include <array>
+#include <cstring>
 
 namespace i3d {
 namespace one {
 
-// Accumulator is fixed-size buffer for accumulating byte data.
+// Accumulator is a bounded buffer for accumulating byte data.
 // It adds new data to the end, and removes data from the front.
 class Accumulator final {
 public:
+    // A buffer of a fixed size.
     Accumulator(size_t capacity);
+    // A buffer allocated with initial_capacity bytes and doubling in size as
+    // needed when data is put, up to max_capacity.
+    Accumulator(size_t initial_capacity, size_t max_capacity);
     ~Accumulator();
 
+    // The maximum number of bytes the buffer can hold.
     size_t capacity() const {
         return _capacity;
     }
+    // The number of bytes currently allocated.
+    size_t reserved() const {
+        return _reserved;
+    }
     size_t size() const {
         return _size;
     }
@@ -23,9 +35,10 @@ public:
         trim(size());
     };
 
-    // Copies the given data and adds it to the stream. length must be less than
-    // or equal to capacity - size.
-    void put(const void *data, size_t length);
+    // Copies the given data and adds it to the stream, growing the buffer if
+    // needed. length must be less than or equal to capacity - size. Returns
+    // false if the buffer could not be grown, in which case nothing is added.
+    bool put(const void *data, size_t length);
 
     // Provides a pointer to data from the beginning of the stream. Sets the
     // given data pointer to the data. length must be <= size.
@@ -44,6 +57,62 @@ private:
 
     char *_buffer;
     size_t _capacity;
+    size_t _reserved;
+    size_t _size;
+};
+
+// Accumulator of a fixed capacity known at compile time, held inline. It needs
+// no allocation, so that put only checks the capacity in debug builds. The
+// capacities given to the constructors are ignored.
+template <size_t Capacity>
+class InlineAccumulator final {
+public:
+    explicit InlineAccumulator(size_t) : _size(0) {}
+    InlineAccumulator(size_t, size_t) : _size(0) {}
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+    // Part of the owner, nothing is allocated.
+    size_t reserved() const {
+        return 0;
+    }
+    size_t size() const {
+        return _size;
+    }
+
+    void clear() {
+        _size = 0;
+    }
+
+    // length must be less than or equal to capacity - size.
+    bool put(const void *data, size_t length) {
+        assert(_size + length <= Capacity);
+        std::memcpy(_buffer.data() + _size, data, length);
+        _size += length;
+        return true;
+    }
+    void peek(size_t length, void **data) {
+        assert(data);
+        assert(length <= _size);
+        (void)length;
+        *data = _buffer.data();
+    }
+    void trim(size_t length) {
+        assert(length <= _size);
+        std::memmove(_buffer.data(), _buffer.data() + length, _size - length);
+        _size -= length;
+    }
+    void get(size_t length, void **data) {
+        peek(length, data);
+        trim(length);
+    }
+
+private:
+    InlineAccumulator() = delete;
+    InlineAccumulator(InlineAccumulator &other) = delete;
+
+    std::array<char, Capacity> _buffer;
     size_t _size;
 };
 
@@ -0,0 +1,204 @@
+#include <one/arcus/internal/async_logger.h>
+
+#include <one/arcus/allocator.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+namespace i3d {
+namespace one {
+
+namespace {
+
+// Upper bound on how long a pushed record waits for the drain thread if its
+// wake up notification is missed.
+constexpr std::chrono::milliseconds drain_poll_interval(10);
+
+size_t round_up_to_power_of_two(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+AsyncLogger::AsyncLogger()
+    : _records(nullptr)
+    , _mask(0)
+    , _enqueue_position(0)
+    , _dequeue_position(0)
+    , _dropped(0)
+    , _forwarded(0)
+    , _is_running(false) {}
+
+AsyncLogger::~AsyncLogger() {
+    shutdown();
+}
+
+OneError AsyncLogger::init(const Logger &sink, size_t capacity) {
+    if (_records != nullptr) {
+        return ONE_ERROR_LOGGER_ALREADY_INITIALIZED;
+    }
+    if (capacity == 0) {
+        return ONE_ERROR_LOGGER_CAPACITY_IS_ZERO;
+    }
+
+    capacity = round_up_to_power_of_two(capacity);
+    _records = allocator::create_array<Record>(capacity);
+    if (_records == nullptr) {
+        return ONE_ERROR_LOGGER_ALLOCATION_FAILED;
+    }
+    _mask = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+        _records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _enqueue_position.store(0, std::memory_order_relaxed);
+    _dequeue_position.store(0, std::memory_order_relaxed);
+
+    {
+        const std::lock_guard<std::mutex> lock(_sink_mutex);
+        _sink = sink;
+    }
+
+    _is_running = true;
+    _thread = std::thread(&AsyncLogger::drain_loop, this);
+    return ONE_ERROR_NONE;
+}
+
+void AsyncLogger::shutdown() {
+    if (_records == nullptr) {
+        return;
+    }
+
+    _is_running = false;
+    _wake.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+
+    allocator::destroy_array<Record>(_records);
+    _records = nullptr;
+    _mask = 0;
+}
+
+void AsyncLogger::set_sink(const Logger &sink) {
+    const std::lock_guard<std::mutex> lock(_sink_mutex);
+    _sink = sink;
+}
+
+Logger AsyncLogger::front() const {
+    auto fn = [](void *userdata, LogLevel level, const String &message) {
+        auto async_logger = reinterpret_cast<AsyncLogger *>(userdata);
+        async_logger->push(level, message);
+    };
+    Logger logger(fn, const_cast<AsyncLogger *>(this));
+    {
+        const std::lock_guard<std::mutex> lock(_sink_mutex);
+        logger.set_level(_sink.level());
+    }
+    return logger;
+}
+
+bool AsyncLogger::push(LogLevel level, const String &message) {
+    if (_records == nullptr) {
+        return false;
+    }
+
+    // Bounded multi-producer queue: a producer claims a slot by advancing the
+    // enqueue position, fills it and then publishes it through the slot
+    // sequence number.
+    Record *record = nullptr;
+    size_t position = _enqueue_position.load(std::memory_order_relaxed);
+    while (true) {
+        record = &_records[position & _mask];
+        const size_t sequence = record->sequence.load(std::memory_order_acquire);
+        const auto difference =
+            static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0) {
+            if (_enqueue_position.compare_exchange_weak(position, position + 1,
+                                                        std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // Full.
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = _enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t length =
+        message.size() < max_record_length ? message.size() : max_record_length;
+    record->level = level;
+    record->length = length;
+    std::memcpy(record->text, message.data(), length);
+    record->sequence.store(position + 1, std::memory_order_release);
+
+    _wake.notify_one();
+    return true;
+}
+
+void AsyncLogger::flush() {
+    if (_records == nullptr || !_is_running) {
+        return;
+    }
+
+    const size_t target = _enqueue_position.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    while (_forwarded.load(std::memory_order_acquire) < target) {
+        _wake.notify_one();
+        _drained.wait_for(lock, drain_poll_interval);
+    }
+}
+
+size_t AsyncLogger::dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogger::pop_and_forward() {
+    // Single consumer: only the drain thread reads from the ring.
+    const size_t position = _dequeue_position.load(std::memory_order_relaxed);
+    Record &record = _records[position & _mask];
+    const size_t sequence = record.sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1) {
+        return false;
+    }
+
+    const LogLevel level = record.level;
+    const String message(record.text, record.length);
+    record.sequence.store(position + _mask + 1, std::memory_order_release);
+    _dequeue_position.store(position + 1, std::memory_order_relaxed);
+
+    {
+        const std::lock_guard<std::mutex> lock(_sink_mutex);
+        _sink.Log(level, message);
+    }
+    _forwarded.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+void AsyncLogger::drain_loop() {
+    while (true) {
+        while (pop_and_forward()) {
+        }
+
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _drained.notify_all();
+        if (!_is_running) {
+            break;
+        }
+        _wake.wait_for(lock, drain_poll_interval);
+    }
+
+    // Forward anything pushed while stopping.
+    while (pop_and_forward()) {
+    }
+    _drained.notify_all();
+}
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <one/arcus/error.h>
+#include <one/arcus/logger.h>
+
+namespace i3d {
+namespace one {
+
+// Asynchronous front for a Logger. Log calls copy the level and the text
+// (truncated to a fixed size) into a record of a bounded lock-free ring and
+// return immediately. A background thread drains the ring and forwards the
+// records to the wrapped sink logger, in order.
+//
+// When the ring is full, records are dropped and counted rather than blocking
+// the caller.
+class AsyncLogger final {
+public:
+    // Must be a power of two.
+    static constexpr size_t default_capacity = 256;
+    // Longer messages are truncated.
+    static constexpr size_t max_record_length = 512;
+
+    AsyncLogger();
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+    ~AsyncLogger();
+
+    // Allocates the ring and starts the drain thread. The capacity is rounded
+    // up to a power of two.
+    OneError init(const Logger &sink, size_t capacity = default_capacity);
+
+    // Drains all pending records and stops the drain thread.
+    void shutdown();
+
+    // Replaces the logger that the drain thread forwards records to.
+    void set_sink(const Logger &sink);
+
+    // Returns a Logger that enqueues into this instance. The returned logger
+    // keeps the level of the sink logger. Must not outlive this instance.
+    Logger front() const;
+
+    // Copies the message into the ring. Lock-free and safe to call from any
+    // thread. Returns false if the record was dropped.
+    bool push(LogLevel level, const String &message);
+
+    // Blocks until every record pushed before the call has been forwarded.
+    void flush();
+
+    // Number of records dropped because the ring was full.
+    size_t dropped() const;
+
+private:
+    struct Record {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        size_t length;
+        char text[max_record_length];
+    };
+
+    bool pop_and_forward();
+    void drain_loop();
+
+    Record *_records;
+    size_t _mask;
+
+    // Producer and consumer positions, padded apart to avoid false sharing.
+    std::atomic<size_t> _enqueue_position;
+    char _padding[64];
+    std::atomic<size_t> _dequeue_position;
+
+    std::atomic<size_t> _dropped;
+    std::atomic<size_t> _forwarded;
+
+    mutable std::mutex _sink_mutex;
+    Logger _sink;
+
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+    std::atomic<bool> _is_running;
+    std::thread _thread;
+};
+
+}  // namespace one
+}  // namespace i3d
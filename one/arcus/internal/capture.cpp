@@ -0,0 +1,419 @@
+#include <one/arcus/internal/capture.h>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/c_platform.h>
+#include <one/arcus/internal/codec.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifndef ONE_WINDOWS
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace i3d {
+namespace one {
+
+namespace {
+
+constexpr char magic[4] = {'A', 'R', 'C', 'P'};
+
+void put_uint32(char *out, uint32_t value) {
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+void put_uint64(char *out, uint64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+}
+
+uint32_t get_uint32(const char *in) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (i * 8);
+    }
+    return value;
+}
+
+uint64_t get_uint64(const char *in) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (i * 8);
+    }
+    return value;
+}
+
+size_t padding_for(size_t length) {
+    const size_t remainder = length % capture::record_alignment;
+    return (remainder == 0) ? 0 : capture::record_alignment - remainder;
+}
+
+uint64_t steady_now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t wall_now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+String rotated_path(const String &path, size_t index) {
+    String rotated = path;
+    rotated += ".";
+    rotated += std::to_string(index).c_str();
+    return rotated;
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+// CaptureWriter.
+
+CaptureWriter::CaptureWriter()
+    : _max_file_size(default_max_file_size)
+    , _max_files(default_max_files)
+    , _file(nullptr)
+    , _file_size(0)
+    , _records_written(0)
+    , _buffer(nullptr)
+    , _buffer_size(0) {}
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+OneError CaptureWriter::open(const char *path, size_t max_file_size, size_t max_files) {
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (is_open()) {
+        return ONE_ERROR_CAPTURE_ALREADY_OPEN;
+    }
+
+    _path = path;
+    _max_file_size = max_file_size;
+    _max_files = (max_files == 0) ? 1 : max_files;
+    _records_written = 0;
+
+    _buffer = reinterpret_cast<char *>(allocator::alloc(buffer_size));
+    if (_buffer == nullptr) {
+        return ONE_ERROR_CAPTURE_ALLOCATION_FAILED;
+    }
+    _buffer_size = 0;
+
+    auto err = open_file();
+    if (is_error(err)) {
+        allocator::free(_buffer);
+        _buffer = nullptr;
+        return err;
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+void CaptureWriter::close() {
+    if (_file != nullptr) {
+        flush();
+        std::fclose(_file);
+        _file = nullptr;
+    }
+    if (_buffer != nullptr) {
+        allocator::free(_buffer);
+        _buffer = nullptr;
+    }
+    _buffer_size = 0;
+    _file_size = 0;
+}
+
+bool CaptureWriter::is_open() const {
+    return _file != nullptr;
+}
+
+OneError CaptureWriter::open_file() {
+    _file = std::fopen(_path.c_str(), "wb");
+    if (_file == nullptr) {
+        return ONE_ERROR_CAPTURE_OPEN_FAILED;
+    }
+    _file_size = 0;
+
+    char header[capture::file_header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    put_uint32(header + 4, capture::format_version);
+    put_uint64(header + 8, wall_now_ns());
+    put_uint64(header + 16, steady_now_ns());
+    return append(header, sizeof(header));
+}
+
+OneError CaptureWriter::rotate() {
+    auto err = flush();
+    if (is_error(err)) {
+        return err;
+    }
+    std::fclose(_file);
+    _file = nullptr;
+
+    // Shift path.N-1 ... path.1 up by one, dropping the oldest, then move the
+    // current file to path.1.
+    if (_max_files > 1) {
+        std::remove(rotated_path(_path, _max_files - 1).c_str());
+        for (size_t i = _max_files - 1; i > 1; --i) {
+            std::rename(rotated_path(_path, i - 1).c_str(), rotated_path(_path, i).c_str());
+        }
+        if (std::rename(_path.c_str(), rotated_path(_path, 1).c_str()) != 0) {
+            return ONE_ERROR_CAPTURE_ROTATION_FAILED;
+        }
+    }
+
+    return open_file();
+}
+
+OneError CaptureWriter::append(const void *data, size_t size) {
+    if (_buffer_size + size > buffer_size) {
+        auto err = flush();
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    if (size > buffer_size) {
+        // Too large to buffer, write directly.
+        if (std::fwrite(data, 1, size, _file) != size) {
+            return ONE_ERROR_CAPTURE_WRITE_FAILED;
+        }
+    } else {
+        std::memcpy(_buffer + _buffer_size, data, size);
+        _buffer_size += size;
+    }
+
+    _file_size += size;
+    return ONE_ERROR_NONE;
+}
+
+OneError CaptureWriter::write(CaptureDirection direction, const codec::Header &header,
+                              const void *payload) {
+    if (!is_open()) {
+        return ONE_ERROR_CAPTURE_NOT_OPEN;
+    }
+    if (header.length > 0 && payload == nullptr) {
+        return ONE_ERROR_VALIDATION_DATA_IS_NULLPTR;
+    }
+
+    const size_t padding = padding_for(header.length);
+    const size_t record_size = capture::record_header_size + header.length + padding;
+    // A file always holds at least one record, even if larger than the limit.
+    if (_file_size > capture::file_header_size &&
+        _file_size + record_size > _max_file_size) {
+        auto err = rotate();
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    char record[capture::record_header_size] = {};
+    put_uint64(record, steady_now_ns());
+    put_uint32(record + 8, header.packet_id);
+    put_uint32(record + 12, header.length);
+    record[16] = static_cast<char>(direction);
+    record[17] = header.flags;
+    record[18] = header.opcode;
+
+    auto err = append(record, sizeof(record));
+    if (is_error(err)) {
+        return err;
+    }
+    if (header.length > 0) {
+        err = append(payload, header.length);
+        if (is_error(err)) {
+            return err;
+        }
+    }
+    if (padding > 0) {
+        const char zeros[capture::record_alignment] = {};
+        err = append(zeros, padding);
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    _records_written++;
+    return ONE_ERROR_NONE;
+}
+
+OneError CaptureWriter::flush() {
+    if (!is_open()) {
+        return ONE_ERROR_CAPTURE_NOT_OPEN;
+    }
+    if (_buffer_size == 0) {
+        return ONE_ERROR_NONE;
+    }
+
+    const size_t size = _buffer_size;
+    _buffer_size = 0;
+    if (std::fwrite(_buffer, 1, size, _file) != size || std::fflush(_file) != 0) {
+        return ONE_ERROR_CAPTURE_WRITE_FAILED;
+    }
+    return ONE_ERROR_NONE;
+}
+
+//------------------------------------------------------------------------------
+// CaptureReader.
+
+CaptureReader::CaptureReader()
+    : _data(nullptr)
+    , _size(0)
+    , _position(0)
+    , _is_mapped(false)
+    , _is_truncated(false)
+    , _wall_clock_ns(0)
+    , _steady_clock_ns(0) {}
+
+CaptureReader::~CaptureReader() {
+    close();
+}
+
+OneError CaptureReader::open(const char *path) {
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (is_open()) {
+        return ONE_ERROR_CAPTURE_ALREADY_OPEN;
+    }
+
+#ifdef ONE_WINDOWS
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return ONE_ERROR_CAPTURE_OPEN_FAILED;
+    }
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if (size < static_cast<long>(capture::file_header_size)) {
+        std::fclose(file);
+        return ONE_ERROR_CAPTURE_INVALID_FILE;
+    }
+    char *data = reinterpret_cast<char *>(allocator::alloc(size));
+    if (data == nullptr) {
+        std::fclose(file);
+        return ONE_ERROR_CAPTURE_ALLOCATION_FAILED;
+    }
+    const size_t read = std::fread(data, 1, size, file);
+    std::fclose(file);
+    if (read != static_cast<size_t>(size)) {
+        allocator::free(data);
+        return ONE_ERROR_CAPTURE_OPEN_FAILED;
+    }
+    _data = data;
+    _size = static_cast<size_t>(size);
+    _is_mapped = false;
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return ONE_ERROR_CAPTURE_OPEN_FAILED;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 ||
+        info.st_size < static_cast<off_t>(capture::file_header_size)) {
+        ::close(fd);
+        return ONE_ERROR_CAPTURE_INVALID_FILE;
+    }
+    void *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return ONE_ERROR_CAPTURE_OPEN_FAILED;
+    }
+    _data = reinterpret_cast<const char *>(data);
+    _size = static_cast<size_t>(info.st_size);
+    _is_mapped = true;
+#endif
+
+    if (std::memcmp(_data, magic, sizeof(magic)) != 0 ||
+        get_uint32(_data + 4) != capture::format_version) {
+        close();
+        return ONE_ERROR_CAPTURE_INVALID_FILE;
+    }
+    _wall_clock_ns = get_uint64(_data + 8);
+    _steady_clock_ns = get_uint64(_data + 16);
+    rewind();
+    return ONE_ERROR_NONE;
+}
+
+void CaptureReader::close() {
+    if (_data == nullptr) {
+        return;
+    }
+
+#ifdef ONE_WINDOWS
+    allocator::free(const_cast<char *>(_data));
+#else
+    if (_is_mapped) {
+        ::munmap(const_cast<char *>(_data), _size);
+    }
+#endif
+    _data = nullptr;
+    _size = 0;
+    _position = 0;
+    _is_truncated = false;
+}
+
+bool CaptureReader::is_open() const {
+    return _data != nullptr;
+}
+
+void CaptureReader::rewind() {
+    _position = capture::file_header_size;
+    _is_truncated = false;
+}
+
+OneError CaptureReader::read(CaptureRecord &record, bool &is_end) {
+    is_end = false;
+    if (!is_open()) {
+        return ONE_ERROR_CAPTURE_NOT_OPEN;
+    }
+
+    const size_t remaining = _size - _position;
+    if (remaining < capture::record_header_size) {
+        _is_truncated = (remaining > 0);
+        is_end = true;
+        return ONE_ERROR_NONE;
+    }
+
+    const char *data = _data + _position;
+    const uint32_t length = get_uint32(data + 12);
+    const size_t record_size = capture::record_header_size + length;
+    if (remaining < record_size) {
+        _is_truncated = true;
+        is_end = true;
+        return ONE_ERROR_NONE;
+    }
+
+    const char direction = data[16];
+    if (direction != static_cast<char>(CaptureDirection::incoming) &&
+        direction != static_cast<char>(CaptureDirection::outgoing)) {
+        return ONE_ERROR_CAPTURE_INVALID_FILE;
+    }
+
+    record.timestamp_ns = get_uint64(data);
+    record.packet_id = get_uint32(data + 8);
+    record.length = length;
+    record.direction = static_cast<CaptureDirection>(direction);
+    record.flags = data[17];
+    record.opcode = data[18];
+    record.payload = data + capture::record_header_size;
+
+    // The padding of the last record may be missing if the file was cut.
+    const size_t padded_size = record_size + padding_for(length);
+    _position += (remaining < padded_size) ? remaining : padded_size;
+    return ONE_ERROR_NONE;
+}
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <one/arcus/error.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+
+namespace codec {
+struct Header;
+}
+
+// Capture files record the Arcus frames sent and received by a Connection, to
+// reproduce issues and to replay real traffic.
+//
+// File layout, all integers little-endian:
+//
+//   File header (32 bytes):
+//     char     magic[4]           "ARCP"
+//     uint32_t version            capture::format_version
+//     uint64_t wall_clock_ns      system clock at file creation, since epoch
+//     uint64_t steady_clock_ns    steady clock at file creation
+//     uint64_t reserved
+//
+//   Records, each starting on an 8 byte boundary:
+//     uint64_t timestamp_ns       steady clock when the frame was handled
+//     uint32_t packet_id          frame header fields
+//     uint32_t length
+//     uint8_t  direction          CaptureDirection
+//     uint8_t  flags
+//     uint8_t  opcode
+//     uint8_t  reserved[5]
+//     char     payload[length]    raw payload bytes, zero padded to 8 bytes
+//
+// Records are only ever appended, so a capture interrupted mid-write remains
+// readable up to its last complete record. The fixed layout allows reading a
+// file directly from a memory mapping.
+namespace capture {
+
+constexpr uint32_t format_version = 1;
+constexpr size_t file_header_size = 32;
+constexpr size_t record_header_size = 24;
+constexpr size_t record_alignment = 8;
+
+}  // namespace capture
+
+enum class CaptureDirection { incoming = 0, outgoing = 1 };
+
+struct CaptureRecord {
+    uint64_t timestamp_ns;
+    CaptureDirection direction;
+    char flags;
+    char opcode;
+    uint32_t packet_id;
+    uint32_t length;
+    const char *payload;  // Points into the reader's data, length bytes.
+};
+
+// Appends frames to a capture file through a write buffer. When the file
+// would exceed max_file_size, it is rotated: `path` is renamed `path.1`,
+// `path.1` to `path.2` and so on, keeping at most max_files files in total.
+//
+// Writes are not thread safe. A writer must only be used by one Connection at
+// a time.
+class CaptureWriter final {
+public:
+    static constexpr size_t default_max_file_size = 1024 * 1024 * 64;
+    static constexpr size_t default_max_files = 4;
+    static constexpr size_t buffer_size = 1024 * 64;
+
+    CaptureWriter();
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+    ~CaptureWriter();
+
+    // Creates, or truncates, the capture file at path.
+    OneError open(const char *path, size_t max_file_size = default_max_file_size,
+                  size_t max_files = default_max_files);
+    // Flushes and closes the file.
+    void close();
+    bool is_open() const;
+
+    // Appends a frame. The header length is the payload length.
+    OneError write(CaptureDirection direction, const codec::Header &header,
+                   const void *payload);
+
+    // Writes buffered records to the file.
+    OneError flush();
+
+    size_t records_written() const {
+        return _records_written;
+    }
+
+private:
+    OneError open_file();
+    OneError rotate();
+    OneError append(const void *data, size_t size);
+
+    String _path;
+    size_t _max_file_size;
+    size_t _max_files;
+
+    FILE *_file;
+    size_t _file_size;  // Including buffered bytes.
+    size_t _records_written;
+
+    char *_buffer;
+    size_t _buffer_size;
+};
+
+// Reads the records of a single capture file, in order. On POSIX systems the
+// file is memory mapped, otherwise it is read into memory.
+class CaptureReader final {
+public:
+    CaptureReader();
+    CaptureReader(const CaptureReader &) = delete;
+    CaptureReader &operator=(const CaptureReader &) = delete;
+    ~CaptureReader();
+
+    OneError open(const char *path);
+    void close();
+    bool is_open() const;
+
+    // Reads the next record. Sets is_end, without error, once all complete
+    // records have been read. The record payload remains valid until close.
+    OneError read(CaptureRecord &record, bool &is_end);
+
+    // Restarts reading from the first record.
+    void rewind();
+
+    // True if the file ends with an incomplete record.
+    bool is_truncated() const {
+        return _is_truncated;
+    }
+
+    uint64_t wall_clock_ns() const {
+        return _wall_clock_ns;
+    }
+    uint64_t steady_clock_ns() const {
+        return _steady_clock_ns;
+    }
+
+private:
+    const char *_data;
+    size_t _size;
+    size_t _position;
+    bool _is_mapped;
+    bool _is_truncated;
+    uint64_t _wall_clock_ns;
+    uint64_t _steady_clock_ns;
+};
+
+}  // namespace one
+}  // namespace i3d
@@ -6,6 +6,7 @@
 
 #include <cstring>
 #include <algorithm>
+#include <random>
 
 namespace i3d {
 namespace one {
@@ -22,6 +23,38 @@ const Hello &valid_hello() {
     return hello;
 }
 
+void session_to_data(const Session &session, std::array<char, session_size()> &data) {
+    // Same byte order as the Header.
+    Session swapped(session);
+    if (endian::which() == endian::Arch::little) {
+        swapped.token = endian::swap_uint32(session.token);
+        swapped.received = endian::swap_uint32(session.received);
+        swapped.first_replayable = endian::swap_uint32(session.first_replayable);
+        swapped.last_sent = endian::swap_uint32(session.last_sent);
+    }
+    std::memcpy(data.data(), &swapped, session_size());
+}
+
+void data_to_session(const void *data, Session &session) {
+    std::memcpy(&session, data, session_size());
+    if (endian::which() == endian::Arch::little) {
+        session.token = endian::swap_uint32(session.token);
+        session.received = endian::swap_uint32(session.received);
+        session.first_replayable = endian::swap_uint32(session.first_replayable);
+        session.last_sent = endian::swap_uint32(session.last_sent);
+    }
+}
+
+uint32_t new_session_token() {
+    // Per thread, as connections may be created concurrently.
+    thread_local std::mt19937 generator(std::random_device{}());
+    uint32_t token = 0;
+    while (token == 0) {
+        token = static_cast<uint32_t>(generator());
+    }
+    return token;
+}
+
 bool validate_header(const Header &header) {
     // Minimal validation in the codec at the moment. Opcode will be handled
     // by message layer. Length will be handled by document reader.
@@ -57,17 +90,17 @@ OneError data_to_message(const void *data, const size_t data_size, size_t &read_
 
     read_data_size = total_message_size;
 
-    Payload payload;
-
+    // Parse directly into the message, whose payload pool is reused, rather
+    // than through a temporary payload.
+    const Opcode code = static_cast<Opcode>(header.opcode);
     if (0 < header.length) {
         const size_t payload_length = header.length;
         const char *payload_data = static_cast<const char *>(data) + codec::header_size();
-        err = payload.from_json({payload_data, payload_length});
-        if (is_error(err)) return err;
+        err = message.init(code, {payload_data, payload_length});
+    } else {
+        message.reset();
+        err = message.init(code, Payload());
     }
-
-    const Opcode code = static_cast<Opcode>(header.opcode);
-    err = message.init(code, payload);
     if (is_error(err)) {
         message.reset();
         return err;
@@ -79,10 +112,16 @@ OneError data_to_message(const void *data, const size_t data_size, size_t &read_
 OneError message_to_data(const uint32_t packet_id, const Message &message,
                       size_t &data_length,
                       std::array<char, header_size() + payload_max_size()> &data) {
-    std::array<char, payload_max_size()> payload_data;
+    // The payload is written in place after the header.
     size_t payload_length = 0;
-    auto err = payload_to_data(message.payload(), payload_length, payload_data);
-    if (is_error(err)) return err;
+    if (!message.payload().is_empty()) {
+        bool truncated = false;
+        payload_length = message.payload().to_json(data.data() + header_size(),
+                                                   payload_max_size(), truncated);
+        if (truncated) {
+            return ONE_ERROR_CODEC_INVALID_MESSAGE_PAYLOAD_SIZE_TOO_BIG;
+        }
+    }
 
     // See: https://en.cppreference.com/w/cpp/language/value_initialization
     // C++11 Value initialization
@@ -92,16 +131,12 @@ OneError message_to_data(const uint32_t packet_id, const Message &message,
     header.length = payload_length;
 
     std::array<char, header_size()> header_data;
-    err = header_to_data(header, header_data);
+    auto err = header_to_data(header, header_data);
     if (is_error(err)) return err;
 
     data_length = header_size() + payload_length;
     std::copy(header_data.cbegin(), header_data.cend(), data.begin());
 
-    if (0 < payload_length) {
-        std::copy_n(payload_data.cbegin(), payload_length, data.begin() + header_size());
-    }
-
     return ONE_ERROR_NONE;
 }
 
@@ -172,14 +207,12 @@ OneError payload_to_data(const Payload &payload, size_t &payload_length,
         return ONE_ERROR_NONE;
     }
 
-    auto str = payload.to_json();
-    payload_length = str.size();
-
-    if (payload_max_size() < payload_length) {
+    bool truncated = false;
+    payload_length = payload.to_json(data.data(), data.size(), truncated);
+    if (truncated) {
         return ONE_ERROR_CODEC_INVALID_MESSAGE_PAYLOAD_SIZE_TOO_BIG;
     }
 
-    std::memcpy(data.data(), str.c_str(), payload_length);
     return ONE_ERROR_NONE;
 }
 
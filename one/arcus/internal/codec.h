@@ -36,6 +36,68 @@ bool validate_hello(const Hello &hello);
 // Returns the valid, expected Hello values.
 const Hello &valid_hello();
 
+//------------------
+// Optional features.
+
+// The initiator offers features in a health frame sent right after the Hello,
+// with the flags in reserved[0]. The responder accepts some of them by
+// setting them in reserved[0] of the hello reply header, and replies without
+// features if no offer follows the Hello shortly. Peers predating the offer
+// skip it as a health message, and send a plain reply, so that mixed versions
+// fall back to no features.
+// Leaves liveness to kernel TCP keepalive.
+constexpr char feature_kernel_liveness = 0x1;
+// Session resumption, both ends sending a Session after the hello reply.
+constexpr char feature_session = 0x2;
+// Frames sent through shared memory rings created by the initiator, see
+// SharedMemoryRegion. Not agreed along with kernel liveness.
+constexpr char feature_shared_memory = 0x4;
+
+//------------------
+// Shared memory.
+
+// Sent by the initiator after the hello reply when shared memory is agreed,
+// naming the region it created, or empty if it could not create one. The
+// responder replies whether it opened it, as its last bytes on the socket, and
+// both ends then send their frames through the region if it did.
+struct SharedMemoryRegion {
+    char name[64];  // Null terminated.
+};
+static_assert(sizeof(SharedMemoryRegion) == 64, "shared memory region struct size");
+
+struct SharedMemoryResult {
+    char is_opened;
+    char reserved[3];
+};
+static_assert(sizeof(SharedMemoryResult) == 4, "shared memory result struct size");
+
+//------------------
+// Session resumption.
+
+// Sent by both ends after the hello reply when session resumption is agreed.
+// The token identifies the session, and received is the packet_id of the last
+// message received in it, so that the peer replays the later ones. The
+// messages sent from first_replayable to last_sent can be replayed.
+struct Session {
+    uint32_t token;
+    uint32_t received;
+    uint32_t first_replayable;
+    uint32_t last_sent;
+    char reserved[4];
+};
+static_assert(sizeof(Session) == 20, "session struct alignment");
+
+constexpr size_t session_size() {
+    return sizeof(Session);
+}
+
+// Converts a Session to and from byte data, of session_size() bytes.
+void session_to_data(const Session &session, std::array<char, session_size()> &data);
+void data_to_session(const void *data, Session &session);
+
+// Returns a random non-zero token for a new session.
+uint32_t new_session_token();
+
 //---------------
 // Arcus Message.
 
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
 #include <vector>
 
 #include <one/arcus/error.h>
 #include <one/arcus/c_platform.h>
+#include <one/arcus/options.h>
 #include <one/arcus/internal/accumulator.h>
 #include <one/arcus/internal/health.h>
+#include <one/arcus/internal/outgoing_queue.h>
 #include <one/arcus/internal/ring.h>
 #include <one/arcus/internal/time.h>
 
@@ -15,50 +18,114 @@ namespace one {
 
 namespace codec {
 struct Header;
+struct Session;
 }
-class Socket;
+enum class CaptureDirection;
+class CaptureWriter;
+class Transport;
+class SharedMemoryTransport;
 class Message;
-template <typename T>
-class RingBuffer;
+
+//#define ONE_ARCUS_CONNECTION_LOGGING
+
+// Compile-time configuration of a BasicConnection. Embedders can build a
+// specialized connection from a policy with the same members, for example to
+// compile out health checks or capturing. Features disabled by the policy are
+// guarded by constant conditions and removed by the compiler.
+struct DefaultConnectionPolicy {
+    // Queue depths of the (in, out) constructor.
+    static constexpr size_t max_messages = 48;
+    // Stream buffers sizes used to pump pending data from/to the connection's
+    // socket, by the (in, out) constructor.
+    static constexpr size_t stream_send_buffer_size = 1024 * 128;
+    static constexpr size_t stream_receive_buffer_size = 1024 * 128;
+
+    // Whether the message queues and stream buffers are held inline in the
+    // connection, sized by the sizes above, instead of allocated at
+    // construction. Inline storage needs no allocation and its bounds are
+    // constants, but the sizes given to the constructors, including those of
+    // ConnectionOptions, are then ignored.
+    static constexpr bool is_storage_inline = false;
+
+    static constexpr int handshake_timeout_seconds = 1;
+    // How long the responder waits for the features offered after the Hello
+    // before replying without features, to an initiator predating them.
+    static constexpr int feature_offer_wait_ms = 50;
+
+    // Sends health messages and fails the connection if nothing is received
+    // for the receive interval. The intervals apply to the (in, out)
+    // constructor, ConnectionOptions::health to the other.
+    static constexpr bool is_health_enabled = true;
+    static constexpr unsigned int health_check_send_interval_ms =
+        HealthChecker::health_check_send_interval_ms;
+    static constexpr unsigned int health_check_receive_interval_ms =
+        HealthChecker::health_check_receive_interval_ms;
+
+    // Whether set_capture records frames.
+    static constexpr bool is_capture_enabled = true;
+
+#ifdef ONE_ARCUS_CONNECTION_LOGGING
+    static constexpr bool is_logging_enabled = true;
+#else
+    static constexpr bool is_logging_enabled = false;
+#endif
+};
 
 namespace connection {
 
-// Stream buffers sizes used to pump pending data from/to the connection's
-// socket.
 constexpr size_t stream_send_buffer_size() {
-    return 1024 * 128;
+    return DefaultConnectionPolicy::stream_send_buffer_size;
 }
 
 constexpr size_t stream_receive_buffer_size() {
-    return 1024 * 128;
+    return DefaultConnectionPolicy::stream_receive_buffer_size;
 }
 
 }  // namespace connection
 
-// Connection manages Arcus protocol communication between two TCP sockets.
-class Connection final {
+// Connection manages Arcus protocol communication between two transports,
+// usually TCP sockets.
+// Its definitions are in connection_impl.h, and the default policy is
+// instantiated by connection.cpp.
+template <class Policy>
+class BasicConnection final {
 public:
     // A default that can be used for production.
-    static constexpr size_t max_message_default = 48;
-    static constexpr int handshake_timeout_seconds = 1;
+    static constexpr size_t max_message_default = Policy::max_messages;
+    static constexpr int handshake_timeout_seconds = Policy::handshake_timeout_seconds;
 
-    // Connection must be given an active socket. Socket errors encountered
-    // during processing will be returned as errors, and it is the caller's
-    // responsibilty to either destroy the Connection, or restore the Socket's
-    // state for communication.
+    // Connection must be given an active transport, usually a Socket.
+    // Transport errors encountered during processing will be returned as
+    // errors, and it is the caller's responsibilty to either destroy the
+    // Connection, or restore the transport's state for communication.
     // Creating the conneciton starts the handshake timeout.
-    Connection(size_t max_messages_in, size_t max_messages_out);
-    ~Connection() = default;
+    BasicConnection(size_t max_messages_in, size_t max_messages_out);
+    // Queue depths and growing stream buffers set by the options, which must
+    // be valid.
+    explicit BasicConnection(const ConnectionOptions &options);
+    ~BasicConnection();
 
-    // Init the connection with the given socket. The given socket should be
-    // active. Must be called after construction and shutdown. Handshaking timers
-    // start when init is called.
-    void init(Socket &socket);
+    // Init the connection with the given transport. The given transport should
+    // be active. Must be called after construction and shutdown. Handshaking
+    // timers start when init is called.
+    void init(Transport &transport);
+
+    // Records every frame sent and received into the given capture, which must
+    // outlive the connection or be unset first. Nullptr disables capturing.
+    void set_capture(CaptureWriter *capture);
 
     // Clears Connection to construction state. Erases all pending incoming
     // and outgoing data. Unassigns the socket.
     void shutdown();
 
+    // Unassigns the socket after it failed or closed, like shutdown, but keeps
+    // the session, the queued outgoing messages and the incoming messages not
+    // yet removed, so that the next init can resume the session. Same as
+    // shutdown if session resumption is disabled. If the next handshake does
+    // not resume the session, the queued outgoing messages, meant for the
+    // previous peer, are dropped.
+    void suspend();
+
     // Marks this side of the connection as responsible for initiating the
     // handshaking process. Must be called from one side of the connection
     // only. Attempting to send a Message or any other data to other side of
@@ -77,18 +144,57 @@ public:
         handshake_hello_received,
         handshake_hello_scheduled,
         handshake_hello_sent,
+        handshake_shared_memory,  // Moving to the shared memory of the initiator.
+        handshake_session,        // Waiting for the Session of the peer.
         ready,
         error
     };
     Status status() const;
 
-    // Adds a Message to the outgoing message queue, and passes the message
-    // back in a modifier function that allows the caller to configure the
-    // queued message. If the outgoing message queue is full, then the
-    // call fails with ONE_ERROR_INSUFFICIENT_SPACE and the queue is not
-    // modified. Must be called after init.
+    // The liveness mechanism agreed with the peer during the handshake, kernel
+    // if both requested it. Health messages until then.
+    Liveness liveness() const;
+
+    // Whether the last handshake resumed the session of the previous
+    // connection, on both ends. The messages sent before the reconnection and
+    // not received by the peer were then sent again, so that no state needs
+    // to be sent again in full. See ConnectionOptions::session_replay_size.
+    bool is_resumed() const;
+
+    // Whether the frames go through shared memory rings instead of the
+    // transport given to init, since the last handshake. See
+    // ConnectionOptions::shared_memory_capacity.
+    bool is_shared_memory() const;
+
+    // Adds a Message to the outgoing message queue of its priority class, or
+    // replaces the queued message with the same opcode if the opcode is set
+    // to replace in queue. If the queue of the class is full, then the call
+    // fails with ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE and
+    // the queue is not modified, and the class is marked as blocked. Must be
+    // called after init.
     OneError add_outgoing(const Message &message);
 
+    // Returns true once after a blocked class has drained to at most half of
+    // its capacity, so that senders can resume.
+    bool take_writable();
+
+    // Sets the priority class and replace in queue behavior of outgoing
+    // messages with the opcode, see OutgoingQueue. Kept across shutdown.
+    OneError set_outgoing_policy(Opcode code, Priority priority, bool replace_in_queue);
+    // The number of queued outgoing messages of the priority class.
+    size_t outgoing_count(Priority priority) const;
+    size_t outgoing_capacity() const;
+    size_t incoming_capacity() const;
+
+    // Whether reading from the socket stopped at the last update because the
+    // incoming queue was full. Unread data is left to the socket, so that TCP
+    // flow control slows the sender down, and reading resumes once the queue
+    // has room.
+    bool is_reading_paused() const;
+
+    // Adds the memory held by the connection, including the connection itself.
+    void footprint(MemoryFootprint &footprint) const;
+
     // The number of incoming messages available for pop. Must be called after
     // init.
     OneError incoming_count(unsigned int &count) const;
@@ -104,41 +210,133 @@ public:
         std::function<OneError(const Message &message)> read_callback);
 
 private:
-    Connection() = delete;
+    BasicConnection() = delete;
 
     OneError process_handshake();
     // Reads all available incoming messages from the socket and stores them in
-    // the incoming message queue.
+    // the incoming message queue, until the queue is full.
     OneError process_incoming_messages();
-    // Sends all outgoing messages in the queue as long as the socket is ready
-    // for sending.
+    // Sends outgoing messages in the queue as long as the socket accepts all
+    // of the data. Messages are left queued while sent data is pending.
     OneError process_outgoing_messages();
+    // Sets the writable flag if a blocked class has drained.
+    void update_writable();
 
     OneError process_health();
 
+    // Appends a frame to the capture, if set. Capture failures do not affect
+    // the connection.
+    void capture_frame(CaptureDirection direction, const codec::Header &header,
+                       const void *payload);
+
     // Message helpers.
     OneError try_read_data_into_in_stream();
     OneError try_read_message_from_in_stream(codec::Header &header, Message &message);
 
     // Handshake helpers.
     OneError ensure_nothing_received();
-    OneError try_send_hello();  // The initial hello type.
+    OneError try_send_hello();  // The initial hello type, and the offer.
     OneError try_receive_hello();
+    OneError try_receive_offer();
+    // The features requested by the options of this end.
+    char requested_features() const;
+    // Status of the first handshake stage following the hello reply.
+    Status stage_after_hello() const;
+
+    // Exchange of fixed size handshake data following the hello reply. The
+    // data is buffered on the first call of a stage, and the partial sends and
+    // receives are resumed by the next calls. The received data is left at the
+    // start of the in stream.
+    OneError try_send_stage(const void *data, size_t size, OneError failed);
+    OneError try_receive_stage(size_t size, OneError failed);
+
+    // Shared memory helpers, the initiator creating the region and the
+    // responder opening it.
+    bool create_shared_memory();
+    OneError try_offer_shared_memory();
+    OneError try_open_shared_memory();
+    void close_shared_memory();
     OneError try_send_hello_message();  // Hello as a Message with opcode.
     OneError try_receive_hello_message();
 
-    Socket *_socket;
+    // Session resumption helpers.
+    bool is_session_enabled() const {
+        return _session_replay_size > 0;
+    }
+    // Restarts the packet ids and the replayable messages.
+    void start_session(uint32_t token);
+    // Drops the queued outgoing messages, once the handshake that followed
+    // suspend did not resume the session.
+    void drop_suspended_outgoing();
+    // The Session of this end.
+    codec::Session session() const;
+    // Whether the messages following the one with the received packet_id
+    // can be replayed, by this end or by the peer.
+    bool can_replay(uint32_t received) const;
+    static bool can_replay(const codec::Session &session, uint32_t received);
+    // Keeps a sent frame for replay, dropping the oldest ones as needed.
+    void retain_sent(const char *data, size_t size, uint32_t packet_id);
+    // Adds the kept frames following the received packet_id to the out stream.
+    OneError replay(uint32_t received);
+    OneError try_send_session();
+    OneError try_receive_session();
+
+    // Storage types, inline if the policy sizes them.
+    static constexpr size_t inline_messages =
+        Policy::is_storage_inline ? Policy::max_messages : 0;
+    using InStream =
+        typename std::conditional<Policy::is_storage_inline,
+                                  InlineAccumulator<Policy::stream_receive_buffer_size>,
+                                  Accumulator>::type;
+    using OutStream =
+        typename std::conditional<Policy::is_storage_inline,
+                                  InlineAccumulator<Policy::stream_send_buffer_size>,
+                                  Accumulator>::type;
+
+    Transport *_transport;
     Status _status;
 
-    Accumulator _in_stream;
-    Accumulator _out_stream;
+    InStream _in_stream;
+    OutStream _out_stream;
 
-    Ring<Message> _incoming_messages;
-    Ring<Message> _outgoing_messages;
+    Ring<Message, inline_messages> _incoming_messages;
+    BasicOutgoingQueue<inline_messages> _outgoing_messages;
 
     IntervalTimer _handshake_timer;
     HealthChecker _health_checker;
+
+    // Features offered by this end, then those agreed with the peer.
+    char _features;
+    bool _is_initiator;
+    bool _is_offer_pending;                // Whether the initiator offer is expected.
+    steady_clock::time_point _hello_time;  // When the Hello was received.
+    bool _is_stage_sent;                   // Whether this end sent its part of the stage.
+
+    // Session resumption. Frames sent from _first_replayable on are kept in
+    // _replay, created on first use.
+    const size_t _session_replay_size;
+    uint32_t _session_token;  // Zero until a session starts.
+    uint32_t _next_packet_id;
+    uint32_t _last_received;  // Packet id of the last message received.
+    Accumulator *_replay;
+    uint32_t _first_replayable;
+    bool _is_resumed;
+    bool _is_suspended;  // From suspend until the next handshake completes.
+
+    // Shared memory, created on first use.
+    const size_t _shared_memory_capacity;
+    SharedMemoryTransport *_shared_memory;
+
+    CaptureWriter *_capture;
+
+    bool _is_reading_paused;
+    bool _is_blocked[priority_count];  // Per class, since a push failed.
+    bool _is_writable;
 };
 
+using Connection = BasicConnection<DefaultConnectionPolicy>;
+
+extern template class BasicConnection<DefaultConnectionPolicy>;
+
 }  // namespace one
 }  // namespace i3d
@@ -0,0 +1,1373 @@
+#pragma once
+
+#include <one/arcus/internal/connection.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/message.h>
+#include <one/arcus/opcode.h>
+#include <one/arcus/c_platform.h>
+#include <one/arcus/internal/capture.h>
+#include <one/arcus/internal/codec.h>
+#include <one/arcus/internal/outgoing_queue_impl.h>
+#include <one/arcus/internal/shared_memory.h>
+#include <one/arcus/internal/transport.h>
+
+#ifdef ONE_WINDOWS
+#else
+    #include <errno.h>
+#endif
+
+namespace i3d {
+namespace one {
+
+namespace connection {
+
+// Writes a line to standard output. Defined in connection.cpp, so that the
+// header does not pull in the standard streams.
+void write_log(const String &line);
+
+// Only called when the logging of the policy is enabled.
+template <class Write>
+void log(const Transport &transport, Write write) {
+    // Get transport info to help identify the connection.
+    String ip;
+    unsigned int port;
+    transport.address(ip, port);
+    OStringStream stream;
+
+    // Write it to the stream, then allow caller to add more.
+    stream << "ip: " << ip << ", port: " << port << ". ";
+    write(stream);
+
+    write_log(stream.str());
+}
+
+// There are two hello packets. The initial codec::hello sent from the
+// handshake initiater, and the response codec::Header message with a
+// hello opcode sent in response. This is the response header.
+inline const codec::Header &hello_message() {
+    // See: https://en.cppreference.com/w/cpp/language/value_initialization
+    // C++11 Value initialization
+    static codec::Header message{};
+    message.opcode = static_cast<char>(Opcode::hello);
+    return message;
+}
+
+// Health options of the (in, out) constructor.
+template <class Policy>
+HealthOptions policy_health_options() {
+    HealthOptions options;
+    options.send_interval_ms = Policy::health_check_send_interval_ms;
+    options.receive_timeout_ms = Policy::health_check_receive_interval_ms;
+    return options;
+}
+
+}  // namespace connection
+
+template <class Policy>
+BasicConnection<Policy>::BasicConnection(size_t max_messages_in,
+                                         size_t max_messages_out)
+    : _transport(nullptr)
+    , _status(Status::uninitialized)
+    , _in_stream(Policy::stream_receive_buffer_size)
+    , _out_stream(Policy::stream_send_buffer_size)
+    , _incoming_messages(max_messages_in)
+    , _outgoing_messages(max_messages_out)
+    , _handshake_timer(milliseconds(handshake_timeout_seconds * 1000))
+    , _health_checker(connection::policy_health_options<Policy>())
+    , _features(0)
+    , _is_initiator(false)
+    , _is_offer_pending(false)
+    , _hello_time()
+    , _is_stage_sent(false)
+    , _session_replay_size(0)
+    , _session_token(0)
+    , _next_packet_id(1)
+    , _last_received(0)
+    , _replay(nullptr)
+    , _first_replayable(1)
+    , _is_resumed(false)
+    , _is_suspended(false)
+    , _shared_memory_capacity(0)
+    , _shared_memory(nullptr)
+    , _capture(nullptr)
+    , _is_reading_paused(false)
+    , _is_blocked()
+    , _is_writable(false) {
+    _handshake_timer.sync_now();
+}
+
+template <class Policy>
+BasicConnection<Policy>::BasicConnection(const ConnectionOptions &options)
+    : _transport(nullptr)
+    , _status(Status::uninitialized)
+    , _in_stream(options.initial_stream_size, options.max_stream_size)
+    , _out_stream(options.initial_stream_size, options.max_stream_size)
+    , _incoming_messages(options.max_incoming_messages)
+    , _outgoing_messages(options.max_outgoing_messages)
+    , _handshake_timer(milliseconds(handshake_timeout_seconds * 1000))
+    , _health_checker(options.health)
+    , _features(0)
+    , _is_initiator(false)
+    , _is_offer_pending(false)
+    , _hello_time()
+    , _is_stage_sent(false)
+    , _session_replay_size(options.session_replay_size)
+    , _session_token(0)
+    , _next_packet_id(1)
+    , _last_received(0)
+    , _replay(nullptr)
+    , _first_replayable(1)
+    , _is_resumed(false)
+    , _is_suspended(false)
+    , _shared_memory_capacity(options.shared_memory_capacity)
+    , _shared_memory(nullptr)
+    , _capture(nullptr)
+    , _is_reading_paused(false)
+    , _is_blocked()
+    , _is_writable(false) {
+    _handshake_timer.sync_now();
+}
+
+template <class Policy>
+BasicConnection<Policy>::~BasicConnection() {
+    if (_replay != nullptr) {
+        allocator::destroy<Accumulator>(_replay);
+    }
+    if (_shared_memory != nullptr) {
+        allocator::destroy<SharedMemoryTransport>(_shared_memory);
+    }
+}
+
+template <class Policy>
+void BasicConnection<Policy>::init(Transport &transport) {
+    assert(_status == Status::uninitialized);
+    _transport = &transport;
+    _handshake_timer.sync_now();
+    _health_checker.reset();
+    _features = 0;
+    _is_initiator = false;
+    _is_offer_pending = false;
+    _is_stage_sent = false;
+    _is_resumed = false;
+    _status = Status::handshake_not_started;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::set_capture(CaptureWriter *capture) {
+    _capture = capture;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::capture_frame(CaptureDirection direction,
+                                            const codec::Header &header,
+                                            const void *payload) {
+    if (!Policy::is_capture_enabled || _capture == nullptr) {
+        return;
+    }
+
+    _capture->write(direction, header, payload);
+}
+
+template <class Policy>
+void BasicConnection<Policy>::shutdown() {
+    _out_stream.clear();
+    _in_stream.clear();
+    _outgoing_messages.clear();
+    _incoming_messages.clear();
+    _is_reading_paused = false;
+    for (auto &is_blocked : _is_blocked) {
+        is_blocked = false;
+    }
+    _is_writable = false;
+    _status = Status::uninitialized;
+    _transport = nullptr;
+    close_shared_memory();
+    start_session(0);
+    _is_resumed = false;
+    _is_suspended = false;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::suspend() {
+    if (!is_session_enabled()) {
+        shutdown();
+        return;
+    }
+
+    // Partially sent or received frames are sent again from the replay by the
+    // end that sent them.
+    _out_stream.clear();
+    _in_stream.clear();
+    _status = Status::uninitialized;
+    _transport = nullptr;
+    close_shared_memory();
+    _is_suspended = true;
+}
+
+template <class Policy>
+typename BasicConnection<Policy>::Status BasicConnection<Policy>::status() const {
+    return _status;
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::is_resumed() const {
+    return _is_resumed;
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::is_shared_memory() const {
+    return _shared_memory != nullptr && _transport == _shared_memory;
+}
+
+template <class Policy>
+Liveness BasicConnection<Policy>::liveness() const {
+    return _health_checker.is_kernel_liveness() ? Liveness::kernel
+                                                : Liveness::health_messages;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::add_outgoing(const Message &message) {
+    if (_status == Status::uninitialized) return ONE_ERROR_CONNECTION_UNINITIALIZED;
+
+    auto err = _outgoing_messages.push(message);
+    if (err == ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE) {
+        const auto priority = _outgoing_messages.priority(message.code());
+        _is_blocked[static_cast<size_t>(priority)] = true;
+    }
+    return err;
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::take_writable() {
+    const bool is_writable = _is_writable;
+    _is_writable = false;
+    return is_writable;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::update_writable() {
+    const size_t threshold = _outgoing_messages.capacity_per_priority() / 2;
+    for (size_t i = 0; i < priority_count; ++i) {
+        if (_is_blocked[i] &&
+            _outgoing_messages.size(static_cast<Priority>(i)) <= threshold) {
+            _is_blocked[i] = false;
+            _is_writable = true;
+        }
+    }
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::set_outgoing_policy(Opcode code, Priority priority,
+                                                      bool replace_in_queue) {
+    return _outgoing_messages.set_policy(code, priority, replace_in_queue);
+}
+
+template <class Policy>
+size_t BasicConnection<Policy>::outgoing_count(Priority priority) const {
+    return _outgoing_messages.size(priority);
+}
+
+template <class Policy>
+size_t BasicConnection<Policy>::outgoing_capacity() const {
+    return _outgoing_messages.capacity_per_priority();
+}
+
+template <class Policy>
+size_t BasicConnection<Policy>::incoming_capacity() const {
+    return _incoming_messages.capacity();
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::is_reading_paused() const {
+    return _is_reading_paused;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::footprint(MemoryFootprint &footprint) const {
+    footprint.instance += sizeof(BasicConnection);
+    footprint.streams += _in_stream.reserved() + _out_stream.reserved();
+    footprint.queues += _incoming_messages.allocated_size();
+    const Message *slot = _incoming_messages.slots();
+    if (slot != nullptr) {
+        for (size_t i = 0; i < _incoming_messages.capacity(); ++i) {
+            footprint.messages += slot[i].footprint();
+        }
+    }
+    _outgoing_messages.footprint(footprint.queues, footprint.messages);
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::incoming_count(unsigned int &count) const {
+    if (_status == Status::uninitialized) return ONE_ERROR_CONNECTION_UNINITIALIZED;
+
+    count = static_cast<unsigned int>(_incoming_messages.size());
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::remove_incoming(
+    std::function<OneError(const Message &message)> read_callback) {
+    assert(read_callback);
+    if (_status == Status::uninitialized) return ONE_ERROR_CONNECTION_UNINITIALIZED;
+
+    if (_incoming_messages.size() == 0) {
+        return ONE_ERROR_CONNECTION_QUEUE_EMPTY;
+    }
+
+    Message &message = _incoming_messages.pop();
+    auto err = read_callback(message);
+    message.reset();
+
+    return err;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::initiate_handshake() {
+    if (_status == Status::uninitialized) return ONE_ERROR_CONNECTION_UNINITIALIZED;
+    assert(_status == Status::handshake_not_started);
+    _is_initiator = true;
+    _status = Status::handshake_hello_scheduled;
+
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::process_health() {
+    if (_health_checker.process_receive()) {
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_HEALTH_TIMEOUT;
+    }
+    auto sender = [this](const Message &m) { return add_outgoing(m); };
+    auto err = _health_checker.process_send(sender);
+    if (is_error(err)) {
+        _status = Status::error;
+        return err;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::update() {
+    if (_status == Status::uninitialized) return ONE_ERROR_CONNECTION_UNINITIALIZED;
+    if (_status == Status::error) return ONE_ERROR_CONNECTION_UPDATE_AFTER_ERROR;
+
+    assert(_transport && _transport->is_initialized());
+
+    if (Policy::is_health_enabled && _status == Status::ready) {
+        auto err = process_health();
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    if (Policy::is_logging_enabled) {
+        connection::log(*_transport,
+                        [&](OStringStream &stream) { stream << "connection update"; });
+    }
+
+    // Return if socket has no activity or has an error.
+    bool is_ready = false;
+    auto err = _transport->ready_for_send(0.f, is_ready);
+    if (is_error(err)) return err;
+    if (!is_ready) return ONE_ERROR_NONE;
+
+    if (_status != Status::ready) return process_handshake();
+
+    if (Policy::is_logging_enabled) {
+        connection::log(*_transport,
+            [](OStringStream &stream) { stream << "connection processing messages"; });
+    }
+
+    // The server mostly replies to client request, so send outgoing messages
+    // first.
+    err = process_outgoing_messages();
+    if (is_error(err)) return err;  // Flush incoming also if error on outgoing?
+    update_writable();
+    return process_incoming_messages();
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::ensure_nothing_received() {
+    assert(_transport && _transport->is_initialized());
+
+    char byte;
+    size_t received = 0;
+    auto err = _transport->receive(&byte, 1, received);
+    if (is_error(err)) {
+        return err;
+    }
+    if (received > 0) {
+        return ONE_ERROR_CONNECTION_RECEIVE_BEFORE_SEND;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_send_hello() {
+    assert(_transport && _transport->is_initialized());
+
+    auto &stream = _out_stream;
+
+    // Buffer outgoing message if not yet done so. Nearly all the time the
+    // send will succeed since it is tiny and partial sends
+    // are rare edge cases in general.
+    if (stream.size() == 0) {
+        if (!stream.put(&codec::valid_hello(), codec::hello_size())) {
+            return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+        }
+
+        // The offer follows in the same send, so that the responder does not
+        // wait for it.
+        _features = requested_features();
+        codec::Header offer{};
+        offer.opcode = static_cast<char>(Opcode::health);
+        offer.reserved[0] = _features;
+        if (!stream.put(&offer, codec::header_size())) {
+            return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+        }
+        capture_frame(CaptureDirection::outgoing, offer, nullptr);
+    }
+
+    // Get remaining buffer.
+    const auto size = stream.size();
+    assert(size > 0);
+    void *data = nullptr;
+    stream.peek(size, &data);
+    assert(data != nullptr);
+
+    // Send as much as possible.
+    size_t sent = 0;
+    auto err = _transport->send(data, size, sent);
+    if (is_error(err)) {  // Error.
+        return ONE_ERROR_CONNECTION_HELLO_SEND_FAILED;
+    }
+    if (sent == 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    // Remove from send stream, check if finished.
+    stream.trim(sent);
+    if (stream.size() > 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_receive_hello() {
+    assert(_transport && _transport->is_initialized());
+
+    // Read a hello packet from socket.
+
+    // See: https://en.cppreference.com/w/cpp/language/value_initialization
+    // C++11 Value initialization
+    codec::Hello hello{};
+    size_t received = 0;
+    // Only the rest of a partially received hello, so that the hello message
+    // following it stays in the transport.
+    const size_t remaining = codec::hello_size() - _in_stream.size();
+    auto err = _transport->receive(&hello, remaining, received);
+    if (is_error(err)) {
+        return ONE_ERROR_CONNECTION_HELLO_RECEIVE_FAILED;
+    }
+    if (received == 0) {                        // No error but nothing received.
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;  // Retry next attempt.
+    }
+    if (received > remaining) {
+        return ONE_ERROR_CONNECTION_HELLO_TOO_BIG;
+    }
+
+    // Buffer bytes read. This will normally be the entire hello, but
+    // there are edge cases that might result in partial reads. Return
+    // if the full hello has not been read yet.
+    if (!_in_stream.put(&hello, received)) {
+        return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+    }
+    if (_in_stream.size() < codec::hello_size()) {
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;
+    }
+
+    // Read and validate the full hello from the receive buffer.
+    codec::Hello *data;
+    _in_stream.get(codec::hello_size(), reinterpret_cast<void **>(&data));
+    assert(data != nullptr);
+
+    if (!codec::validate_hello(*data)) {
+        return ONE_ERROR_CONNECTION_HELLO_INVALID;
+    }
+
+    _is_offer_pending = true;
+    _hello_time = steady_clock::now();
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_receive_offer() {
+    assert(_transport && _transport->is_initialized());
+
+    // Only the rest of a partially received offer, nothing else being sent by
+    // the initiator before the reply.
+    if (_in_stream.size() < codec::header_size()) {
+        std::array<char, codec::header_size()> data;
+        const size_t remaining = codec::header_size() - _in_stream.size();
+        size_t received = 0;
+        auto err = _transport->receive(data.data(), remaining, received);
+        if (is_error(err)) {
+            return ONE_ERROR_CONNECTION_HELLO_RECEIVE_FAILED;
+        }
+        if (received > 0 && !_in_stream.put(data.data(), received)) {
+            return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+        }
+        if (_in_stream.size() == 0) {
+            // An initiator predating the offer waits for the reply instead.
+            const int wait_ms = Policy::feature_offer_wait_ms;
+            if (steady_clock::now() - _hello_time < milliseconds(wait_ms)) {
+                return ONE_ERROR_CONNECTION_TRY_AGAIN;
+            }
+            _features = 0;
+            _is_offer_pending = false;
+            return ONE_ERROR_NONE;
+        }
+        if (_in_stream.size() < codec::header_size()) {
+            return ONE_ERROR_CONNECTION_TRY_AGAIN;
+        }
+    }
+
+    void *data = nullptr;
+    _in_stream.peek(codec::header_size(), &data);
+    codec::Header offer{};
+    auto err = codec::data_to_header(data, codec::header_size(), offer);
+    _in_stream.trim(codec::header_size());
+    if (is_error(err) || offer.opcode != static_cast<char>(Opcode::health) ||
+        offer.length != 0) {
+        return ONE_ERROR_CONNECTION_HELLO_INVALID;
+    }
+    capture_frame(CaptureDirection::incoming, offer, nullptr);
+    _is_offer_pending = false;
+
+    // Features are accepted if requested on both sides, the reply telling the
+    // initiator. The socket probed by the kernel is left idle by shared memory.
+    _features = offer.reserved[0] & requested_features();
+    if ((_features & codec::feature_shared_memory) != 0) {
+        _features &= ~codec::feature_kernel_liveness;
+    }
+    _health_checker.set_kernel_liveness(
+        (_features & codec::feature_kernel_liveness) != 0);
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+char BasicConnection<Policy>::requested_features() const {
+    char requested = 0;
+    if (_health_checker.is_kernel_liveness_requested()) {
+        requested |= codec::feature_kernel_liveness;
+    }
+    if (is_session_enabled()) {
+        requested |= codec::feature_session;
+    }
+    if (_shared_memory_capacity > 0) {
+        requested |= codec::feature_shared_memory;
+    }
+    return requested;
+}
+
+template <class Policy>
+typename BasicConnection<Policy>::Status BasicConnection<Policy>::stage_after_hello()
+    const {
+    if ((_features & codec::feature_shared_memory) != 0) {
+        return Status::handshake_shared_memory;
+    }
+    if ((_features & codec::feature_session) != 0) {
+        return Status::handshake_session;
+    }
+    return Status::ready;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_send_hello_message() {
+    assert(_transport && _transport->is_initialized());
+
+    auto &stream = _out_stream;
+
+    // Buffer outgoing message if not yet done so. Nearly all the time the send
+    // will succeed since it is tiny and partial sends are rare edge cases in
+    // general.
+    if (stream.size() == 0) {
+        codec::Header header = connection::hello_message();
+        header.reserved[0] = _features;
+        if (!stream.put(&header, codec::header_size())) {
+            return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+        }
+        capture_frame(CaptureDirection::outgoing, header, nullptr);
+    }
+
+    // Get remaining buffer.
+    const auto size = stream.size();
+    assert(size > 0);
+    void *data = nullptr;
+    stream.peek(size, &data);
+    assert(data != nullptr);
+
+    // Send.
+    size_t sent = 0;
+    auto err = _transport->send(data, size, sent);
+    if (is_error(err)) {
+        return ONE_ERROR_CONNECTION_HELLO_MESSAGE_SEND_FAILED;
+    }
+    if (sent == 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    // Remove from send stream, check if finished.
+    stream.trim(sent);
+    if (stream.size() > 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_read_data_into_in_stream() {
+    assert(_transport && _transport->is_initialized());
+
+    constexpr size_t max_read_size = codec::header_size() + codec::payload_max_size();
+    // Per thread, as connections may be updated concurrently.
+    thread_local std::array<char, max_read_size> buffer;
+    const size_t available_size = _in_stream.capacity() - _in_stream.size();
+    if (available_size == 0) {
+        // Only read when the stream does not hold a complete message, so the
+        // message does not fit.
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_READ_TOO_BIG_FOR_STREAM;
+    }
+    const size_t read_size =
+        (max_read_size > available_size) ? available_size : max_read_size;
+
+    size_t received = 0;
+    auto err = _transport->receive(buffer.data(), read_size, received);
+    if (is_error(err)) {
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_MESSAGE_RECEIVE_FAILED;
+    }
+
+    if (Policy::is_logging_enabled) {
+        connection::log(*_transport, [&](OStringStream &stream) {
+            stream << "connection received data: " << received;
+        });
+    }
+
+    if (received == 0) {
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;
+    }
+
+    if (received > _in_stream.capacity() - _in_stream.size()) {
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_READ_TOO_BIG_FOR_STREAM;
+    }
+
+    // Buffer bytes read.
+    if (!_in_stream.put(buffer.data(), received)) {
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+    }
+    if (_in_stream.size() < codec::header_size()) {
+        if (Policy::is_logging_enabled) {
+            connection::log(*_transport, [&](OStringStream &stream) {
+                stream << "stream size smaller than header size: " << _in_stream.size();
+            });
+        }
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_read_message_from_in_stream(
+    codec::Header &header, Message &message) {
+    const size_t in_stream_size = _in_stream.size();
+    if (in_stream_size < codec::header_size())
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;  // Nothing to read.
+
+    // Get a pointer to the entire input stream.
+    void *data = nullptr;
+    _in_stream.peek(in_stream_size, &data);
+    assert(data != nullptr);
+
+    // Attempt to read a message from it.
+    size_t size_read = 0;
+    auto err = codec::data_to_message(data, in_stream_size, size_read, header, message);
+    if (is_error(err)) {
+        if (err == ONE_ERROR_CODEC_DATA_LENGTH_TOO_SMALL_FOR_PAYLOAD) {
+            // More reading is needed to be able to read the entire payload.
+            err = ONE_ERROR_CONNECTION_TRY_AGAIN;
+        }
+        return err;
+    }
+    capture_frame(CaptureDirection::incoming, header,
+                  static_cast<const char *>(data) + codec::header_size());
+    _in_stream.trim(size_read);
+
+    if (Policy::is_logging_enabled) {
+        connection::log(*_transport, [&](OStringStream &stream) {
+            stream << "connection read message opcode: " << (int)message.code();
+        });
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_receive_hello_message() {
+    auto err = try_read_data_into_in_stream();
+    if (is_error(err)) return err;
+
+    // See: https://en.cppreference.com/w/cpp/language/value_initialization
+    // C++11 Value initialization
+    codec::Header header{};
+    Message message;
+    err = try_read_message_from_in_stream(header, message);
+    if (is_error(err)) return err;
+
+    // The reply may only accept the features that were offered.
+    codec::Header expected = connection::hello_message();
+    const char accepted = header.reserved[0];
+    if ((accepted & ~_features) == 0) {
+        expected.reserved[0] = accepted;
+    }
+    if (std::memcmp(&header, &expected, codec::header_size()) != 0)
+        return ONE_ERROR_CONNECTION_HELLO_MESSAGE_REPLY_INVALID;
+    if (!message.payload().is_empty())
+        return ONE_ERROR_CONNECTION_HELLO_MESSAGE_REPLY_INVALID;
+    _features = accepted;
+    _health_checker.set_kernel_liveness(
+        (accepted & codec::feature_kernel_liveness) != 0);
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::start_session(uint32_t token) {
+    _session_token = token;
+    _next_packet_id = 1;
+    _last_received = 0;
+    if (_replay != nullptr) {
+        _replay->clear();
+    }
+    _first_replayable = 1;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::drop_suspended_outgoing() {
+    // They may depend on what the previous peer received, e.g. live state
+    // deltas, and the new one gets the whole state anyway.
+    _outgoing_messages.clear();
+    for (auto &is_blocked : _is_blocked) {
+        is_blocked = false;
+    }
+}
+
+template <class Policy>
+codec::Session BasicConnection<Policy>::session() const {
+    codec::Session session{};
+    session.token = _session_token;
+    session.received = _last_received;
+    session.first_replayable = _first_replayable;
+    session.last_sent = _next_packet_id - 1;
+    return session;
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::can_replay(uint32_t received) const {
+    return can_replay(session(), received);
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::can_replay(const codec::Session &session,
+                                         uint32_t received) {
+    return received + 1 >= session.first_replayable && received <= session.last_sent;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::retain_sent(const char *data, size_t size,
+                                          uint32_t packet_id) {
+    // A frame that cannot be kept leaves a gap, the frames before it no longer
+    // being replayable.
+    auto drop_all = [&]() {
+        if (_replay != nullptr) {
+            _replay->clear();
+        }
+        _first_replayable = packet_id + 1;
+    };
+
+    if (size > _session_replay_size) {
+        drop_all();
+        return;
+    }
+    if (_replay == nullptr) {
+        const size_t initial_size = std::min<size_t>(1024, _session_replay_size);
+        _replay = allocator::create<Accumulator>(initial_size, _session_replay_size);
+        if (_replay == nullptr) {
+            drop_all();
+            return;
+        }
+    }
+
+    // Drop the oldest frames until the frame fits.
+    while (_replay->capacity() - _replay->size() < size) {
+        void *oldest = nullptr;
+        _replay->peek(codec::header_size(), &oldest);
+        codec::Header header{};
+        codec::data_to_header(oldest, codec::header_size(), header);
+        _replay->trim(codec::header_size() + header.length);
+        _first_replayable = header.packet_id + 1;
+    }
+
+    if (!_replay->put(data, size)) {
+        drop_all();
+    }
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::replay(uint32_t received) {
+    if (_replay == nullptr || _replay->size() == 0) {
+        return ONE_ERROR_NONE;
+    }
+
+    void *data = nullptr;
+    _replay->peek(_replay->size(), &data);
+    const char *frames = static_cast<const char *>(data);
+
+    // Frames are kept in packet_id order, those not received are at the end.
+    size_t offset = 0;
+    size_t replay_offset = _replay->size();
+    while (offset < _replay->size()) {
+        codec::Header header{};
+        codec::data_to_header(frames + offset, codec::header_size(), header);
+        if (header.packet_id > received && replay_offset == _replay->size()) {
+            replay_offset = offset;
+        }
+        if (offset >= replay_offset) {
+            capture_frame(CaptureDirection::outgoing, header,
+                          frames + offset + codec::header_size());
+        }
+        offset += codec::header_size() + header.length;
+    }
+
+    const size_t size = _replay->size() - replay_offset;
+    if (size > _out_stream.capacity() - _out_stream.size()) {
+        return ONE_ERROR_CONNECTION_OUT_MESSAGE_TOO_BIG_FOR_STREAM;
+    }
+    if (!_out_stream.put(frames + replay_offset, size)) {
+        return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_send_stage(const void *data, size_t size,
+                                                 OneError failed) {
+    assert(_transport && _transport->is_initialized());
+
+    if (_is_stage_sent) {
+        return ONE_ERROR_NONE;
+    }
+
+    auto &stream = _out_stream;
+    if (stream.size() == 0 && !stream.put(data, size)) {
+        return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+    }
+
+    // Get remaining buffer.
+    const auto remaining = stream.size();
+    void *buffered = nullptr;
+    stream.peek(remaining, &buffered);
+    assert(buffered != nullptr);
+
+    // Send.
+    size_t sent = 0;
+    auto err = _transport->send(buffered, remaining, sent);
+    if (is_error(err)) {
+        return failed;
+    }
+    if (sent == 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    // Remove from send stream, check if finished.
+    stream.trim(sent);
+    if (stream.size() > 0) return ONE_ERROR_CONNECTION_TRY_AGAIN;
+
+    _is_stage_sent = true;
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_receive_stage(size_t size, OneError failed) {
+    assert(_transport && _transport->is_initialized());
+
+    // Sized for the largest stage data.
+    static_assert(codec::session_size() <= sizeof(codec::SharedMemoryRegion),
+                  "stage data size");
+    std::array<char, sizeof(codec::SharedMemoryRegion)> data;
+    assert(size <= data.size());
+
+    // The initiator may have read the data along with the hello reply.
+    // Otherwise only the rest of partially received data is read, so that the
+    // bytes following it stay in the transport.
+    if (_in_stream.size() >= size) {
+        return ONE_ERROR_NONE;
+    }
+    const size_t remaining = size - _in_stream.size();
+    size_t received = 0;
+    auto err = _transport->receive(data.data(), remaining, received);
+    if (is_error(err)) {
+        return failed;
+    }
+    if (received == 0) {
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;
+    }
+    if (!_in_stream.put(data.data(), received)) {
+        return ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED;
+    }
+    if (_in_stream.size() < size) {
+        return ONE_ERROR_CONNECTION_TRY_AGAIN;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+bool BasicConnection<Policy>::create_shared_memory() {
+    if (_shared_memory == nullptr) {
+        _shared_memory = allocator::create<SharedMemoryTransport>();
+        if (_shared_memory == nullptr) {
+            return false;
+        }
+    }
+    return !is_error(_shared_memory->create_unique(_shared_memory_capacity));
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_offer_shared_memory() {
+    // The region is created when the stage starts. An empty name tells the
+    // responder that it could not be.
+    codec::SharedMemoryRegion region{};
+    if (!_is_stage_sent && _out_stream.size() == 0 && create_shared_memory()) {
+        String name;
+        unsigned int port = 0;
+        _shared_memory->address(name, port);
+        if (name.size() < sizeof(region.name)) {
+            std::memcpy(region.name, name.c_str(), name.size());
+        }
+    }
+    auto err = try_send_stage(&region, sizeof(region),
+                              ONE_ERROR_CONNECTION_SHARED_MEMORY_SEND_FAILED);
+    if (is_error(err)) return err;
+
+    err = try_receive_stage(sizeof(codec::SharedMemoryResult),
+                            ONE_ERROR_CONNECTION_SHARED_MEMORY_RECEIVE_FAILED);
+    if (is_error(err)) return err;
+    void *data = nullptr;
+    _in_stream.peek(sizeof(codec::SharedMemoryResult), &data);
+    codec::SharedMemoryResult result{};
+    std::memcpy(&result, data, sizeof(result));
+    _in_stream.trim(sizeof(result));
+
+    // Nothing else is received through the transport given to init.
+    if (result.is_opened != 0 && _shared_memory != nullptr &&
+        _shared_memory->is_initialized()) {
+        _transport = _shared_memory;
+    } else {
+        close_shared_memory();
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_open_shared_memory() {
+    // The region is opened once received, the result then being sent.
+    codec::SharedMemoryResult result{};
+    if (!_is_stage_sent && _out_stream.size() == 0) {
+        auto err = try_receive_stage(sizeof(codec::SharedMemoryRegion),
+                                     ONE_ERROR_CONNECTION_SHARED_MEMORY_RECEIVE_FAILED);
+        if (is_error(err)) return err;
+        void *data = nullptr;
+        _in_stream.peek(sizeof(codec::SharedMemoryRegion), &data);
+        codec::SharedMemoryRegion region{};
+        std::memcpy(&region, data, sizeof(region));
+        _in_stream.trim(sizeof(region));
+        region.name[sizeof(region.name) - 1] = 0;
+
+        if (region.name[0] != 0) {
+            if (_shared_memory == nullptr) {
+                _shared_memory = allocator::create<SharedMemoryTransport>();
+            }
+            result.is_opened = _shared_memory != nullptr &&
+                               !is_error(_shared_memory->open(region.name));
+        }
+    }
+    auto err = try_send_stage(&result, sizeof(result),
+                              ONE_ERROR_CONNECTION_SHARED_MEMORY_SEND_FAILED);
+    if (is_error(err)) return err;
+
+    // The result was the last data sent through the transport given to init.
+    if (_shared_memory != nullptr && _shared_memory->is_initialized()) {
+        _transport = _shared_memory;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+void BasicConnection<Policy>::close_shared_memory() {
+    if (_shared_memory != nullptr) {
+        _shared_memory->close();
+    }
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_send_session() {
+    // The initiator starts the session to resume if there is none yet.
+    if (_is_initiator && _session_token == 0) {
+        start_session(codec::new_session_token());
+    }
+    std::array<char, codec::session_size()> data;
+    codec::session_to_data(session(), data);
+    return try_send_stage(data.data(), data.size(),
+                          ONE_ERROR_CONNECTION_SESSION_SEND_FAILED);
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::try_receive_session() {
+    auto err = try_receive_stage(codec::session_size(),
+                                 ONE_ERROR_CONNECTION_SESSION_RECEIVE_FAILED);
+    if (is_error(err)) return err;
+
+    void *data = nullptr;
+    _in_stream.peek(codec::session_size(), &data);
+    codec::Session peer{};
+    codec::data_to_session(data, peer);
+    _in_stream.trim(codec::session_size());
+
+    // Both ends decide alike from the two sessions, resuming only if each can
+    // replay what the other did not receive. Otherwise both start a new session
+    // with the token of the initiator.
+    _is_resumed = _session_token != 0 && peer.token == _session_token &&
+                  can_replay(peer.received) && can_replay(peer, _last_received);
+    if (!_is_resumed) {
+        start_session(_is_initiator ? _session_token : peer.token);
+        return ONE_ERROR_NONE;
+    }
+    return replay(peer.received);
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::process_handshake() {
+    assert(_transport && _transport->is_initialized());
+
+    if (_handshake_timer.update()) {
+        _status = Status::error;
+        return ONE_ERROR_CONNECTION_HANDSHAKE_TIMEOUT;
+    }
+
+    OneError err;
+    auto fail = [this](OneError err) {
+        _status = Status::error;
+        return err;
+    };
+
+    switch (_status) {
+        case Status::handshake_not_started:
+            // Check if hello received.
+            err = try_receive_hello();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+            // A partially sent hello message is resumed on the next update.
+            _status = Status::handshake_hello_received;
+
+            {
+                bool is_ready = false;
+                err = _transport->ready_for_send(0.f, is_ready);
+                if (is_error(err)) return err;
+                if (!is_ready) break;
+            }
+            // Fallthrough.
+        case Status::handshake_hello_received:
+            if (_is_offer_pending) {
+                err = try_receive_offer();
+                if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+                if (is_error(err)) return fail(err);
+            }
+            err = try_send_hello_message();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+            // Unless agreed features need more stages, handshaking is complete
+            // now. This side is free to send other Messages now. If handshaking
+            // fails on the server, then the connection will be closed and the
+            // Messages will be ignored.
+            _status = stage_after_hello();
+            break;
+        case Status::handshake_hello_scheduled:
+            // Ensure nothing is received. Arcus client should not send
+            // until it receives a Hello.
+            err = ensure_nothing_received();
+            if (is_error(err)) return fail(err);
+
+            // Send the hello.
+            err = try_send_hello();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+
+            _status = Status::handshake_hello_sent;
+            break;
+        case Status::handshake_hello_sent:
+            err = try_receive_hello_message();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+            _status = stage_after_hello();
+            if (_status == Status::ready) break;
+            // Fallthrough.
+        case Status::handshake_shared_memory:
+            if (_status == Status::handshake_shared_memory) {
+                err = _is_initiator ? try_offer_shared_memory()
+                                    : try_open_shared_memory();
+                if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+                if (is_error(err)) return fail(err);
+                _is_stage_sent = false;
+                if ((_features & codec::feature_session) == 0) {
+                    _status = Status::ready;
+                    break;
+                }
+                _status = Status::handshake_session;
+            }
+            // Fallthrough.
+        case Status::handshake_session:
+            // Both ends send their session, then decide from the one of the
+            // peer.
+            err = try_send_session();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+            err = try_receive_session();
+            if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) break;
+            if (is_error(err)) return fail(err);
+            _is_stage_sent = false;
+            _status = Status::ready;
+            break;
+        default:
+            _status = Status::error;
+            return fail(ONE_ERROR_CONNECTION_UNKNOWN_STATUS);
+    }
+
+    // Also when the peer did not agree to sessions at all.
+    if (_status == Status::ready && _is_suspended) {
+        if (!_is_resumed) {
+            drop_suspended_outgoing();
+        }
+        _is_suspended = false;
+    }
+    return ONE_ERROR_NONE;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::process_incoming_messages() {
+    assert(_transport && _transport->is_initialized());
+
+    // See: https://en.cppreference.com/w/cpp/language/value_initialization
+    // C++11 Value initialization
+    codec::Header header{};
+    Message message;
+    auto err = ONE_ERROR_NONE;
+
+    // Attempts to get data to process from the socket. Sets the above error if an error
+    // is encountered.
+    auto get_data_and_continue = [&]() -> bool {
+        err = try_read_data_into_in_stream();
+        if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) {
+            err = ONE_ERROR_NONE;
+            return false;
+        }
+        if (is_error(err)) return false;
+
+        return true;
+    };
+
+    // Attempts to read message from the incoming data stream and returns
+    // true if successful. Sets the above error if an error is encountered.
+    auto read_message_and_continue = [&]() -> bool {
+        err = try_read_message_from_in_stream(header, message);
+        if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) {
+            err = ONE_ERROR_NONE;
+            return false;
+        }
+        if (is_error(err)) return false;
+
+        // At this point data has been received from the remote end so update
+        // health timer.
+        _health_checker.reset_receive_timer(message.code() == Opcode::health);
+        _last_received = header.packet_id;
+
+        return true;
+    };
+
+    auto is_incoming_full = [&]() -> bool {
+        return _incoming_messages.size() == _incoming_messages.capacity();
+    };
+
+    // Messages left in the stream by a previous paused update are read before
+    // reading from the socket again.
+    _is_reading_paused = false;
+    while (true) {
+        while (!is_incoming_full() && read_message_and_continue()) {
+            // Skip health messages, they are consumed internally and do not
+            // make it to the queue for public consumption.
+            if (message.code() == Opcode::health) {
+                continue;
+            }
+
+            // Store in incoming queue for consumption.
+            if (!_incoming_messages.reserve()) {
+                err = ONE_ERROR_CONNECTION_QUEUE_ALLOCATION_FAILED;
+                break;
+            }
+            _incoming_messages.push(message);
+        }
+        if (is_error(err)) break;
+
+        // Stop reading until the queue is drained. The data left in the
+        // socket fills its receive buffer and TCP pushes back on the sender,
+        // rather than the connection failing on a burst.
+        if (is_incoming_full()) {
+            _is_reading_paused = true;
+            break;
+        }
+
+        if (!get_data_and_continue()) break;
+    }
+
+    if (is_error(err)) _status = Status::error;
+
+    return err;
+}
+
+template <class Policy>
+OneError BasicConnection<Policy>::process_outgoing_messages() {
+    assert(_transport && _transport->is_initialized());
+
+    // Util to attempt to send all pending data in the buffered outgoing data
+    // stream.
+    auto send_pending_data = [&]() -> OneError {
+        size_t size = _out_stream.size();
+        if (size == 0) return ONE_ERROR_NONE;
+
+        // Check is socket is connected and ready.
+        bool can_send = false;
+        auto err = _transport->ready_for_send(0.f, can_send);
+        if (is_error(err)) return err;
+        if (!can_send) return ONE_ERROR_NONE;
+
+        // Try to send pending data.
+        void *data;
+        _out_stream.peek(size, &data);
+        size_t sent = 0;
+        err = _transport->send(data, size, sent);
+        if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) return ONE_ERROR_NONE;
+        if (is_error(err)) return err;
+
+        // Keep the part not accepted by the socket for the next update.
+        _out_stream.trim(sent);
+
+        if (Policy::is_logging_enabled) {
+            connection::log(*_transport, [&](OStringStream &stream) {
+                stream << "connection sent data: " << sent;
+            });
+        }
+
+        return ONE_ERROR_NONE;
+    };
+
+    // Send from outgoing buffer if any previous messages are not finished
+    // sending.
+    auto err = send_pending_data();
+    if (is_error(err)) return err;
+    // The socket is full, leave the messages queued.
+    if (_out_stream.size() > 0) return ONE_ERROR_NONE;
+
+    if (Policy::is_logging_enabled) {
+        connection::log(*_transport, [&](OStringStream &stream) {
+            stream << "processing outgoing messages: " << _outgoing_messages.size();
+        });
+    }
+
+    // Attempt to send all pending messages.
+    while (_outgoing_messages.size() > 0) {
+        // Convert to data payload and add to outgoing buffer. The popped slot
+        // is only reused by later pushes, so it is read in place.
+        auto &message = _outgoing_messages.pop();
+
+        auto fail = [&](OneError err) {
+            _status = Status::error;
+            return err;
+        };
+
+        size_t message_size = 0;
+        const uint32_t packet_id = _next_packet_id;
+        // Per thread, as connections may be updated concurrently.
+        thread_local std::array<char, codec::header_size() + codec::payload_max_size()>
+            out_message_buffer;
+        err =
+            codec::message_to_data(packet_id, message, message_size, out_message_buffer);
+
+        if (is_error(err)) {
+            return fail(err);
+        }
+
+        const size_t max_size = _out_stream.capacity() - _out_stream.size();
+
+        // If it doesn't fit, then put the the connection into an error state.
+        if (message_size > max_size) {
+            return fail(ONE_ERROR_CONNECTION_OUT_MESSAGE_TOO_BIG_FOR_STREAM);
+        }
+
+        if (!_out_stream.put(out_message_buffer.data(), message_size)) {
+            return fail(ONE_ERROR_CONNECTION_STREAM_ALLOCATION_FAILED);
+        }
+        // Health messages are not worth replaying.
+        if (is_session_enabled() && message.code() != Opcode::health) {
+            retain_sent(out_message_buffer.data(), message_size, packet_id);
+        }
+
+        if (Policy::is_capture_enabled && _capture != nullptr) {
+            codec::Header header{};
+            header.opcode = static_cast<char>(message.code());
+            header.packet_id = packet_id;
+            header.length = static_cast<uint32_t>(message_size - codec::header_size());
+            capture_frame(CaptureDirection::outgoing, header,
+                          out_message_buffer.data() + codec::header_size());
+        }
+
+        if (Policy::is_logging_enabled) {
+            connection::log(*_transport, [&](OStringStream &stream) {
+                stream << "connection sent message opcode: " << (int)message.code();
+                stream << "message payload" << message.payload().to_json();
+            });
+        }
+
+        // The message is fully encoded, release its payload values for reuse
+        // rather than holding them until the slot is overwritten.
+        message.reset();
+
+        // Incrementing packet_id only after the message has been queued.
+        ++_next_packet_id;
+
+        // Any message keeps the peer from timing out, making a health message
+        // unnecessary for a while.
+        _health_checker.reset_send_timer();
+
+        err = send_pending_data();
+        if (err == ONE_ERROR_CONNECTION_TRY_AGAIN) return ONE_ERROR_NONE;
+        if (is_error(err)) {
+            return fail(err);
+        }
+        if (_out_stream.size() > 0) break;
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+}  // namespace one
+}  // namespace i3d
@@ -2,18 +2,44 @@
 #include <one/arcus/message.h>
 #include <one/arcus/opcode.h>
 
+#include <algorithm>
+
 namespace i3d {
 namespace one {
 
-HealthChecker::HealthChecker(size_t send_interval_seconds,
-                             size_t receive_interval_seconds)
-    : _send_timer(send_interval_seconds), _receive_timer(receive_interval_seconds) {
+constexpr unsigned int HealthChecker::health_check_send_interval_ms;
+constexpr unsigned int HealthChecker::health_check_receive_interval_ms;
+constexpr size_t HealthChecker::adaptive_sample_count;
+constexpr int HealthChecker::adaptive_factor;
+
+HealthChecker::HealthChecker(const HealthOptions &options)
+    : _options(options)
+    , _send_timer(milliseconds(options.send_interval_ms))
+    , _receive_timer(milliseconds(options.receive_timeout_ms))
+    , _longest_health_interval(0)
+    , _health_count(0)
+    , _is_kernel_liveness(false) {
     // Sync the timer fresh so it doesn't fire immediately.
+    reset();
+}
+
+void HealthChecker::reset() {
+    _receive_timer.set_interval(milliseconds(_options.receive_timeout_ms));
     _receive_timer.sync_now();
     _send_timer.sync_now();
+    _last_health_time = steady_clock::now();
+    _longest_health_interval = milliseconds(0);
+    _health_count = 0;
+    _is_kernel_liveness = false;
+}
+
+void HealthChecker::set_kernel_liveness(bool is_kernel_liveness) {
+    _is_kernel_liveness = is_kernel_liveness;
 }
 
 OneError HealthChecker::process_send(std::function<OneError(const Message &m)> sender) {
+    if (_is_kernel_liveness) return ONE_ERROR_NONE;
+
     const bool should_send = _send_timer.update();
     if (!should_send) return ONE_ERROR_NONE;
 
@@ -25,11 +51,32 @@ OneError HealthChecker::process_send(std::function<OneError(const Message &m)> s
     return err;
 }
 
-void HealthChecker::reset_receive_timer() {
+void HealthChecker::reset_send_timer() {
+    _send_timer.sync_now();
+}
+
+void HealthChecker::reset_receive_timer(bool is_health) {
+    if (is_health && _options.is_adaptive) {
+        // The peer sends a health message at most once per send interval, and
+        // at least once when it has nothing else to send, so the longest
+        // interval between them bounds its silences.
+        const auto now = steady_clock::now();
+        const auto interval = duration_cast<milliseconds>(now - _last_health_time);
+        _last_health_time = now;
+        _longest_health_interval = std::max(_longest_health_interval, interval);
+        if (++_health_count >= adaptive_sample_count) {
+            const auto timeout = std::min(
+                std::max(_longest_health_interval * adaptive_factor,
+                         milliseconds(_options.min_receive_timeout_ms)),
+                milliseconds(_options.receive_timeout_ms));
+            _receive_timer.set_interval(timeout);
+        }
+    }
     _receive_timer.sync_now();
 }
 
 bool HealthChecker::process_receive() {
+    if (_is_kernel_liveness) return false;
     return _receive_timer.update();
 }
 
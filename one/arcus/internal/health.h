@@ -4,6 +4,7 @@
 
 #include <one/arcus/error.h>
 #include <one/arcus/internal/time.h>
+#include <one/arcus/options.h>
 
 namespace i3d {
 namespace one {
@@ -11,34 +12,77 @@ namespace one {
 class Message;
 
 // Health features:
-// - sending of a health opcode message at an interval
+// - sending of a health opcode message when nothing else was sent for an
+// interval
 // - tracking of a timer for use whenever any message is received, to alert
-// when no message has been received for a period of time
+// when no message has been received for a period of time, optionally adapted
+// to the interval at which the peer sends health messages
 class HealthChecker final {
 public:
     // Optional defaults.
-    static constexpr size_t health_check_send_interval_seconds = 5;
-    static constexpr size_t health_check_receive_interval_seconds = 20;
+    static constexpr unsigned int health_check_send_interval_ms =
+        HealthOptions::default_send_interval_ms;
+    static constexpr unsigned int health_check_receive_interval_ms =
+        HealthOptions::default_receive_timeout_ms;
 
-    HealthChecker(size_t send_interval_seconds, size_t receive_interval_seconds);
+    // Health messages received before the adaptive receive timeout applies,
+    // and the timeout as a multiple of the longest interval between them.
+    static constexpr size_t adaptive_sample_count = 3;
+    static constexpr int adaptive_factor = 3;
 
-    // Updates internal timer and sends a adds a health message if needed.
+    explicit HealthChecker(const HealthOptions &options);
+
+    // Restarts both timers and the adaptation, for a new connection, and
+    // returns to health messages.
+    void reset();
+
+    // Whether kernel liveness was requested by the options, and whether it is
+    // in use. Once set, no health message is sent and the receive timeout no
+    // longer applies, a failed peer surfacing as a socket error instead.
+    bool is_kernel_liveness_requested() const {
+        return _options.liveness == Liveness::kernel;
+    }
+    bool is_kernel_liveness() const {
+        return _is_kernel_liveness;
+    }
+    void set_kernel_liveness(bool is_kernel_liveness);
+
+    // Updates internal timer and adds a health message if nothing was sent for
+    // the send interval.
     OneError process_send(std::function<OneError(const Message &m)> sender);
 
-    // Should be called whenever data is received from the client.
-    void reset_receive_timer();
+    // Should be called whenever a message is sent to the peer, which then
+    // stands in for the health message.
+    void reset_send_timer();
+
+    // Should be called whenever a message is received from the peer.
+    void reset_receive_timer(bool is_health);
 
     // Returns true if the time since last call to reset_receive_timer exceeds
     // the health interval during which a message received from the client is
     // required. Resets the receive timer interval if true.
     bool process_receive();
 
+    // The current receive timeout, lowered once adapted.
+    milliseconds receive_timeout() const {
+        return _receive_timer.interval();
+    }
+
 private:
     HealthChecker() = delete;
     HealthChecker(HealthChecker &other) = delete;
 
+    const HealthOptions _options;
     IntervalTimer _send_timer;     // To track when to send health messages.
     IntervalTimer _receive_timer;  // To track last message receipt time.
+
+    // Longest interval between the health messages of the peer, and the
+    // number received.
+    steady_clock::time_point _last_health_time;
+    milliseconds _longest_health_interval;
+    size_t _health_count;
+
+    bool _is_kernel_liveness;
 };
 
 }  // namespace one
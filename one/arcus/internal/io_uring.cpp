@@ -0,0 +1,763 @@
+#include <one/arcus/internal/io_uring.h>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/internal/socket.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        // Multishot receive and buffer rings are in the headers of Linux 6.0.
+        #if defined(IORING_RECV_MULTISHOT)
+            #define ONE_ARCUS_IO_URING
+        #endif
+    #endif
+#endif
+
+#ifdef ONE_ARCUS_IO_URING
+    #include <errno.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/syscall.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+namespace i3d {
+namespace one {
+
+namespace uring {
+
+#ifdef ONE_ARCUS_IO_URING
+
+// Submission queue entries. At most a receive, a send and a cancel are
+// submitted at once.
+constexpr unsigned queue_entries = 4;
+
+// Identifies the operation of a completion.
+enum Tag : uint64_t { tag_receive = 1, tag_send, tag_cancel };
+
+constexpr unsigned required_features =
+    IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+
+static_assert((IoUringTransport::receive_buffer_count &
+               (IoUringTransport::receive_buffer_count - 1)) == 0,
+              "buffer rings hold a power of two of buffers");
+
+// Bytes received into a provided buffer and not yet read.
+struct Received {
+    uint16_t id;
+    size_t length;
+    size_t offset;
+};
+
+// The ring, as mapped from the kernel, and the state of the attached socket.
+// The receive buffers are handed to the kernel through the buffer ring, and
+// handed back in the completions of the multishot receive. The staged send
+// bytes are [send_begin, send_end), those up to send_in_flight_end being sent.
+struct State {
+    State()
+        : ring_fd(-1)
+        , ring_memory(MAP_FAILED)
+        , ring_size(0)
+        , entries(static_cast<io_uring_sqe *>(MAP_FAILED))
+        , entries_size(0)
+        , sq_tail(nullptr)
+        , sq_flags(nullptr)
+        , sq_array(nullptr)
+        , sq_mask(0)
+        , cq_head(nullptr)
+        , cq_tail(nullptr)
+        , cqes(nullptr)
+        , cq_mask(0)
+        , unsubmitted(0)
+        , buffer_ring(static_cast<io_uring_buf_ring *>(MAP_FAILED))
+        , buffer_ring_size(0)
+        , buffer_tail(0)
+        , receive_buffers(nullptr)
+        , received_head(0)
+        , received_count(0)
+        , send_buffer(nullptr)
+        , send_begin(0)
+        , send_in_flight_end(0)
+        , send_end(0)
+        , descriptor(-1) {
+        reset();
+    }
+
+    ~State() {
+        destroy();
+    }
+
+    // Creates the ring and registers the receive buffers.
+    OneError create();
+    void destroy();
+
+    // Resets the state of the attached socket.
+    void reset() {
+        received_head = 0;
+        received_count = 0;
+        send_begin = send_in_flight_end = send_end = 0;
+        is_receiving = false;
+        is_sending = false;
+        is_cancelling = false;
+        is_end_of_stream = false;
+        receive_error = 0;
+        send_error = 0;
+    }
+
+    // Returns a cleared submission queue entry, submitted by the next submit.
+    io_uring_sqe *next_entry();
+    OneError submit();
+
+    void arm_receive();
+    void start_send();
+    void cancel();
+
+    // Handles the completions, without a system call.
+    void reap();
+    void complete(const io_uring_cqe &cqe);
+
+    // Waits for a completion, up to the timeout in seconds.
+    OneError wait(float timeout);
+
+    // Hands a buffer back to the kernel.
+    void recycle(uint16_t id);
+
+    // Starts the receive and send that can start. Each public call ends with
+    // it, so that they continue as the caller keeps calling.
+    OneError resume();
+
+    int ring_fd;
+    void *ring_memory;
+    size_t ring_size;
+    io_uring_sqe *entries;
+    size_t entries_size;
+    unsigned *sq_tail;
+    unsigned *sq_flags;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    io_uring_cqe *cqes;
+    unsigned cq_mask;
+    unsigned unsubmitted;
+
+    io_uring_buf_ring *buffer_ring;
+    size_t buffer_ring_size;
+    uint16_t buffer_tail;
+    unsigned char *receive_buffers;
+    // In order of arrival, as a ring of receive_buffer_count.
+    Received received[IoUringTransport::receive_buffer_count];
+    size_t received_head;
+    size_t received_count;
+
+    unsigned char *send_buffer;
+    size_t send_begin;
+    size_t send_in_flight_end;
+    size_t send_end;
+
+    int descriptor;
+    bool is_receiving;
+    bool is_sending;
+    bool is_cancelling;
+    bool is_end_of_stream;
+    // The errno of a failed receive or send.
+    int receive_error;
+    int send_error;
+};
+
+int setup(unsigned entries, io_uring_params &params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+          const void *arg, size_t arg_size) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int register_buffers(int fd, io_uring_buf_reg &registration) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &registration, 1));
+}
+
+OneError State::create() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd = setup(queue_entries, params);
+    if (ring_fd < 0) {
+        return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+    }
+    if ((params.features & required_features) != required_features) {
+        destroy();
+        return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+    }
+
+    // The submission and completion queues share a mapping.
+    ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                         params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring_memory = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    entries_size = params.sq_entries * sizeof(io_uring_sqe);
+    entries = static_cast<io_uring_sqe *>(mmap(nullptr, entries_size,
+                                               PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, ring_fd,
+                                               IORING_OFF_SQES));
+    if (ring_memory == MAP_FAILED || entries == MAP_FAILED) {
+        destroy();
+        return ONE_ERROR_TRANSPORT_CREATE_FAILED;
+    }
+
+    auto *ring = static_cast<unsigned char *>(ring_memory);
+    sq_tail = reinterpret_cast<unsigned *>(ring + params.sq_off.tail);
+    sq_flags = reinterpret_cast<unsigned *>(ring + params.sq_off.flags);
+    sq_array = reinterpret_cast<unsigned *>(ring + params.sq_off.array);
+    sq_mask = *reinterpret_cast<unsigned *>(ring + params.sq_off.ring_mask);
+    cq_head = reinterpret_cast<unsigned *>(ring + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(ring + params.cq_off.tail);
+    cqes = reinterpret_cast<io_uring_cqe *>(ring + params.cq_off.cqes);
+    cq_mask = *reinterpret_cast<unsigned *>(ring + params.cq_off.ring_mask);
+
+    // The buffer ring must be page aligned.
+    buffer_ring_size = IoUringTransport::receive_buffer_count * sizeof(io_uring_buf);
+    buffer_ring = static_cast<io_uring_buf_ring *>(
+        mmap(nullptr, buffer_ring_size, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (buffer_ring == MAP_FAILED) {
+        destroy();
+        return ONE_ERROR_TRANSPORT_ALLOCATION_FAILED;
+    }
+
+    receive_buffers = allocator::create_array<unsigned char>(
+        IoUringTransport::receive_buffer_count * IoUringTransport::receive_buffer_size);
+    send_buffer =
+        allocator::create_array<unsigned char>(IoUringTransport::send_buffer_size);
+    if (receive_buffers == nullptr || send_buffer == nullptr) {
+        destroy();
+        return ONE_ERROR_TRANSPORT_ALLOCATION_FAILED;
+    }
+
+    io_uring_buf_reg registration;
+    std::memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<uint64_t>(buffer_ring);
+    registration.ring_entries = IoUringTransport::receive_buffer_count;
+    registration.bgid = 0;
+    if (register_buffers(ring_fd, registration) < 0) {
+        destroy();
+        return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+    }
+
+    buffer_tail = 0;
+    for (size_t i = 0; i < IoUringTransport::receive_buffer_count; ++i) {
+        recycle(static_cast<uint16_t>(i));
+    }
+    return ONE_ERROR_NONE;
+}
+
+void State::destroy() {
+    // Closing the ring releases the buffers registered with it.
+    if (ring_fd >= 0) {
+        close(ring_fd);
+        ring_fd = -1;
+    }
+    if (ring_memory != MAP_FAILED) {
+        munmap(ring_memory, ring_size);
+        ring_memory = MAP_FAILED;
+    }
+    if (entries != MAP_FAILED) {
+        munmap(entries, entries_size);
+        entries = static_cast<io_uring_sqe *>(MAP_FAILED);
+    }
+    if (buffer_ring != MAP_FAILED) {
+        munmap(buffer_ring, buffer_ring_size);
+        buffer_ring = static_cast<io_uring_buf_ring *>(MAP_FAILED);
+    }
+    if (receive_buffers != nullptr) {
+        allocator::destroy_array<unsigned char>(receive_buffers);
+        receive_buffers = nullptr;
+    }
+    if (send_buffer != nullptr) {
+        allocator::destroy_array<unsigned char>(send_buffer);
+        send_buffer = nullptr;
+    }
+}
+
+io_uring_sqe *State::next_entry() {
+    // Completions free the entries as soon as they are submitted, and fewer
+    // operations than entries are ever in flight.
+    const unsigned tail = *sq_tail;
+    const unsigned index = tail & sq_mask;
+    io_uring_sqe *entry = &entries[index];
+    std::memset(entry, 0, sizeof(*entry));
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted;
+    return entry;
+}
+
+OneError State::submit() {
+    while (unsubmitted > 0) {
+        const int result = enter(ring_fd, unsubmitted, 0, 0, nullptr, 0);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            // Completions must be handled before more can be submitted.
+            if (errno == EAGAIN || errno == EBUSY) return ONE_ERROR_NONE;
+            return ONE_ERROR_TRANSPORT_SUBMIT_FAILED;
+        }
+        unsubmitted -= static_cast<unsigned>(result);
+    }
+    return ONE_ERROR_NONE;
+}
+
+void State::arm_receive() {
+    io_uring_sqe *entry = next_entry();
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = descriptor;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->buf_group = 0;
+    entry->user_data = tag_receive;
+    is_receiving = true;
+}
+
+void State::start_send() {
+    io_uring_sqe *entry = next_entry();
+    entry->opcode = IORING_OP_SEND;
+    entry->fd = descriptor;
+    entry->addr = reinterpret_cast<uint64_t>(send_buffer + send_begin);
+    entry->len = static_cast<uint32_t>(send_end - send_begin);
+    entry->msg_flags = MSG_NOSIGNAL;
+    entry->user_data = tag_send;
+    send_in_flight_end = send_end;
+    is_sending = true;
+}
+
+void State::cancel() {
+    io_uring_sqe *entry = next_entry();
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = descriptor;
+    entry->cancel_flags = IORING_ASYNC_CANCEL_ALL | IORING_ASYNC_CANCEL_FD;
+    entry->user_data = tag_cancel;
+    is_cancelling = true;
+}
+
+void State::reap() {
+    // Completions the queue had no room for are flushed into it by entering.
+    if (__atomic_load_n(sq_flags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) {
+        enter(ring_fd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+
+    unsigned head = *cq_head;
+    const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        complete(cqes[head & cq_mask]);
+        ++head;
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+void State::complete(const io_uring_cqe &cqe) {
+    switch (cqe.user_data) {
+        case tag_receive: {
+            const bool has_buffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+            const auto id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && has_buffer) {
+                const size_t index = (received_head + received_count) %
+                                     IoUringTransport::receive_buffer_count;
+                received[index] = Received{id, static_cast<size_t>(cqe.res), 0};
+                ++received_count;
+            } else {
+                if (has_buffer) {
+                    recycle(id);
+                }
+                if (cqe.res == 0) {
+                    is_end_of_stream = true;
+                } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+                    // Receiving stops when all buffers hold unread data, or when
+                    // the submitting thread exits, and resumes afterwards.
+                    receive_error = -cqe.res;
+                }
+            }
+            if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+                is_receiving = false;
+            }
+            break;
+        }
+        case tag_send:
+            is_sending = false;
+            if (cqe.res >= 0) {
+                send_begin += static_cast<size_t>(cqe.res);
+            } else if (cqe.res != -ECANCELED) {
+                send_error = -cqe.res;
+            }
+            if (send_begin == send_end) {
+                send_begin = send_end = 0;
+            }
+            break;
+        case tag_cancel:
+            is_cancelling = false;
+            break;
+        default:
+            break;
+    }
+}
+
+OneError State::wait(float timeout) {
+    if (timeout <= 0.f) {
+        return ONE_ERROR_NONE;
+    }
+
+    __kernel_timespec duration;
+    duration.tv_sec = static_cast<long long>(timeout);
+    duration.tv_nsec = static_cast<long long>((timeout - duration.tv_sec) * 1e9);
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&duration);
+    const int result = enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                             &arg, sizeof(arg));
+    if (result < 0 && errno != ETIME && errno != EINTR) {
+        return ONE_ERROR_TRANSPORT_WAIT_FAILED;
+    }
+    return ONE_ERROR_NONE;
+}
+
+void State::recycle(uint16_t id) {
+    // The buffers start the ring, overlaying the tail. Not through bufs, which
+    // the uapi header declares in a way that C++ offsets.
+    io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(
+        buffer_ring)[buffer_tail & (IoUringTransport::receive_buffer_count - 1)];
+    const size_t offset = static_cast<size_t>(id) * IoUringTransport::receive_buffer_size;
+    buffer.addr = reinterpret_cast<uint64_t>(receive_buffers + offset);
+    buffer.len = static_cast<uint32_t>(IoUringTransport::receive_buffer_size);
+    buffer.bid = id;
+    ++buffer_tail;
+    __atomic_store_n(&buffer_ring->tail, buffer_tail, __ATOMIC_RELEASE);
+}
+
+OneError State::resume() {
+    if (!is_receiving && !is_end_of_stream && receive_error == 0 &&
+        received_count < IoUringTransport::receive_buffer_count) {
+        arm_receive();
+    }
+    if (!is_sending && send_error == 0 && send_begin < send_end) {
+        start_send();
+    }
+    return submit();
+}
+
+#else
+
+struct State {};
+
+#endif
+
+}  // namespace uring
+
+using namespace uring;
+
+constexpr size_t IoUringTransport::receive_buffer_count;
+constexpr size_t IoUringTransport::receive_buffer_size;
+constexpr size_t IoUringTransport::send_buffer_size;
+
+#ifdef ONE_ARCUS_IO_URING
+
+// Receives a byte over a socket pair, which fails where the kernel is older
+// than 6.0 or io_uring is disabled.
+bool IoUringTransport::probe() {
+    IoUringTransport transport;
+    if (is_error(transport.init())) {
+        return false;
+    }
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        return false;
+    }
+
+    bool is_supported = false;
+    if (!is_error(transport.attach_descriptor(pair[0]))) {
+        const unsigned char byte = 1;
+        unsigned char received = 0;
+        size_t length = 0;
+        bool is_ready = false;
+        if (::send(pair[1], &byte, 1, MSG_NOSIGNAL) == 1 &&
+            !is_error(transport.ready_for_read(1.f, is_ready)) && is_ready &&
+            !is_error(transport.receive(&received, 1, length))) {
+            is_supported = (length == 1 && received == byte);
+        }
+        transport.detach();
+    }
+    close(pair[0]);
+    close(pair[1]);
+    return is_supported;
+}
+
+bool IoUringTransport::is_supported() {
+    static const bool is_supported = probe();
+    return is_supported;
+}
+
+#else
+
+bool IoUringTransport::is_supported() {
+    return false;
+}
+
+#endif
+
+IoUringTransport::IoUringTransport() : _state(nullptr), _socket(nullptr) {}
+
+IoUringTransport::~IoUringTransport() {
+    shutdown();
+}
+
+OneError IoUringTransport::init() {
+#ifdef ONE_ARCUS_IO_URING
+    if (_state != nullptr) {
+        return ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED;
+    }
+
+    allocator::ScopedCategory category(allocator::Category::connection);
+    _state = allocator::create<State>();
+    if (_state == nullptr) {
+        return ONE_ERROR_TRANSPORT_ALLOCATION_FAILED;
+    }
+    auto err = _state->create();
+    if (is_error(err)) {
+        shutdown();
+        return err;
+    }
+    return ONE_ERROR_NONE;
+#else
+    return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+#endif
+}
+
+void IoUringTransport::shutdown() {
+    detach();
+    if (_state != nullptr) {
+        allocator::destroy<State>(_state);
+        _state = nullptr;
+    }
+}
+
+OneError IoUringTransport::attach(Socket &socket) {
+    if (!socket.is_initialized()) {
+        return ONE_ERROR_SOCKET_SELECT_UNINITIALIZED;
+    }
+    auto err = attach_descriptor(static_cast<int>(socket.system_socket()));
+    if (is_error(err)) {
+        return err;
+    }
+    _socket = &socket;
+    return ONE_ERROR_NONE;
+}
+
+OneError IoUringTransport::attach_descriptor(int descriptor) {
+#ifdef ONE_ARCUS_IO_URING
+    if (_state == nullptr) {
+        return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    }
+    if (_state->descriptor >= 0) {
+        return ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED;
+    }
+
+    _state->reset();
+    _state->descriptor = descriptor;
+    auto err = _state->resume();
+    if (is_error(err)) {
+        detach();
+        return err;
+    }
+    return ONE_ERROR_NONE;
+#else
+    (void)descriptor;
+    return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+#endif
+}
+
+void IoUringTransport::detach() {
+#ifdef ONE_ARCUS_IO_URING
+    if (_state == nullptr || _state->descriptor < 0) {
+        return;
+    }
+
+    auto &state = *_state;
+    state.reap();
+    if (state.is_receiving || state.is_sending) {
+        state.cancel();
+        state.submit();
+    }
+    // The buffers are the kernel's until the completions of the cancelled
+    // operations arrive, which is immediate for sockets.
+    while (state.is_receiving || state.is_sending || state.is_cancelling) {
+        if (is_error(state.wait(0.1f))) {
+            break;
+        }
+        state.reap();
+    }
+
+    while (state.received_count > 0) {
+        state.recycle(state.received[state.received_head].id);
+        state.received_head =
+            (state.received_head + 1) % IoUringTransport::receive_buffer_count;
+        --state.received_count;
+    }
+    state.reset();
+    state.descriptor = -1;
+#endif
+    _socket = nullptr;
+}
+
+size_t IoUringTransport::footprint() const {
+    if (_state == nullptr) {
+        return 0;
+    }
+    return sizeof(State) + receive_buffer_count * receive_buffer_size + send_buffer_size;
+}
+
+bool IoUringTransport::is_initialized() const {
+#ifdef ONE_ARCUS_IO_URING
+    return _state != nullptr && _state->descriptor >= 0;
+#else
+    return false;
+#endif
+}
+
+OneError IoUringTransport::ready_for_read(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+#ifdef ONE_ARCUS_IO_URING
+    // Ready once there is data, or once the peer closed or an error occurred
+    // so that receive reports it.
+    auto &state = *_state;
+    state.reap();
+    auto err = state.resume();
+    if (is_error(err)) {
+        return err;
+    }
+    is_ready = state.received_count > 0 || state.is_end_of_stream ||
+               state.receive_error != 0;
+    if (!is_ready && timeout > 0.f) {
+        err = state.wait(timeout);
+        if (is_error(err)) {
+            return err;
+        }
+        state.reap();
+        is_ready = state.received_count > 0 || state.is_end_of_stream ||
+                   state.receive_error != 0;
+    }
+#else
+    (void)timeout;
+#endif
+    return ONE_ERROR_NONE;
+}
+
+OneError IoUringTransport::ready_for_send(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+#ifdef ONE_ARCUS_IO_URING
+    auto &state = *_state;
+    state.reap();
+    is_ready = state.send_end < send_buffer_size || state.send_error != 0;
+    if (!is_ready && timeout > 0.f) {
+        auto err = state.wait(timeout);
+        if (is_error(err)) {
+            return err;
+        }
+        state.reap();
+        is_ready = state.send_end < send_buffer_size || state.send_error != 0;
+    }
+    return state.resume();
+#else
+    (void)timeout;
+    return ONE_ERROR_NONE;
+#endif
+}
+
+OneError IoUringTransport::send(const void *data, size_t length, size_t &length_sent) {
+    length_sent = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+#ifdef ONE_ARCUS_IO_URING
+    auto &state = *_state;
+    state.reap();
+    if (state.send_error != 0) {
+        return ONE_ERROR_SOCKET_SEND_FAILED;
+    }
+
+    // Bytes in flight stay in place, the others move to the front to make
+    // room.
+    if (!state.is_sending && state.send_begin > 0) {
+        std::memmove(state.send_buffer, state.send_buffer + state.send_begin,
+                     state.send_end - state.send_begin);
+        state.send_end -= state.send_begin;
+        state.send_begin = 0;
+    }
+
+    const size_t size = std::min(length, send_buffer_size - state.send_end);
+    std::memcpy(state.send_buffer + state.send_end, data, size);
+    state.send_end += size;
+    length_sent = size;
+    return state.resume();
+#else
+    (void)data;
+    (void)length;
+    return ONE_ERROR_NONE;
+#endif
+}
+
+OneError IoUringTransport::receive(void *data, size_t length, size_t &length_received) {
+    length_received = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+#ifdef ONE_ARCUS_IO_URING
+    auto &state = *_state;
+    state.reap();
+
+    auto *bytes = static_cast<unsigned char *>(data);
+    while (length_received < length && state.received_count > 0) {
+        auto &received = state.received[state.received_head];
+        const size_t size = std::min(length - length_received,
+                                     received.length - received.offset);
+        std::memcpy(bytes + length_received,
+                    state.receive_buffers +
+                        static_cast<size_t>(received.id) * receive_buffer_size +
+                        received.offset,
+                    size);
+        received.offset += size;
+        length_received += size;
+        if (received.offset == received.length) {
+            state.recycle(received.id);
+            state.received_head = (state.received_head + 1) % receive_buffer_count;
+            --state.received_count;
+        }
+    }
+
+    // Like a socket, the end of the stream is a receive of zero bytes.
+    if (length_received == 0 && state.receive_error != 0) {
+        return ONE_ERROR_SOCKET_RECEIVE_FAILED;
+    }
+    return state.resume();
+#else
+    (void)data;
+    (void)length;
+    return ONE_ERROR_NONE;
+#endif
+}
+
+OneError IoUringTransport::address(String &ip, unsigned int &port) const {
+    if (_socket == nullptr) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    return _socket->address(ip, port);
+}
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <one/arcus/error.h>
+#include <one/arcus/internal/transport.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+
+class Socket;
+
+namespace uring {
+struct State;
+}
+
+// Transport moving the bytes of a connected Socket through io_uring, on Linux
+// 6.0 and later. A multishot receive fills buffers provided to the kernel as
+// data arrives, so that receiving and checking for readiness only read the
+// completion queue, without system calls. Sent bytes are copied to a staging
+// buffer, and bytes sent while a send is in flight go out together in the
+// next one.
+//
+// The ring and buffers are created by init and reused by the sockets attached
+// in turn. Where io_uring is unavailable, is_supported returns false and the
+// socket is used directly instead.
+class IoUringTransport final : public Transport {
+public:
+    // Buffers provided to the kernel for the multishot receive. Once all hold
+    // unread data, receiving pauses until they are read.
+    static constexpr size_t receive_buffer_count = 8;
+    static constexpr size_t receive_buffer_size = 4 * 1024;
+    // Bytes staged for sending.
+    static constexpr size_t send_buffer_size = 16 * 1024;
+
+    // Whether io_uring and its multishot receive are available. Probed on the
+    // first call.
+    static bool is_supported();
+
+    IoUringTransport();
+    IoUringTransport(const IoUringTransport &) = delete;
+    IoUringTransport &operator=(const IoUringTransport &) = delete;
+    ~IoUringTransport();
+
+    // Creates the ring and its buffers. Returns ONE_ERROR_TRANSPORT_UNSUPPORTED
+    // if io_uring is not available.
+    OneError init();
+
+    // Detaches the socket, if any, and frees the ring and buffers.
+    void shutdown();
+
+    // Starts receiving on the connected socket, which must stay open until
+    // detach.
+    OneError attach(Socket &socket);
+
+    // Cancels the pending receive and send, waiting for the kernel to release
+    // the buffers. Unsent bytes are dropped.
+    void detach();
+
+    // Bytes allocated for the buffers.
+    size_t footprint() const;
+
+    // Whether a socket is attached.
+    bool is_initialized() const override;
+
+    OneError ready_for_read(float timeout, bool &is_ready) override;
+    OneError ready_for_send(float timeout, bool &is_ready) override;
+    OneError send(const void *data, size_t length, size_t &length_sent) override;
+    OneError receive(void *data, size_t length, size_t &length_received) override;
+
+    // The address of the attached socket.
+    OneError address(String &ip, unsigned int &port) const override;
+
+private:
+    static bool probe();
+    OneError attach_descriptor(int descriptor);
+
+    uring::State *_state;
+    Socket *_socket;
+};
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,214 @@
+#include <one/arcus/internal/json.h>
+
+#include <one/arcus/allocator.h>
+
+#include <cstddef>
+#include <cstring>
+
+namespace i3d {
+namespace one {
+namespace json {
+
+namespace {
+
+// Size classes are powers of two from 16 to 4096 bytes.
+constexpr size_t smallest_class_size = 16;
+constexpr size_t class_count = 9;
+// Marks blocks larger than the largest class, which are not cached.
+constexpr size_t uncached_class = class_count;
+
+// Bounds the memory each thread keeps, in total and per class, so that a
+// burst of large messages does not leave a thread holding much more than its
+// steady state needs.
+constexpr size_t max_cached_bytes = 16 * 1024;
+constexpr size_t max_cached_bytes_per_class = 4 * 1024;
+constexpr size_t max_cached_blocks_per_class = 16;
+
+// Precedes each block, padded to keep the returned memory aligned for any
+// value.
+union BlockHeader {
+    struct {
+        size_t size_class;
+        size_t capacity;
+    } info;
+    std::max_align_t alignment;
+};
+
+// Cached blocks are linked through their first bytes.
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+size_t class_size(size_t size_class) {
+    return smallest_class_size << size_class;
+}
+
+size_t max_cached_blocks(size_t size_class) {
+    const size_t blocks = max_cached_bytes_per_class / class_size(size_class);
+    return blocks < max_cached_blocks_per_class ? blocks : max_cached_blocks_per_class;
+}
+
+size_t size_class_of(size_t size) {
+    size_t size_class = 0;
+    while (size_class < class_count && class_size(size_class) < size) {
+        ++size_class;
+    }
+    return size_class;
+}
+
+BlockHeader *header(void *p) {
+    return reinterpret_cast<BlockHeader *>(p) - 1;
+}
+
+void release(void *p) {
+    allocator::free(header(p));
+}
+
+struct Cache {
+    FreeBlock *free_blocks[class_count] = {};
+    size_t counts[class_count] = {};
+    size_t bytes = 0;  // Class sizes of the cached blocks, without headers.
+
+    ~Cache();
+
+    void flush();
+};
+
+// Set once the cache of the thread is destroyed, so that blocks freed later
+// during thread or static destruction bypass it.
+thread_local bool _is_cache_destroyed = false;
+thread_local Cache _cache;
+
+Cache::~Cache() {
+    _is_cache_destroyed = true;
+    flush();
+}
+
+void Cache::flush() {
+    for (size_t i = 0; i < class_count; ++i) {
+        while (free_blocks[i] != nullptr) {
+            FreeBlock *block = free_blocks[i];
+            free_blocks[i] = block->next;
+            release(block);
+        }
+        counts[i] = 0;
+    }
+    bytes = 0;
+}
+
+size_t capacity_of(size_t size_class, size_t size) {
+    return (size_class == uncached_class) ? size : class_size(size_class);
+}
+
+// The pool has its own thread caches, caching here too would only round the
+// sizes up twice and keep blocks out of its reach.
+size_t block_class_of(size_t size) {
+    return allocator::is_pool() ? uncached_class : size_class_of(size);
+}
+
+}  // namespace
+
+void *alloc(size_t size) {
+    const size_t size_class = block_class_of(size);
+
+    if (size_class != uncached_class && !_is_cache_destroyed) {
+        FreeBlock *block = _cache.free_blocks[size_class];
+        if (block != nullptr) {
+            _cache.free_blocks[size_class] = block->next;
+            --_cache.counts[size_class];
+            _cache.bytes -= class_size(size_class);
+            return block;
+        }
+    }
+
+    const size_t capacity = capacity_of(size_class, size);
+    auto h = reinterpret_cast<BlockHeader *>(
+        allocator::alloc(sizeof(BlockHeader) + capacity, allocator::Category::json));
+    if (h == nullptr) {
+        return nullptr;
+    }
+    h->info.size_class = size_class;
+    h->info.capacity = capacity;
+    return h + 1;
+}
+
+void *realloc(void *p, size_t size) {
+    if (p == nullptr) {
+        return alloc(size);
+    }
+    if (size == 0) {
+        free(p);
+        return nullptr;
+    }
+
+    const auto &info = header(p)->info;
+    if (size <= info.capacity) {
+        return p;
+    }
+
+    // Not cached, so grown by the allocator, which may do it in place, e.g.
+    // malloc, or the pool for blocks over its largest size class.
+    if (info.size_class == uncached_class) {
+        auto h = reinterpret_cast<BlockHeader *>(allocator::realloc(
+            header(p), sizeof(BlockHeader) + size, allocator::Category::json));
+        if (h == nullptr) {
+            return nullptr;
+        }
+        h->info.capacity = size;
+        return h + 1;
+    }
+
+    const size_t capacity = info.capacity;
+    void *resized = alloc(size);
+    if (resized == nullptr) {
+        return nullptr;
+    }
+    std::memcpy(resized, p, capacity);
+    free(p);
+    return resized;
+}
+
+void free(void *p) {
+    if (p == nullptr) {
+        return;
+    }
+
+    const size_t size_class = header(p)->info.size_class;
+    if (size_class == uncached_class || _is_cache_destroyed ||
+        _cache.counts[size_class] == max_cached_blocks(size_class) ||
+        _cache.bytes + class_size(size_class) > max_cached_bytes) {
+        release(p);
+        return;
+    }
+
+    auto block = reinterpret_cast<FreeBlock *>(p);
+    block->next = _cache.free_blocks[size_class];
+    _cache.free_blocks[size_class] = block;
+    ++_cache.counts[size_class];
+    _cache.bytes += class_size(size_class);
+}
+
+void flush() {
+    if (!_is_cache_destroyed) {
+        _cache.flush();
+    }
+}
+
+size_t block_size(size_t size) {
+    return sizeof(BlockHeader) + capacity_of(block_class_of(size), size);
+}
+
+size_t cached_size() {
+    if (_is_cache_destroyed) {
+        return 0;
+    }
+    size_t size = 0;
+    for (size_t i = 0; i < class_count; ++i) {
+        size += _cache.counts[i] * (sizeof(BlockHeader) + class_size(i));
+    }
+    return size;
+}
+
+}  // namespace json
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace i3d {
+namespace one {
+
+// Memory for rapidjson, which allocates every value and its parse and write
+// stacks separately and frees them as soon as a document changes or is
+// destroyed. Freed blocks are kept in per thread, size class free lists and
+// handed out again, so that repeatedly building, copying, parsing and
+// serializing messages of similar shape stops allocating once warmed up.
+//
+// Cache misses and blocks larger than the largest size class go through the
+// arcus allocator. Cached blocks remain allocated from its point of view until
+// flush is called on their thread or the thread exits, with at most 16 KiB
+// cached per thread. With allocator::use_pool, which caches per thread itself,
+// all blocks go through the allocator directly.
+namespace json {
+
+void *alloc(size_t size);
+void *realloc(void *p, size_t size);
+void free(void *p);
+
+// Bytes taken from the arcus allocator for a block of the given size.
+size_t block_size(size_t size);
+
+// Bytes held by the free lists of the calling thread.
+size_t cached_size();
+
+// Releases the blocks cached by the calling thread. Server and Client shutdown
+// call it, for the thread shutting them down.
+void flush();
+
+}  // namespace json
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,296 @@
+#include <one/arcus/internal/loopback.h>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/internal/ring.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace i3d {
+namespace one {
+
+namespace loopback {
+
+using namespace std::chrono;
+
+// Chunks in flight when delivery is delayed. Sends make no progress while
+// all are in flight.
+constexpr size_t max_chunks = 256;
+
+// Bytes sent by a single send, receivable from the ready time.
+struct Chunk {
+    size_t end;  // Value of Direction::head after the send.
+    steady_clock::time_point ready;
+};
+
+// Bytes flowing from one end to the other. The counters are the bytes written,
+// delivered and read since init, their value modulo the capacity is the
+// offset in the data.
+struct Direction {
+    Direction(const LoopbackOptions &options)
+        : options(options)
+        , data(nullptr)
+        , head(0)
+        , delivered(0)
+        , tail(0)
+        , chunks(max_chunks)
+        , is_writer_closed(false)
+        , is_reader_closed(false) {}
+    ~Direction() {
+        if (data != nullptr) {
+            allocator::destroy_array<unsigned char>(data);
+        }
+    }
+
+    bool is_delayed() const {
+        return options.latency.count() > 0 || options.bytes_per_second > 0;
+    }
+
+    // Delivers the chunks that are due. Requires the mutex.
+    void deliver(steady_clock::time_point now) {
+        while (chunks.size() > 0 && chunks.peek()->ready <= now) {
+            delivered = chunks.pop().end;
+        }
+    }
+
+    // Copies between the data and the given bytes, wrapping around the end of
+    // the data.
+    void copy_in(const unsigned char *bytes, size_t length) {
+        const size_t offset = head % options.capacity;
+        const size_t first = std::min(length, options.capacity - offset);
+        std::memcpy(data + offset, bytes, first);
+        std::memcpy(data, bytes + first, length - first);
+    }
+    void copy_out(unsigned char *bytes, size_t length) const {
+        const size_t offset = tail % options.capacity;
+        const size_t first = std::min(length, options.capacity - offset);
+        std::memcpy(bytes, data + offset, first);
+        std::memcpy(bytes + first, data, length - first);
+    }
+
+    const LoopbackOptions options;
+    unsigned char *data;
+    size_t head;
+    size_t delivered;
+    size_t tail;
+    Ring<Chunk> chunks;
+    steady_clock::time_point link_free_time;  // Bandwidth used until then.
+    bool is_writer_closed;
+    bool is_reader_closed;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+// Waits on the direction until is_ready returns true or the timeout in seconds
+// passes, delivering chunks as they become due.
+template <class IsReady>
+bool wait_until(Direction &direction, std::unique_lock<std::mutex> &lock, float timeout,
+                IsReady is_ready) {
+    const auto deadline = steady_clock::now() +
+                          duration_cast<steady_clock::duration>(duration<float>(timeout));
+    while (true) {
+        const auto now = steady_clock::now();
+        direction.deliver(now);
+        if (is_ready()) {
+            return true;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+        auto until = deadline;
+        if (direction.chunks.size() > 0) {
+            until = std::min(until, direction.chunks.peek()->ready);
+        }
+        direction.changed.wait_until(lock, until);
+    }
+}
+
+}  // namespace loopback
+
+using namespace loopback;
+
+LoopbackTransport::LoopbackTransport() : _in(nullptr), _out(nullptr), _index(0) {}
+
+void LoopbackTransport::close() {
+    if (!is_initialized()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_out->mutex);
+        _out->is_writer_closed = true;
+    }
+    _out->changed.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(_in->mutex);
+        _in->is_reader_closed = true;
+    }
+    _in->changed.notify_all();
+    _in = nullptr;
+    _out = nullptr;
+}
+
+bool LoopbackTransport::is_initialized() const {
+    return _in != nullptr;
+}
+
+OneError LoopbackTransport::ready_for_read(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    // Ready once there is data, or once the peer closed so that receive
+    // reports it.
+    auto &in = *_in;
+    std::unique_lock<std::mutex> lock(in.mutex);
+    is_ready = wait_until(in, lock, timeout, [&]() {
+        return in.delivered != in.tail || in.is_writer_closed;
+    });
+    return ONE_ERROR_NONE;
+}
+
+OneError LoopbackTransport::ready_for_send(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    auto &out = *_out;
+    std::unique_lock<std::mutex> lock(out.mutex);
+    is_ready = wait_until(out, lock, timeout, [&]() {
+        const bool has_chunk = !out.is_delayed() || out.chunks.size() < max_chunks;
+        return (out.head - out.tail < out.options.capacity && has_chunk) ||
+               out.is_reader_closed;
+    });
+    return ONE_ERROR_NONE;
+}
+
+OneError LoopbackTransport::send(const void *data, size_t length, size_t &length_sent) {
+    length_sent = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    auto &out = *_out;
+    {
+        std::lock_guard<std::mutex> lock(out.mutex);
+        if (out.is_reader_closed) return ONE_ERROR_TRANSPORT_PEER_CLOSED;
+
+        const auto &options = out.options;
+        size_t size = std::min(length, options.capacity - (out.head - out.tail));
+        if (options.max_send_size > 0) {
+            size = std::min(size, options.max_send_size);
+        }
+        if (out.is_delayed() && out.chunks.size() >= max_chunks) {
+            size = 0;
+        }
+        if (size == 0) {
+            return ONE_ERROR_NONE;
+        }
+
+        out.copy_in(static_cast<const unsigned char *>(data), size);
+        out.head += size;
+        if (out.is_delayed()) {
+            // The chunk is sent once the previous ones are, taking its share of
+            // the bandwidth, and arrives after the latency.
+            const auto now = steady_clock::now();
+            auto sent = std::max(now, out.link_free_time);
+            if (options.bytes_per_second > 0) {
+                sent += duration_cast<steady_clock::duration>(duration<double>(
+                    static_cast<double>(size) / options.bytes_per_second));
+            }
+            out.link_free_time = sent;
+            out.chunks.push(Chunk{out.head, sent + options.latency});
+        } else {
+            out.delivered = out.head;
+        }
+        length_sent = size;
+    }
+    out.changed.notify_all();
+    return ONE_ERROR_NONE;
+}
+
+OneError LoopbackTransport::receive(void *data, size_t length,
+                                    size_t &length_received) {
+    length_received = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    auto &in = *_in;
+    {
+        std::lock_guard<std::mutex> lock(in.mutex);
+        in.deliver(steady_clock::now());
+        size_t size = std::min(length, in.delivered - in.tail);
+        if (in.options.max_receive_size > 0) {
+            size = std::min(size, in.options.max_receive_size);
+        }
+        if (size == 0) {
+            // The bytes sent before closing are received first.
+            if (in.is_writer_closed && in.head == in.tail) {
+                return ONE_ERROR_TRANSPORT_PEER_CLOSED;
+            }
+            return ONE_ERROR_NONE;
+        }
+
+        in.copy_out(static_cast<unsigned char *>(data), size);
+        in.tail += size;
+        length_received = size;
+    }
+    in.changed.notify_all();
+    return ONE_ERROR_NONE;
+}
+
+OneError LoopbackTransport::address(String &ip, unsigned int &port) const {
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    ip = "loopback";
+    port = _index;
+    return ONE_ERROR_NONE;
+}
+
+LoopbackPipe::LoopbackPipe() : _directions{nullptr, nullptr} {
+    _ends[1]._index = 1;
+}
+
+LoopbackPipe::~LoopbackPipe() {
+    shutdown();
+}
+
+OneError LoopbackPipe::init(const LoopbackOptions &options) {
+    if (!options.is_valid()) {
+        return ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID;
+    }
+    if (_directions[0] != nullptr) {
+        return ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED;
+    }
+
+    allocator::ScopedCategory category(allocator::Category::connection);
+    for (auto &direction : _directions) {
+        direction = allocator::create<Direction>(options);
+        if (direction == nullptr) {
+            shutdown();
+            return ONE_ERROR_TRANSPORT_ALLOCATION_FAILED;
+        }
+        direction->data = allocator::create_array<unsigned char>(options.capacity);
+        if (direction->data == nullptr ||
+            (direction->is_delayed() && !direction->chunks.reserve())) {
+            shutdown();
+            return ONE_ERROR_TRANSPORT_ALLOCATION_FAILED;
+        }
+    }
+
+    // The first end writes the first direction and reads the second.
+    _ends[0]._out = _ends[1]._in = _directions[0];
+    _ends[1]._out = _ends[0]._in = _directions[1];
+    return ONE_ERROR_NONE;
+}
+
+void LoopbackPipe::shutdown() {
+    for (auto &end : _ends) {
+        end.close();
+    }
+    for (auto &direction : _directions) {
+        if (direction != nullptr) {
+            allocator::destroy<Direction>(direction);
+            direction = nullptr;
+        }
+    }
+}
+
+}  // namespace one
+}  // namespace i3d
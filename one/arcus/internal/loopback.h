@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <chrono>
+
+#include <one/arcus/error.h>
+#include <one/arcus/internal/transport.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+
+namespace loopback {
+struct Direction;
+}
+
+// Network conditions simulated by a LoopbackPipe, in each direction. The
+// defaults deliver every byte immediately, so that benchmarks measure only
+// the cost of the SDK.
+struct LoopbackOptions {
+    LoopbackOptions()
+        : capacity(64 * 1024)
+        , max_send_size(0)
+        , max_receive_size(0)
+        , latency(0)
+        , bytes_per_second(0) {}
+
+    // Bytes in flight before sends stop making progress.
+    size_t capacity;
+    // Bytes accepted by a single send or returned by a single receive, to
+    // force partial writes and reads. Zero for no limit.
+    size_t max_send_size;
+    size_t max_receive_size;
+    // Delay before sent bytes can be received.
+    std::chrono::microseconds latency;
+    // Rate at which sent bytes are delivered, after the latency. Zero for no
+    // limit.
+    size_t bytes_per_second;
+
+    bool is_valid() const {
+        return capacity > 0 && latency.count() >= 0;
+    }
+};
+
+class LoopbackPipe;
+
+// One end of a LoopbackPipe.
+class LoopbackTransport final : public Transport {
+public:
+    LoopbackTransport(const LoopbackTransport &) = delete;
+    LoopbackTransport &operator=(const LoopbackTransport &) = delete;
+
+    // Stops this end. The peer receives the bytes already sent, after which
+    // its send and receive return ONE_ERROR_TRANSPORT_PEER_CLOSED.
+    void close();
+
+    bool is_initialized() const override;
+
+    OneError ready_for_read(float timeout, bool &is_ready) override;
+    OneError ready_for_send(float timeout, bool &is_ready) override;
+    OneError send(const void *data, size_t length, size_t &length_sent) override;
+    OneError receive(void *data, size_t length, size_t &length_received) override;
+
+    // Sets ip to "loopback" and port to the index of the end.
+    OneError address(String &ip, unsigned int &port) const override;
+
+private:
+    friend class LoopbackPipe;
+    LoopbackTransport();
+
+    loopback::Direction *_in;
+    loopback::Direction *_out;
+    unsigned int _index;
+};
+
+// Two connected in memory transports, for tests and benchmarks that run both
+// peers of a Connection in one process. No sockets or ports are used, so any
+// number of pipes can run in parallel. The ends may be used from different
+// threads, but each end from one thread at a time.
+class LoopbackPipe final {
+public:
+    LoopbackPipe();
+    LoopbackPipe(const LoopbackPipe &) = delete;
+    LoopbackPipe &operator=(const LoopbackPipe &) = delete;
+    ~LoopbackPipe();
+
+    // Allocates the buffers of both directions. Returns
+    // ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID for invalid options.
+    OneError init(const LoopbackOptions &options = LoopbackOptions());
+
+    // Closes both ends and frees the buffers.
+    void shutdown();
+
+    LoopbackTransport &first() {
+        return _ends[0];
+    }
+    LoopbackTransport &second() {
+        return _ends[1];
+    }
+
+private:
+    loopback::Direction *_directions[2];
+    LoopbackTransport _ends[2];
+};
+
+}  // namespace one
+}  // namespace i3d
@@ -211,13 +211,36 @@ OneError custom_command(const Message &message, params::CustomCommandRequest &pa
     return ONE_ERROR_NONE;
 }
 
+OneError features(const Message &message, params::FeaturesRequest &params) {
+    const auto code = message.code();
+    if (!is_opcode_supported(code)) {
+        return ONE_ERROR_MESSAGE_OPCODE_NOT_SUPPORTED;
+    }
+
+    if (code != Opcode::features) {
+        return ONE_ERROR_MESSAGE_OPCODE_NOT_MATCHING_EXPECTING_FEATURES;
+    }
+
+    // Features unknown to the sender are omitted.
+    params._live_state_delta = false;
+    const auto &payload = message.payload();
+    if (payload.is_val_bool("liveStateDelta")) {
+        auto err = payload.val_bool("liveStateDelta", params._live_state_delta);
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    return ONE_ERROR_NONE;
+}
+
 }  // namespace validation
 
 namespace invocation {
 
-OneError soft_stop(const Message &message, std::function<void(void *, int)> callback,
-                   void *data) {
-    if (callback == nullptr) {
+OneError soft_stop(const Message &message,
+                   const Callback<void(void *, int)> &callback, void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -231,9 +254,9 @@ OneError soft_stop(const Message &message, std::function<void(void *, int)> call
     return ONE_ERROR_NONE;
 }
 
-OneError allocated(const Message &message, std::function<void(void *, Array *)> callback,
-                   void *data) {
-    if (callback == nullptr) {
+OneError allocated(const Message &message,
+                   const Callback<void(void *, Array *)> &callback, void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -247,9 +270,9 @@ OneError allocated(const Message &message, std::function<void(void *, Array *)>
     return ONE_ERROR_NONE;
 }
 
-OneError metadata(const Message &message, std::function<void(void *, Array *)> callback,
-                  void *data) {
-    if (callback == nullptr) {
+OneError metadata(const Message &message,
+                  const Callback<void(void *, Array *)> &callback, void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -264,8 +287,9 @@ OneError metadata(const Message &message, std::function<void(void *, Array *)> c
 }
 
 OneError reverse_metadata(const Message &message,
-                          std::function<void(void *, Array *)> callback, void *data) {
-    if (callback == nullptr) {
+                          const Callback<void(void *, Array *)> &callback,
+                          void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -280,11 +304,11 @@ OneError reverse_metadata(const Message &message,
 }
 
 OneError live_state(const Message &message,
-                    std::function<void(void *, int, int, const String &, const String &,
-                                       const String &, const String &)>
-                        callback,
+                    const Callback<void(void *, int, int, const String &,
+                                        const String &, const String &,
+                                        const String &)> &callback,
                     void *data) {
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -300,8 +324,9 @@ OneError live_state(const Message &message,
 }
 
 OneError host_information(const Message &message,
-                          std::function<void(void *, Object *)> callback, void *data) {
-    if (callback == nullptr) {
+                          const Callback<void(void *, Object *)> &callback,
+                          void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -315,10 +340,10 @@ OneError host_information(const Message &message,
     return ONE_ERROR_NONE;
 }
 
-OneError application_instance_information(const Message &message,
-                                          std::function<void(void *, Object *)> callback,
-                                          void *data) {
-    if (callback == nullptr) {
+OneError application_instance_information(
+    const Message &message, const Callback<void(void *, Object *)> &callback,
+    void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -333,9 +358,9 @@ OneError application_instance_information(const Message &message,
 }
 
 OneError application_instance_status(const Message &message,
-                                     std::function<void(void *, int)> callback,
+                                     const Callback<void(void *, int)> &callback,
                                      void *data) {
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
@@ -350,8 +375,9 @@ OneError application_instance_status(const Message &message,
 }
 
 OneError custom_command(const Message &message,
-                        std::function<void(void *, Array *)> callback, void *data) {
-    if (callback == nullptr) {
+                        const Callback<void(void *, Array *)> &callback,
+                        void *data) {
+    if (!callback) {
         return ONE_ERROR_MESSAGE_CALLBACK_IS_NULLPTR;
     }
 
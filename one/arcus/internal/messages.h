@@ -1,6 +1,7 @@
 #pragma once
 
 #include <one/arcus/array.h>
+#include <one/arcus/callback.h>
 #include <one/arcus/error.h>
 #include <one/arcus/message.h>
 #include <one/arcus/object.h>
@@ -55,6 +56,11 @@ struct CustomCommandRequest {
     Array _data;
 };
 
+struct FeaturesRequest {
+    // Missing features are not supported.
+    bool _live_state_delta;
+};
+
 }  // namespace params
 
 namespace validation {
@@ -71,41 +77,45 @@ OneError application_instance_information(
 OneError application_instance_status(const Message &message,
                                      params::ApplicationInstanceSetStatusRequest &params);
 OneError custom_command(const Message &message, params::CustomCommandRequest &params);
+OneError features(const Message &message, params::FeaturesRequest &params);
 }  // namespace validation
 
 namespace invocation {
 
-OneError soft_stop(const Message &message, std::function<void(void *, int)> callback,
-                   void *data);
+OneError soft_stop(const Message &message,
+                   const Callback<void(void *, int)> &callback, void *data);
 
-OneError allocated(const Message &message, std::function<void(void *, Array *)> callback,
-                   void *data);
+OneError allocated(const Message &message,
+                   const Callback<void(void *, Array *)> &callback, void *data);
 
-OneError metadata(const Message &message, std::function<void(void *, Array *)> callback,
-                  void *data);
+OneError metadata(const Message &message,
+                  const Callback<void(void *, Array *)> &callback, void *data);
 
 OneError reverse_metadata(const Message &message,
-                          std::function<void(void *, Array *)> callback, void *data);
+                          const Callback<void(void *, Array *)> &callback,
+                          void *data);
 
 OneError live_state(const Message &message,
-                    std::function<void(void *, int, int, const String &, const String &,
-                                       const String &, const String &)>
-                        callback,
+                    const Callback<void(void *, int, int, const String &,
+                                        const String &, const String &,
+                                        const String &)> &callback,
                     void *data);
 
 OneError host_information(const Message &message,
-                          std::function<void(void *, Object *)> callback, void *data);
+                          const Callback<void(void *, Object *)> &callback,
+                          void *data);
 
-OneError application_instance_information(const Message &message,
-                                          std::function<void(void *, Object *)> callback,
-                                          void *data);
+OneError application_instance_information(
+    const Message &message, const Callback<void(void *, Object *)> &callback,
+    void *data);
 
 OneError application_instance_status(const Message &message,
-                                     std::function<void(void *, int)> callback,
+                                     const Callback<void(void *, int)> &callback,
                                      void *data);
 
 OneError custom_command(const Message &message,
-                        std::function<void(void *, Array *)> callback, void *data);
+                        const Callback<void(void *, Array *)> &callback,
+                        void *data);
 
 }  // namespace invocation
 
@@ -0,0 +1,9 @@
+#include <one/arcus/internal/outgoing_queue_impl.h>
+
+namespace i3d {
+namespace one {
+
+template class BasicOutgoingQueue<0>;
+
+}  // namespace one
+}  // namespace i3d
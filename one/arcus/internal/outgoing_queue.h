@@ -0,0 +1,83 @@
+#pragma once
+
+#include <one/arcus/error.h>
+#include <one/arcus/internal/ring.h>
+#include <one/arcus/message.h>
+#include <one/arcus/opcode.h>
+
+namespace i3d {
+namespace one {
+
+// Queue of outgoing messages with a ring per priority class. Messages are
+// popped from the highest priority class that is not empty, in FIFO order
+// within a class, so that control traffic is not delayed behind bulk
+// messages. Each class holds up to the given capacity.
+//
+// A message with an opcode set to replace in queue overwrites a message with
+// the same opcode that is still queued, keeping its place, instead of being
+// queued after it.
+//
+// A non zero Capacity holds the rings inline, see Ring. Its definitions are in
+// outgoing_queue_impl.h, and the default is instantiated by
+// outgoing_queue.cpp.
+template <size_t Capacity = 0>
+class BasicOutgoingQueue final {
+public:
+    explicit BasicOutgoingQueue(size_t capacity_per_priority);
+    BasicOutgoingQueue(const BasicOutgoingQueue &) = delete;
+    BasicOutgoingQueue &operator=(const BasicOutgoingQueue &) = delete;
+
+    // Sets the priority class and replace in queue behavior of the opcode.
+    // Affects messages pushed afterwards.
+    OneError set_policy(Opcode code, Priority priority, bool replace_in_queue);
+    Priority priority(Opcode code) const;
+    bool replace_in_queue(Opcode code) const;
+
+    // Erases all queued messages. Policies are kept.
+    void clear();
+
+    size_t size() const;
+    size_t size(Priority priority) const;
+    size_t capacity_per_priority() const;
+
+    // Adds the bytes allocated for the slots of the queues, and for the
+    // messages in them.
+    void footprint(size_t &slots, size_t &messages) const;
+
+    // Queues a copy of the message, or replaces the queued one. Fails with
+    // ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE if the class of
+    // the message is full.
+    OneError push(const Message &message);
+
+    // Pops the next message to send. Asserts if the queue is empty. The
+    // returned slot is only reused by later pushes.
+    Message &pop();
+
+private:
+    struct Policy {
+        Priority priority;
+        bool replace_in_queue;
+    };
+    // Opcodes are sent as a single byte.
+    static constexpr size_t policy_count = 256;
+    static size_t policy_index(Opcode code) {
+        return static_cast<unsigned char>(code);
+    }
+
+    using Queue = Ring<Message, Capacity>;
+    Queue &ring(Priority priority);
+    const Queue &ring(Priority priority) const;
+
+    Policy _policies[policy_count];
+
+    Queue _control;
+    Queue _state;
+    Queue _bulk;
+};
+
+using OutgoingQueue = BasicOutgoingQueue<>;
+
+extern template class BasicOutgoingQueue<0>;
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <one/arcus/internal/outgoing_queue.h>
+
+#include <assert.h>
+
+namespace i3d {
+namespace one {
+
+template <size_t Capacity>
+BasicOutgoingQueue<Capacity>::BasicOutgoingQueue(size_t capacity_per_priority)
+    : _control(capacity_per_priority)
+    , _state(capacity_per_priority)
+    , _bulk(capacity_per_priority) {
+    for (size_t i = 0; i < policy_count; ++i) {
+        const auto code = static_cast<Opcode>(i);
+        _policies[i].priority = default_priority(code);
+        _policies[i].replace_in_queue = default_replace_in_queue(code);
+    }
+}
+
+template <size_t Capacity>
+OneError BasicOutgoingQueue<Capacity>::set_policy(Opcode code, Priority priority,
+                                                  bool replace_in_queue) {
+    if (!is_opcode_supported(code)) {
+        return ONE_ERROR_MESSAGE_OPCODE_NOT_SUPPORTED;
+    }
+
+    switch (priority) {
+        case Priority::control:
+        case Priority::state:
+        case Priority::bulk:
+            break;
+        default:
+            return ONE_ERROR_CONNECTION_PRIORITY_IS_INVALID;
+    }
+
+    auto &policy = _policies[policy_index(code)];
+    policy.priority = priority;
+    policy.replace_in_queue = replace_in_queue;
+    return ONE_ERROR_NONE;
+}
+
+template <size_t Capacity>
+Priority BasicOutgoingQueue<Capacity>::priority(Opcode code) const {
+    return _policies[policy_index(code)].priority;
+}
+
+template <size_t Capacity>
+bool BasicOutgoingQueue<Capacity>::replace_in_queue(Opcode code) const {
+    return _policies[policy_index(code)].replace_in_queue;
+}
+
+template <size_t Capacity>
+void BasicOutgoingQueue<Capacity>::clear() {
+    _control.clear();
+    _state.clear();
+    _bulk.clear();
+}
+
+template <size_t Capacity>
+size_t BasicOutgoingQueue<Capacity>::size() const {
+    return _control.size() + _state.size() + _bulk.size();
+}
+
+template <size_t Capacity>
+size_t BasicOutgoingQueue<Capacity>::size(Priority priority) const {
+    return ring(priority).size();
+}
+
+template <size_t Capacity>
+size_t BasicOutgoingQueue<Capacity>::capacity_per_priority() const {
+    return _control.capacity();
+}
+
+template <size_t Capacity>
+void BasicOutgoingQueue<Capacity>::footprint(size_t &slots, size_t &messages) const {
+    for (auto queue : {&_control, &_state, &_bulk}) {
+        slots += queue->allocated_size();
+        const Message *slot = queue->slots();
+        if (slot == nullptr) {
+            continue;
+        }
+        for (size_t i = 0; i < queue->capacity(); ++i) {
+            messages += slot[i].footprint();
+        }
+    }
+}
+
+template <size_t Capacity>
+OneError BasicOutgoingQueue<Capacity>::push(const Message &message) {
+    const auto &policy = _policies[policy_index(message.code())];
+    auto &queue = ring(policy.priority);
+
+    if (policy.replace_in_queue) {
+        for (size_t i = 0; i < queue.size(); ++i) {
+            auto &queued = queue.at(i);
+            if (queued.code() == message.code()) {
+                queued = message;
+                return ONE_ERROR_NONE;
+            }
+        }
+    }
+
+    if (queue.size() == queue.capacity()) {
+        return ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE;
+    }
+    if (!queue.reserve()) {
+        return ONE_ERROR_CONNECTION_QUEUE_ALLOCATION_FAILED;
+    }
+
+    queue.push(message);
+    return ONE_ERROR_NONE;
+}
+
+template <size_t Capacity>
+Message &BasicOutgoingQueue<Capacity>::pop() {
+    assert(size() > 0);
+    if (_control.size() > 0) {
+        return _control.pop();
+    }
+    if (_state.size() > 0) {
+        return _state.pop();
+    }
+    return _bulk.pop();
+}
+
+template <size_t Capacity>
+typename BasicOutgoingQueue<Capacity>::Queue &BasicOutgoingQueue<Capacity>::ring(
+    Priority priority) {
+    switch (priority) {
+        case Priority::control:
+            return _control;
+        case Priority::state:
+            return _state;
+        default:
+            return _bulk;
+    }
+}
+
+template <size_t Capacity>
+const typename BasicOutgoingQueue<Capacity>::Queue &
+BasicOutgoingQueue<Capacity>::ring(Priority priority) const {
+    switch (priority) {
+        case Priority::control:
+            return _control;
+        case Priority::state:
+            return _state;
+        default:
+            return _bulk;
+    }
+}
+
+}  // namespace one
+}  // namespace i3d
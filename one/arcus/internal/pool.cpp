@@ -0,0 +1,340 @@
+#include <one/arcus/internal/pool.h>
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace i3d {
+namespace one {
+namespace pool {
+
+namespace {
+
+constexpr size_t class_count = 12;  // 16 to 32768 bytes.
+static_assert((smallest_block_size << (class_count - 1)) == max_block_size,
+              "size classes must end at the max block size");
+
+// Marks blocks allocated directly from malloc.
+constexpr uint32_t large_class = class_count;
+
+constexpr size_t min_slab_size = 64 * 1024;
+// Bytes moved between a thread cache and the shared lists at once.
+constexpr size_t batch_bytes = 16 * 1024;
+constexpr size_t min_batch_count = 2;
+constexpr size_t max_batch_count = 64;
+
+// Precedes each block, padded to keep the returned memory aligned for any
+// value.
+union BlockHeader {
+    struct {
+        uint32_t size_class;
+        size_t size;  // Requested size of large blocks.
+    } info;
+    std::max_align_t alignment;
+};
+
+// Free blocks are linked through their first bytes.
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+size_t block_size(size_t size_class) {
+    return smallest_block_size << size_class;
+}
+
+size_t batch_count(size_t size_class) {
+    const size_t count = batch_bytes / block_size(size_class);
+    if (count < min_batch_count) {
+        return min_batch_count;
+    }
+    return count < max_batch_count ? count : max_batch_count;
+}
+
+size_t size_class_of(size_t size) {
+    size_t size_class = 0;
+    while (size_class < class_count && block_size(size_class) < size) {
+        ++size_class;
+    }
+    return size_class;
+}
+
+BlockHeader *header(void *p) {
+    return reinterpret_cast<BlockHeader *>(p) - 1;
+}
+
+struct SharedList {
+    std::mutex mutex;
+    FreeBlock *head = nullptr;
+    size_t count = 0;
+};
+
+struct Shared {
+    SharedList lists[class_count];
+
+    std::mutex slab_mutex;
+    size_t slab_bytes = 0;
+};
+
+// Never destroyed, as blocks may be freed during static destruction.
+Shared &shared() {
+    static Shared *instance = new Shared();
+    return *instance;
+}
+
+// Carves a new slab into blocks of the class and links them into a list.
+// Returns the number of blocks, or zero if malloc failed.
+size_t carve_slab(size_t size_class, FreeBlock *&head, FreeBlock *&tail) {
+    const size_t stride = sizeof(BlockHeader) + block_size(size_class);
+    size_t slab_size = stride * batch_count(size_class);
+    if (slab_size < min_slab_size) {
+        slab_size = min_slab_size;
+    }
+
+    auto slab = reinterpret_cast<char *>(std::malloc(slab_size));
+    if (slab == nullptr) {
+        return 0;
+    }
+
+    auto &state = shared();
+    {
+        const std::lock_guard<std::mutex> lock(state.slab_mutex);
+        state.slab_bytes += slab_size;
+    }
+
+    const size_t count = slab_size / stride;
+    head = nullptr;
+    tail = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        auto h = reinterpret_cast<BlockHeader *>(slab + i * stride);
+        h->info.size_class = static_cast<uint32_t>(size_class);
+        h->info.size = 0;
+        auto block = reinterpret_cast<FreeBlock *>(h + 1);
+        block->next = nullptr;
+        if (tail == nullptr) {
+            head = block;
+        } else {
+            tail->next = block;
+        }
+        tail = block;
+    }
+    return count;
+}
+
+// Moves up to count blocks from the shared list of the class to head,
+// carving a new slab if the shared list is empty. Returns the number of
+// blocks moved.
+size_t take_batch(size_t size_class, size_t count, FreeBlock *&head) {
+    auto &list = shared().lists[size_class];
+    {
+        const std::lock_guard<std::mutex> lock(list.mutex);
+        if (list.head != nullptr) {
+            size_t taken = 0;
+            FreeBlock *last = nullptr;
+            FreeBlock *block = list.head;
+            while (block != nullptr && taken < count) {
+                last = block;
+                block = block->next;
+                ++taken;
+            }
+            head = list.head;
+            last->next = nullptr;
+            list.head = block;
+            list.count -= taken;
+            return taken;
+        }
+    }
+
+    FreeBlock *slab_head = nullptr;
+    FreeBlock *slab_tail = nullptr;
+    const size_t carved = carve_slab(size_class, slab_head, slab_tail);
+    if (carved == 0) {
+        return 0;
+    }
+    if (carved <= count) {
+        head = slab_head;
+        return carved;
+    }
+
+    // Keep the batch and share the rest of the slab.
+    FreeBlock *last = slab_head;
+    for (size_t i = 1; i < count; ++i) {
+        last = last->next;
+    }
+    FreeBlock *rest = last->next;
+    last->next = nullptr;
+    head = slab_head;
+
+    const std::lock_guard<std::mutex> lock(list.mutex);
+    slab_tail->next = list.head;
+    list.head = rest;
+    list.count += carved - count;
+    return count;
+}
+
+// Links the list of count blocks into the shared list of the class.
+void give_batch(size_t size_class, FreeBlock *head, FreeBlock *tail, size_t count) {
+    auto &list = shared().lists[size_class];
+    const std::lock_guard<std::mutex> lock(list.mutex);
+    tail->next = list.head;
+    list.head = head;
+    list.count += count;
+}
+
+struct ThreadCache {
+    FreeBlock *lists[class_count] = {};
+    size_t counts[class_count] = {};
+
+    ~ThreadCache();
+};
+
+// Set once the cache of the thread is destroyed, so that blocks freed later
+// during thread or static destruction go to the shared lists.
+thread_local bool _is_cache_destroyed = false;
+thread_local ThreadCache _cache;
+
+ThreadCache::~ThreadCache() {
+    _is_cache_destroyed = true;
+    for (size_t i = 0; i < class_count; ++i) {
+        if (lists[i] == nullptr) {
+            continue;
+        }
+        FreeBlock *tail = lists[i];
+        while (tail->next != nullptr) {
+            tail = tail->next;
+        }
+        give_batch(i, lists[i], tail, counts[i]);
+        lists[i] = nullptr;
+        counts[i] = 0;
+    }
+}
+
+void *alloc_large(size_t size) {
+    auto h = reinterpret_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+    if (h == nullptr) {
+        return nullptr;
+    }
+    h->info.size_class = large_class;
+    h->info.size = size;
+    return h + 1;
+}
+
+}  // namespace
+
+void *alloc(size_t size) {
+    const size_t size_class = size_class_of(size);
+    if (size_class == large_class) {
+        return alloc_large(size);
+    }
+
+    if (_is_cache_destroyed) {
+        FreeBlock *block = nullptr;
+        if (take_batch(size_class, 1, block) == 0) {
+            return nullptr;
+        }
+        return block;
+    }
+
+    FreeBlock *&list = _cache.lists[size_class];
+    if (list == nullptr) {
+        _cache.counts[size_class] = take_batch(size_class, batch_count(size_class), list);
+        if (list == nullptr) {
+            return nullptr;
+        }
+    }
+
+    FreeBlock *block = list;
+    list = block->next;
+    --_cache.counts[size_class];
+    return block;
+}
+
+void free(void *p) {
+    if (p == nullptr) {
+        return;
+    }
+
+    const size_t size_class = header(p)->info.size_class;
+    if (size_class == large_class) {
+        std::free(header(p));
+        return;
+    }
+
+    auto block = reinterpret_cast<FreeBlock *>(p);
+    if (_is_cache_destroyed) {
+        give_batch(size_class, block, block, 1);
+        return;
+    }
+
+    block->next = _cache.lists[size_class];
+    _cache.lists[size_class] = block;
+    ++_cache.counts[size_class];
+
+    // Give a batch back once the thread holds two, so that memory freed by
+    // one thread can be reused by others.
+    const size_t batch = batch_count(size_class);
+    if (_cache.counts[size_class] >= 2 * batch) {
+        FreeBlock *head = _cache.lists[size_class];
+        FreeBlock *tail = head;
+        for (size_t i = 1; i < batch; ++i) {
+            tail = tail->next;
+        }
+        _cache.lists[size_class] = tail->next;
+        _cache.counts[size_class] -= batch;
+        give_batch(size_class, head, tail, batch);
+    }
+}
+
+void *realloc(void *p, size_t size) {
+    if (p == nullptr) {
+        return alloc(size);
+    }
+    if (size == 0) {
+        free(p);
+        return nullptr;
+    }
+
+    const auto &info = header(p)->info;
+    const size_t capacity =
+        (info.size_class == large_class) ? info.size : block_size(info.size_class);
+    if (size <= capacity) {
+        return p;
+    }
+
+    // Large blocks stay large when growing, and malloc may resize them in place.
+    if (info.size_class == large_class) {
+        auto h = reinterpret_cast<BlockHeader *>(
+            std::realloc(header(p), sizeof(BlockHeader) + size));
+        if (h == nullptr) {
+            return nullptr;
+        }
+        h->info.size = size;
+        return h + 1;
+    }
+
+    void *resized = alloc(size);
+    if (resized == nullptr) {
+        return nullptr;
+    }
+    std::memcpy(resized, p, capacity);
+    free(p);
+    return resized;
+}
+
+void statistics(Statistics &statistics) {
+    auto &state = shared();
+    {
+        const std::lock_guard<std::mutex> lock(state.slab_mutex);
+        statistics.slab_bytes = state.slab_bytes;
+    }
+    statistics.shared_blocks = 0;
+    for (auto &list : state.lists) {
+        const std::lock_guard<std::mutex> lock(list.mutex);
+        statistics.shared_blocks += list.count;
+    }
+}
+
+}  // namespace pool
+}  // namespace one
+}  // namespace i3d
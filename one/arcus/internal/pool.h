@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace i3d {
+namespace one {
+
+// Built-in memory pool, selected with allocator::use_pool.
+//
+// Requests up to max_block_size bytes are rounded up to power of two size
+// classes. Each thread keeps a free list per class and refills it in batches
+// from a shared, locked list per class, which is itself refilled by carving
+// slabs obtained from malloc. Threads give batches back when their list grows
+// too long and all of their blocks when they exit. Slabs are kept for reuse
+// and never returned to the system. Larger requests go to malloc directly.
+namespace pool {
+
+constexpr size_t smallest_block_size = 16;
+constexpr size_t max_block_size = 32 * 1024;
+
+void *alloc(size_t size);
+void free(void *p);
+void *realloc(void *p, size_t size);
+
+struct Statistics {
+    size_t slab_bytes;     // Obtained from malloc for slabs.
+    size_t shared_blocks;  // Blocks in the shared lists, not in thread caches.
+};
+
+void statistics(Statistics &statistics);
+
+}  // namespace pool
+
+}  // namespace one
+}  // namespace i3d
@@ -646,24 +646,25 @@ RAPIDJSON_NAMESPACE_END
 
 // i3d::one change
 #include <one/arcus/allocator.h>
+#include <one/arcus/internal/json.h>
 
 #ifndef RAPIDJSON_MALLOC
 ///! customization point for global \c malloc
 // i3d::one change
 //#define RAPIDJSON_MALLOC(size) std::malloc(size)
-#define RAPIDJSON_MALLOC(size) i3d::one::allocator::alloc(size)
+#define RAPIDJSON_MALLOC(size) i3d::one::json::alloc(size)
 #endif
 #ifndef RAPIDJSON_REALLOC
 ///! customization point for global \c realloc
 // i3d::one change
 //#define RAPIDJSON_REALLOC(ptr, new_size) std::realloc(ptr, new_size)
-#define RAPIDJSON_REALLOC(ptr, new_size) i3d::one::allocator::realloc(ptr, new_size)
+#define RAPIDJSON_REALLOC(ptr, new_size) i3d::one::json::realloc(ptr, new_size)
 #endif
 #ifndef RAPIDJSON_FREE
 ///! customization point for global \c free
 // i3d::one change
 //#define RAPIDJSON_FREE(ptr) std::free(ptr)
-#define RAPIDJSON_FREE(ptr) i3d::one::allocator::free(ptr)
+#define RAPIDJSON_FREE(ptr) i3d::one::json::free(ptr)
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1,27 +1,115 @@
 #pragma once
 
 #include <assert.h>
+#include <array>
 
 #include <one/arcus/allocator.h>
 
 namespace i3d {
 namespace one {
 
-// FIFO ring buffer with a fixed capacity.
+namespace ring {
+
+// Slots of a Ring held inline, for a capacity known at compile time. They
+// need no allocation, and the wrap around compares with a constant.
+template <typename T, size_t Capacity>
+class Slots final {
+public:
+    explicit Slots(size_t) {}
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+    bool reserve() {
+        return true;
+    }
+    T *data() {
+        return _slots.data();
+    }
+    const T *data() const {
+        return _slots.data();
+    }
+    // Part of the owner, nothing is allocated.
+    size_t allocated_size() const {
+        return 0;
+    }
+
+private:
+    std::array<T, Capacity> _slots;
+};
+
+// Slots allocated by the first reserve, for a capacity given at construction,
+// so that queues that are never used take no memory.
 template <typename T>
-class Ring final {
+class Slots<T, 0> final {
 public:
-    Ring(size_t capacity)
-        : _buffer(nullptr), _capacity(capacity), _size(0), _last(0), _next(0) {
+    explicit Slots(size_t capacity) : _buffer(nullptr), _capacity(capacity) {
         assert(_capacity > 0);
-        void *p = allocator::create_array<T>(_capacity);
-        assert(p);
-        _buffer = reinterpret_cast<T *>(p);
     }
-    ~Ring() {
-        assert(_buffer);
-        allocator::destroy_array<T>(_buffer);
-        _buffer = nullptr;
+    ~Slots() {
+        if (_buffer != nullptr) {
+            allocator::destroy_array<T>(_buffer);
+            _buffer = nullptr;
+        }
+    }
+    Slots(const Slots &) = delete;
+    Slots &operator=(const Slots &) = delete;
+
+    size_t capacity() const {
+        return _capacity;
+    }
+    bool reserve() {
+        if (_buffer != nullptr) {
+            return true;
+        }
+        // Rings only hold the connection message queues.
+        allocator::ScopedCategory category(allocator::Category::connection);
+        _buffer = allocator::create_array<T>(_capacity);
+        return _buffer != nullptr;
+    }
+    T *data() {
+        return _buffer;
+    }
+    const T *data() const {
+        return _buffer;
+    }
+    size_t allocated_size() const {
+        if (_buffer == nullptr) {
+            return 0;
+        }
+        return sizeof(size_t) + _capacity * sizeof(T);
+    }
+
+private:
+    T *_buffer;
+    const size_t _capacity;
+};
+
+}  // namespace ring
+
+// FIFO ring buffer with a fixed capacity. By default the capacity is given at
+// construction and the slots are only allocated by the first reserve or push.
+// A non zero Capacity holds the slots inline instead, ignoring the capacity
+// given at construction.
+template <typename T, size_t Capacity = 0>
+class Ring final {
+public:
+    Ring(size_t capacity = Capacity) : _slots(capacity), _size(0), _last(0), _next(0) {}
+
+    // Allocates the slots, if not yet done. Returns false if the allocation
+    // failed.
+    bool reserve() {
+        return _slots.reserve();
+    }
+
+    // The slots, or nullptr if not yet allocated.
+    const T *slots() const {
+        return _slots.data();
+    }
+
+    // Bytes allocated for the slots, zero if not yet allocated or inline.
+    size_t allocated_size() const {
+        return _slots.allocated_size();
     }
 
     Ring(const Ring &) = delete;
@@ -33,17 +121,22 @@ public:
     }
 
     size_t capacity() const {
-        return _capacity;
+        return _slots.capacity();
     }
     size_t size() const {
         return _size;
     }
 
+    // Asserts if the slots could not be allocated, callers that handle the
+    // failure reserve first.
     void push(const T &val) {
-        _buffer[_next] = val;
+        const bool is_reserved = reserve();
+        assert(is_reserved);
+        (void)is_reserved;
+        _slots.data()[_next] = val;
         _next++;
-        if (_next >= _capacity) _next = 0;
-        if (_size < _capacity) _size++;
+        if (_next >= capacity()) _next = 0;
+        if (_size < capacity()) _size++;
     }
 
     // Returns the last element, if any, or null if none.
@@ -51,7 +144,13 @@ public:
         if (_size == 0) {
             return nullptr;
         }
-        return &_buffer[_last];
+        return &_slots.data()[_last];
+    }
+
+    // Returns the index-th oldest element. Asserts if index is out of range.
+    T &at(size_t index) {
+        assert(index < _size);
+        return _slots.data()[(_last + index) % capacity()];
     }
 
     // Pops the oldest pushed value. Asserts if size is zero.
@@ -62,15 +161,14 @@ public:
         // referencing the current last in the buffer.
         const auto prev_last = _last;
         _last++;
-        if (_last >= _capacity) _last = 0;
+        if (_last >= capacity()) _last = 0;
         if (_size > 0) _size--;
-        return _buffer[prev_last];
+        return _slots.data()[prev_last];
     }
 
 private:
-    T *_buffer;
+    ring::Slots<T, Capacity> _slots;
 
-    const size_t _capacity;
     size_t _size;
 
     unsigned int _last;  // The oldest pushed item that is not yet popped.
@@ -0,0 +1,398 @@
+#include <one/arcus/internal/shared_memory.h>
+
+#include <one/arcus/c_platform.h>
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <random>
+
+#ifndef ONE_WINDOWS
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+    #if defined(__linux__)
+        #include <linux/futex.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+namespace i3d {
+namespace one {
+
+namespace shared_memory {
+
+constexpr uint32_t region_magic = 0x53435241;  // "ARCS".
+constexpr uint32_t region_version = 2;
+constexpr size_t cache_line_size = 64;
+
+enum SideState : uint32_t { side_unopened = 0, side_open, side_closed };
+
+// The counters are the bytes written and read since creation, modulo 2^32.
+// As the capacity is a power of two, their difference is the number of
+// unread bytes and the counter modulo the capacity is the offset in the data.
+// Head and tail are on separate cache lines, as each is written by a
+// different side.
+//
+// The reader sleeps on head_sequence and the writer on tail_sequence. They are
+// incremented after the counter when the other side is waiting, and by close,
+// so that a sleep starting after the change returns at once.
+struct Ring {
+    alignas(cache_line_size) std::atomic<uint32_t> head;
+    std::atomic<uint32_t> head_sequence;
+    std::atomic<uint32_t> is_reader_waiting;
+    alignas(cache_line_size) std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> tail_sequence;
+    std::atomic<uint32_t> is_writer_waiting;
+};
+
+// Start of the region. Ring i is written by side i, its data follows the
+// header at data_offset + i * capacity.
+struct Region {
+    std::atomic<uint32_t> magic;  // Stored last by the creator.
+    uint32_t version;
+    uint32_t capacity;
+    std::atomic<uint32_t> sides[2];
+    Ring rings[2];
+};
+
+constexpr size_t data_offset =
+    (sizeof(Region) + cache_line_size - 1) / cache_line_size * cache_line_size;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "atomics must be lock free to be shared between processes");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futexes are waited on through the atomic words");
+
+// Sleeps until the word is woken or no longer equal to expected, or until the
+// timeout in seconds. May return early.
+void wait(std::atomic<uint32_t> &word, uint32_t expected, double timeout) {
+#if defined(__linux__)
+    timespec duration;
+    duration.tv_sec = static_cast<time_t>(timeout);
+    duration.tv_nsec = static_cast<long>((timeout - duration.tv_sec) * 1e9);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected,
+            &duration, nullptr, 0);
+#elif !defined(ONE_WINDOWS)
+    // Polls every millisecond.
+    (void)word;
+    (void)expected;
+    timespec duration;
+    duration.tv_sec = 0;
+    duration.tv_nsec = static_cast<long>((timeout < 0.001 ? timeout : 0.001) * 1e9);
+    nanosleep(&duration, nullptr);
+#else
+    (void)word;
+    (void)expected;
+    (void)timeout;
+#endif
+}
+
+void wake(std::atomic<uint32_t> &word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX,
+            nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Increments the sequence and wakes the side sleeping on it.
+void signal(std::atomic<uint32_t> &sequence) {
+    sequence.fetch_add(1);
+    wake(sequence);
+}
+
+// Waits until is_ready returns true or the timeout in seconds passes, setting
+// the waiting flag while asleep so that the peer signals the sequence.
+template <class IsReady>
+bool wait_until(std::atomic<uint32_t> &sequence, std::atomic<uint32_t> &is_waiting,
+                float timeout, IsReady is_ready) {
+    using namespace std::chrono;
+    const auto deadline = steady_clock::now() + duration<double>(timeout);
+    while (true) {
+        const uint32_t observed = sequence.load();
+        if (is_ready()) {
+            return true;
+        }
+        const double remaining = duration<double>(deadline - steady_clock::now()).count();
+        if (remaining <= 0.0) {
+            return false;
+        }
+
+        is_waiting.store(1);
+        if (sequence.load() == observed && !is_ready()) {
+            wait(sequence, observed, remaining);
+        }
+        is_waiting.store(0);
+    }
+}
+
+}  // namespace shared_memory
+
+using namespace shared_memory;
+
+SharedMemoryTransport::SharedMemoryTransport()
+    : _region(nullptr), _mapped_size(0), _in(nullptr), _out(nullptr), _side(0) {}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    close();
+}
+
+OneError SharedMemoryTransport::create(const char *name, size_t capacity) {
+    if (name == nullptr) {
+        return ONE_ERROR_VALIDATION_NAME_IS_NULLPTR;
+    }
+    if (capacity < min_capacity || capacity > max_capacity ||
+        (capacity & (capacity - 1)) != 0) {
+        return ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED;
+    }
+    return map(name, true, capacity);
+}
+
+OneError SharedMemoryTransport::create_unique(size_t capacity) {
+#ifdef ONE_WINDOWS
+    (void)capacity;
+    return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+#else
+    std::random_device device;
+    char name[32];
+    std::snprintf(name, sizeof(name), "/arcus-%d-%08x", static_cast<int>(getpid()),
+                  static_cast<unsigned int>(device()));
+    return create(name, capacity);
+#endif
+}
+
+OneError SharedMemoryTransport::open(const char *name) {
+    if (name == nullptr) {
+        return ONE_ERROR_VALIDATION_NAME_IS_NULLPTR;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED;
+    }
+    return map(name, false, 0);
+}
+
+OneError SharedMemoryTransport::map(const char *name, bool is_creator,
+                                    size_t capacity) {
+#ifdef ONE_WINDOWS
+    (void)name;
+    (void)is_creator;
+    (void)capacity;
+    return ONE_ERROR_TRANSPORT_UNSUPPORTED;
+#else
+    const OneError failed =
+        is_creator ? ONE_ERROR_TRANSPORT_CREATE_FAILED : ONE_ERROR_TRANSPORT_OPEN_FAILED;
+
+    size_t size = 0;
+    int fd = -1;
+    if (is_creator) {
+        // Replace a region left by a previous creator.
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            return failed;
+        }
+        size = data_offset + 2 * capacity;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            shm_unlink(name);
+            return failed;
+        }
+    } else {
+        fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0) {
+            return failed;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return failed;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size < data_offset) {
+            ::close(fd);
+            return ONE_ERROR_TRANSPORT_INVALID_REGION;
+        }
+    }
+
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        if (is_creator) {
+            shm_unlink(name);
+        }
+        return failed;
+    }
+
+    auto region = reinterpret_cast<Region *>(memory);
+    if (is_creator) {
+        new (memory) Region();
+        region->version = region_version;
+        region->capacity = static_cast<uint32_t>(capacity);
+        region->sides[0].store(side_open);
+        region->magic.store(region_magic);
+    } else {
+        // The magic is stored last, the other fields are only read after it.
+        const bool is_valid = region->magic.load() == region_magic &&
+                              region->version == region_version &&
+                              data_offset + 2 * size_t(region->capacity) == size;
+        if (!is_valid) {
+            munmap(memory, size);
+            return ONE_ERROR_TRANSPORT_INVALID_REGION;
+        }
+        // Only one side may open the region.
+        uint32_t unopened = side_unopened;
+        if (!region->sides[1].compare_exchange_strong(unopened, side_open)) {
+            munmap(memory, size);
+            return failed;
+        }
+        capacity = region->capacity;
+    }
+
+    _region = region;
+    _mapped_size = size;
+    _side = is_creator ? 0 : 1;
+    auto data = reinterpret_cast<unsigned char *>(memory) + data_offset;
+    _out = data + _side * capacity;
+    _in = data + (1 - _side) * capacity;
+    _name = name;
+    return ONE_ERROR_NONE;
+#endif
+}
+
+void SharedMemoryTransport::close() {
+    if (_region == nullptr) {
+        return;
+    }
+
+#ifndef ONE_WINDOWS
+    // Wake the peer waiting to read from or write to this side, even if it
+    // checked the side just before it was closed.
+    _region->sides[_side].store(side_closed);
+    signal(_region->rings[_side].head_sequence);
+    signal(_region->rings[1 - _side].tail_sequence);
+
+    if (_side == 0) {
+        shm_unlink(_name.c_str());
+    }
+    munmap(_region, _mapped_size);
+#endif
+
+    _region = nullptr;
+    _mapped_size = 0;
+    _in = nullptr;
+    _out = nullptr;
+    _name.clear();
+}
+
+bool SharedMemoryTransport::is_peer_open() const {
+    return _region != nullptr && _region->sides[1 - _side].load() == side_open;
+}
+
+bool SharedMemoryTransport::is_peer_closed() const {
+    return _region->sides[1 - _side].load() == side_closed;
+}
+
+OneError SharedMemoryTransport::ready_for_read(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    // Ready once there is data, or once the peer closed so that receive
+    // reports it.
+    auto &ring = _region->rings[1 - _side];
+    is_ready = wait_until(ring.head_sequence, ring.is_reader_waiting, timeout, [&]() {
+        return ring.head.load() != ring.tail.load() || is_peer_closed();
+    });
+    return ONE_ERROR_NONE;
+}
+
+OneError SharedMemoryTransport::ready_for_send(float timeout, bool &is_ready) {
+    is_ready = false;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    auto &ring = _region->rings[_side];
+    const uint32_t capacity = _region->capacity;
+    is_ready = wait_until(ring.tail_sequence, ring.is_writer_waiting, timeout, [&]() {
+        return ring.head.load() - ring.tail.load() < capacity || is_peer_closed();
+    });
+    return ONE_ERROR_NONE;
+}
+
+OneError SharedMemoryTransport::send(const void *data, size_t length,
+                                     size_t &length_sent) {
+    length_sent = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    if (is_peer_closed()) return ONE_ERROR_TRANSPORT_PEER_CLOSED;
+
+    auto &ring = _region->rings[_side];
+    const uint32_t capacity = _region->capacity;
+    const uint32_t head = ring.head.load(std::memory_order_relaxed);
+    const uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    const size_t space = capacity - (head - tail);
+    const size_t count = length < space ? length : space;
+    if (count == 0) {
+        return ONE_ERROR_NONE;
+    }
+
+    const size_t offset = head & (capacity - 1);
+    const size_t first = (count < capacity - offset) ? count : capacity - offset;
+    std::memcpy(_out + offset, data, first);
+    std::memcpy(_out, reinterpret_cast<const unsigned char *>(data) + first,
+                count - first);
+    ring.head.store(head + static_cast<uint32_t>(count));
+    if (ring.is_reader_waiting.load() != 0) {
+        signal(ring.head_sequence);
+    }
+
+    length_sent = count;
+    return ONE_ERROR_NONE;
+}
+
+OneError SharedMemoryTransport::receive(void *data, size_t length,
+                                        size_t &length_received) {
+    length_received = 0;
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+
+    auto &ring = _region->rings[1 - _side];
+    const uint32_t capacity = _region->capacity;
+    const uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    const uint32_t head = ring.head.load(std::memory_order_acquire);
+    const size_t available = head - tail;
+    const size_t count = length < available ? length : available;
+    if (count == 0) {
+        // Data sent before closing is still received.
+        return is_peer_closed() ? ONE_ERROR_TRANSPORT_PEER_CLOSED : ONE_ERROR_NONE;
+    }
+
+    const size_t offset = tail & (capacity - 1);
+    const size_t first = (count < capacity - offset) ? count : capacity - offset;
+    std::memcpy(data, _in + offset, first);
+    std::memcpy(reinterpret_cast<unsigned char *>(data) + first, _in, count - first);
+    ring.tail.store(tail + static_cast<uint32_t>(count));
+    if (ring.is_writer_waiting.load() != 0) {
+        signal(ring.tail_sequence);
+    }
+
+    length_received = count;
+    return ONE_ERROR_NONE;
+}
+
+OneError SharedMemoryTransport::address(String &ip, unsigned int &port) const {
+    if (!is_initialized()) return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    ip = _name;
+    port = 0;
+    return ONE_ERROR_NONE;
+}
+
+}  // namespace one
+}  // namespace i3d
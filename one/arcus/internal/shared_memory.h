@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <one/arcus/error.h>
+#include <one/arcus/internal/transport.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+
+namespace shared_memory {
+struct Region;
+}
+
+// Transport carrying the bytes of a Connection through a named shared memory
+// region, for an agent and a game on the same host. The region holds two
+// single producer, single consumer byte rings, one per direction. One side
+// creates the region and the other opens it by name, each side must only be
+// used by one thread at a time.
+//
+// Waiting in ready_for_read and ready_for_send sleeps on a futex on Linux,
+// woken by the peer, and polls elsewhere. Closing either side is seen by the
+// peer: its send and receive return ONE_ERROR_TRANSPORT_PEER_CLOSED.
+//
+// Not available on Windows, where all calls return
+// ONE_ERROR_TRANSPORT_UNSUPPORTED.
+class SharedMemoryTransport final : public Transport {
+public:
+    // Bytes of each ring.
+    static constexpr size_t default_capacity = 64 * 1024;
+    static constexpr size_t min_capacity = 64;
+    static constexpr size_t max_capacity = 1024 * 1024 * 1024;
+
+    SharedMemoryTransport();
+    SharedMemoryTransport(const SharedMemoryTransport &) = delete;
+    SharedMemoryTransport &operator=(const SharedMemoryTransport &) = delete;
+    ~SharedMemoryTransport();
+
+    // Creates the region with the given name, e.g. "/arcus-game-1", replacing
+    // a region left with the same name. The capacity of each ring must be a
+    // power of two between min_capacity and max_capacity. The name is removed
+    // when this side is closed.
+    OneError create(const char *name, size_t capacity = default_capacity);
+
+    // Creates the region with a new name, made of the process id and a random
+    // number, which address then reports.
+    OneError create_unique(size_t capacity = default_capacity);
+
+    // Opens the region created by the peer with the given name. Returns
+    // ONE_ERROR_TRANSPORT_INVALID_REGION if the region is not fully created yet
+    // or was created by an incompatible version.
+    OneError open(const char *name);
+
+    // Marks this side as closed and unmaps the region.
+    void close();
+
+    bool is_initialized() const override {
+        return _region != nullptr;
+    }
+
+    // Whether the peer has opened the region, or created it.
+    bool is_peer_open() const;
+
+    OneError ready_for_read(float timeout, bool &is_ready) override;
+    OneError ready_for_send(float timeout, bool &is_ready) override;
+    OneError send(const void *data, size_t length, size_t &length_sent) override;
+    OneError receive(void *data, size_t length, size_t &length_received) override;
+
+    // Sets ip to the region name and port to 0.
+    OneError address(String &ip, unsigned int &port) const override;
+
+private:
+    OneError map(const char *name, bool is_creator, size_t capacity);
+    bool is_peer_closed() const;
+
+    shared_memory::Region *_region;
+    size_t _mapped_size;
+    unsigned char *_in;   // Data of the ring read by this side.
+    unsigned char *_out;  // Data of the ring written by this side.
+    size_t _side;         // 0 for the creator, 1 for the opener.
+    String _name;
+};
+
+}  // namespace one
+}  // namespace i3d
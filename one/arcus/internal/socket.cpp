@@ -13,6 +13,8 @@ typedef int socklen_t;
     #include <fcntl.h>
     #include <netinet/in.h>
     #include <sys/ioctl.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
     #include <unistd.h>
     #include <errno.h>
 
@@ -57,14 +59,15 @@ inline int last_error() {
 #endif
 }
 
-Socket::Socket() : _socket(INVALID_SOCKET) {}
+Socket::Socket() : _socket(INVALID_SOCKET), _family(AF_UNSPEC) {}
 
-Socket::Socket(const Socket &other) : _socket(other._socket) {
+Socket::Socket(const Socket &other) : _socket(other._socket), _family(other._family) {
     other._socket = INVALID_SOCKET;
 }
 
 void Socket::operator=(const Socket &other) {
     _socket = other._socket;
+    _family = other._family;
     other._socket = INVALID_SOCKET;
 }
 
@@ -82,7 +85,21 @@ int set_non_blocking(SOCKET &system_socket, bool enable) {
 }
 
 OneError Socket::init() {
-    _socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    // A dual stack IPv6 socket reaches IPv4 peers through IPv4 mapped
+    // addresses. Hosts without IPv6 fall back to IPv4 only.
+    _family = AF_INET6;
+    _socket = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
+    if (_socket != INVALID_SOCKET) {
+        int disable = 0;
+        if (setsockopt(_socket, IPPROTO_IPV6, IPV6_V6ONLY, (const char *)&disable,
+                       sizeof(int)) < 0) {
+            close();
+        }
+    }
+    if (_socket == INVALID_SOCKET) {
+        _family = AF_INET;
+        _socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    }
     if (_socket == INVALID_SOCKET) {
         return ONE_ERROR_SOCKET_CREATE_FAILED;
     }
@@ -95,21 +112,263 @@ OneError Socket::init() {
     if (setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int)) < 0)
         return ONE_ERROR_SOCKET_SOCKET_OPTIONS_FAILED;
 
-        // The TCP_NODELAY option can be used to ensure that our very small TCP
-        // packets are sent immediatley, at the cost of more network messages.
-        // This can be useful when using TCP for scenarios where small packets
-        // are often sent and need to be processed immediately, e.g. in a
-        // realtime editor scenario that requires high user input fidelity. This
-        // is not required for Arcus, where the client does not need to process
-        // messages in 0-500 millisecond timeframe. In the case of Arcus
-        // messages and their goals, it is ok to sometimes take hundreds of
-        // milliseconds to arrive on the server or agent.
-        // setsockopt(_socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));
+    // TCP_NODELAY and the other tuning options are left to set_options.
+#endif
+
+    return ONE_ERROR_NONE;
+}
+
+namespace {
+
+// Sets an integer option, as taken by all the supported options.
+bool set_option(SOCKET socket, int level, int name, unsigned int value) {
+    const int converted = static_cast<int>(value);
+    return ::setsockopt(socket, level, name, (const char *)&converted,
+                        sizeof(converted)) == 0;
+}
+
+}  // namespace
+
+OneError Socket::set_options(const SocketOptions &options) {
+    assert(_socket != INVALID_SOCKET);
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+
+    auto fail = [this]() {
+        set_last_error_text();
+        return ONE_ERROR_SOCKET_SOCKET_OPTIONS_FAILED;
+    };
+
+    if (options.send_buffer_size > 0 &&
+        !set_option(_socket, SOL_SOCKET, SO_SNDBUF, options.send_buffer_size)) {
+        return fail();
+    }
+    if (options.receive_buffer_size > 0 &&
+        !set_option(_socket, SOL_SOCKET, SO_RCVBUF, options.receive_buffer_size)) {
+        return fail();
+    }
+
+    if (is_local()) {
+        return ONE_ERROR_NONE;
+    }
+
+    if (!set_option(_socket, IPPROTO_TCP, TCP_NODELAY, options.is_no_delay ? 1 : 0)) {
+        return fail();
+    }
+
+    if (options.is_keepalive_enabled) {
+        if (!set_option(_socket, SOL_SOCKET, SO_KEEPALIVE, 1)) {
+            return fail();
+        }
+#if defined(TCP_KEEPIDLE)
+        const int keepalive_idle = TCP_KEEPIDLE;
+#elif defined(TCP_KEEPALIVE)
+        const int keepalive_idle = TCP_KEEPALIVE;  // macOS.
+#else
+        if (options.keepalive_idle_seconds > 0) {
+            return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
+        }
+        const int keepalive_idle = 0;
+#endif
+        if (options.keepalive_idle_seconds > 0 &&
+            !set_option(_socket, IPPROTO_TCP, keepalive_idle,
+                        options.keepalive_idle_seconds)) {
+            return fail();
+        }
+#if defined(TCP_KEEPINTVL) && defined(TCP_KEEPCNT)
+        if (options.keepalive_interval_seconds > 0 &&
+            !set_option(_socket, IPPROTO_TCP, TCP_KEEPINTVL,
+                        options.keepalive_interval_seconds)) {
+            return fail();
+        }
+        if (options.keepalive_count > 0 &&
+            !set_option(_socket, IPPROTO_TCP, TCP_KEEPCNT, options.keepalive_count)) {
+            return fail();
+        }
+#else
+        if (options.keepalive_interval_seconds > 0 || options.keepalive_count > 0) {
+            return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
+        }
+#endif
+    }
+
+    if (options.user_timeout_ms > 0) {
+#if defined(TCP_USER_TIMEOUT)
+        if (!set_option(_socket, IPPROTO_TCP, TCP_USER_TIMEOUT,
+                        options.user_timeout_ms)) {
+            return fail();
+        }
+#else
+        return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
+#endif
+    }
+
+    if (options.busy_poll_us > 0) {
+#if defined(SO_BUSY_POLL)
+        if (!set_option(_socket, SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_us)) {
+            return fail();
+        }
+#else
+        return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
 #endif
+    }
 
     return ONE_ERROR_NONE;
 }
 
+bool Socket::is_supported(const SocketOptions &options) {
+    bool is_supported = true;
+#if !defined(TCP_KEEPIDLE) && !defined(TCP_KEEPALIVE)
+    is_supported &= !options.is_keepalive_enabled || options.keepalive_idle_seconds == 0;
+#endif
+#if !defined(TCP_KEEPINTVL) || !defined(TCP_KEEPCNT)
+    is_supported &= !options.is_keepalive_enabled ||
+                    (options.keepalive_interval_seconds == 0 &&
+                     options.keepalive_count == 0);
+#endif
+#if !defined(TCP_USER_TIMEOUT)
+    is_supported &= options.user_timeout_ms == 0;
+#endif
+#if !defined(SO_BUSY_POLL)
+    is_supported &= options.busy_poll_us == 0;
+#endif
+    (void)options;
+    return is_supported;
+}
+
+bool Socket::is_local() const {
+#ifdef ONE_WINDOWS
+    return false;
+#else
+    return _family == AF_UNIX;
+#endif
+}
+
+OneError Socket::init_local() {
+#ifdef ONE_WINDOWS
+    return ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED;
+#else
+    _family = AF_UNIX;
+    _socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_socket == INVALID_SOCKET) {
+        return ONE_ERROR_SOCKET_CREATE_FAILED;
+    }
+    return ONE_ERROR_NONE;
+#endif
+}
+
+#ifndef ONE_WINDOWS
+OneError local_address(const char *path, sockaddr_un &addr) {
+    const size_t length = std::strlen(path);
+    if (length >= Socket::local_path_size) {
+        return ONE_ERROR_SOCKET_PATH_TOO_LONG;
+    }
+    static_assert(sizeof(addr.sun_path) >= Socket::local_path_size,
+                  "local paths must fit in sun_path");
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path, length + 1);
+    return ONE_ERROR_NONE;
+}
+
+// Returns true if connecting to the socket file at addr is refused, i.e. its
+// socket was closed without removing it, e.g. after a crash. Not connecting
+// in time, as when the listen backlog is full, means it is still in use.
+bool is_local_stale(const sockaddr_un &addr) {
+    SOCKET probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe == INVALID_SOCKET) {
+        return false;
+    }
+    set_non_blocking(probe, true);
+    const int result = ::connect(probe, (const sockaddr *)&addr, sizeof(addr));
+    const bool is_stale = result < 0 && errno == ECONNREFUSED;
+    ::close(probe);
+    return is_stale;
+}
+#endif
+
+// Sets addr to the IPv4 or IPv6 address ip, or to the any address if ip is
+// empty, in the given family. IPv6 addresses may be in brackets. IPv4
+// addresses are mapped to IPv6 for AF_INET6 sockets.
+OneError ip_address(const char *ip, unsigned int port, int family,
+                    sockaddr_storage &addr, socklen_t &addr_size) {
+    std::memset(&addr, 0, sizeof(addr));
+
+    char unbracketed[INET6_ADDRSTRLEN];
+    const size_t length = std::strlen(ip);
+    if (length >= 2 && ip[0] == '[' && ip[length - 1] == ']') {
+        if (length - 2 >= sizeof(unbracketed)) {
+            return ONE_ERROR_SOCKET_ADDRESS_INVALID;
+        }
+        std::memcpy(unbracketed, ip + 1, length - 2);
+        unbracketed[length - 2] = '\0';
+        ip = unbracketed;
+    }
+
+    in_addr v4;
+    const bool is_any = std::strlen(ip) == 0;
+    const bool is_v4 = !is_any && inet_pton(AF_INET, ip, &v4) == 1;
+
+    if (family == AF_INET) {
+        auto sin = (sockaddr_in *)&addr;
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        if (is_any) {
+            sin->sin_addr.s_addr = INADDR_ANY;
+        } else if (is_v4) {
+            sin->sin_addr = v4;
+        } else {
+            return ONE_ERROR_SOCKET_ADDRESS_INVALID;
+        }
+        addr_size = sizeof(sockaddr_in);
+        return ONE_ERROR_NONE;
+    }
+
+    auto sin6 = (sockaddr_in6 *)&addr;
+    sin6->sin6_family = AF_INET6;
+    sin6->sin6_port = htons(port);
+    if (is_any) {
+        sin6->sin6_addr = in6addr_any;
+    } else if (is_v4) {
+        // ::ffff:a.b.c.d
+        unsigned char *bytes = sin6->sin6_addr.s6_addr;
+        bytes[10] = bytes[11] = 0xff;
+        std::memcpy(bytes + 12, &v4, sizeof(v4));
+    } else if (inet_pton(AF_INET6, ip, &sin6->sin6_addr) != 1) {
+        return ONE_ERROR_SOCKET_ADDRESS_INVALID;
+    }
+    addr_size = sizeof(sockaddr_in6);
+    return ONE_ERROR_NONE;
+}
+
+// Sets ip and port from an IPv4 or IPv6 address. IPv4 mapped IPv6 addresses
+// are given as IPv4. Returns false for other families.
+bool ip_and_port(const sockaddr_storage &addr, String &ip, unsigned int &port) {
+    char str[INET6_ADDRSTRLEN];
+    if (addr.ss_family == AF_INET) {
+        auto sin = (const sockaddr_in *)&addr;
+        inet_ntop(AF_INET, &sin->sin_addr, str, sizeof(str));
+        port = (unsigned int)ntohs(sin->sin_port);
+    } else if (addr.ss_family == AF_INET6) {
+        auto sin6 = (const sockaddr_in6 *)&addr;
+        const unsigned char *bytes = sin6->sin6_addr.s6_addr;
+        static const unsigned char mapped_prefix[12] = {0, 0, 0, 0, 0, 0,
+                                                        0, 0, 0, 0, 0xff, 0xff};
+        if (std::memcmp(bytes, mapped_prefix, sizeof(mapped_prefix)) == 0) {
+            inet_ntop(AF_INET, bytes + 12, str, sizeof(str));
+        } else {
+            inet_ntop(AF_INET6, &sin6->sin6_addr, str, sizeof(str));
+        }
+        port = (unsigned int)ntohs(sin6->sin6_port);
+    } else {
+        return false;
+    }
+    ip = str;
+    return true;
+}
+
 OneError Socket::close() {
     if (_socket == INVALID_SOCKET) return ONE_ERROR_NONE;
 
@@ -137,15 +396,13 @@ OneError Socket::close() {
 OneError Socket::bind(const char *ip, unsigned int port) {
     assert(_socket != INVALID_SOCKET);
 
-    sockaddr_in sin;
-    sin.sin_port = htons(port);
-    if (std::strlen(ip) == 0) {
-        sin.sin_addr.s_addr = INADDR_ANY;
-    } else {
-        inet_pton(AF_INET, ip, &(sin.sin_addr));
+    sockaddr_storage addr;
+    socklen_t addr_size = 0;
+    auto err = ip_address(ip, port, _family, addr, addr_size);
+    if (is_error(err)) {
+        return err;
     }
-    sin.sin_family = AF_INET;
-    const int result = ::bind(_socket, (sockaddr *)&sin, sizeof(sin));
+    const int result = ::bind(_socket, (sockaddr *)&addr, addr_size);
     if (result < 0) {
         set_last_error_text();
         return ONE_ERROR_SOCKET_BIND_FAILED;
@@ -154,33 +411,68 @@ OneError Socket::bind(const char *ip, unsigned int port) {
 }
 
 OneError Socket::bind(unsigned int port) {
+    return bind("", port);
+}
+
+OneError Socket::bind_local(const char *path) {
     assert(_socket != INVALID_SOCKET);
+#ifdef ONE_WINDOWS
+    return ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED;
+#else
+    if (std::strlen(path) == 0) {
+        return ONE_ERROR_SOCKET_BIND_FAILED;
+    }
+
+    sockaddr_un addr;
+    auto err = local_address(path, addr);
+    if (is_error(err)) {
+        return err;
+    }
 
-    sockaddr_in sin;
-    sin.sin_port = htons(port);
-    sin.sin_addr.s_addr = INADDR_ANY;
-    sin.sin_family = AF_INET;
-    const int result = ::bind(_socket, (sockaddr *)&sin, sizeof(sin));
+    // A socket file outlives its socket, e.g. after a crash. One still
+    // accepting connections belongs to another server and is kept, so that
+    // bind fails.
+    if (is_local_stale(addr)) {
+        remove_local(path);
+    }
+
+    const int result = ::bind(_socket, (sockaddr *)&addr, sizeof(addr));
     if (result < 0) {
         set_last_error_text();
         return ONE_ERROR_SOCKET_BIND_FAILED;
     }
     return ONE_ERROR_NONE;
+#endif
+}
+
+void Socket::remove_local(const char *path) {
+#ifndef ONE_WINDOWS
+    // Only socket files are removed, never a file that happens to be at path.
+    struct stat info;
+    if (::lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        ::unlink(path);
+    }
+#endif
 }
 
 OneError Socket::address(String &ip, unsigned int &port) const {
-    sockaddr_in addr;
+    sockaddr_storage addr;
     socklen_t addr_size = sizeof(addr);
 
     const int result = ::getsockname(_socket, (sockaddr *)&addr, &addr_size);
     if (result != 0) return ONE_ERROR_SOCKET_ADDRESS_FAILED;
 
-    assert(addr_size == sizeof(addr));
-    char str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(addr.sin_addr), str, INET_ADDRSTRLEN);
-    ip = str;
+#ifndef ONE_WINDOWS
+    if (addr.ss_family == AF_UNIX) {
+        ip = ((sockaddr_un *)&addr)->sun_path;
+        port = 0;
+        return ONE_ERROR_NONE;
+    }
+#endif
 
-    port = (unsigned int)(ntohs(addr.sin_port));
+    if (!ip_and_port(addr, ip, port)) {
+        return ONE_ERROR_SOCKET_ADDRESS_FAILED;
+    }
     return ONE_ERROR_NONE;
 }
 
@@ -202,9 +494,9 @@ OneError Socket::accept(Socket &client, String &ip, unsigned int &port) {
         return ONE_ERROR_SOCKET_ACCEPT_UNINITIALIZED;
     }
 
-    struct sockaddr addr;
-    socklen_t addrLen = (socklen_t)sizeof(sockaddr);
-    SOCKET socket = ::accept(_socket, &addr, &addrLen);
+    sockaddr_storage addr;
+    socklen_t addrLen = (socklen_t)sizeof(addr);
+    SOCKET socket = ::accept(_socket, (sockaddr *)&addr, &addrLen);
 
     // No client is attempting to connect.
     if (socket == INVALID_SOCKET) return ONE_ERROR_NONE;
@@ -215,12 +507,11 @@ OneError Socket::accept(Socket &client, String &ip, unsigned int &port) {
     if (result < 0) return ONE_ERROR_SOCKET_ACCEPT_NON_BLOCKING_FAILED;
 
     client._socket = socket;
-    struct sockaddr_in *s = (struct sockaddr_in *)&addr;
-    char str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(s->sin_addr), str, INET_ADDRSTRLEN);
-    ip = str;
-    port = (unsigned int)ntohs(s->sin_port);
-
+    client._family = _family;
+    if (!ip_and_port(addr, ip, port)) {
+        ip = "";
+        port = 0;
+    }
     return ONE_ERROR_NONE;
 }
 
@@ -230,18 +521,45 @@ OneError Socket::connect(const char *ip, const unsigned int port) {
         return ONE_ERROR_SOCKET_CONNECT_UNINITIALIZED;
     }
 
-    sockaddr_in sin;
-    sin.sin_port = htons(port);
-    inet_pton(AF_INET, ip, &(sin.sin_addr));
-    sin.sin_family = AF_INET;
+    sockaddr_storage addr;
+    socklen_t addr_size = 0;
+    auto err = ip_address(ip, port, _family, addr, addr_size);
+    if (is_error(err)) {
+        return err;
+    }
+
+    int result = ::connect(_socket, (sockaddr *)&addr, addr_size);
+    if (result < 0) return ONE_ERROR_SOCKET_CONNECT_FAILED;
+
+    result = set_non_blocking(_socket, true);
+    if (result < 0) return ONE_ERROR_SOCKET_CONNECT_NON_BLOCKING_FAILED;
+
+    return ONE_ERROR_NONE;
+}
+
+OneError Socket::connect_local(const char *path) {
+    assert(_socket != INVALID_SOCKET);
+#ifdef ONE_WINDOWS
+    return ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED;
+#else
+    if (std::strlen(path) == 0) {
+        return ONE_ERROR_SOCKET_CONNECT_UNINITIALIZED;
+    }
+
+    sockaddr_un addr;
+    auto err = local_address(path, addr);
+    if (is_error(err)) {
+        return err;
+    }
 
-    int result = ::connect(_socket, (sockaddr *)&sin, sizeof(sin));
+    int result = ::connect(_socket, (sockaddr *)&addr, sizeof(addr));
     if (result < 0) return ONE_ERROR_SOCKET_CONNECT_FAILED;
 
     result = set_non_blocking(_socket, true);
     if (result < 0) return ONE_ERROR_SOCKET_CONNECT_NON_BLOCKING_FAILED;
 
     return ONE_ERROR_NONE;
+#endif
 }
 
 OneError Socket::ready_for_read(float timeout, bool &is_ready) {
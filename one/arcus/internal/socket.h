@@ -21,6 +21,8 @@ const int INVALID_SOCKET = -1;
 #endif
 
 #include <one/arcus/error.h>
+#include <one/arcus/internal/transport.h>
+#include <one/arcus/options.h>
 #include <one/arcus/types.h>
 
 namespace i3d {
@@ -39,8 +41,10 @@ OneError init_socket_system();
 // calls decrement counters matching the number of times init was called.
 OneError shutdown_socket_system();
 
-// A limited, cross-platform, low level TCP socket interface.
-class Socket final {
+// A limited, cross-platform, low level TCP socket interface. Unix domain
+// stream sockets are also supported for endpoints on the same host, except on
+// Windows.
+class Socket final : public Transport {
 public:
     //------------
     // Life cycle.
@@ -59,12 +63,34 @@ public:
     void operator=(const Socket &other);
 
     // Initializes as a TCP socket. Must be called before listen or connect.
+    // The socket is dual stack, accepting and connecting to both IPv4 and IPv6
+    // addresses, unless the host has no IPv6 support, in which case it is IPv4
+    // only.
     OneError init();
 
-    bool is_initialized() const {
+    // Size of the buffer holding a Unix domain socket path, including the
+    // terminator. The smallest among the supported platforms.
+    static constexpr size_t local_path_size = 104;
+
+    // Initializes as a Unix domain stream socket. Must be called before
+    // bind_local or connect_local. Returns ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED
+    // on Windows.
+    OneError init_local();
+
+    bool is_initialized() const override {
         return _socket != INVALID_SOCKET;
     }
 
+    // Applies the tuning options to an initialized socket. Only the buffer
+    // sizes apply to Unix domain sockets. Returns
+    // ONE_ERROR_SOCKET_OPTION_UNSUPPORTED if a non zero option is not
+    // available on the platform.
+    OneError set_options(const SocketOptions &options);
+
+    // Whether set_options can apply the options to a TCP socket on the
+    // platform, for options applied only once connected.
+    static bool is_supported(const SocketOptions &options);
+
     // Closes active socket, if active.
     OneError close();
 
@@ -72,14 +98,28 @@ public:
     // Server.
 
     // Assigns the given IP and port to the socket. Use "" for any ip address
-    // and 0 for any port.
+    // and 0 for any port. The ip may be IPv4 or IPv6, optionally in brackets,
+    // e.g. "[::1]". Returns ONE_ERROR_SOCKET_ADDRESS_INVALID if it cannot be
+    // parsed, or if it is IPv6 on an IPv4 only host.
     OneError bind(const char *ip, unsigned int port);
 
-    // Assigns the port to the socket. Use 0 for any port.
+    // Assigns the port to the socket, on any IPv4 and IPv6 address. Use 0 for
+    // any port.
     OneError bind(unsigned int port);
 
-    // Returns the address of this socket.
-    OneError address(String &ip, unsigned int &port) const;
+    // Assigns the Unix domain socket path to a socket initialized with
+    // init_local. A socket file left at path by a previous socket is removed
+    // first, unless a socket is still listening on it, in which case
+    // ONE_ERROR_SOCKET_BIND_FAILED is returned.
+    OneError bind_local(const char *path);
+
+    // Removes the socket file of a socket bound with bind_local.
+    static void remove_local(const char *path);
+
+    // Returns the address of this socket. IPv4 peers of a dual stack socket are
+    // given as IPv4. For Unix domain sockets, ip is set to the path and port
+    // to 0.
+    OneError address(String &ip, unsigned int &port) const override;
 
     // A decent default for the listen queue length for production. Ensure
     // the listen socket is serviced by accept to keep the queue free.
@@ -91,28 +131,33 @@ public:
 
     // Process incoming listen connections. Returns < 0 if an error occurred
     // during processing. If a new client connection was accepted, then the
-    // given client socket's IsInitialized will be true.
+    // given client socket's IsInitialized will be true. Clients accepted on a
+    // Unix domain socket have an empty ip and a port of 0.
     OneError accept(Socket &client, String &ip, unsigned int &port);
 
     //--------
     // Client.
 
+    // Connects to the IPv4 or IPv6 address, parsed as by bind.
     OneError connect(const char *ip, const unsigned int port);
 
+    // Connects a socket initialized with init_local to the given path.
+    OneError connect_local(const char *path);
+
     //--------
     // IO.
 
     // Sets is_ready to true if the socket is ready for reading (accept or receive).
-    OneError ready_for_read(float timeout, bool &is_ready);
+    OneError ready_for_read(float timeout, bool &is_ready) override;
 
     // Sets is_ready to true if the socket is ready for sending.
-    OneError ready_for_send(float timeout, bool &is_ready);
+    OneError ready_for_send(float timeout, bool &is_ready) override;
 
     // Sends data on the socket, setting the given length_sent to the number of
     // bytes sent. A failure to due to the socket not being ready, e.g.
     // due to EAGAIN on Linux, is not considered to be an error and returns
     // ONE_ERROR_NONE.
-    OneError send(const void *data, size_t length, size_t &length_sent);
+    OneError send(const void *data, size_t length, size_t &length_sent) override;
 
     // Puts number of bytes available for reading into the given length.
     OneError available(size_t &length);
@@ -121,14 +166,23 @@ public:
     // length_received to the number of bytes received. A failure to due to the
     // socket not being ready, e.g. due to EAGAIN on Linux, is not considered
     // to be an error and returns ONE_ERROR_NONE.
-    OneError receive(void *data, size_t length, size_t &length_received);
+    OneError receive(void *data, size_t length, size_t &length_received) override;
 
     // Error reporting.
     const char *last_error_text() const;
 
+    // The system socket, for transports that drive it directly. Ownership is
+    // kept.
+    SOCKET system_socket() const {
+        return _socket;
+    }
+
 private:
+    bool is_local() const;
+
     mutable SOCKET _socket;  // Mutable so that the copy constructor and operator can take
                              // ownership of the system socket.
+    int _family;             // AF_INET6, AF_INET or AF_UNIX once initialized.
 
 public:
     void set_last_error_text();
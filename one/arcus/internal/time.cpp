@@ -1,14 +1,17 @@
 #include <one/arcus/internal/time.h>
 
+#include <algorithm>
+#include <random>
+
 namespace i3d {
 namespace one {
 
-IntervalTimer::IntervalTimer(long long seconds)
-    : _interval(seconds), _last_trigger_time(steady_clock::duration::zero()) {}
+IntervalTimer::IntervalTimer(milliseconds interval)
+    : _interval(interval), _last_trigger_time(steady_clock::duration::zero()) {}
 
 bool IntervalTimer::update() {
     const auto now = steady_clock::now();
-    if (duration_cast<seconds>(now - _last_trigger_time).count() >= _interval) {
+    if (now - _last_trigger_time >= _interval) {
         _last_trigger_time = now;
         return true;
     }
@@ -19,5 +22,42 @@ void IntervalTimer::sync_now() {
     _last_trigger_time = steady_clock::now();
 }
 
+void IntervalTimer::set_interval(milliseconds interval) {
+    _interval = interval;
+}
+
+Backoff::Backoff(const RetryOptions &options)
+    : _options(options)
+    , _delay(options.initial_delay_ms)
+    , _next_attempt_time(steady_clock::duration::zero()) {}
+
+bool Backoff::update() {
+    const auto now = steady_clock::now();
+    if (now < _next_attempt_time) {
+        return false;
+    }
+
+    // Per thread, as instances may be updated concurrently.
+    thread_local std::mt19937 generator{std::random_device{}()};
+    const auto count = static_cast<unsigned long long>(_delay.count());
+    const auto jitter = count * _options.jitter_percent / 100;
+    std::uniform_int_distribution<unsigned long long> distribution(count - jitter, count);
+    _next_attempt_time = now + milliseconds(distribution(generator));
+
+    _delay = milliseconds(std::min<unsigned long long>(count * _options.multiplier,
+                                                       _options.max_delay_ms));
+    return true;
+}
+
+void Backoff::reset() {
+    _delay = milliseconds(_options.initial_delay_ms);
+    _next_attempt_time = steady_clock::time_point(steady_clock::duration::zero());
+}
+
+void Backoff::set_options(const RetryOptions &options) {
+    _options = options;
+    reset();
+}
+
 }  // namespace one
-}  // namespace i3d
\ No newline at end of file
+}  // namespace i3d
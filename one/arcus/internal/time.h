@@ -2,15 +2,18 @@
 
 #include <chrono>
 
+#include <one/arcus/options.h>
+
 using namespace std::chrono;
 
 namespace i3d {
 namespace one {
 
-// IntervalTimer is used to easily track if an interval in seconds has expired.
+// IntervalTimer is used to easily track if an interval has expired, to the
+// resolution of the steady clock.
 class IntervalTimer final {
 public:
-    IntervalTimer(long long seconds);
+    explicit IntervalTimer(milliseconds interval);
     IntervalTimer() = delete;
     IntervalTimer(IntervalTimer &other) = delete;
 
@@ -22,10 +25,47 @@ public:
     // Synchronizes the timer with time now, starting a new interval.
     void sync_now();
 
+    // Changes the interval, without starting a new one.
+    void set_interval(milliseconds interval);
+    milliseconds interval() const {
+        return _interval;
+    }
+
 private:
-    long long _interval;
+    milliseconds _interval;
     steady_clock::time_point _last_trigger_time;
 };
 
+// Backoff schedules retries of a failing operation, waiting longer after each
+// failed attempt as set by RetryOptions.
+class Backoff final {
+public:
+    explicit Backoff(const RetryOptions &options);
+    Backoff() = delete;
+    Backoff(Backoff &other) = delete;
+
+    // Returns true if an attempt is due, in which case the next one is
+    // scheduled after the current delay, shortened by the jitter, and the
+    // delay grows. Always true after construction or reset.
+    bool update();
+
+    // Makes the next attempt due immediately, starting over from the initial
+    // delay. To be called once an attempt succeeds.
+    void reset();
+
+    // Changes the options and resets.
+    void set_options(const RetryOptions &options);
+
+    // The delay, before jitter, that the next due attempt schedules.
+    milliseconds delay() const {
+        return _delay;
+    }
+
+private:
+    RetryOptions _options;
+    milliseconds _delay;
+    steady_clock::time_point _next_attempt_time;
+};
+
 }  // namespace one
-}  // namespace i3d
\ No newline at end of file
+}  // namespace i3d
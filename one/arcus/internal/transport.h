@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <one/arcus/error.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+
+// Carries the bytes of a Connection to its peer. Socket is the default
+// implementation, others may move the bytes without going through the
+// network stack.
+//
+// All calls are non blocking unless given a timeout. A send or receive that
+// cannot make progress is not an error: it returns ONE_ERROR_NONE and sets
+// the length to zero.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual bool is_initialized() const = 0;
+
+    // Sets is_ready to true if data can be received, waiting up to timeout
+    // seconds.
+    virtual OneError ready_for_read(float timeout, bool &is_ready) = 0;
+
+    // Sets is_ready to true if data can be sent, waiting up to timeout
+    // seconds.
+    virtual OneError ready_for_send(float timeout, bool &is_ready) = 0;
+
+    // Sends up to length bytes, setting length_sent to the number of bytes
+    // sent.
+    virtual OneError send(const void *data, size_t length, size_t &length_sent) = 0;
+
+    // Receives up to length bytes into data, setting length_received to the
+    // number of bytes received.
+    virtual OneError receive(void *data, size_t length, size_t &length_received) = 0;
+
+    // Identifies the endpoint in logs.
+    virtual OneError address(String &ip, unsigned int &port) const = 0;
+};
+
+}  // namespace one
+}  // namespace i3d
@@ -11,20 +11,38 @@ namespace one {
 enum class LogLevel { Info = 0, Error };
 
 // Simple logger class that needs to be given the actual logging callback.
+//
+// Messages below the logger level are discarded. Callers building a message
+// should check is_enabled first, so that disabled levels cost no formatting.
 class Logger final {
 public:
-    Logger() : _logFn(nullptr) {}
-    Logger(std::function<void(void *userdata, LogLevel, const String &)> logFn, void *userdata) : _logFn(logFn), _userdata(userdata) {}
+    Logger() : _logFn(nullptr), _userdata(nullptr), _level(LogLevel::Info) {}
+    Logger(std::function<void(void *userdata, LogLevel, const String &)> logFn, void *userdata)
+        : _logFn(logFn), _userdata(userdata), _level(LogLevel::Info) {}
+
+    void set_level(LogLevel level) {
+        _level = level;
+    }
+    LogLevel level() const {
+        return _level;
+    }
+
+    // Returns true if a message with the given level would reach the logging
+    // callback.
+    bool is_enabled(LogLevel level) const {
+        return _logFn != nullptr && static_cast<int>(level) >= static_cast<int>(_level);
+    }
 
     void Log(LogLevel level, const String &message) const {
-        if (_logFn == nullptr) return;
+        if (!is_enabled(level)) return;
         _logFn(_userdata, level, message);
     };
 
 private:
     std::function<void(void *, LogLevel, const String &)> _logFn;
     void *_userdata;
+    LogLevel _level;
 };
 
 }  // namespace one
-}  // namespace i3d
\ No newline at end of file
+}  // namespace i3d
@@ -1,17 +1,125 @@
 #include <one/arcus/message.h>
 
 #include <one/arcus/array.h>
+#include <one/arcus/internal/json.h>
 #include <one/arcus/internal/rapidjson/stringbuffer.h>
 #include <one/arcus/internal/rapidjson/writer.h>
 #include <one/arcus/opcode.h>
 #include <one/arcus/object.h>
 
+#include <stdint.h>
+
 namespace i3d {
 namespace one {
 
-Payload::Payload() : _doc(rapidjson::kObjectType) {}
+namespace {
+
+// Rapidjson's allocator is stateless. Sharing one instance avoids documents
+// and writers allocating their own.
+rapidjson::CrtAllocator shared_allocator;
+
+// Same as rapidjson's default.
+constexpr size_t parse_stack_capacity = 1024;
+
+// Rapidjson output stream writing into a fixed size buffer. Characters past
+// the end of the buffer are discarded.
+class FixedOutputStream final {
+public:
+    typedef char Ch;
+
+    FixedOutputStream(char *buffer, size_t size)
+        : _buffer(buffer), _size(size), _length(0), _is_full(false) {}
+
+    void Put(char c) {
+        if (_length < _size) {
+            _buffer[_length++] = c;
+            return;
+        }
+        _is_full = true;
+    }
+    void Flush() {}
+
+    size_t length() const {
+        return _length;
+    }
+    bool is_full() const {
+        return _is_full;
+    }
+
+private:
+    char *_buffer;
+    size_t _size;
+    size_t _length;
+    bool _is_full;
+};
+
+// Handler forwarding to a writer that stops the document traversal once the
+// output stream is full, so that the cost is bounded by the buffer size rather
+// than the document size.
+class TruncatingHandler final {
+public:
+    typedef char Ch;
+    typedef rapidjson::SizeType SizeType;
+
+    explicit TruncatingHandler(FixedOutputStream &stream)
+        : _stream(stream), _writer(stream, &shared_allocator) {}
+
+    bool Null() {
+        return _writer.Null() && !_stream.is_full();
+    }
+    bool Bool(bool b) {
+        return _writer.Bool(b) && !_stream.is_full();
+    }
+    bool Int(int i) {
+        return _writer.Int(i) && !_stream.is_full();
+    }
+    bool Uint(unsigned u) {
+        return _writer.Uint(u) && !_stream.is_full();
+    }
+    bool Int64(int64_t i) {
+        return _writer.Int64(i) && !_stream.is_full();
+    }
+    bool Uint64(uint64_t u) {
+        return _writer.Uint64(u) && !_stream.is_full();
+    }
+    bool Double(double d) {
+        return _writer.Double(d) && !_stream.is_full();
+    }
+    bool RawNumber(const Ch *str, SizeType length, bool copy) {
+        return _writer.RawNumber(str, length, copy) && !_stream.is_full();
+    }
+    bool String(const Ch *str, SizeType length, bool copy) {
+        return _writer.String(str, length, copy) && !_stream.is_full();
+    }
+    bool StartObject() {
+        return _writer.StartObject() && !_stream.is_full();
+    }
+    bool Key(const Ch *str, SizeType length, bool copy) {
+        return _writer.Key(str, length, copy) && !_stream.is_full();
+    }
+    bool EndObject(SizeType count) {
+        return _writer.EndObject(count) && !_stream.is_full();
+    }
+    bool StartArray() {
+        return _writer.StartArray() && !_stream.is_full();
+    }
+    bool EndArray(SizeType count) {
+        return _writer.EndArray(count) && !_stream.is_full();
+    }
+
+private:
+    FixedOutputStream &_stream;
+    rapidjson::Writer<FixedOutputStream> _writer;
+};
 
-Payload::Payload(const Payload &other) {
+}  // namespace
+
+Payload::Payload()
+    : _doc(rapidjson::kObjectType, &shared_allocator, parse_stack_capacity,
+           &shared_allocator) {}
+
+Payload::Payload(const Payload &other)
+    : _doc(&shared_allocator, parse_stack_capacity, &shared_allocator) {
     _doc.CopyFrom(other._doc, _doc.GetAllocator());
 }
 
@@ -30,12 +138,26 @@ OneError Payload::from_json(std::pair<const char *, size_t> data) {
 }
 
 String Payload::to_json() const {
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    rapidjson::StringBuffer buffer(&shared_allocator);
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer, &shared_allocator);
     _doc.Accept(writer);
     return String(buffer.GetString(), buffer.GetSize());
 }
 
+size_t Payload::to_json(char *buffer, size_t size, bool &truncated) const {
+    truncated = false;
+    if (buffer == nullptr || size == 0) {
+        truncated = true;
+        return 0;
+    }
+
+    FixedOutputStream stream(buffer, size);
+    TruncatingHandler handler(stream);
+    _doc.Accept(handler);
+    truncated = stream.is_full();
+    return stream.length();
+}
+
 bool Payload::is_empty() const {
     return _doc.ObjectEmpty();
 }
@@ -44,6 +166,38 @@ void Payload::clear() {
     _doc.SetObject();
 }
 
+size_t Payload::footprint() const {
+    return footprint(_doc);
+}
+
+size_t Payload::footprint(const rapidjson::Value &value) {
+    size_t size = 0;
+    if (value.IsObject()) {
+        if (value.MemberCapacity() > 0) {
+            size += json::block_size(value.MemberCapacity() *
+                                     sizeof(rapidjson::Value::Member));
+        }
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            size += footprint(it->name) + footprint(it->value);
+        }
+    } else if (value.IsArray()) {
+        if (value.Capacity() > 0) {
+            size += json::block_size(value.Capacity() * sizeof(rapidjson::Value));
+        }
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            size += footprint(*it);
+        }
+    } else if (value.IsString()) {
+        // Short strings are stored within the value itself.
+        const auto string = reinterpret_cast<uintptr_t>(value.GetString());
+        const auto begin = reinterpret_cast<uintptr_t>(&value);
+        if (string < begin || string >= begin + sizeof(value)) {
+            size += json::block_size(value.GetStringLength() + 1);
+        }
+    }
+    return size;
+}
+
 bool Payload::is_val_bool(const char *key) const {
     if (key == nullptr) {
         return false;
@@ -158,7 +312,8 @@ OneError Payload::val_string(const char *key, String &val) const {
         return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_STRING;
     }
 
-    val = value->value.GetString();
+    // Assigning keeps the capacity of the string when it is reused.
+    val.assign(value->value.GetString(), value->value.GetStringLength());
     return ONE_ERROR_NONE;
 }
 
@@ -254,16 +409,23 @@ OneError Payload::set_val_int(const char *key, int val) {
 }
 
 OneError Payload::set_val_string(const char *key, const String &val) {
+    return set_val_string(key, val.c_str());
+}
+
+OneError Payload::set_val_string(const char *key, const char *val) {
     if (key == nullptr) {
         return ONE_ERROR_PAYLOAD_KEY_IS_NULLPTR;
     }
+    if (val == nullptr) {
+        return ONE_ERROR_PAYLOAD_VAL_IS_NULLPTR;
+    }
 
     const auto &value = _doc.FindMember(key);
 
     // Adding key if it does not exists already.
     if (value == _doc.MemberEnd()) {
         _doc.AddMember(rapidjson::Value(key, _doc.GetAllocator()).Move(),
-                       rapidjson::Value(val.c_str(), _doc.GetAllocator()).Move(),
+                       rapidjson::Value(val, _doc.GetAllocator()).Move(),
                        _doc.GetAllocator());
         return ONE_ERROR_NONE;
     }
@@ -273,7 +435,7 @@ OneError Payload::set_val_string(const char *key, const String &val) {
         return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_STRING;
     }
 
-    value->value.SetString(val.c_str(), _doc.GetAllocator());
+    value->value.SetString(val, _doc.GetAllocator());
     return ONE_ERROR_NONE;
 }
 
@@ -334,6 +496,74 @@ OneError Payload::set_val_root_object(const Object &val) {
     return ONE_ERROR_NONE;
 }
 
+OneError Payload::set_delta(const Payload &previous, const Payload &current,
+                            const char *removed_key) {
+    if (removed_key == nullptr) {
+        return ONE_ERROR_PAYLOAD_KEY_IS_NULLPTR;
+    }
+    if (!previous._doc.IsObject() || !current._doc.IsObject()) {
+        return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_OBJECT;
+    }
+
+    auto &allocator = _doc.GetAllocator();
+    _doc.SetObject();
+    for (auto it = current._doc.MemberBegin(); it != current._doc.MemberEnd(); ++it) {
+        const auto found = previous._doc.FindMember(it->name);
+        if (found != previous._doc.MemberEnd() && found->value == it->value) {
+            continue;
+        }
+        _doc.AddMember(rapidjson::Value(it->name, allocator).Move(),
+                       rapidjson::Value(it->value, allocator).Move(), allocator);
+    }
+
+    rapidjson::Value removed(rapidjson::kArrayType);
+    for (auto it = previous._doc.MemberBegin(); it != previous._doc.MemberEnd(); ++it) {
+        if (!current._doc.HasMember(it->name)) {
+            removed.PushBack(rapidjson::Value(it->name, allocator).Move(), allocator);
+        }
+    }
+    if (!removed.Empty()) {
+        _doc.AddMember(rapidjson::Value(removed_key, allocator).Move(), removed,
+                       allocator);
+    }
+    return ONE_ERROR_NONE;
+}
+
+OneError Payload::apply_delta(const Payload &delta, const char *removed_key) {
+    if (removed_key == nullptr) {
+        return ONE_ERROR_PAYLOAD_KEY_IS_NULLPTR;
+    }
+    if (!_doc.IsObject() || !delta._doc.IsObject()) {
+        return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_OBJECT;
+    }
+
+    auto &allocator = _doc.GetAllocator();
+    for (auto it = delta._doc.MemberBegin(); it != delta._doc.MemberEnd(); ++it) {
+        if (it->name == removed_key) {
+            if (!it->value.IsArray()) {
+                return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_ARRAY;
+            }
+            for (rapidjson::SizeType i = 0; i < it->value.Size(); ++i) {
+                const auto &name = it->value[i];
+                if (!name.IsString()) {
+                    return ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_STRING;
+                }
+                _doc.RemoveMember(name);
+            }
+            continue;
+        }
+
+        const auto found = _doc.FindMember(it->name);
+        if (found != _doc.MemberEnd()) {
+            found->value.CopyFrom(it->value, allocator);
+            continue;
+        }
+        _doc.AddMember(rapidjson::Value(it->name, allocator).Move(),
+                       rapidjson::Value(it->value, allocator).Move(), allocator);
+    }
+    return ONE_ERROR_NONE;
+}
+
 Message::Message() : _code(Opcode::invalid) {}
 
 Message::Message(const Message &other) {
@@ -373,6 +603,10 @@ Opcode Message::code() const {
     return _code;
 }
 
+size_t Message::footprint() const {
+    return _payload.footprint();
+}
+
 Payload &Message::payload() {
     return _payload;
 }
@@ -502,6 +736,33 @@ prepare_live_state(int players, int max_players, const char *name, const char *m
     return ONE_ERROR_NONE;
 }
 
+OneError prepare_live_state_delta(const Payload &previous, const Payload &current,
+                                  Message &message, bool &is_empty) {
+    Payload payload;
+    auto err = payload.set_delta(previous, current, live_state_removed_key);
+    if (is_error(err)) {
+        return err;
+    }
+
+    is_empty = payload.is_empty();
+    if (is_empty) {
+        return ONE_ERROR_NONE;
+    }
+
+    message.reset();
+    return message.init(Opcode::live_state_delta, payload);
+}
+
+OneError prepare_features(bool live_state_delta, Message &message) {
+    Payload payload;
+    auto err = payload.set_val_bool("liveStateDelta", live_state_delta);
+    if (is_error(err)) {
+        return err;
+    }
+
+    return message.init(Opcode::features, payload);
+}
+
 OneError prepare_host_information(const Object &information, Message &message) {
     Payload payload;
     auto err = payload.set_val_root_object(information);
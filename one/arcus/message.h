@@ -27,6 +27,10 @@ public:
 
     OneError from_json(std::pair<const char *, size_t> data);
     String to_json() const;
+    // Writes at most size characters of the JSON text into the buffer, without
+    // null termination. Returns the number of characters written. Truncated is
+    // set if the text did not fit.
+    size_t to_json(char *buffer, size_t size, bool &truncated) const;
 
     const rapidjson::Value &get() const {
         return _doc;
@@ -35,6 +39,11 @@ public:
     bool is_empty() const;
     void clear();
 
+    // Bytes allocated for the JSON values of the payload, or of any value
+    // built by Payload, Array or Object, which only hold copied strings.
+    size_t footprint() const;
+    static size_t footprint(const rapidjson::Value &value);
+
     bool is_val_bool(const char *key) const;
     bool is_val_int(const char *key) const;
     bool is_val_string(const char *key) const;
@@ -53,10 +62,21 @@ public:
     OneError set_val_bool(const char *key, bool val);
     OneError set_val_int(const char *key, int val);
     OneError set_val_string(const char *key, const String &val);
+    // Same as above, without constructing a String.
+    OneError set_val_string(const char *key, const char *val);
     OneError set_val_array(const char *key, const Array &val);
     OneError set_val_object(const char *key, const Object &val);
     OneError set_val_root_object(const Object &val);
 
+    // Sets this payload to the members of current that are missing from or
+    // differ in previous. The names of the members of previous missing from
+    // current are listed in an array under removed_key, if any. Both payloads
+    // must be objects.
+    OneError set_delta(const Payload &previous, const Payload &current,
+                       const char *removed_key);
+    // Applies a delta made by set_delta to this payload.
+    OneError apply_delta(const Payload &delta, const char *removed_key);
+
 private:
     rapidjson::Document _doc;
 };
@@ -77,6 +97,9 @@ public:
     Payload &payload();
     const Payload &payload() const;
 
+    // Bytes allocated for the payload, not including the message itself.
+    size_t footprint() const;
+
 private:
     Opcode _code;
     Payload _payload;
@@ -96,6 +119,17 @@ OneError prepare_application_instance_information(const Object &information,
 OneError prepare_application_instance_status(int status, Message &message);
 OneError prepare_custom_command(const Array &array, Message &message);
 
+// Key of the array listing the removed additional data keys in a live state
+// delta.
+constexpr const char *live_state_removed_key = "removedKeys";
+
+// Prepares the changes from the previous to the current live state payload.
+// Is empty is set if nothing changed, in which case the message is not
+// initialized.
+OneError prepare_live_state_delta(const Payload &previous, const Payload &current,
+                                  Message &message, bool &is_empty);
+OneError prepare_features(bool live_state_delta, Message &message);
+
 }  // namespace messages
 
 }  // namespace one
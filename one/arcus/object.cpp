@@ -11,9 +11,16 @@
 namespace i3d {
 namespace one {
 
-Object::Object() : _doc(rapidjson::kObjectType) {}
+namespace {
 
-Object::Object(const Object &other) {
+// Stateless, shared so that each document does not allocate its own.
+rapidjson::CrtAllocator shared_allocator;
+
+}  // namespace
+
+Object::Object() : _doc(rapidjson::kObjectType, &shared_allocator) {}
+
+Object::Object(const Object &other) : _doc(&shared_allocator) {
     _doc.CopyFrom(other.get(), _doc.GetAllocator());
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #include <one/arcus/internal/version.h>
 
 namespace i3d {
@@ -7,24 +9,54 @@ namespace one {
 
 enum class Opcode {
     invalid = 0,
-    health = 0x02,  // Used internally by the connection.
-    hello = 0x04,   // Used internally by the connection.
+    health = 0x02,    // Used internally by the connection.
+    hello = 0x04,     // Used internally by the connection.
+    features = 0x06,  // Optional features supported by the client.
     soft_stop = 0x30,
     allocated = 0x60,
     metadata = 0x40,
     reverse_metadata = 0x41,
     live_state = 0x20,
+    live_state_delta = 0x21,  // Sent instead of live_state once negotiated.
     host_information = 0x50,
     application_instance_information = 0x70,
     application_instance_status = 0x71,
     custom_command = 0x45
 };
 
+// Priority classes of outgoing messages. All queued messages of a class are
+// sent before any message of a lower class.
+enum class Priority {
+    control = 0,  // Connection and status traffic.
+    state = 1,    // Game state updates.
+    bulk = 2      // Everything else.
+};
+constexpr size_t priority_count = 3;
+
+// The class of outgoing messages with the opcode unless configured otherwise.
+constexpr Priority default_priority(Opcode code) {
+    return (code == Opcode::health || code == Opcode::hello ||
+            code == Opcode::features || code == Opcode::application_instance_status)
+               ? Priority::control
+               : (code == Opcode::live_state || code == Opcode::live_state_delta)
+                     ? Priority::state
+                     : Priority::bulk;
+}
+
+// Whether a queued outgoing message with the opcode is replaced by a newer
+// one unless configured otherwise. Only for opcodes of which the newest
+// message supersedes the previous ones. Live state deltas are not, as each
+// depends on the previous one.
+constexpr bool default_replace_in_queue(Opcode code) {
+    return code == Opcode::live_state || code == Opcode::application_instance_status;
+}
+
 // To finalize when the list of supported opcode is confirmed.
 constexpr bool is_opcode_supported_v2(Opcode code) {
-    return code == Opcode::health || code == Opcode::hello || code == Opcode::soft_stop ||
-           code == Opcode::allocated || code == Opcode::metadata ||
-           code == Opcode::reverse_metadata || code == Opcode::live_state ||
+    return code == Opcode::health || code == Opcode::hello || code == Opcode::features ||
+           code == Opcode::soft_stop || code == Opcode::allocated ||
+           code == Opcode::metadata || code == Opcode::reverse_metadata ||
+           code == Opcode::live_state || code == Opcode::live_state_delta ||
            code == Opcode::host_information ||
            code == Opcode::application_instance_information ||
            code == Opcode::application_instance_status || code == Opcode::custom_command;
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <one/arcus/opcode.h>
+
+namespace i3d {
+namespace one {
+
+// Tuning of the TCP sockets of a Server or Client, given at init as part of
+// ConnectionOptions. The defaults keep the system defaults, except that
+// Nagle's algorithm is left enabled as before. Zero keeps the system default
+// for the numeric options. Options other than the buffer sizes are ignored for
+// Unix domain sockets.
+struct SocketOptions {
+    SocketOptions()
+        : is_no_delay(false)
+        , send_buffer_size(0)
+        , receive_buffer_size(0)
+        , is_keepalive_enabled(false)
+        , keepalive_idle_seconds(0)
+        , keepalive_interval_seconds(0)
+        , keepalive_count(0)
+        , user_timeout_ms(0)
+        , busy_poll_us(0) {}
+
+    // TCP_NODELAY, sending small messages without waiting for the previous
+    // ones to be acknowledged. Lowers the tail latency of soft stops and
+    // allocations.
+    bool is_no_delay;
+    // SO_SNDBUF and SO_RCVBUF, in bytes.
+    unsigned int send_buffer_size;
+    unsigned int receive_buffer_size;
+    // SO_KEEPALIVE, probing an idle connection after keepalive_idle_seconds,
+    // every keepalive_interval_seconds, dropping it after keepalive_count
+    // unanswered probes.
+    bool is_keepalive_enabled;
+    unsigned int keepalive_idle_seconds;
+    unsigned int keepalive_interval_seconds;
+    unsigned int keepalive_count;
+    // TCP_USER_TIMEOUT, dropping the connection when sent data stays
+    // unacknowledged this long. Linux only.
+    unsigned int user_timeout_ms;
+    // SO_BUSY_POLL, busy polling the device queue on receive for this long.
+    // Linux only, and values above net.core.busy_read need CAP_NET_ADMIN.
+    unsigned int busy_poll_us;
+
+    // A profile for the lowest message latency, at the cost of more packets.
+    static SocketOptions low_latency() {
+        SocketOptions options;
+        options.is_no_delay = true;
+        return options;
+    }
+
+    bool is_valid() const {
+        // The system calls take signed integers.
+        const unsigned int max = 0x7fffffff;
+        return send_buffer_size <= max && receive_buffer_size <= max &&
+               keepalive_idle_seconds <= max && keepalive_interval_seconds <= max &&
+               keepalive_count <= max && user_timeout_ms <= max && busy_poll_us <= max;
+    }
+};
+
+// How a Server or Client detects a failed peer.
+enum class Liveness {
+    // Health messages are exchanged at the HealthOptions intervals.
+    health_messages = 0,
+    // SO_KEEPALIVE and TCP_USER_TIMEOUT, set from the HealthOptions intervals,
+    // leave detection to the kernel, without health messages. Linux only, and
+    // only used if the peer also requests it during the handshake, falling
+    // back to health messages otherwise. Unlike health messages, a peer that
+    // hangs while its host stays up is not detected.
+    kernel
+};
+
+// Health checking of the connection of a Server or Client, given at init as
+// part of ConnectionOptions. Each end sends a health message when it has sent
+// nothing else for the send interval, and fails the connection when it has
+// received nothing for the receive timeout, which must therefore exceed the
+// send interval of the peer.
+struct HealthOptions {
+    static constexpr unsigned int default_send_interval_ms = 5000;
+    static constexpr unsigned int default_receive_timeout_ms = 20000;
+
+    HealthOptions()
+        : send_interval_ms(default_send_interval_ms)
+        , receive_timeout_ms(default_receive_timeout_ms)
+        , is_adaptive(false)
+        , min_receive_timeout_ms(1000)
+        , liveness(Liveness::health_messages) {}
+
+    unsigned int send_interval_ms;
+    unsigned int receive_timeout_ms;
+    // Once the peer has sent a few health messages, lowers the receive timeout
+    // to three times the longest interval between them, which follows the send
+    // interval of the peer, but not below min_receive_timeout_ms. A failed peer
+    // is then detected sooner when its send interval is well below the receive
+    // timeout.
+    bool is_adaptive;
+    unsigned int min_receive_timeout_ms;
+    // The requested liveness mechanism.
+    Liveness liveness;
+
+    // A profile detecting a failed peer within a second, for both ends.
+    static HealthOptions fast_failover() {
+        HealthOptions options;
+        options.send_interval_ms = 250;
+        options.receive_timeout_ms = 1000;
+        options.is_adaptive = true;
+        options.min_receive_timeout_ms = 500;
+        return options;
+    }
+
+    bool is_valid() const {
+        return send_interval_ms > 0 && receive_timeout_ms > 0 &&
+               min_receive_timeout_ms <= receive_timeout_ms &&
+               (liveness == Liveness::health_messages || liveness == Liveness::kernel);
+    }
+};
+
+// Retrying of a Client connecting to the server, and of a Server binding its
+// port, given at init as part of ConnectionOptions. The delay between attempts
+// starts at initial_delay_ms and is multiplied after each failed attempt, up to
+// max_delay_ms. Each delay is shortened at random by up to jitter_percent, so
+// that instances restarting together do not retry in step. The delay starts
+// over once connected, so that a dropped connection is retried immediately.
+struct RetryOptions {
+    RetryOptions()
+        : initial_delay_ms(50), max_delay_ms(5000), multiplier(2), jitter_percent(50) {}
+
+    unsigned int initial_delay_ms;
+    unsigned int max_delay_ms;
+    unsigned int multiplier;
+    unsigned int jitter_percent;
+
+    // A fixed delay between attempts, without jitter.
+    static RetryOptions fixed(unsigned int delay_ms) {
+        RetryOptions options;
+        options.initial_delay_ms = delay_ms;
+        options.max_delay_ms = delay_ms;
+        options.multiplier = 1;
+        options.jitter_percent = 0;
+        return options;
+    }
+
+    bool is_valid() const {
+        return initial_delay_ms <= max_delay_ms && multiplier > 0 &&
+               jitter_percent <= 100;
+    }
+};
+
+// How the connected socket of a Server or Client is read and written.
+enum class IoBackend {
+    // Non blocking system calls, polled with select on each update.
+    select = 0,
+    // io_uring on Linux 6.0 and later, receiving without system calls into
+    // buffers the kernel fills as data arrives, and batching the sends queued
+    // while one is in flight. Falls back to select where unavailable.
+    io_uring
+};
+
+// Sizing of the message queues and stream buffers of the connection of a
+// Server or Client, and tuning of its sockets, given at init. The defaults suit
+// a single game server; hosts running many instances can lower them to reduce
+// memory use.
+struct ConnectionOptions {
+    ConnectionOptions()
+        : max_incoming_messages(48)
+        , max_outgoing_messages(48)
+        , initial_stream_size(16 * 1024)
+        , max_stream_size(128 * 1024)
+        , socket()
+        , io_backend(IoBackend::select)
+        , health()
+        , session_replay_size(0)
+        , shared_memory_capacity(0)
+        , retry() {}
+
+    // Received messages waiting to be processed by update.
+    size_t max_incoming_messages;
+    // Queued outgoing messages, for each priority class.
+    size_t max_outgoing_messages;
+    // The send and receive streams each start with initial_stream_size bytes
+    // and double in size as needed, up to max_stream_size. Messages that do
+    // not fit in max_stream_size cannot be sent or received.
+    size_t initial_stream_size;
+    size_t max_stream_size;
+    SocketOptions socket;
+    // Requested backend. The Server and Client report the one in use.
+    IoBackend io_backend;
+    HealthOptions health;
+    // Session resumption, when not zero. Up to this many bytes of the last
+    // messages sent are kept, so that after a reconnection only the messages
+    // the peer did not receive are sent again, instead of the whole state.
+    // Used only if the peer also enables it during the handshake, and at most
+    // half of max_stream_size.
+    size_t session_replay_size;
+    // Shared memory, when not zero. After the handshake, messages go through
+    // two rings of this many bytes instead of the socket, created by the
+    // Server. Used only if the peer also enables it and can open the rings,
+    // i.e. runs on the same host, the socket being kept otherwise. Kernel
+    // liveness is then not used. A power of two from 64 bytes to 1 GB, and
+    // not available on Windows.
+    size_t shared_memory_capacity;
+    RetryOptions retry;
+
+    // A profile for hosts running many instances, keeping an idle connected
+    // Server or Client below 32 KB. Queues are shallow and the streams start
+    // small, growing only to fit large messages.
+    static ConnectionOptions small_footprint() {
+        ConnectionOptions options;
+        options.max_incoming_messages = 8;
+        options.max_outgoing_messages = 8;
+        options.initial_stream_size = 1024;
+        return options;
+    }
+
+    // The socket options to apply for the liveness agreed with the peer, the
+    // socket options until the handshake agrees on kernel liveness. With
+    // kernel liveness, keepalive probing starts after the health send
+    // interval and repeats at that interval, and both the probes and
+    // TCP_USER_TIMEOUT give up after the receive timeout, replacing the
+    // keepalive and user timeout options.
+    SocketOptions applied_socket_options(Liveness liveness) const {
+        SocketOptions options = socket;
+        if (liveness != Liveness::kernel) {
+            return options;
+        }
+        const unsigned int send_seconds = (health.send_interval_ms + 999) / 1000;
+        const unsigned int receive_seconds = (health.receive_timeout_ms + 999) / 1000;
+        options.is_keepalive_enabled = true;
+        options.keepalive_idle_seconds = send_seconds;
+        options.keepalive_interval_seconds = send_seconds;
+        options.keepalive_count = 1;
+        if (receive_seconds > 2 * send_seconds) {
+            options.keepalive_count = (receive_seconds - send_seconds) / send_seconds;
+        }
+        options.user_timeout_ms = health.receive_timeout_ms;
+        return options;
+    }
+
+    bool is_valid() const {
+        // Shared memory rings are sized by a power of two.
+        const size_t shared = shared_memory_capacity;
+        const bool is_shared_valid =
+            shared == 0 || (shared >= 64 && shared <= 1024 * 1024 * 1024 &&
+                            (shared & (shared - 1)) == 0);
+        return max_incoming_messages > 0 && max_outgoing_messages > 0 &&
+               initial_stream_size > 0 && initial_stream_size <= max_stream_size &&
+               socket.is_valid() &&
+               (io_backend == IoBackend::select || io_backend == IoBackend::io_uring) &&
+               health.is_valid() && session_replay_size <= max_stream_size / 2 &&
+               is_shared_valid && retry.is_valid();
+    }
+};
+
+// Fill levels of the message queues of a connection, reported by the Server
+// and Client so that integrations can slow down before sends fail.
+struct QueuePressure {
+    QueuePressure()
+        : incoming(0)
+        , incoming_capacity(0)
+        , outgoing()
+        , outgoing_capacity(0)
+        , is_reading_paused(false) {}
+
+    size_t incoming;
+    size_t incoming_capacity;
+    // Indexed by Priority.
+    size_t outgoing[priority_count];
+    size_t outgoing_capacity;  // For each priority class.
+    // Reading from the socket is paused until the incoming queue is processed.
+    bool is_reading_paused;
+};
+
+// Memory held by an initialized Server or Client, in bytes allocated through
+// the arcus allocator. Kernel socket buffers are not included.
+struct MemoryFootprint {
+    MemoryFootprint()
+        : instance(0), streams(0), queues(0), messages(0), state(0), json_cache(0) {}
+
+    size_t instance;  // The Server or Client, its connection and sockets.
+    size_t streams;   // Send and receive stream buffers.
+    size_t queues;    // Message queue slots, allocated on first use.
+    size_t messages;  // JSON values of the messages in the queue slots.
+    size_t state;     // JSON values and strings kept by the instance.
+    // Blocks cached for reuse by the JSON allocator of the calling thread. They
+    // are shared by everything using JSON on the thread and are not part of
+    // the total.
+    size_t json_cache;
+
+    size_t total() const {
+        return instance + streams + queues + messages + state;
+    }
+};
+
+}  // namespace one
+}  // namespace i3d
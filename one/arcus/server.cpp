@@ -1,88 +1,239 @@
 #include <one/arcus/server.h>
 
 #include <one/arcus/allocator.h>
+#include <one/arcus/internal/async_logger.h>
+#include <one/arcus/internal/capture.h>
 #include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/io_uring.h>
+#include <one/arcus/internal/json.h>
 #include <one/arcus/internal/messages.h>
 #include <one/arcus/internal/mutex.h>
 #include <one/arcus/internal/socket.h>
+#include <one/arcus/internal/time.h>
+#include <one/arcus/internal/transport.h>
 #include <one/arcus/opcode.h>
 #include <one/arcus/message.h>
 
+#include <stdint.h>
+#include <cstring>
+
+// Logging can be compiled out entirely by defining ONE_ARCUS_DISABLE_SERVER_LOGGING.
+// Otherwise log calls are still skipped at runtime, before any formatting, when
+// no logger is set or the level is below the logger level.
+#ifndef ONE_ARCUS_DISABLE_SERVER_LOGGING
 #define ONE_ARCUS_SERVER_LOGGING
+#endif
 
 namespace i3d {
 namespace one {
 
 namespace {
-size_t listen_retry_delay_seconds = 60;
-}
 
-namespace server {
-// For testing.
-void set_listen_retry_delay(size_t seconds) {
-    listen_retry_delay_seconds = seconds;
-}
-}  // namespace server
-
-bool Server::game_states_changed(Server::GameState &new_state,
-                                 Server::GameState &old_state) {
-    if (new_state.players != old_state.players) {
-        return true;
-    }
-    if (new_state.max_players != old_state.max_players) {
-        return true;
-    }
-    if (new_state.name != old_state.name) {
-        return true;
+// Checks that a live state string is set and fits in the fixed buffers.
+OneError validate_live_state_string(const char *val, OneError null_error) {
+    if (val == nullptr) {
+        return null_error;
     }
-    if (new_state.map != old_state.map) {
-        return true;
+    if (std::strlen(val) > Server::max_live_state_string_length) {
+        return ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG;
     }
-    if (new_state.mode != old_state.mode) {
-        return true;
-    }
-    if (new_state.version != old_state.version) {
-        return true;
+    return ONE_ERROR_NONE;
+}
+
+// Heap bytes of the string, zero if stored within the string itself.
+size_t string_footprint(const String &string) {
+    const auto data = reinterpret_cast<uintptr_t>(string.data());
+    const auto begin = reinterpret_cast<uintptr_t>(&string);
+    if (data >= begin && data < begin + sizeof(string)) {
+        return 0;
     }
-    return false;
+    return string.capacity() + 1;
 }
 
+}  // namespace
+
 // See: https://en.cppreference.com/w/cpp/language/value_initialization
 // C++11 Value initialization
 Server::Server()
-    : _listen_port(0)
+    : _async_logger(nullptr)
+    , _listen_port(0)
     , _is_listening(false)
     , _listen_socket(nullptr)
     , _client_socket(nullptr)
     , _client_connection(nullptr)
+    , _io_uring(nullptr)
+    , _transport(nullptr)
+    , _is_transport_open(false)
+    , _capture(nullptr)
     , _is_waiting_for_client(false)
     , _game_state()
-    , _last_sent_game_state()
-    , _game_state_was_set(false)
+    , _dirty_live_state_fields(0)
+    , _has_live_state(false)
     , _status(ApplicationInstanceStatus::starting)
     , _should_send_status(false)
+    , _min_send_interval_ms(0)
+    , _last_live_state_send_time(steady_clock::duration::zero())
+    , _last_status_send_time(steady_clock::duration::zero())
     , _callbacks{}
-    , _last_listen_attempt_time(steady_clock::duration::zero())
-    , _additional_data(nullptr) {}
+    , _listen_backoff(nullptr)
+    , _additional_data(nullptr)
+    , _live_state_params(nullptr)
+    , _is_live_state_delta_enabled(false)
+    , _is_live_state_delta_negotiated(false)
+    , _last_sent_live_state(nullptr)
+    , _has_sent_live_state(false) {}
 
 Server::~Server() {
     shutdown();
+    disable_capture();
+    set_async_logging(false);
 }
 
 void Server::set_logger(const Logger &logger) {
-    _logger = logger;
+    const std::lock_guard<std::mutex> lock(_server);
+
+    Logger sink = logger;
+    sink.set_level(_sink_logger.level());
+    _sink_logger = sink;
+    if (_async_logger != nullptr) {
+        _async_logger->set_sink(_sink_logger);
+        _logger = _async_logger->front();
+    } else {
+        _logger = _sink_logger;
+    }
 }
 
-OneError Server::init(unsigned int listen_port) {
+void Server::set_log_level(LogLevel level) {
     const std::lock_guard<std::mutex> lock(_server);
 
+    _sink_logger.set_level(level);
+    _logger.set_level(level);
+    if (_async_logger != nullptr) {
+        _async_logger->set_sink(_sink_logger);
+    }
+}
+
+OneError Server::set_async_logging(bool enabled) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (enabled == (_async_logger != nullptr)) {
+        return ONE_ERROR_NONE;
+    }
+
+    if (!enabled) {
+        _logger = _sink_logger;
+        allocator::destroy<AsyncLogger>(_async_logger);
+        _async_logger = nullptr;
+        return ONE_ERROR_NONE;
+    }
+
+    _async_logger = allocator::create<AsyncLogger>();
+    if (_async_logger == nullptr) {
+        return ONE_ERROR_LOGGER_ALLOCATION_FAILED;
+    }
+
+    auto err = _async_logger->init(_sink_logger);
+    if (is_error(err)) {
+        allocator::destroy<AsyncLogger>(_async_logger);
+        _async_logger = nullptr;
+        return err;
+    }
+
+    _logger = _async_logger->front();
+    return ONE_ERROR_NONE;
+}
+
+void Server::log_message(const char *direction, const Message &message) const {
+    if (!_logger.is_enabled(LogLevel::Info)) {
+        return;
+    }
+
+    char payload[log_payload_max_length];
+    bool truncated = false;
+    const size_t length = message.payload().to_json(payload, sizeof(payload), truncated);
+
+    OStringStream stream;
+    stream << direction << " opcode: " << static_cast<int>(message.code())
+           << ", payload: ";
+    stream.write(payload, length);
+    if (truncated) {
+        stream << "...";
+    }
+    _logger.Log(LogLevel::Info, stream.str());
+}
+
+OneError Server::init(unsigned int listen_port, const ConnectionOptions &options) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (is_initialized()) {
+        return ONE_ERROR_SERVER_ALREADY_INITIALIZED;
+    }
+
     _listen_port = listen_port;
+    _listen_path.clear();
+    return init_endpoint(options);
+}
 
+OneError Server::init_local(const char *path, const ConnectionOptions &options) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (std::strlen(path) >= Socket::local_path_size) {
+        return ONE_ERROR_SOCKET_PATH_TOO_LONG;
+    }
+    if (is_initialized()) {
+        return ONE_ERROR_SERVER_ALREADY_INITIALIZED;
+    }
+
+    _listen_port = 0;
+    _listen_path = path;
+    return init_endpoint(options);
+}
+
+OneError Server::init_transport(Transport &transport, const ConnectionOptions &options) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (is_initialized() || _client_connection != nullptr) {
+        return ONE_ERROR_SERVER_ALREADY_INITIALIZED;
+    }
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+    if (!transport.is_initialized()) {
+        return ONE_ERROR_TRANSPORT_NOT_INITIALIZED;
+    }
+
+    auto err = init_socket_system();
+    if (is_error(err)) {
+        return err;
+    }
+
+    _client_connection = allocator::create<Connection>(options);
+    if (_client_connection == nullptr) {
+        shutdown_locked();
+        return ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR;
+    }
+    _client_connection->set_capture(_capture);
+
+    _transport = &transport;
+    _is_transport_open = true;
+    _client_connection->init(transport);
+    _client_connection->initiate_handshake();
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::init_endpoint(const ConnectionOptions &options) {
     if (_listen_socket != nullptr || _client_socket != nullptr ||
         _client_connection != nullptr) {
         return ONE_ERROR_SERVER_ALREADY_INITIALIZED;
     }
 
+    if (!options.is_valid()) {
+        return ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID;
+    }
+
     auto err = init_socket_system();
     if (is_error(err)) {
         return err;
@@ -93,31 +244,61 @@ OneError Server::init(unsigned int listen_port) {
         return ONE_ERROR_SERVER_SOCKET_ALLOCATION_FAILED;
     }
 
-    err = _listen_socket->init();
+    _listen_backoff = allocator::create<Backoff>(options.retry);
+    if (_listen_backoff == nullptr) {
+        shutdown_locked();
+        return ONE_ERROR_SERVER_ALLOCATION_FAILED;
+    }
+
+    err = _listen_path.empty() ? _listen_socket->init() : _listen_socket->init_local();
     if (is_error(err)) {
-        shutdown();
+        shutdown_locked();
         return err;
     }
 
+    // Set on the listen socket too, so that the buffer sizes apply from the
+    // start of accepted connections. Those of kernel liveness apply once the
+    // client agrees, and must not be inherited from the listen socket.
+    _socket_options = options.applied_socket_options(Liveness::health_messages);
+    err = _listen_socket->set_options(_socket_options);
+    if (is_error(err)) {
+        shutdown_locked();
+        return err;
+    }
+    _kernel_socket_options = options.applied_socket_options(Liveness::kernel);
+    if (options.health.liveness == Liveness::kernel && _listen_path.empty() &&
+        !Socket::is_supported(_kernel_socket_options)) {
+        shutdown_locked();
+        return ONE_ERROR_SOCKET_OPTION_UNSUPPORTED;
+    }
+
     _client_socket = allocator::create<Socket>();
     if (_client_socket == nullptr) {
-        shutdown();
+        shutdown_locked();
         return ONE_ERROR_SERVER_SOCKET_ALLOCATION_FAILED;
     }
 
-    _additional_data = allocator::create<Object>();
-    if (_additional_data == nullptr) {
-        shutdown();
-        return ONE_ERROR_SERVER_OBJECT_ALLOCATION_FAILED;
-    }
-
-    const auto max_incoming = Connection::max_message_default;
-    const auto max_outgoing = Connection::max_message_default;
-    _client_connection = allocator::create<Connection>(max_incoming, max_outgoing);
+    _client_connection = allocator::create<Connection>(options);
     if (_client_connection == nullptr) {
-        shutdown();
+        shutdown_locked();
         return ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR;
     }
+    _client_connection->set_capture(_capture);
+
+    // Falls back to select where io_uring is unavailable.
+    if (options.io_backend == IoBackend::io_uring && IoUringTransport::is_supported()) {
+        _io_uring = allocator::create<IoUringTransport>();
+        if (_io_uring == nullptr) {
+            shutdown_locked();
+            return ONE_ERROR_SERVER_SOCKET_ALLOCATION_FAILED;
+        }
+        err = _io_uring->init();
+        if (is_error(err)) {
+            _logger.Log(LogLevel::Info, "io_uring is unavailable, using select");
+            allocator::destroy<IoUringTransport>(_io_uring);
+            _io_uring = nullptr;
+        }
+    }
 
     // Attempt to start listening at init time, but if port binding fails then
     // update will try to listen again periodically, so punt the bind error
@@ -130,20 +311,87 @@ OneError Server::init(unsigned int listen_port) {
     return ONE_ERROR_NONE;
 }
 
-OneError Server::shutdown() {
-    _logger.Log(LogLevel::Info, "server is shutting down");
+OneError Server::enable_capture(const char *path, size_t max_file_size,
+                                size_t max_files) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (path == nullptr) {
+        return ONE_ERROR_VALIDATION_PATH_IS_NULLPTR;
+    }
+    if (_capture != nullptr) {
+        return ONE_ERROR_CAPTURE_ALREADY_OPEN;
+    }
 
+    _capture = allocator::create<CaptureWriter>();
+    if (_capture == nullptr) {
+        return ONE_ERROR_CAPTURE_ALLOCATION_FAILED;
+    }
+
+    auto err = _capture->open(path, max_file_size, max_files);
+    if (is_error(err)) {
+        allocator::destroy<CaptureWriter>(_capture);
+        _capture = nullptr;
+        return err;
+    }
+
+    if (_client_connection != nullptr) {
+        _client_connection->set_capture(_capture);
+    }
+    return ONE_ERROR_NONE;
+}
+
+void Server::disable_capture() {
     const std::lock_guard<std::mutex> lock(_server);
 
+    if (_capture == nullptr) {
+        return;
+    }
+
+    if (_client_connection != nullptr) {
+        _client_connection->set_capture(nullptr);
+    }
+    allocator::destroy<CaptureWriter>(_capture);
+    _capture = nullptr;
+}
+
+OneError Server::shutdown() {
+    const std::lock_guard<std::mutex> lock(_server);
+    const OneError err = shutdown_locked();
+    json::flush();
+    return err;
+}
+
+OneError Server::shutdown_locked() {
+    _logger.Log(LogLevel::Info, "server is shutting down");
+
     if (_client_connection != nullptr) {
         allocator::destroy<Connection>(_client_connection);
         _client_connection = nullptr;
     }
 
+    // Before the client socket, which it reads and writes.
+    if (_io_uring != nullptr) {
+        allocator::destroy<IoUringTransport>(_io_uring);
+        _io_uring = nullptr;
+    }
+
     if (_listen_socket != nullptr) {
         allocator::destroy<Socket>(_listen_socket);
         _listen_socket = nullptr;
     }
+    if (_is_listening && !_listen_path.empty()) {
+        Socket::remove_local(_listen_path.c_str());
+    }
+    _is_listening = false;
+    _is_waiting_for_client = false;
+    if (_listen_backoff != nullptr) {
+        allocator::destroy<Backoff>(_listen_backoff);
+        _listen_backoff = nullptr;
+    }
+
+    // Owned by the caller of init_transport.
+    _transport = nullptr;
+    _is_transport_open = false;
 
     if (_client_socket != nullptr) {
         allocator::destroy<Socket>(_client_socket);
@@ -155,6 +403,23 @@ OneError Server::shutdown() {
         _additional_data = nullptr;
     }
 
+    if (_game_state.additional_data != nullptr) {
+        _game_state.additional_data = nullptr;
+        _dirty_live_state_fields |= additional_data_field;
+    }
+
+    if (_live_state_params != nullptr) {
+        allocator::destroy<params::LiveStateResponse>(_live_state_params);
+        _live_state_params = nullptr;
+    }
+
+    if (_last_sent_live_state != nullptr) {
+        allocator::destroy<Message>(_last_sent_live_state);
+        _last_sent_live_state = nullptr;
+    }
+    _is_live_state_delta_negotiated = false;
+    _has_sent_live_state = false;
+
     shutdown_socket_system();
     ServerCallbacks cb{};
     _callbacks = cb;
@@ -186,7 +451,10 @@ Server::Status Server::status() const {
 
     if (_is_waiting_for_client) return Status::waiting_for_client;
 
-    if (_listen_socket->is_initialized() && !_is_waiting_for_client &&
+    // A failed transport is not replaced by a new connection.
+    if (_transport != nullptr && !_is_transport_open) return Status::error;
+
+    if (_transport == nullptr && _listen_socket->is_initialized() &&
         !_client_socket->is_initialized()) {
         return Status::initialized;
     }
@@ -194,8 +462,11 @@ Server::Status Server::status() const {
     const auto status = _client_connection->status();
     switch (status) {
         case Connection::Status::handshake_not_started:
+        case Connection::Status::handshake_hello_received:
         case Connection::Status::handshake_hello_scheduled:
         case Connection::Status::handshake_hello_sent:
+        case Connection::Status::handshake_shared_memory:
+        case Connection::Status::handshake_session:
             return Status::handshake;
         case Connection::Status::ready:
             return Status::ready;
@@ -217,20 +488,19 @@ OneError Server::listen() {
         return ONE_ERROR_SERVER_ALREADY_LISTENING;
     }
 
-    // Check if server has already listened and should delay before attempting again.
-    const steady_clock::time_point _time_zero(steady_clock::duration::zero());
-    const auto now = steady_clock::now();
-    if (_last_listen_attempt_time != _time_zero) { // If this isn't the first time listening...
-        const size_t delta = duration_cast<seconds>(now - _last_listen_attempt_time).count();
-        if (delta <= listen_retry_delay_seconds) { // ...and not enough time has passed since the previous listen.
-            return ONE_ERROR_SERVER_RETRYING_LISTEN;
-        }
+    // Delay before attempting again if a previous attempt failed.
+    assert(_listen_backoff != nullptr);
+    if (!_listen_backoff->update()) {
+        return ONE_ERROR_SERVER_RETRYING_LISTEN;
     }
-    _last_listen_attempt_time = now;
 
-    auto err = _listen_socket->bind(_listen_port);
+    auto err = _listen_path.empty() ? _listen_socket->bind(_listen_port)
+                                    : _listen_socket->bind_local(_listen_path.c_str());
     if (is_error(err)) {
 #ifdef ONE_ARCUS_SERVER_LOGGING
+        if (!_logger.is_enabled(LogLevel::Error)) {
+            return err;
+        }
         _listen_socket->set_last_error_text();
         OStringStream stream;
         stream << "failed to bind socket with error text: "
@@ -253,7 +523,14 @@ OneError Server::listen() {
 }
 
 bool Server::is_initialized() const {
-    return (_listen_socket != nullptr);
+    return (_listen_socket != nullptr || _transport != nullptr);
+}
+
+bool Server::is_client_connected() const {
+    if (_transport != nullptr) {
+        return _is_transport_open;
+    }
+    return _client_socket->is_initialized();
 }
 
 OneError Server::update_listen_socket() {
@@ -288,6 +565,12 @@ OneError Server::update_listen_socket() {
         return ONE_ERROR_NONE;
     }
 
+    // Not all options are inherited from the listen socket on all platforms.
+    err = incoming_client.set_options(_socket_options);
+    if (is_error(err)) {
+        return err;
+    }
+
     // If a client is already connected, then override the existing connection.
     if (_client_socket->is_initialized()) {
         close_client_connection();
@@ -298,7 +581,11 @@ OneError Server::update_listen_socket() {
     _is_waiting_for_client = false;
 
     *_client_socket = incoming_client;
-    _client_connection->init(*_client_socket);
+    if (_io_uring != nullptr && !is_error(_io_uring->attach(*_client_socket))) {
+        _client_connection->init(*_io_uring);
+    } else {
+        _client_connection->init(*_client_socket);
+    }
 
     // The Arcus Server is responsible for initiating the handshake against agents.
     // The agent waits for an initial hello packet from the Server.
@@ -307,50 +594,71 @@ OneError Server::update_listen_socket() {
     return ONE_ERROR_NONE;
 }
 
+OneError Server::process_features(const Message &message) {
+#ifdef ONE_ARCUS_SERVER_LOGGING
+    log_message("incoming", message);
+#endif
+
+    params::FeaturesRequest params;
+    const auto err = validation::features(message, params);
+    if (is_error(err)) {
+        return err;
+    }
+
+    const bool negotiated = _is_live_state_delta_enabled && params._live_state_delta;
+    if (negotiated && !_is_live_state_delta_negotiated) {
+        // The next live state is sent in full.
+        _has_sent_live_state = false;
+    }
+    _is_live_state_delta_negotiated = negotiated;
+    return ONE_ERROR_NONE;
+}
+
 OneError Server::process_incoming_message(const Message &message) {
+    if (message.code() == Opcode::features) {
+        return process_features(message);
+    }
+
     // Unlock and relock the server mutex when processing incoming messages to
     // allow the callback to be re-entrant on server functions (e.g. to send
     // an outgoing message in response to an incoming message).
     const ReverseLockGuard<std::mutex> reverse_lock(_server);
 
 #ifdef ONE_ARCUS_SERVER_LOGGING
-    OStringStream stream;
-    stream << "incoming opcode: " << static_cast<int>(message.code())
-           << ", payload: " << message.payload().to_json();
-    _logger.Log(LogLevel::Info, stream.str());
+    log_message("incoming", message);
 #endif
 
     switch (message.code()) {
         case Opcode::soft_stop:
-            if (_callbacks._soft_stop == nullptr) {
+            if (!_callbacks._soft_stop) {
                 return ONE_ERROR_NONE;
             }
 
             return invocation::soft_stop(message, _callbacks._soft_stop,
                                          _callbacks._soft_stop_userdata);
         case Opcode::allocated:
-            if (_callbacks._allocated == nullptr) {
+            if (!_callbacks._allocated) {
                 return ONE_ERROR_NONE;
             }
 
             return invocation::allocated(message, _callbacks._allocated,
                                          _callbacks._allocated_userdata);
         case Opcode::metadata:
-            if (_callbacks._metadata == nullptr) {
+            if (!_callbacks._metadata) {
                 return ONE_ERROR_NONE;
             }
 
             return invocation::metadata(message, _callbacks._metadata,
                                         _callbacks._metadata_userdata);
         case Opcode::host_information:
-            if (_callbacks._host_information == nullptr) {
+            if (!_callbacks._host_information) {
                 return ONE_ERROR_NONE;
             }
 
             return invocation::host_information(message, _callbacks._host_information,
                                                 _callbacks._host_information_data);
         case Opcode::application_instance_information:
-            if (_callbacks._application_instance_information == nullptr) {
+            if (!_callbacks._application_instance_information) {
                 return ONE_ERROR_NONE;
             }
 
@@ -358,7 +666,7 @@ OneError Server::process_incoming_message(const Message &message) {
                 message, _callbacks._application_instance_information,
                 _callbacks._application_instance_information_data);
         case Opcode::custom_command:
-            if (_callbacks._custom_command == nullptr) {
+            if (!_callbacks._custom_command) {
                 return ONE_ERROR_NONE;
             }
 
@@ -371,23 +679,28 @@ OneError Server::process_incoming_message(const Message &message) {
 
 OneError Server::process_outgoing_message(const Message &message) {
 #ifdef ONE_ARCUS_SERVER_LOGGING
-    OStringStream stream;
-    stream << "outgoing opcode: " << static_cast<int>(message.code())
-           << ", payload: " << message.payload().to_json();
-    _logger.Log(LogLevel::Info, stream.str());
+    log_message("outgoing", message);
 #endif
 
     OneError err = ONE_ERROR_NONE;
     switch (message.code()) {
         case Opcode::live_state: {
-            params::LiveStateResponse params;
-            err = validation::live_state(message, params);
+            if (_live_state_params == nullptr) {
+                _live_state_params = allocator::create<params::LiveStateResponse>();
+                if (_live_state_params == nullptr) {
+                    return ONE_ERROR_SERVER_OBJECT_ALLOCATION_FAILED;
+                }
+            }
+            err = validation::live_state(message, *_live_state_params);
             if (is_error(err)) {
                 return err;
             }
 
             break;
         }
+        case Opcode::live_state_delta:
+            // Made from validated live states.
+            break;
         case Opcode::reverse_metadata: {
             params::ReverseMetaDataResponse params;
             err = validation::reverse_metadata(message, params);
@@ -428,17 +741,28 @@ OneError Server::process_outgoing_message(const Message &message) {
 }
 
 void Server::close_client_connection() {
-    _client_connection->shutdown();
+    // The session is kept for the client to resume, if enabled.
+    _client_connection->suspend();
+    if (_transport != nullptr) {
+        _is_transport_open = false;
+        _logger.Log(LogLevel::Info, "closing client transport");
+        return;
+    }
+    if (_io_uring != nullptr) {
+        _io_uring->detach();
+    }
     _client_socket->close();
     _is_waiting_for_client = true;
 
 #ifdef ONE_ARCUS_SERVER_LOGGING
-    String ip;
-    unsigned int port;
-    _client_socket->address(ip, port);
-    OStringStream stream;
-    stream << "closing client ip: " << ip << ", port: " << std::to_string(port);
-    _logger.Log(LogLevel::Info, stream.str());
+    if (_logger.is_enabled(LogLevel::Info)) {
+        String ip;
+        unsigned int port;
+        _client_socket->address(ip, port);
+        OStringStream stream;
+        stream << "closing client ip: " << ip << ", port: " << std::to_string(port);
+        _logger.Log(LogLevel::Info, stream.str());
+    }
 #endif
 }
 
@@ -466,9 +790,11 @@ OneError Server::update_client_connection() {
         if (count == 0) break;
 
 #ifdef ONE_ARCUS_SERVER_LOGGING
-        OStringStream stream;
-        stream << "server processing incoming messages: " << count;
-        _logger.Log(LogLevel::Info, stream.str());
+        if (_logger.is_enabled(LogLevel::Info)) {
+            OStringStream stream;
+            stream << "server processing incoming messages: " << count;
+            _logger.Log(LogLevel::Info, stream.str());
+        }
 #endif
 
         err = _client_connection->remove_incoming(
@@ -486,43 +812,30 @@ OneError Server::update() {
         return ONE_ERROR_SERVER_SOCKET_NOT_INITIALIZED;
     }
 
-    assert(_client_socket != nullptr);
+    assert(_transport != nullptr || _client_socket != nullptr);
     assert(_client_connection != nullptr);
 
-    auto err = update_listen_socket();
-    if (is_error(err)) {
-        return err;
+    OneError err = ONE_ERROR_NONE;
+    if (_transport == nullptr) {
+        err = update_listen_socket();
+        if (is_error(err)) {
+            return err;
+        }
     }
 
     // Done if no client is connected.
-    if (!_client_socket->is_initialized()) {
+    if (!is_client_connected()) {
         return ONE_ERROR_NONE;
     }
 
     const bool was_ready = (_client_connection->status() == Connection::Status::ready);
 
-    if (was_ready && _game_state_was_set) {
-        if (game_states_changed(_game_state, _last_sent_game_state)) {
-            if (_client_connection->status() == Connection::Status::ready) {
-                err = send_live_state();
-                if (is_error(err)) {
-                    close_client_connection();
-                    return err;
-                }
-                _game_state_was_set = false;
-                _last_sent_game_state = _game_state;
-            }
-        } else {
-            _game_state_was_set = false;
-        }
-    }
-    if (was_ready && _should_send_status) {
-        err = send_application_instance_status();
+    if (was_ready) {
+        err = send_pending_states(false);
         if (is_error(err)) {
             close_client_connection();
             return err;
         }
-        _should_send_status = false;
     }
 
     err = update_client_connection();
@@ -530,12 +843,35 @@ OneError Server::update() {
         return err;
     }
 
+    if (_client_connection->take_writable() && _callbacks._writable) {
+        // Unlocked so that the callback can send messages.
+        const ReverseLockGuard<std::mutex> reverse_lock(_server);
+        _callbacks._writable(_callbacks._writable_userdata);
+    }
+
     const bool is_ready = (_client_connection->status() == Connection::Status::ready);
-    if (is_ready && !was_ready) {
+    if (is_ready && !was_ready && _transport == nullptr &&
+        _client_connection->liveness() == Liveness::kernel) {
+        err = _client_socket->set_options(_kernel_socket_options);
+        if (is_error(err)) {
+            close_client_connection();
+            return err;
+        }
+    }
+    if (is_ready && !was_ready && !_client_connection->is_resumed()) {
         // Schedule a send when connection is established to ensure newly
-        // connected client has the correct state.
-        _game_state_was_set = true;
+        // connected client has the correct state. A resumed session received
+        // everything sent before.
+        _is_live_state_delta_negotiated = false;
+        _has_sent_live_state = false;
+        if (_has_live_state) {
+            _dirty_live_state_fields = all_live_state_fields;
+        }
         _should_send_status = true;
+
+        // The new client receives the current state without delay.
+        _last_live_state_send_time = steady_clock::time_point();
+        _last_status_send_time = steady_clock::time_point();
     }
 
     return ONE_ERROR_NONE;
@@ -546,24 +882,285 @@ OneError Server::set_live_state(int players, int max_players, const char *name,
                                 Object *additional_data) {
     const std::lock_guard<std::mutex> lock(_server);
 
+    // Strings of any length are accepted, as before the per-field setters.
+    if (name == nullptr) {
+        return ONE_ERROR_VALIDATION_NAME_IS_NULLPTR;
+    }
+    if (map == nullptr) {
+        return ONE_ERROR_VALIDATION_MAP_IS_NULLPTR;
+    }
+    if (mode == nullptr) {
+        return ONE_ERROR_VALIDATION_MODE_IS_NULLPTR;
+    }
+    if (version == nullptr) {
+        return ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR;
+    }
+    if (additional_data != nullptr) {
+        auto err = create_additional_data();
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    store_int(_game_state.players, players, players_field);
+    store_int(_game_state.max_players, max_players, max_players_field);
+    store_string(_game_state.name, name, name_field);
+    store_string(_game_state.map, map, map_field);
+    store_string(_game_state.mode, mode, mode_field);
+    store_string(_game_state.version, version, version_field);
+    store_additional_data(additional_data);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_players(int players) {
+    const std::lock_guard<std::mutex> lock(_server);
+    store_int(_game_state.players, players, players_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_max_players(int max_players) {
+    const std::lock_guard<std::mutex> lock(_server);
+    store_int(_game_state.max_players, max_players, max_players_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_name(const char *name) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    auto err = validate_live_state_string(name, ONE_ERROR_VALIDATION_NAME_IS_NULLPTR);
+    if (is_error(err)) {
+        return err;
+    }
+
+    store_string(_game_state.name, name, name_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_map(const char *map) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    auto err = validate_live_state_string(map, ONE_ERROR_VALIDATION_MAP_IS_NULLPTR);
+    if (is_error(err)) {
+        return err;
+    }
+
+    store_string(_game_state.map, map, map_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_mode(const char *mode) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    auto err = validate_live_state_string(mode, ONE_ERROR_VALIDATION_MODE_IS_NULLPTR);
+    if (is_error(err)) {
+        return err;
+    }
+
+    store_string(_game_state.mode, mode, mode_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_version(const char *version) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    auto err =
+        validate_live_state_string(version, ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR);
+    if (is_error(err)) {
+        return err;
+    }
+
+    store_string(_game_state.version, version, version_field);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::set_additional_data(Object *additional_data) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (additional_data != nullptr) {
+        auto err = create_additional_data();
+        if (is_error(err)) {
+            return err;
+        }
+    }
+
+    store_additional_data(additional_data);
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::create_additional_data() {
+    if (_additional_data == nullptr) {
+        _additional_data = allocator::create<Object>();
+        if (_additional_data == nullptr) {
+            return ONE_ERROR_SERVER_OBJECT_ALLOCATION_FAILED;
+        }
+    }
+    return ONE_ERROR_NONE;
+}
+
+void Server::store_int(int &field, int val, LiveStateField bit) {
+    if (field != val || !_has_live_state) {
+        field = val;
+        _dirty_live_state_fields |= bit;
+    }
+    _has_live_state = true;
+}
+
+void Server::store_string(LiveStateString &field, const char *val, LiveStateField bit) {
+    if (std::strcmp(field.c_str(), val) != 0 || !_has_live_state) {
+        const size_t length = std::strlen(val);
+        if (length > max_live_state_string_length) {
+            field.long_value = val;
+        } else {
+            field.long_value.clear();
+            std::memcpy(field.value, val, length + 1);
+        }
+        _dirty_live_state_fields |= bit;
+    }
+    _has_live_state = true;
+}
+
+void Server::store_additional_data(Object *additional_data) {
+    // The owned copy is kept when no additional data is given, so that it can
+    // be reused by later calls.
     if (additional_data == nullptr) {
-        _additional_data = nullptr;
-    } else {
-        (*_additional_data) = *additional_data;
+        if (_game_state.additional_data != nullptr) {
+            _game_state.additional_data = nullptr;
+            _dirty_live_state_fields |= additional_data_field;
+        }
+    } else if (_game_state.additional_data == nullptr ||
+               _additional_data->get() != additional_data->get()) {
+        *_additional_data = *additional_data;
+        _game_state.additional_data = _additional_data;
+        _dirty_live_state_fields |= additional_data_field;
+    }
+    _has_live_state = true;
+}
+
+void Server::set_min_send_interval(size_t milliseconds) {
+    const std::lock_guard<std::mutex> lock(_server);
+    _min_send_interval_ms = milliseconds;
+}
+
+OneError Server::flush() {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (!is_initialized()) {
+        return ONE_ERROR_SERVER_SOCKET_NOT_INITIALIZED;
+    }
+
+    // Pending states stay pending and are sent once a client is ready.
+    if (!is_client_connected() ||
+        _client_connection->status() != Connection::Status::ready) {
+        return ONE_ERROR_NONE;
+    }
+
+    auto err = send_pending_states(true);
+    if (is_error(err)) {
+        close_client_connection();
+        return err;
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::queue_pressure(QueuePressure &pressure) const {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (_client_connection == nullptr) {
+        return ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR;
+    }
+
+    // The incoming count is left at zero while no client is connected.
+    unsigned int incoming = 0;
+    _client_connection->incoming_count(incoming);
+    pressure.incoming = incoming;
+    pressure.incoming_capacity = _client_connection->incoming_capacity();
+    for (size_t i = 0; i < priority_count; ++i) {
+        const auto priority = static_cast<Priority>(i);
+        pressure.outgoing[i] = _client_connection->outgoing_count(priority);
+    }
+    pressure.outgoing_capacity = _client_connection->outgoing_capacity();
+    pressure.is_reading_paused = _client_connection->is_reading_paused();
+    return ONE_ERROR_NONE;
+}
+
+OneError Server::memory_footprint(MemoryFootprint &footprint) const {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (!is_initialized()) {
+        return ONE_ERROR_SERVER_SOCKET_NOT_INITIALIZED;
+    }
+
+    footprint = MemoryFootprint();
+    footprint.instance = sizeof(Server);
+    if (_listen_socket != nullptr) {
+        footprint.instance += sizeof(Socket) + sizeof(Backoff);
+    }
+    if (_client_socket != nullptr) {
+        footprint.instance += sizeof(Socket);
+    }
+    if (_async_logger != nullptr) {
+        footprint.instance += sizeof(AsyncLogger);
+    }
+    if (_capture != nullptr) {
+        footprint.instance += sizeof(CaptureWriter);
+    }
+    if (_io_uring != nullptr) {
+        footprint.instance += sizeof(IoUringTransport);
+        footprint.streams += _io_uring->footprint();
+    }
+    if (_client_connection != nullptr) {
+        _client_connection->footprint(footprint);
     }
 
-    _game_state.players = players;
-    _game_state.max_players = max_players;
-    _game_state.name = name;
-    _game_state.map = map;
-    _game_state.mode = mode;
-    _game_state.version = version;
-    _game_state.additional_data = _additional_data;
-    _game_state_was_set = true;
+    if (_additional_data != nullptr) {
+        footprint.state += sizeof(Object) + Payload::footprint(_additional_data->get());
+    }
+    footprint.state += string_footprint(_game_state.name.long_value) +
+                       string_footprint(_game_state.map.long_value) +
+                       string_footprint(_game_state.mode.long_value) +
+                       string_footprint(_game_state.version.long_value);
+    if (_live_state_params != nullptr) {
+        footprint.state += sizeof(params::LiveStateResponse) +
+                           string_footprint(_live_state_params->_name) +
+                           string_footprint(_live_state_params->_map) +
+                           string_footprint(_live_state_params->_mode) +
+                           string_footprint(_live_state_params->_version);
+    }
+    if (_last_sent_live_state != nullptr) {
+        footprint.state += sizeof(Message) + _last_sent_live_state->footprint();
+    }
 
+    footprint.json_cache = json::cached_size();
     return ONE_ERROR_NONE;
 }
 
+IoBackend Server::io_backend() const {
+    const std::lock_guard<std::mutex> lock(_server);
+    return _io_uring != nullptr ? IoBackend::io_uring : IoBackend::select;
+}
+
+bool Server::is_shared_memory() const {
+    const std::lock_guard<std::mutex> lock(_server);
+    return _client_connection != nullptr && _client_connection->is_shared_memory();
+}
+
+void Server::set_live_state_delta(bool enabled) {
+    const std::lock_guard<std::mutex> lock(_server);
+    _is_live_state_delta_enabled = enabled;
+}
+
+OneError Server::set_outgoing_policy(Opcode code, Priority priority,
+                                     bool replace_in_queue) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (_client_connection == nullptr) {
+        return ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR;
+    }
+
+    return _client_connection->set_outgoing_policy(code, priority, replace_in_queue);
+}
+
 OneError Server::set_application_instance_status(ApplicationInstanceStatus status) {
     const std::lock_guard<std::mutex> lock(_server);
 
@@ -575,11 +1172,11 @@ OneError Server::set_application_instance_status(ApplicationInstanceStatus statu
     return ONE_ERROR_NONE;
 }
 
-OneError Server::set_soft_stop_callback(std::function<void(void *, int)> callback,
+OneError Server::set_soft_stop_callback(Callback<void(void *, int)> callback,
                                         void *data) {
     const std::lock_guard<std::mutex> lock(_server);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -588,6 +1185,40 @@ OneError Server::set_soft_stop_callback(std::function<void(void *, int)> callbac
     return ONE_ERROR_NONE;
 }
 
+OneError Server::send_pending_states(bool force) {
+    const auto now = steady_clock::now();
+    const milliseconds interval(_min_send_interval_ms);
+
+    if (_dirty_live_state_fields != 0 &&
+        (force || now - _last_live_state_send_time >= interval)) {
+        auto err = send_live_state();
+        // A full queue is not fatal, the state stays pending and is sent by a
+        // later update.
+        if (err == ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE) {
+            return ONE_ERROR_NONE;
+        }
+        if (is_error(err)) {
+            return err;
+        }
+        _dirty_live_state_fields = 0;
+        _last_live_state_send_time = now;
+    }
+
+    if (_should_send_status && (force || now - _last_status_send_time >= interval)) {
+        auto err = send_application_instance_status();
+        if (err == ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE) {
+            return ONE_ERROR_NONE;
+        }
+        if (is_error(err)) {
+            return err;
+        }
+        _should_send_status = false;
+        _last_status_send_time = now;
+    }
+
+    return ONE_ERROR_NONE;
+}
+
 OneError Server::send_live_state() {
     Message message;
     auto err = messages::prepare_live_state(
@@ -599,6 +1230,10 @@ OneError Server::send_live_state() {
         return err;
     }
 
+    if (_is_live_state_delta_negotiated) {
+        return send_live_state_delta(message);
+    }
+
     err = process_outgoing_message(message);
     if (is_error(err)) {
         return err;
@@ -607,6 +1242,41 @@ OneError Server::send_live_state() {
     return ONE_ERROR_NONE;
 }
 
+OneError Server::send_live_state_delta(const Message &live_state) {
+    if (_last_sent_live_state == nullptr) {
+        _last_sent_live_state = allocator::create<Message>();
+        if (_last_sent_live_state == nullptr) {
+            return ONE_ERROR_SERVER_OBJECT_ALLOCATION_FAILED;
+        }
+    }
+
+    if (!_has_sent_live_state) {
+        auto err = process_outgoing_message(live_state);
+        if (is_error(err)) {
+            return err;
+        }
+    } else {
+        Message delta;
+        bool is_empty = false;
+        auto err = messages::prepare_live_state_delta(
+            _last_sent_live_state->payload(), live_state.payload(), delta, is_empty);
+        if (is_error(err)) {
+            return err;
+        }
+
+        if (!is_empty) {
+            err = process_outgoing_message(delta);
+            if (is_error(err)) {
+                return err;
+            }
+        }
+    }
+
+    *_last_sent_live_state = live_state;
+    _has_sent_live_state = true;
+    return ONE_ERROR_NONE;
+}
+
 OneError Server::send_reverse_metadata(Array *data) {
     if (data == nullptr) {
         return ONE_ERROR_VALIDATION_DATA_IS_NULLPTR;
@@ -642,11 +1312,11 @@ OneError Server::send_application_instance_status() {
     return ONE_ERROR_NONE;
 }
 
-OneError Server::set_allocated_callback(std::function<void(void *, Array *)> callback,
+OneError Server::set_allocated_callback(Callback<void(void *, Array *)> callback,
                                         void *data) {
     const std::lock_guard<std::mutex> lock(_server);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -655,11 +1325,11 @@ OneError Server::set_allocated_callback(std::function<void(void *, Array *)> cal
     return ONE_ERROR_NONE;
 }
 
-OneError Server::set_metadata_callback(std::function<void(void *, Array *)> callback,
+OneError Server::set_metadata_callback(Callback<void(void *, Array *)> callback,
                                        void *data) {
     const std::lock_guard<std::mutex> lock(_server);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -669,10 +1339,10 @@ OneError Server::set_metadata_callback(std::function<void(void *, Array *)> call
 }
 
 OneError Server::set_host_information_callback(
-    std::function<void(void *, Object *)> callback, void *data) {
+    Callback<void(void *, Object *)> callback, void *data) {
     const std::lock_guard<std::mutex> lock(_server);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -682,10 +1352,10 @@ OneError Server::set_host_information_callback(
 }
 
 OneError Server::set_application_instance_information_callback(
-    std::function<void(void *, Object *)> callback, void *data) {
+    Callback<void(void *, Object *)> callback, void *data) {
     const std::lock_guard<std::mutex> lock(_server);
 
-    if (callback == nullptr) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -695,8 +1365,8 @@ OneError Server::set_application_instance_information_callback(
 }
 
 OneError Server::set_custom_command_callback(
-    std::function<void(void *, Array *)> callback, void *data) {
-    if (callback == nullptr) {
+    Callback<void(void *, Array *)> callback, void *data) {
+    if (!callback) {
         return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
     }
 
@@ -705,5 +1375,17 @@ OneError Server::set_custom_command_callback(
     return ONE_ERROR_NONE;
 }
 
+OneError Server::set_writable_callback(Callback<void(void *)> callback, void *data) {
+    const std::lock_guard<std::mutex> lock(_server);
+
+    if (!callback) {
+        return ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR;
+    }
+
+    _callbacks._writable = callback;
+    _callbacks._writable_userdata = data;
+    return ONE_ERROR_NONE;
+}
+
 }  // namespace one
 }  // namespace i3d
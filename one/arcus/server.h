@@ -1,11 +1,13 @@
 #pragma once
 
 #include <chrono>
-#include <functional>
 #include <mutex>
 
+#include <one/arcus/callback.h>
 #include <one/arcus/error.h>
 #include <one/arcus/logger.h>
+#include <one/arcus/opcode.h>
+#include <one/arcus/options.h>
 #include <one/arcus/types.h>
 
 using namespace std::chrono;
@@ -13,30 +15,39 @@ using namespace std::chrono;
 namespace i3d {
 namespace one {
 
-namespace server {
-// Exposed for testing.
-void set_listen_retry_delay(size_t seconds);
-}  // namespace server
-
 class Array;
-class Connection;
+class AsyncLogger;
+class Backoff;
+class CaptureWriter;
+struct DefaultConnectionPolicy;
+template <class Policy>
+class BasicConnection;
+using Connection = BasicConnection<DefaultConnectionPolicy>;
+class IoUringTransport;
 class Message;
 class Object;
 class Socket;
+class Transport;
+
+namespace params {
+struct LiveStateResponse;
+}
 
 struct ServerCallbacks {
-    std::function<void(void *, int)> _soft_stop;
+    Callback<void(void *, int)> _soft_stop;
     void *_soft_stop_userdata;
-    std::function<void(void *, Array *)> _allocated;
+    Callback<void(void *, Array *)> _allocated;
     void *_allocated_userdata;
-    std::function<void(void *, Array *)> _metadata;
+    Callback<void(void *, Array *)> _metadata;
     void *_metadata_userdata;
-    std::function<void(void *, Object *)> _host_information;
+    Callback<void(void *, Object *)> _host_information;
     void *_host_information_data;
-    std::function<void(void *, Object *)> _application_instance_information;
+    Callback<void(void *, Object *)> _application_instance_information;
     void *_application_instance_information_data;
-    std::function<void(void *, Array *)> _custom_command;
+    Callback<void(void *, Array *)> _custom_command;
     void *_custom_command_userdata;
+    Callback<void(void *)> _writable;
+    void *_writable_userdata;
 };
 
 // An Arcus Server is designed for use by a Game. It allows an Arcus One Agent
@@ -49,8 +60,54 @@ public:
     ~Server();
 
     void set_logger(const Logger &);
-    OneError init(unsigned int listen_port);
 
+    // Messages below the given level are discarded before being formatted.
+    // Default is LogLevel::Info.
+    void set_log_level(LogLevel level);
+
+    // When enabled, log calls only copy the message into a bounded ring and a
+    // background thread calls the logger. Messages are truncated to
+    // AsyncLogger::max_record_length and dropped if the ring is full. Disabling
+    // forwards all pending messages before returning.
+    OneError set_async_logging(bool enabled);
+
+    // Message payloads logged at the info level are truncated to this length.
+    static constexpr size_t log_payload_max_length = 256;
+
+    // The options size the queues and stream buffers of the client
+    // connection and tune its socket, ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID
+    // is returned if they are not valid.
+    OneError init(unsigned int listen_port,
+                  const ConnectionOptions &options = ConnectionOptions());
+
+    // Same as init, listening on a Unix domain socket at path instead of a TCP
+    // port, for an agent on the same host. The framing and handshake are the
+    // same. A socket file left at path is replaced unless a server is still
+    // listening on it, and the file is removed on shutdown. Returns
+    // ONE_ERROR_SOCKET_PATH_TOO_LONG if the path does not fit in
+    // Socket::local_path_size and ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED on
+    // Windows.
+    OneError init_local(const char *path,
+                        const ConnectionOptions &options = ConnectionOptions());
+
+    // Same as init, over a transport already connected to the agent instead
+    // of a listening socket, e.g. one end of a LoopbackPipe. The handshake
+    // starts on the next update. The transport is not owned and must outlive
+    // the server or its shutdown. It is not reconnected: once the connection
+    // fails, the status is error until shutdown. Returns
+    // ONE_ERROR_TRANSPORT_NOT_INITIALIZED if the transport is not initialized.
+    OneError init_transport(Transport &transport,
+                            const ConnectionOptions &options = ConnectionOptions());
+
+    // Records every Arcus frame exchanged with the agent into a capture file
+    // at path. The file is rotated once it exceeds max_file_size bytes, keeping
+    // at most max_files files. Capturing stays enabled across reconnections and
+    // shutdown until disabled.
+    OneError enable_capture(const char *path, size_t max_file_size, size_t max_files);
+    // Flushes and closes the capture file, if any.
+    void disable_capture();
+
+    // Also releases the JSON blocks cached for reuse by the calling thread.
     OneError shutdown();
 
     // Note these MUST be kept in sync with the values in c_api.cpp, or
@@ -81,10 +138,72 @@ public:
     //------------------------------------------------------------------------------
     // Property setters.
 
+    // Sets all live state fields at once, see the per-field setters below.
+    // Nothing is changed if any field is invalid. Unlike the per-field
+    // setters, strings may be longer than max_live_state_string_length, those
+    // being kept on the heap.
     OneError set_live_state(int players, int max_players, const char *name,
                             const char *map, const char *mode, const char *version,
                             Object *additional_data);
 
+    // Per-field live state setters. A field is only marked as changed if its
+    // value differs, and the live state is then sent by a later update. The
+    // strings are copied into fixed buffers and must not be longer than
+    // max_live_state_string_length, or ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG
+    // is returned.
+    static constexpr size_t max_live_state_string_length = 255;
+    OneError set_players(int players);
+    OneError set_max_players(int max_players);
+    OneError set_name(const char *name);
+    OneError set_map(const char *map);
+    OneError set_mode(const char *mode);
+    OneError set_version(const char *version);
+    // Copies the additional data, or removes it if nullptr.
+    OneError set_additional_data(Object *additional_data);
+
+    // When enabled, and once a connected client has offered it, live states
+    // are sent as deltas holding only the fields and additional data keys that
+    // changed since the previous one, after an initial full live state. The
+    // client merges them back into the full state. Takes effect for the next
+    // connection. Disabled by default.
+    void set_live_state_delta(bool enabled);
+
+    // Sets the priority class of outgoing messages with the opcode, and whether
+    // a queued one is replaced by a newer one instead of being queued after it.
+    // See default_priority and default_replace_in_queue for the defaults. Must
+    // be called after init, and is kept across connections until shutdown.
+    OneError set_outgoing_policy(Opcode code, Priority priority, bool replace_in_queue);
+
+    // Live states and application instance statuses are each sent at most
+    // once per interval. Changes made in between are coalesced and only the
+    // latest one is sent once the interval has passed. Zero, the default,
+    // sends changes on the next update.
+    void set_min_send_interval(size_t milliseconds);
+
+    // Sends the pending live state and application instance status now,
+    // regardless of the minimum send interval, e.g. for critical transitions.
+    // They are written to the client during the next update. Nothing is sent
+    // while no client connection is ready.
+    OneError flush();
+
+    // Reports the fill levels of the message queues of the client connection.
+    // Must be called after init.
+    OneError queue_pressure(QueuePressure &pressure) const;
+
+    // Reports the memory held by the server, see MemoryFootprint. Queue slots,
+    // the additional data copy and other buffers are only allocated once
+    // used. Use ConnectionOptions::small_footprint at init to minimize it.
+    // Must be called after init.
+    OneError memory_footprint(MemoryFootprint &footprint) const;
+
+    // The backend reading and writing the client socket. IoBackend::select
+    // until init, or if io_uring was requested but is unavailable.
+    IoBackend io_backend() const;
+
+    // Whether messages go through shared memory with the connected client
+    // instead of the socket. See ConnectionOptions::shared_memory_capacity.
+    bool is_shared_memory() const;
+
     OneError send_reverse_metadata(Array *data);
 
     // Must match api standards.
@@ -98,28 +217,28 @@ public:
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_soft_stop_callback(std::function<void(void *, int)> callback,
+    OneError set_soft_stop_callback(Callback<void(void *, int)> callback,
                                     void *data);
 
     // set the callback for when a allocated message in received.
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_allocated_callback(std::function<void(void *, Array *)> callback,
+    OneError set_allocated_callback(Callback<void(void *, Array *)> callback,
                                     void *data);
 
     // set the callback for when a metadata message in received.
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_metadata_callback(std::function<void(void *, Array *)> callback,
+    OneError set_metadata_callback(Callback<void(void *, Array *)> callback,
                                    void *data);
 
     // set the callback for when a host_information message in received.
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_host_information_callback(std::function<void(void *, Object *)> callback,
+    OneError set_host_information_callback(Callback<void(void *, Object *)> callback,
                                            void *data);
 
     // set the callback for when a application_instance_information message in
@@ -127,70 +246,158 @@ public:
     // argument of the callback when invoked. The `data` can be nullptr, the callback is
     // responsible to use the data properly.
     OneError set_application_instance_information_callback(
-        std::function<void(void *, Object *)> callback, void *data);
+        Callback<void(void *, Object *)> callback, void *data);
 
     // set the callback for when a custom command message in received.
     // The `void *data` is the user provided and will be passed as the first argument
     // of the callback when invoked.
     // The `data` can be nullptr, the callback is responsible to use the data properly.
-    OneError set_custom_command_callback(std::function<void(void *, Array *)> callback,
+    OneError set_custom_command_callback(Callback<void(void *, Array *)> callback,
                                          void *data);
 
+    // set the callback for when outgoing messages can be sent again. Sends
+    // fail with ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE while
+    // the queue of their priority class is full, and the callback is invoked
+    // once during update after the queue has drained to half of its capacity.
+    // The `data` can be nullptr, the callback is responsible to use the data properly.
+    OneError set_writable_callback(Callback<void(void *)> callback, void *data);
+
 private:
-    struct GameState {
-        GameState() : players(0), max_players(0), name(), map(), mode(), version() {}
+    // A live state string in a fixed buffer, or on the heap if longer, as
+    // only accepted by set_live_state.
+    struct LiveStateString {
+        LiveStateString() : value(), long_value() {}
 
-        int players;      // Game number of players.
-        int max_players;  // Game max number of players.
-        String name;      // Server name.
-        String map;       // Game map.
-        String mode;      // Game mode.
-        String version;   // Game version.
+        const char *c_str() const {
+            return long_value.empty() ? value : long_value.c_str();
+        }
+
+        char value[max_live_state_string_length + 1];
+        String long_value;  // Empty unless the string does not fit in value.
+    };
+
+    struct GameState {
+        GameState()
+            : players(0)
+            , max_players(0)
+            , name()
+            , map()
+            , mode()
+            , version()
+            , additional_data(nullptr) {}
+
+        int players;              // Game number of players.
+        int max_players;          // Game max number of players.
+        LiveStateString name;     // Server name.
+        LiveStateString map;      // Game map.
+        LiveStateString mode;     // Game mode.
+        LiveStateString version;  // Game version.
 
         Object *additional_data;  // Optional extra fields.
     };
-    static bool game_states_changed(Server::GameState &new_state,
-                                    Server::GameState &old_state);
+
+    // Bits of the live state fields changed since the live state was last
+    // sent.
+    enum LiveStateField : unsigned int {
+        players_field = 1 << 0,
+        max_players_field = 1 << 1,
+        name_field = 1 << 2,
+        map_field = 1 << 3,
+        mode_field = 1 << 4,
+        version_field = 1 << 5,
+        additional_data_field = 1 << 6,
+        all_live_state_fields = (1 << 7) - 1
+    };
+
+    // Unlocked versions of the per-field setters.
+    void store_int(int &field, int val, LiveStateField bit);
+    void store_string(LiveStateString &field, const char *val, LiveStateField bit);
+    void store_additional_data(Object *additional_data);
+    // Creates the owned additional data copy, if not yet done.
+    OneError create_additional_data();
 
     bool is_initialized() const;
+    // Whether a client socket was accepted, or the transport given to
+    // init_transport has not failed.
+    bool is_client_connected() const;
+    // Creates the sockets and connection, after the endpoint is set.
+    OneError init_endpoint(const ConnectionOptions &options);
+    // Shutdown, with the server mutex held.
+    OneError shutdown_locked();
     OneError listen();
     OneError update_client_connection();
     OneError update_listen_socket();
     void close_client_connection();
 
+    // Logs the message opcode and a truncated dump of its payload, if info
+    // logs are enabled.
+    void log_message(const char *direction, const Message &message) const;
+
     OneError process_incoming_message(const Message &message);
+    // Called with the server mutex held, unlike other incoming messages.
+    OneError process_features(const Message &message);
     // The server must have an active and ready listen connection in order to
     // send outgoing messages. If not, either ONE_ERROR_SERVER_CONNECTION_IS_NULLPTR or
     // ONE_ERROR_SERVER_CONNECTION_NOT_READY is returned and the message is
     // not sent.
     OneError process_outgoing_message(const Message &message);
 
+    // Sends the live state and the application instance status if they
+    // changed and, unless forced, the minimum send interval has passed since
+    // they were last sent.
+    OneError send_pending_states(bool force);
     OneError send_live_state();
+    // Sends the difference from the last live state sent, or the full live
+    // state if none was sent since the delta was negotiated.
+    OneError send_live_state_delta(const Message &live_state);
     OneError send_application_instance_status();
 
     mutable std::mutex _server;
 
-    Logger _logger;
+    Logger _logger;       // Logger used by the server, may be the async front.
+    Logger _sink_logger;  // Logger set by the integration.
+    AsyncLogger *_async_logger;
 
     unsigned int _listen_port;
+    String _listen_path;  // Unix domain socket path, empty when using TCP.
     bool _is_listening;
     Socket *_listen_socket;
     Socket *_client_socket;
+    SocketOptions _socket_options;  // Applied to the listen and client sockets.
+    SocketOptions _kernel_socket_options;  // Once kernel liveness is agreed.
     Connection *_client_connection;
+    IoUringTransport *_io_uring;  // Null unless the io_uring backend is used.
+    Transport *_transport;        // Set by init_transport, instead of the sockets.
+    bool _is_transport_open;
+    CaptureWriter *_capture;
 
     bool _is_waiting_for_client;
 
     GameState _game_state;
-    GameState _last_sent_game_state;
-    bool _game_state_was_set;
+    unsigned int _dirty_live_state_fields;
+    bool _has_live_state;  // Whether any field was set.
 
     ApplicationInstanceStatus _status;
     bool _should_send_status;
 
+    size_t _min_send_interval_ms;
+    steady_clock::time_point _last_live_state_send_time;
+    steady_clock::time_point _last_status_send_time;
+
     ServerCallbacks _callbacks;
-    steady_clock::time_point _last_listen_attempt_time;
+    Backoff *_listen_backoff;  // Delays binding again after a failure.
 
     Object *_additional_data;
+    // Reused to validate outgoing live states, so that its strings keep their
+    // capacity across updates.
+    params::LiveStateResponse *_live_state_params;
+
+    bool _is_live_state_delta_enabled;
+    bool _is_live_state_delta_negotiated;
+    // Last live state sent since the delta was negotiated, created on first
+    // use.
+    Message *_last_sent_live_state;
+    bool _has_sent_live_state;
 };
 
 }  // namespace one
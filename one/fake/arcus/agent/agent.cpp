@@ -25,8 +25,20 @@ OneError Agent::init(const char *addr, unsigned int port) {
     if (is_error(err)) {
         return err;
     }
+    return set_callbacks();
+}
+
+OneError Agent::init(Transport &transport) {
+    const std::lock_guard<std::mutex> lock(_agent);
+    auto err = _client.init_transport(transport);
+    if (is_error(err)) {
+        return err;
+    }
+    return set_callbacks();
+}
 
-    err = _client.set_live_state_callback(
+OneError Agent::set_callbacks() {
+    auto err = _client.set_live_state_callback(
         [this](void *, int players, int max_players, const String &name,
                const String &map, const String &mode, const String &version) {
             ++_live_state_receive_count;
@@ -23,6 +23,9 @@ public:
     // Init with a target remote address. The agent attempts to connect during
     // update.
     OneError init(const char *ip, unsigned int port);
+    // Init over a transport already connected to the server, see
+    // Client::init_transport.
+    OneError init(Transport &transport);
 
     void set_quiet(bool quiet) {
         _quiet = quiet;
@@ -88,6 +91,9 @@ public:
     }
 
 private:
+    // Sets the client callbacks, once it is initialized.
+    OneError set_callbacks();
+
     OneError send_host_information();
     OneError send_application_instance_information();
 
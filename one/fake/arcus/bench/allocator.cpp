@@ -0,0 +1,88 @@
+#include <one/fake/arcus/bench/bench.h>
+
+#include <cstdio>
+#include <vector>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/internal/pool.h>
+#include <one/arcus/message.h>
+#include <one/arcus/types.h>
+
+namespace i3d {
+namespace one {
+namespace bench {
+
+namespace {
+
+// Allocates and frees small blocks of mixed sizes, keeping a window of them
+// alive so that frees do not always hit the most recent allocation.
+void raw_churn(size_t iterations) {
+    constexpr size_t window = 64;
+    void *live[window] = {};
+    for (size_t i = 0; i < iterations; ++i) {
+        const size_t slot = i % window;
+        allocator::free(live[slot]);
+        live[slot] = allocator::alloc(16 + (i * 37) % 496);
+    }
+    for (auto p : live) {
+        allocator::free(p);
+    }
+}
+
+// Builds a string one character at a time, growing it through the standard
+// allocator, as when formatting log lines.
+void string_building(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+        String text;
+        for (size_t j = 0; j < 100; ++j) {
+            text += static_cast<char>('a' + j % 26);
+        }
+        if (text.empty()) {
+            std::printf("unexpected empty string\n");
+        }
+    }
+}
+
+// Builds a live state like message, copies it as when queued and serializes
+// it as when sent.
+void message_churn(size_t iterations) {
+    char buffer[512];
+    for (size_t i = 0; i < iterations; ++i) {
+        Message message;
+        Payload payload;
+        payload.set_val_int("players", static_cast<int>(i % 64));
+        payload.set_val_int("maxPlayers", 64);
+        payload.set_val_string("name", "a server name that is not short");
+        payload.set_val_string("map", "a map name");
+        payload.set_val_string("mode", "a mode name");
+        payload.set_val_string("version", "1.0.0");
+        message.init(Opcode::live_state, payload);
+
+        Message copy(message);
+        bool truncated = false;
+        copy.payload().to_json(buffer, sizeof(buffer), truncated);
+    }
+}
+
+}  // namespace
+
+int run_allocator(const Options &options) {
+    std::printf("allocator: %s, %zu thread(s), %zu iterations\n",
+                options.use_pool ? "pool" : "default", options.threads,
+                options.iterations);
+
+    report("raw alloc/free", measure(options, raw_churn));
+    report("string building (100 chars)", measure(options, string_building));
+    report("message churn (live state)", measure(options, message_churn));
+
+    if (options.use_pool) {
+        pool::Statistics statistics;
+        pool::statistics(statistics);
+        std::printf("pool slabs: %zu KiB\n", statistics.slab_bytes / 1024);
+    }
+    return 0;
+}
+
+}  // namespace bench
+}  // namespace one
+}  // namespace i3d
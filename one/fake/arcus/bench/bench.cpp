@@ -0,0 +1,51 @@
+#include <one/fake/arcus/bench/bench.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace i3d {
+namespace one {
+namespace bench {
+
+double measure(const Options &options, const std::function<void(size_t)> &workload) {
+    using clock = std::chrono::steady_clock;
+
+    const size_t threads = options.threads == 0 ? 1 : options.threads;
+    std::vector<double> durations(threads, 0.0);
+
+    auto run = [&](size_t index) {
+        const auto start = clock::now();
+        workload(options.iterations);
+        const auto end = clock::now();
+        durations[index] = std::chrono::duration<double, std::nano>(end - start).count();
+    };
+
+    if (threads == 1) {
+        run(0);
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(run, i);
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    double total = 0.0;
+    for (auto duration : durations) {
+        total += duration;
+    }
+    const size_t iterations = options.iterations == 0 ? 1 : options.iterations;
+    return total / static_cast<double>(threads) / static_cast<double>(iterations);
+}
+
+void report(const char *name, double ns_per_iteration) {
+    std::printf("%-32s %12.1f ns/op\n", name, ns_per_iteration);
+}
+
+}  // namespace bench
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+
+namespace i3d {
+namespace one {
+namespace bench {
+
+struct Options {
+    size_t iterations = 1000000;
+    // Each workload runs concurrently on this many threads.
+    size_t threads = 1;
+    // Selects the built-in pool allocator before anything is allocated.
+    bool use_pool = false;
+};
+
+// Runs the workload for the given number of iterations on each thread and
+// returns the average time per iteration, in nanoseconds.
+double measure(const Options &options, const std::function<void(size_t)> &workload);
+
+// Prints a result line.
+void report(const char *name, double ns_per_iteration);
+
+// Suites. Return zero on success.
+int run_allocator(const Options &options);
+int run_callbacks(const Options &options);
+int run_transport(const Options &options);
+
+}  // namespace bench
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,111 @@
+#include <one/fake/arcus/bench/bench.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/callback.h>
+
+namespace i3d {
+namespace one {
+namespace bench {
+
+namespace {
+
+// Read and written through volatile so that calls cannot be optimized away.
+volatile int _sink = 0;
+
+void on_int(void *, int value) {
+    _sink = value;
+}
+
+void *malloc_wrapper(size_t size) {
+    return std::malloc(size);
+}
+
+void free_wrapper(void *p) {
+    std::free(p);
+}
+
+// The callables are loaded from volatile pointers so that the compiler cannot
+// see through them and inline the calls.
+void (*volatile _on_int)(void *, int) = on_int;
+void *(*volatile _malloc_wrapper)(size_t) = malloc_wrapper;
+void (*volatile _free_wrapper)(void *) = free_wrapper;
+
+// Message callback storage before: a std::function holding a plain function.
+void std_function_call(size_t iterations) {
+    const std::function<void(void *, int)> callback = _on_int;
+    for (size_t i = 0; i < iterations; ++i) {
+        callback(nullptr, static_cast<int>(i));
+    }
+}
+
+// Message callback storage after, set from a plain function.
+void callback_function_call(size_t iterations) {
+    const Callback<void(void *, int)> callback = _on_int;
+    for (size_t i = 0; i < iterations; ++i) {
+        callback(nullptr, static_cast<int>(i));
+    }
+}
+
+// Message callback storage after, set from a capturing lambda.
+void callback_wrapped_call(size_t iterations) {
+    int offset = _sink;
+    const Callback<void(void *, int)> callback = [offset](void *, int value) {
+        _sink = value + offset;
+    };
+    for (size_t i = 0; i < iterations; ++i) {
+        callback(nullptr, static_cast<int>(i));
+    }
+}
+
+// Allocator overrides before: malloc and free called through std::function.
+void std_function_alloc(size_t iterations) {
+    const std::function<void *(size_t)> alloc = _malloc_wrapper;
+    const std::function<void(void *)> free = _free_wrapper;
+    for (size_t i = 0; i < iterations; ++i) {
+        free(alloc(32));
+    }
+}
+
+// Allocator overrides after: through allocator::alloc and allocator::free.
+void allocator_alloc(size_t iterations) {
+    allocator::set_alloc(_malloc_wrapper);
+    allocator::set_free(_free_wrapper);
+    for (size_t i = 0; i < iterations; ++i) {
+        allocator::free(allocator::alloc(32));
+    }
+    allocator::reset_overrides();
+}
+
+// Baseline: malloc and free called directly.
+void direct_alloc(size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+        _free_wrapper(_malloc_wrapper(32));
+    }
+}
+
+}  // namespace
+
+int run_callbacks(const Options &options) {
+    std::printf("callbacks: %zu thread(s), %zu iterations\n", options.threads,
+                options.iterations);
+
+    report("std::function call", measure(options, std_function_call));
+    report("Callback call (function)", measure(options, callback_function_call));
+    report("Callback call (std::function)", measure(options, callback_wrapped_call));
+
+    // Replacing the allocator is not thread safe.
+    Options single = options;
+    single.threads = 1;
+    report("malloc/free direct", measure(single, direct_alloc));
+    report("malloc/free std::function", measure(single, std_function_alloc));
+    report("malloc/free allocator", measure(single, allocator_alloc));
+    return 0;
+}
+
+}  // namespace bench
+}  // namespace one
+}  // namespace i3d
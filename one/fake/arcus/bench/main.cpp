@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <one/arcus/allocator.h>
+#include <one/fake/arcus/bench/bench.h>
+
+using namespace i3d::one;
+
+namespace {
+
+struct Suite {
+    const char *name;
+    int (*run)(const bench::Options &options);
+};
+
+const Suite suites[] = {
+    {"allocator", bench::run_allocator},
+    {"callbacks", bench::run_callbacks},
+    {"transport", bench::run_transport},
+};
+
+void print_usage() {
+    std::printf("usage: bench [--iterations <n>] [--threads <n>] [--pool] <suite>...\n");
+    std::printf("suites:");
+    for (const auto &suite : suites) {
+        std::printf(" %s", suite.name);
+    }
+    std::printf("\n");
+}
+
+bool parse_size(const char *text, size_t &value) {
+    char *end = nullptr;
+    const unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || parsed == 0) {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+const Suite *find_suite(const char *name) {
+    for (const auto &suite : suites) {
+        if (std::strcmp(suite.name, name) == 0) {
+            return &suite;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bench::Options options;
+    const Suite *selected[sizeof(suites) / sizeof(suites[0])] = {};
+    size_t selected_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            if (!parse_size(argv[++i], options.iterations)) {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!parse_size(argv[++i], options.threads)) {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--pool") == 0) {
+            options.use_pool = true;
+        } else {
+            const Suite *suite = find_suite(argv[i]);
+            const size_t capacity = sizeof(selected) / sizeof(selected[0]);
+            if (suite == nullptr || selected_count == capacity) {
+                print_usage();
+                return 1;
+            }
+            selected[selected_count++] = suite;
+        }
+    }
+    if (selected_count == 0) {
+        print_usage();
+        return 1;
+    }
+
+    // Must be selected before anything is allocated.
+    if (options.use_pool) {
+        allocator::use_pool();
+    }
+
+    for (size_t i = 0; i < selected_count; ++i) {
+        const int result = selected[i]->run(options);
+        if (result != 0) {
+            return result;
+        }
+    }
+    return 0;
+}
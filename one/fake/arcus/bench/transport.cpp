@@ -0,0 +1,311 @@
+#include <one/fake/arcus/bench/bench.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/io_uring.h>
+#include <one/arcus/internal/loopback.h>
+#include <one/arcus/internal/messages.h>
+#include <one/arcus/internal/socket.h>
+#include <one/arcus/message.h>
+
+namespace i3d {
+namespace one {
+namespace bench {
+
+namespace {
+
+const char *local_path = "bench_transport.sock";
+
+// Attempts to reach a connected or ready state, a millisecond apart, before
+// giving up.
+constexpr int max_attempts = 1000;
+
+// A listener with an accepted server side socket and the client socket
+// connected to it, each wrapped in an Arcus connection.
+struct Endpoints {
+    Endpoints() : server_connection(4, 4), client_connection(4, 4) {}
+
+    Socket listener;
+    Socket server;
+    Socket client;
+    Connection server_connection;
+    Connection client_connection;
+};
+
+bool connect(bool is_local, Endpoints &endpoints) {
+    if (is_local) {
+        if (is_error(endpoints.listener.init_local()) ||
+            is_error(endpoints.listener.bind_local(local_path)) ||
+            is_error(endpoints.listener.listen(1)) ||
+            is_error(endpoints.client.init_local()) ||
+            is_error(endpoints.client.connect_local(local_path))) {
+            return false;
+        }
+    } else {
+        String ip;
+        unsigned int port = 0;
+        if (is_error(endpoints.listener.init()) ||
+            is_error(endpoints.listener.bind("127.0.0.1", 0)) ||
+            is_error(endpoints.listener.address(ip, port)) ||
+            is_error(endpoints.listener.listen(1)) ||
+            is_error(endpoints.client.init()) ||
+            is_error(endpoints.client.connect("127.0.0.1", port))) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < max_attempts && !endpoints.server.is_initialized(); ++i) {
+        bool is_ready = false;
+        String ip;
+        unsigned int port = 0;
+        if (is_error(endpoints.listener.ready_for_read(0.01f, is_ready)) ||
+            (is_ready &&
+             is_error(endpoints.listener.accept(endpoints.server, ip, port)))) {
+            return false;
+        }
+    }
+    return endpoints.server.is_initialized();
+}
+
+bool handshake(Connection &server, Connection &client) {
+    server.initiate_handshake();
+    for (int i = 0; i < max_attempts; ++i) {
+        if (is_error(server.update()) || is_error(client.update())) {
+            return false;
+        }
+        if (server.status() == Connection::Status::ready &&
+            client.status() == Connection::Status::ready) {
+            return true;
+        }
+        // The hello may be held back by Nagle's algorithm until the last echo
+        // is acknowledged.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// Sends a byte and waits for it to be echoed back, without Arcus framing.
+void socket_round_trip(Endpoints &endpoints, size_t iterations) {
+    unsigned char data = 0;
+    size_t length = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        endpoints.client.send(&data, 1, length);
+        do {
+            endpoints.server.receive(&data, 1, length);
+        } while (length == 0);
+        endpoints.server.send(&data, 1, length);
+        do {
+            endpoints.client.receive(&data, 1, length);
+        } while (length == 0);
+    }
+}
+
+// Sends the message from one connection to the other, updating both until it
+// is received, and drops it.
+void relay(Connection &from, Connection &to, Message &message) {
+    from.add_outgoing(message);
+    unsigned int count = 0;
+    while (count == 0) {
+        from.update();
+        to.update();
+        to.incoming_count(count);
+    }
+    to.remove_incoming([](const Message &) { return ONE_ERROR_NONE; });
+}
+
+// Sends an Arcus message to the server and the same message back.
+void message_round_trip(Connection &server, Connection &client, size_t iterations) {
+    Message message;
+    messages::prepare_soft_stop(1000, message);
+    for (size_t i = 0; i < iterations; ++i) {
+        relay(client, server, message);
+        relay(server, client, message);
+    }
+}
+
+// Sends two messages in separate writes and waits for both before replying, as
+// when an allocation quickly follows a metadata update. Under Nagle's
+// algorithm the second write waits for the first to be acknowledged, which the
+// server delays as it has nothing to send back yet.
+void burst_round_trip(Connection &server, Connection &client, size_t iterations) {
+    Message message;
+    messages::prepare_soft_stop(1000, message);
+    for (size_t i = 0; i < iterations; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            client.add_outgoing(message);
+            client.update();
+        }
+        unsigned int count = 0;
+        while (count < 2) {
+            client.update();
+            server.update();
+            server.incoming_count(count);
+        }
+        for (int j = 0; j < 2; ++j) {
+            server.remove_incoming([](const Message &) { return ONE_ERROR_NONE; });
+        }
+        relay(server, client, message);
+    }
+}
+
+// Runs the burst round trip over TCP with Nagle's algorithm, then with
+// TCP_NODELAY.
+int run_nagle(const Options &options) {
+    // Stalls last tens of milliseconds, few iterations are enough.
+    Options bursts = options;
+    bursts.iterations = std::min<size_t>(options.iterations, 100);
+
+    for (bool is_no_delay : {false, true}) {
+        SocketOptions socket_options;
+        socket_options.is_no_delay = is_no_delay;
+
+        Endpoints endpoints;
+        if (!connect(false, endpoints) ||
+            is_error(endpoints.server.set_options(socket_options)) ||
+            is_error(endpoints.client.set_options(socket_options))) {
+            std::printf("tcp: failed to connect\n");
+            return 1;
+        }
+        endpoints.server_connection.init(endpoints.server);
+        endpoints.client_connection.init(endpoints.client);
+        if (!handshake(endpoints.server_connection, endpoints.client_connection)) {
+            std::printf("tcp: handshake failed\n");
+            return 1;
+        }
+
+        const char *name = is_no_delay ? "tcp burst round trip, no delay"
+                                       : "tcp burst round trip, nagle";
+        report(name, measure(bursts, [&](size_t iterations) {
+                   burst_round_trip(endpoints.server_connection,
+                                    endpoints.client_connection, iterations);
+               }));
+    }
+    return 0;
+}
+
+int run_endpoints(const Options &options, bool is_local) {
+    const char *transport = is_local ? "uds" : "tcp";
+    char name[64];
+
+    Endpoints endpoints;
+    if (!connect(is_local, endpoints)) {
+        std::printf("%s: failed to connect\n", transport);
+        return 1;
+    }
+
+    std::snprintf(name, sizeof(name), "%s socket round trip", transport);
+    report(name, measure(options, [&](size_t iterations) {
+               socket_round_trip(endpoints, iterations);
+           }));
+
+    endpoints.server_connection.init(endpoints.server);
+    endpoints.client_connection.init(endpoints.client);
+    if (!handshake(endpoints.server_connection, endpoints.client_connection)) {
+        std::printf("%s: handshake failed\n", transport);
+        return 1;
+    }
+
+    std::snprintf(name, sizeof(name), "%s message round trip", transport);
+    report(name, measure(options, [&](size_t iterations) {
+               message_round_trip(endpoints.server_connection,
+                                  endpoints.client_connection, iterations);
+           }));
+    return 0;
+}
+
+// Runs the TCP message round trip with both sockets read and written through
+// io_uring, where available.
+int run_io_uring(const Options &options) {
+    if (!IoUringTransport::is_supported()) {
+        std::printf("tcp: io_uring is unavailable\n");
+        return 0;
+    }
+
+    Endpoints endpoints;
+    IoUringTransport server;
+    IoUringTransport client;
+    if (!connect(false, endpoints) || is_error(server.init()) ||
+        is_error(client.init()) || is_error(server.attach(endpoints.server)) ||
+        is_error(client.attach(endpoints.client))) {
+        std::printf("tcp: failed to connect through io_uring\n");
+        return 1;
+    }
+    endpoints.server_connection.init(server);
+    endpoints.client_connection.init(client);
+    if (!handshake(endpoints.server_connection, endpoints.client_connection)) {
+        std::printf("tcp: handshake failed\n");
+        return 1;
+    }
+
+    report("tcp io_uring message round trip", measure(options, [&](size_t iterations) {
+               message_round_trip(endpoints.server_connection,
+                                  endpoints.client_connection, iterations);
+           }));
+    return 0;
+}
+
+// Runs the message round trip over an in memory pipe, measuring the cost of
+// the SDK alone, then again with every frame split into small writes.
+int run_loopback(const Options &options) {
+    for (size_t max_send_size : {size_t(0), size_t(16)}) {
+        LoopbackOptions pipe_options;
+        pipe_options.max_send_size = max_send_size;
+        LoopbackPipe pipe;
+        Connection server(4, 4);
+        Connection client(4, 4);
+        if (is_error(pipe.init(pipe_options))) {
+            std::printf("loopback: failed to init\n");
+            return 1;
+        }
+        server.init(pipe.first());
+        client.init(pipe.second());
+        if (!handshake(server, client)) {
+            std::printf("loopback: handshake failed\n");
+            return 1;
+        }
+
+        const char *name = max_send_size == 0 ? "loopback message round trip"
+                                              : "loopback 16 byte writes";
+        report(name, measure(options, [&](size_t iterations) {
+                   message_round_trip(server, client, iterations);
+               }));
+    }
+    return 0;
+}
+
+}  // namespace
+
+int run_transport(const Options &options) {
+    // A single connection, updated from one thread.
+    Options single = options;
+    single.threads = 1;
+    std::printf("transport: %zu round trips\n", single.iterations);
+
+    int result = run_loopback(single);
+    if (result != 0) {
+        return result;
+    }
+
+    init_socket_system();
+    result = run_endpoints(single, false);
+    if (result == 0) {
+        result = run_io_uring(single);
+    }
+    if (result == 0) {
+        result = run_nagle(single);
+    }
+    if (result == 0) {
+        result = run_endpoints(single, true);
+    }
+    Socket::remove_local(local_path);
+    shutdown_socket_system();
+    return result;
+}
+
+}  // namespace bench
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <one/arcus/error.h>
+#include <one/arcus/internal/capture.h>
+
+using namespace i3d::one;
+
+namespace {
+
+struct Options {
+    bool filter_direction = false;
+    CaptureDirection direction = CaptureDirection::incoming;
+    std::vector<int> opcodes;
+    bool print_payload = false;
+    bool summary = false;
+    std::vector<const char *> files;
+};
+
+struct Totals {
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+void print_usage() {
+    std::printf(
+        "usage: capture [--direction in|out] [--opcode <code>]... [--payload] "
+        "[--summary] <file>...\n");
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--direction") == 0 && i + 1 < argc) {
+            ++i;
+            options.filter_direction = true;
+            if (std::strcmp(argv[i], "in") == 0) {
+                options.direction = CaptureDirection::incoming;
+            } else if (std::strcmp(argv[i], "out") == 0) {
+                options.direction = CaptureDirection::outgoing;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--opcode") == 0 && i + 1 < argc) {
+            ++i;
+            char *end = nullptr;
+            const long code = std::strtol(argv[i], &end, 0);
+            if (end == argv[i] || *end != '\0' || code < 0 || code > 0xff) {
+                return false;
+            }
+            options.opcodes.push_back(static_cast<int>(code));
+        } else if (std::strcmp(argv[i], "--payload") == 0) {
+            options.print_payload = true;
+        } else if (std::strcmp(argv[i], "--summary") == 0) {
+            options.summary = true;
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else {
+            options.files.push_back(argv[i]);
+        }
+    }
+    return !options.files.empty();
+}
+
+bool matches(const Options &options, const CaptureRecord &record) {
+    if (options.filter_direction && record.direction != options.direction) {
+        return false;
+    }
+    if (options.opcodes.empty()) {
+        return true;
+    }
+    const int opcode = static_cast<unsigned char>(record.opcode);
+    for (auto code : options.opcodes) {
+        if (code == opcode) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *direction_text(CaptureDirection direction) {
+    return (direction == CaptureDirection::incoming) ? "in" : "out";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    // Times are relative to the first record of the first file.
+    bool has_start = false;
+    uint64_t start_ns = 0;
+    std::map<std::pair<int, int>, Totals> totals;
+
+    for (auto path : options.files) {
+        CaptureReader reader;
+        auto err = reader.open(path);
+        if (is_error(err)) {
+            std::fprintf(stderr, "failed to open %s: %s\n", path, error_text(err));
+            return 1;
+        }
+
+        while (true) {
+            CaptureRecord record;
+            bool is_end = false;
+            err = reader.read(record, is_end);
+            if (is_error(err)) {
+                std::fprintf(stderr, "failed to read %s: %s\n", path, error_text(err));
+                return 1;
+            }
+            if (is_end) {
+                break;
+            }
+
+            if (!has_start) {
+                start_ns = record.timestamp_ns;
+                has_start = true;
+            }
+            if (!matches(options, record)) {
+                continue;
+            }
+
+            const int opcode = static_cast<unsigned char>(record.opcode);
+            if (options.summary) {
+                auto &total = totals[std::make_pair(static_cast<int>(record.direction), opcode)];
+                total.count++;
+                total.bytes += record.length;
+                continue;
+            }
+
+            const double ms = static_cast<double>(record.timestamp_ns - start_ns) / 1e6;
+            std::printf("%11.3f %-3s opcode=0x%02x packet_id=%u length=%u", ms,
+                        direction_text(record.direction), opcode, record.packet_id,
+                        record.length);
+            if (options.print_payload && record.length > 0) {
+                std::printf(" %.*s", static_cast<int>(record.length), record.payload);
+            }
+            std::printf("\n");
+        }
+
+        if (reader.is_truncated()) {
+            std::fprintf(stderr, "%s ends with an incomplete record\n", path);
+        }
+    }
+
+    if (options.summary) {
+        std::printf("%-3s %-6s %10s %12s\n", "dir", "opcode", "frames", "bytes");
+        for (auto &entry : totals) {
+            const auto direction = static_cast<CaptureDirection>(entry.first.first);
+            std::printf("%-3s 0x%02x   %10zu %12zu\n", direction_text(direction),
+                        entry.first.second, entry.second.count, entry.second.bytes);
+        }
+    }
+
+    return 0;
+}
@@ -100,6 +100,32 @@ bool Game::init(unsigned int port, int max_players, const std::string &name,
         return false;
     }
 
+    init_state(max_players, name, map, mode, version, delay);
+    return (_one_server.status() == OneServerWrapper::Status::waiting_for_client);
+}
+
+bool Game::init(i3d::one::Transport &transport, int max_players, const std::string &name,
+                const std::string &map, const std::string &mode,
+                const std::string &version, seconds delay) {
+    const std::lock_guard<std::mutex> lock(_game);
+
+    std::srand(std::time(nullptr));
+
+    // The agent is already connected, the handshake starts on the first update.
+    OneServerWrapper::AllocationHooks hooks(allocation::alloc, allocation::free,
+                                            allocation::realloc);
+    if (!_one_server.init(transport, hooks)) {
+        L_ERROR("failed to init one server");
+        return false;
+    }
+
+    init_state(max_players, name, map, mode, version, delay);
+    return (_one_server.status() == OneServerWrapper::Status::handshake);
+}
+
+void Game::init_state(int max_players, const std::string &name, const std::string &map,
+                      const std::string &mode, const std::string &version,
+                      seconds delay) {
     //------------------------------------------------------------
     // Set initial game state and register notification callbacks.
 
@@ -121,8 +147,6 @@ bool Game::init(unsigned int port, int max_players, const std::string &name,
     _one_server.set_application_instance_information_callback(
         application_instance_information_callback, this);
     _one_server.set_custom_command_callback(custom_command_callback, this);
-
-    return (_one_server.status() == OneServerWrapper::Status::waiting_for_client);
 }
 
 void Game::shutdown() {
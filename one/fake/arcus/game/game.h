@@ -35,6 +35,11 @@ public:
     bool init(unsigned int port, int max_players, const std::string &name,
               const std::string &map, const std::string &mode, const std::string &version,
               seconds delay);
+    // Same as init, over a transport already connected to the agent, see
+    // OneServerWrapper::init.
+    bool init(i3d::one::Transport &transport, int max_players, const std::string &name,
+              const std::string &map, const std::string &mode, const std::string &version,
+              seconds delay);
     void shutdown();
 
     void alter_game_state();
@@ -88,6 +93,11 @@ public:
                                const std::string &type);
 
 private:
+    // Sets the initial game state and callbacks, once the server is created.
+    void init_state(int max_players, const std::string &name, const std::string &map,
+                    const std::string &mode, const std::string &version,
+                    seconds delay);
+
     static void soft_stop_callback(int timeout, void *userdata);
     static void allocated_callback(const OneServerWrapper::AllocatedData &data,
                                    void *userdata);
@@ -4,8 +4,10 @@
 #include <string>
 #include <cstring>
 
+#include <one/arcus/allocator.h>
 #include <one/arcus/c_api.h>
 #include <one/arcus/c_error.h>
+#include <one/arcus/server.h>
 #include <one/fake/arcus/game/log.h>
 #include <one/fake/arcus/game/parsing.h>
 
@@ -66,6 +68,51 @@ bool OneServerWrapper::init(unsigned int port, const AllocationHooks &hooks) {
         return false;
     }
 
+    set_allocation_hooks(hooks);
+
+    //-----------------------
+    // Create the one server.
+
+    // Each game server must have one corresponding arcus server.
+    OneError err = one_server_create(port, &_server);
+    if (one_is_error(err)) {
+        L_ERROR(one_error_text(err));
+        return false;
+    }
+
+    return complete_init();
+}
+
+bool OneServerWrapper::init(i3d::one::Transport &transport,
+                            const AllocationHooks &hooks) {
+    const std::lock_guard<std::mutex> lock(_wrapper);
+
+    if (_server != nullptr) {
+        L_ERROR("already initialized");
+        return false;
+    }
+
+    set_allocation_hooks(hooks);
+
+    // The C API has no transports, so the server is created as one_server_create
+    // does.
+    auto server = i3d::one::allocator::create<i3d::one::Server>();
+    if (server == nullptr) {
+        L_ERROR(one_error_text(ONE_ERROR_SERVER_ALLOCATION_FAILED));
+        return false;
+    }
+    OneError err = server->init_transport(transport);
+    if (one_is_error(err)) {
+        i3d::one::allocator::destroy<i3d::one::Server>(server);
+        L_ERROR(one_error_text(err));
+        return false;
+    }
+    _server = reinterpret_cast<OneServerPtr>(server);
+
+    return complete_init();
+}
+
+void OneServerWrapper::set_allocation_hooks(const AllocationHooks &hooks) {
     //----------------------
     // Set custom allocator.
 
@@ -90,21 +137,13 @@ bool OneServerWrapper::init(unsigned int port, const AllocationHooks &hooks) {
         one_allocator_set_free(free_wrapper);
         one_allocator_set_realloc(realloc_wrapper);
     }
+}
 
-    //-----------------------
-    // Create the one server.
-
-    // Each game server must have one corresponding arcus server.
-    OneError err = one_server_create(port, &_server);
-    if (one_is_error(err)) {
-        L_ERROR(one_error_text(err));
-        return false;
-    }
-
+bool OneServerWrapper::complete_init() {
     //-----------------------
     // Create the buffers.
 
-    err = one_array_create(&_reverse_metadata_data);
+    OneError err = one_array_create(&_reverse_metadata_data);
     if (one_is_error(err)) {
         L_ERROR(one_error_text(err));
         return false;
@@ -16,6 +16,12 @@ typedef OneArray *OneArrayPtr;
 struct OneObject;
 typedef OneObject *OneObjectPtr;
 
+namespace i3d {
+namespace one {
+class Transport;
+}  // namespace one
+}  // namespace i3d
+
 namespace one_integration {
 
 /// OneServerWrapper encapsulates the integration for the One Arcus Server and
@@ -52,6 +58,10 @@ public:
     // alloc and free are optional allocation override handlers. Both may be nullptr,
     // otherwise both are required.
     bool init(unsigned int port, const AllocationHooks &hooks);
+    // For tests: same as init, over a transport already connected to the agent,
+    // e.g. one end of a LoopbackPipe, see Server::init_transport. Not part of
+    // the integration example, as the C API has no transports.
+    bool init(i3d::one::Transport &transport, const AllocationHooks &hooks);
     void shutdown();
 
     // Must called often (e.g. each frame). Updates the Arcus Server, which
@@ -201,6 +211,12 @@ public:
         void *userdata);
 
 private:
+    // Sets the allocation overrides, if all are given.
+    void set_allocation_hooks(const AllocationHooks &hooks);
+    // Creates the buffers and sets the logger and callbacks once the server is
+    // created.
+    bool complete_init();
+
     // Callbacks potentially called by the arcus server.
     static void soft_stop(void *userdata, int timeout_seconds);
     static void allocated(void *userdata, void *allocated);
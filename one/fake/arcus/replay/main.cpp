@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <one/arcus/error.h>
+#include <one/fake/arcus/replay/replay.h>
+
+using namespace i3d::one;
+
+namespace {
+
+struct Options {
+    ReplayOptions replay;
+    std::vector<const char *> files;
+};
+
+void print_usage() {
+    std::printf(
+        "usage: replay [--target server|client] [--mode open|closed] [--speed <factor>] "
+        "[--connections <n>] [--iterations <n>] [--port <port>] [--timeout <ms>] "
+        "<file>...\n");
+}
+
+bool parse_size(const char *text, size_t &value) {
+    char *end = nullptr;
+    const unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    auto &replay = options.replay;
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--target") == 0 && has_value) {
+            ++i;
+            if (std::strcmp(argv[i], "server") == 0) {
+                replay.target = ReplayTarget::server;
+            } else if (std::strcmp(argv[i], "client") == 0) {
+                replay.target = ReplayTarget::client;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--mode") == 0 && has_value) {
+            ++i;
+            if (std::strcmp(argv[i], "open") == 0) {
+                replay.mode = ReplayMode::open_loop;
+            } else if (std::strcmp(argv[i], "closed") == 0) {
+                replay.mode = ReplayMode::closed_loop;
+            } else {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--speed") == 0 && has_value) {
+            ++i;
+            char *end = nullptr;
+            replay.speed = std::strtod(argv[i], &end);
+            if (end == argv[i] || *end != '\0' || replay.speed < 0.0) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--connections") == 0 && has_value) {
+            if (!parse_size(argv[++i], replay.connections)) return false;
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && has_value) {
+            if (!parse_size(argv[++i], replay.iterations)) return false;
+        } else if (std::strcmp(argv[i], "--timeout") == 0 && has_value) {
+            if (!parse_size(argv[++i], replay.timeout_ms)) return false;
+        } else if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            size_t port = 0;
+            if (!parse_size(argv[++i], port) || port == 0 || port > 65535) return false;
+            replay.port = static_cast<unsigned int>(port);
+        } else if (argv[i][0] == '-') {
+            return false;
+        } else {
+            options.files.push_back(argv[i]);
+        }
+    }
+    return !options.files.empty();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    Replayer replayer;
+    for (auto path : options.files) {
+        auto err = replayer.load(path, options.replay.target);
+        if (is_error(err)) {
+            std::fprintf(stderr, "failed to load %s: %s\n", path, error_text(err));
+            return 1;
+        }
+    }
+    std::printf("frames: %zu\n", replayer.frames().size());
+
+    ReplayReport report;
+    auto result = replayer.run(options.replay, report);
+    if (result != ReplayResult::ok) {
+        std::fprintf(stderr, "replay failed: %s\n", replay_result_text(result));
+        return 1;
+    }
+
+    std::printf("connections: %zu/%zu, lost: %zu\n", report.connections_ready,
+                options.replay.connections, report.connections_lost);
+    std::printf("sent: %zu, delivered: %zu, duration: %.3f s\n", report.sent,
+                report.delivered, report.duration_seconds);
+    std::printf("rate: %.1f sent/s, %.1f delivered/s\n", report.sent_per_second,
+                report.delivered_per_second);
+    std::printf("latency us: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+                report.latency_p50_us, report.latency_p90_us, report.latency_p99_us,
+                report.latency_p999_us, report.latency_max_us);
+
+    return report.delivered == report.sent ? 0 : 2;
+}
@@ -0,0 +1,505 @@
+#include <one/fake/arcus/replay/replay.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+#include <one/arcus/array.h>
+#include <one/arcus/client.h>
+#include <one/arcus/internal/capture.h>
+#include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/socket.h>
+#include <one/arcus/object.h>
+#include <one/arcus/server.h>
+
+using namespace std::chrono;
+
+namespace i3d {
+namespace one {
+
+namespace {
+
+const char *replay_address = "127.0.0.1";
+
+// Opcodes of the frames replayed to either target, see Replayer::is_replayed.
+const Opcode replayed_opcodes[] = {Opcode::soft_stop,
+                                   Opcode::allocated,
+                                   Opcode::metadata,
+                                   Opcode::host_information,
+                                   Opcode::application_instance_information,
+                                   Opcode::custom_command,
+                                   Opcode::live_state,
+                                   Opcode::reverse_metadata,
+                                   Opcode::application_instance_status};
+
+// Replays the trace over a single connection between a target and a peer
+// driven directly through a Connection. The target and the peer are updated
+// from the same thread, so the target callbacks need no synchronization.
+class ReplaySession final {
+public:
+    ReplaySession(const std::vector<Replayer::Frame> &frames, uint64_t trace_duration_ns,
+                  const ReplayOptions &options, unsigned int port)
+        : _frames(frames)
+        , _trace_duration_ns(trace_duration_ns)
+        , _options(options)
+        , _port(port)
+        , _peer(Connection::max_message_default, Connection::max_message_default)
+        , _is_ready(false)
+        , _is_lost(false)
+        , _sent(0)
+        , _delivered(0) {}
+
+    ReplaySession(const ReplaySession &) = delete;
+    ReplaySession &operator=(const ReplaySession &) = delete;
+
+    ~ReplaySession() {
+        _peer.shutdown();
+    }
+
+    void run() {
+        _is_ready = connect();
+        if (!_is_ready) {
+            return;
+        }
+        replay();
+    }
+
+    bool is_ready() const {
+        return _is_ready;
+    }
+
+    bool is_lost() const {
+        return _is_lost;
+    }
+
+    size_t sent() const {
+        return _sent;
+    }
+
+    size_t delivered() const {
+        return _delivered;
+    }
+
+    const std::vector<uint64_t> &latencies_ns() const {
+        return _latencies_ns;
+    }
+
+    steady_clock::time_point start() const {
+        return _start;
+    }
+
+    steady_clock::time_point end() const {
+        return _end;
+    }
+
+private:
+    bool connect() {
+        const auto deadline = steady_clock::now() + milliseconds(_options.timeout_ms);
+
+        // Every frame is sent, in the recorded order. By default, queued live
+        // states and statuses would be replaced by newer ones and classes sent
+        // out of order, leaving frames undelivered and latencies matched to
+        // the wrong frames.
+        for (auto code : replayed_opcodes) {
+            if (is_error(_peer.set_outgoing_policy(code, Priority::bulk, false))) {
+                return false;
+            }
+        }
+
+        if (_options.target == ReplayTarget::server) {
+            if (is_error(_server.init(_port)) || is_error(set_server_callbacks())) {
+                return false;
+            }
+            // The Server listens during its first update.
+            while (_server.status() != Server::Status::waiting_for_client) {
+                _server.update();
+                if (steady_clock::now() > deadline) return false;
+                std::this_thread::yield();
+            }
+            if (is_error(_peer_socket.init()) ||
+                is_error(_peer_socket.connect(replay_address, _port))) {
+                return false;
+            }
+            _peer.init(_peer_socket);
+        } else {
+            if (is_error(_listen_socket.init()) || is_error(_listen_socket.bind(_port)) ||
+                is_error(_listen_socket.listen(1))) {
+                return false;
+            }
+            if (is_error(_client.init(replay_address, _port)) ||
+                is_error(set_client_callbacks())) {
+                return false;
+            }
+        }
+
+        while (!is_connected()) {
+            if (!pump() || steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    bool is_connected() const {
+        if (_peer.status() != Connection::Status::ready) {
+            return false;
+        }
+        if (_options.target == ReplayTarget::server) {
+            return _server.status() == Server::Status::ready;
+        }
+        return _client.status() == Client::Status::ready;
+    }
+
+    // Updates both sides once. Returns false if the peer failed.
+    bool pump() {
+        if (_options.target == ReplayTarget::server) {
+            _server.update();
+        } else {
+            if (!_peer_socket.is_initialized() && !accept()) {
+                return false;
+            }
+            _client.update();
+            if (!_peer_socket.is_initialized()) {
+                return true;
+            }
+        }
+
+        if (is_error(_peer.update())) {
+            return false;
+        }
+
+        // Discard whatever the target sends back.
+        while (true) {
+            unsigned int count = 0;
+            if (is_error(_peer.incoming_count(count)) || count == 0) break;
+            _peer.remove_incoming([](const Message &) { return ONE_ERROR_NONE; });
+        }
+        return true;
+    }
+
+    bool accept() {
+        bool is_ready = false;
+        if (is_error(_listen_socket.ready_for_read(0.f, is_ready))) {
+            return false;
+        }
+        if (!is_ready) {
+            return true;
+        }
+
+        Socket incoming;
+        String ip;
+        unsigned int port = 0;
+        if (is_error(_listen_socket.accept(incoming, ip, port)) ||
+            !incoming.is_initialized()) {
+            return true;
+        }
+
+        // The peer plays the Arcus Server, which initiates the handshake.
+        _peer_socket = incoming;
+        _peer.init(_peer_socket);
+        return !is_error(_peer.initiate_handshake());
+    }
+
+    void on_delivered() {
+        const auto now = steady_clock::now();
+        ++_delivered;
+        _last_delivery = now;
+        if (_pending.empty()) {
+            return;
+        }
+        _latencies_ns.push_back(duration_cast<nanoseconds>(now - _pending.front()).count());
+        _pending.pop_front();
+    }
+
+    OneError set_server_callbacks() {
+        auto on_int = [this](void *, int) { on_delivered(); };
+        auto on_array = [this](void *, Array *) { on_delivered(); };
+        auto on_object = [this](void *, Object *) { on_delivered(); };
+
+        auto err = _server.set_soft_stop_callback(on_int, nullptr);
+        if (is_error(err)) return err;
+        err = _server.set_allocated_callback(on_array, nullptr);
+        if (is_error(err)) return err;
+        err = _server.set_metadata_callback(on_array, nullptr);
+        if (is_error(err)) return err;
+        err = _server.set_custom_command_callback(on_array, nullptr);
+        if (is_error(err)) return err;
+        err = _server.set_host_information_callback(on_object, nullptr);
+        if (is_error(err)) return err;
+        return _server.set_application_instance_information_callback(on_object, nullptr);
+    }
+
+    OneError set_client_callbacks() {
+        auto err = _client.set_live_state_callback(
+            [this](void *, int, int, const String &, const String &, const String &,
+                   const String &) { on_delivered(); },
+            nullptr);
+        if (is_error(err)) return err;
+        err = _client.set_reverse_metadata_callback(
+            [this](void *, Array *) { on_delivered(); }, nullptr);
+        if (is_error(err)) return err;
+        return _client.set_application_instance_status_callback(
+            [this](void *, int) { on_delivered(); }, nullptr);
+    }
+
+    nanoseconds scaled(uint64_t offset_ns) const {
+        if (_options.speed <= 0.0) {
+            return nanoseconds(0);
+        }
+        return nanoseconds(static_cast<int64_t>(offset_ns / _options.speed));
+    }
+
+    // Time at which the frame at the given position of the whole run is due.
+    steady_clock::time_point due(size_t position) const {
+        const size_t count = _frames.size();
+        const auto &frame = _frames[position % count];
+        if (_options.mode == ReplayMode::open_loop) {
+            const uint64_t iteration = position / count;
+            return _start + scaled(iteration * _trace_duration_ns + frame.offset_ns);
+        }
+
+        // Closed loop: the recorded gap after the previous delivery. Each
+        // iteration starts without a gap.
+        if (position % count == 0) {
+            return _last_delivery;
+        }
+        const auto &previous = _frames[position % count - 1];
+        return _last_delivery + scaled(frame.offset_ns - previous.offset_ns);
+    }
+
+    void replay() {
+        const size_t total = _frames.size() * _options.iterations;
+        size_t next = 0;
+
+        _start = steady_clock::now();
+        _last_delivery = _start;
+        // Gives up once neither a send nor a delivery happened for the
+        // timeout, e.g. if the target rejected a frame.
+        auto last_progress = _start;
+        size_t delivered = 0;
+
+        while (next < total || !_pending.empty()) {
+            if (!pump()) {
+                _is_lost = true;
+                break;
+            }
+
+            auto now = steady_clock::now();
+            while (next < total) {
+                if (_options.mode == ReplayMode::closed_loop && !_pending.empty()) {
+                    break;
+                }
+                const auto scheduled = due(next);
+                if (now < scheduled) {
+                    break;
+                }
+                // A full outgoing queue is retried on the next pump.
+                if (is_error(_peer.add_outgoing(_frames[next % _frames.size()].message))) {
+                    break;
+                }
+                // In open loop, latency includes the time the frame waited to
+                // be sent past its schedule.
+                _pending.push_back(_options.mode == ReplayMode::open_loop ? scheduled
+                                                                          : now);
+                last_progress = now;
+                ++next;
+                ++_sent;
+            }
+
+            if (_delivered != delivered) {
+                delivered = _delivered;
+                last_progress = now;
+            }
+            if (now - last_progress > milliseconds(_options.timeout_ms)) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+
+        _end = steady_clock::now();
+    }
+
+    const std::vector<Replayer::Frame> &_frames;
+    const uint64_t _trace_duration_ns;
+    const ReplayOptions &_options;
+    const unsigned int _port;
+
+    Server _server;
+    Client _client;
+
+    Socket _listen_socket;
+    Socket _peer_socket;
+    Connection _peer;
+
+    bool _is_ready;
+    bool _is_lost;
+    size_t _sent;
+    size_t _delivered;
+    std::deque<steady_clock::time_point> _pending;
+    std::vector<uint64_t> _latencies_ns;
+    steady_clock::time_point _start;
+    steady_clock::time_point _end;
+    steady_clock::time_point _last_delivery;
+};
+
+double percentile_us(const std::vector<uint64_t> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    index = std::min(index, sorted.size() - 1);
+    return sorted[index] / 1000.0;
+}
+
+}  // namespace
+
+const char *replay_result_text(ReplayResult result) {
+    switch (result) {
+        case ReplayResult::ok:
+            return "ok";
+        case ReplayResult::no_frames:
+            return "no frames loaded";
+        case ReplayResult::invalid_options:
+            return "invalid options";
+        case ReplayResult::connection_failed:
+            return "no connection became ready";
+    }
+    return "unknown";
+}
+
+bool Replayer::is_replayed(ReplayTarget target, Opcode code) {
+    switch (code) {
+        case Opcode::soft_stop:
+        case Opcode::allocated:
+        case Opcode::metadata:
+        case Opcode::host_information:
+        case Opcode::application_instance_information:
+        case Opcode::custom_command:
+            return target == ReplayTarget::server;
+        case Opcode::live_state:
+        case Opcode::reverse_metadata:
+        case Opcode::application_instance_status:
+            return target == ReplayTarget::client;
+        default:
+            return false;
+    }
+}
+
+OneError Replayer::load(const char *path, ReplayTarget target) {
+    CaptureReader reader;
+    auto err = reader.open(path);
+    if (is_error(err)) {
+        return err;
+    }
+
+    while (true) {
+        CaptureRecord record;
+        bool is_end = false;
+        err = reader.read(record, is_end);
+        if (is_error(err)) {
+            return err;
+        }
+        if (is_end) {
+            break;
+        }
+
+        const auto code = static_cast<Opcode>(static_cast<unsigned char>(record.opcode));
+        if (!is_replayed(target, code)) {
+            continue;
+        }
+
+        Frame frame;
+        if (is_error(frame.message.init(code, {record.payload, record.length}))) {
+            continue;
+        }
+
+        if (_frames.empty() && _last_offset_ns == 0) {
+            _first_timestamp_ns = record.timestamp_ns;
+        }
+        // Keep frames ordered even if files from different runs are mixed.
+        uint64_t offset = 0;
+        if (record.timestamp_ns > _first_timestamp_ns) {
+            offset = record.timestamp_ns - _first_timestamp_ns;
+        }
+        frame.offset_ns = std::max(offset, _last_offset_ns);
+        _last_offset_ns = frame.offset_ns;
+        _frames.push_back(frame);
+    }
+
+    return ONE_ERROR_NONE;
+}
+
+void Replayer::clear() {
+    _frames.clear();
+    _first_timestamp_ns = 0;
+    _last_offset_ns = 0;
+}
+
+ReplayResult Replayer::run(const ReplayOptions &options, ReplayReport &report) const {
+    report = ReplayReport();
+    if (_frames.empty()) {
+        return ReplayResult::no_frames;
+    }
+    if (options.connections == 0 || options.iterations == 0 || options.speed < 0.0) {
+        return ReplayResult::invalid_options;
+    }
+
+    std::vector<ReplaySession *> sessions;
+    for (size_t i = 0; i < options.connections; ++i) {
+        sessions.push_back(new ReplaySession(_frames, _last_offset_ns, options,
+                                             options.port + static_cast<unsigned int>(i)));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto session : sessions) {
+        threads.push_back(std::thread(&ReplaySession::run, session));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> latencies;
+    steady_clock::time_point start = steady_clock::time_point::max();
+    steady_clock::time_point end = steady_clock::time_point::min();
+    for (auto session : sessions) {
+        if (!session->is_ready()) {
+            continue;
+        }
+        ++report.connections_ready;
+        if (session->is_lost()) {
+            ++report.connections_lost;
+        }
+        report.sent += session->sent();
+        report.delivered += session->delivered();
+        latencies.insert(latencies.end(), session->latencies_ns().begin(),
+                         session->latencies_ns().end());
+        start = std::min(start, session->start());
+        end = std::max(end, session->end());
+    }
+    for (auto session : sessions) {
+        delete session;
+    }
+
+    if (report.connections_ready == 0) {
+        return ReplayResult::connection_failed;
+    }
+
+    report.duration_seconds = duration_cast<duration<double>>(end - start).count();
+    if (report.duration_seconds > 0.0) {
+        report.sent_per_second = report.sent / report.duration_seconds;
+        report.delivered_per_second = report.delivered / report.duration_seconds;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    report.latency_p50_us = percentile_us(latencies, 0.5);
+    report.latency_p90_us = percentile_us(latencies, 0.9);
+    report.latency_p99_us = percentile_us(latencies, 0.99);
+    report.latency_p999_us = percentile_us(latencies, 0.999);
+    report.latency_max_us = latencies.empty() ? 0.0 : latencies.back() / 1000.0;
+    return ReplayResult::ok;
+}
+
+}  // namespace one
+}  // namespace i3d
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <one/arcus/error.h>
+#include <one/arcus/message.h>
+#include <one/arcus/opcode.h>
+
+namespace i3d {
+namespace one {
+
+// Which side of the Arcus protocol is driven by the replayed traffic.
+enum class ReplayTarget {
+    // Replays the frames an agent sends (soft_stop, allocated, metadata,
+    // host_information, application_instance_information, custom_command)
+    // to local Servers.
+    server,
+    // Replays the frames a game server sends (live_state, reverse_metadata,
+    // application_instance_status) to local Clients.
+    client
+};
+
+enum class ReplayMode {
+    // Frames are sent on the recorded schedule, regardless of how fast the
+    // target processes them. Latency is measured from the scheduled send time,
+    // so that a slow target is not hidden by a sender falling behind.
+    open_loop,
+    // Each frame is sent once the previous one has been delivered, followed by
+    // the recorded gap to the next frame.
+    closed_loop
+};
+
+// Outcome of Replayer::run. Specific to the replay tool, so not part of
+// OneError.
+enum class ReplayResult {
+    ok,
+    no_frames,
+    invalid_options,
+    // No connection to a target became ready before the timeout.
+    connection_failed
+};
+
+const char *replay_result_text(ReplayResult result);
+
+struct ReplayOptions {
+    ReplayTarget target = ReplayTarget::server;
+    ReplayMode mode = ReplayMode::open_loop;
+    // Divides the recorded gaps between frames. Zero sends as fast as
+    // possible.
+    double speed = 1.0;
+    // Number of target instances, each replaying the whole trace over its own
+    // connection from its own thread. Connection i uses port + i.
+    size_t connections = 1;
+    unsigned int port = 19140;
+    // Number of times each connection replays the trace.
+    size_t iterations = 1;
+    // Time allowed to connect, and without any frame sent or delivered before
+    // giving up on a connection.
+    size_t timeout_ms = 10000;
+};
+
+struct ReplayReport {
+    size_t connections_ready = 0;
+    // Connections that failed during the replay, e.g. because the target
+    // could not keep up and closed the connection.
+    size_t connections_lost = 0;
+    size_t sent = 0;
+    size_t delivered = 0;
+    double duration_seconds = 0.0;
+    // Achieved rates over the whole run, for all connections.
+    double sent_per_second = 0.0;
+    double delivered_per_second = 0.0;
+    // Send to target callback latency, in microseconds.
+    double latency_p50_us = 0.0;
+    double latency_p90_us = 0.0;
+    double latency_p99_us = 0.0;
+    double latency_p999_us = 0.0;
+    double latency_max_us = 0.0;
+};
+
+// Loads frames from Arcus capture files and replays them against local
+// Servers or Clients, measuring the achieved message rate and the latency
+// from sending a frame until the target invokes the matching callback.
+//
+// Frames are selected by opcode according to the target, whatever their
+// recorded direction, so captures from either side of a connection can be
+// used, but captures of both sides of the same connection should not be
+// mixed.
+class Replayer final {
+public:
+    struct Frame {
+        uint64_t offset_ns;  // Since the first loaded frame.
+        Message message;
+    };
+
+    Replayer() = default;
+    Replayer(const Replayer &) = delete;
+    Replayer &operator=(const Replayer &) = delete;
+    ~Replayer() = default;
+
+    // Returns true if frames with the opcode are replayed to the target.
+    static bool is_replayed(ReplayTarget target, Opcode code);
+
+    // Appends the frames of the capture file for the target. Files must be
+    // loaded oldest first. Frames with payloads that are not valid JSON are
+    // skipped.
+    OneError load(const char *path, ReplayTarget target);
+    void clear();
+
+    const std::vector<Frame> &frames() const {
+        return _frames;
+    }
+
+    // Replays the loaded frames and fills the report. Blocks until all frames
+    // were delivered or the timeout expired.
+    ReplayResult run(const ReplayOptions &options, ReplayReport &report) const;
+
+private:
+    std::vector<Frame> _frames;
+    uint64_t _first_timestamp_ns = 0;
+    uint64_t _last_offset_ns = 0;
+};
+
+}  // namespace one
+}  // namespace i3d
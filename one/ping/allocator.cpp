@@ -1,6 +1,10 @@
 #include <one/ping/allocator.h>
 
 #include <assert.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 namespace i3d {
 namespace ping {
@@ -23,6 +27,73 @@ void *default_realloc(void *p, size_t bytes) {
     return std::realloc(p, bytes);
 }
 
+constexpr size_t category_count = static_cast<size_t>(Category::count);
+
+// Tracking state. The map uses the standard allocator so that tracking does
+// not recurse into itself.
+struct Tracking {
+    struct Allocation {
+        size_t size;
+        Category category;
+    };
+
+    std::atomic<bool> is_enabled{false};
+    std::mutex mutex;
+    std::unordered_map<void *, Allocation> allocations;
+    Statistics categories[category_count];
+    Statistics total;
+};
+
+// Never destroyed, as memory may be freed during static destruction.
+Tracking &tracking() {
+    static Tracking *instance = new Tracking();
+    return *instance;
+}
+
+thread_local Category _scoped_category = Category::general;
+
+Category resolve(Category category) {
+    return (category == Category::general) ? _scoped_category : category;
+}
+
+void add(Statistics &statistics, size_t size) {
+    statistics.live_bytes += size;
+    statistics.live_allocations++;
+    statistics.allocations++;
+    statistics.size_classes[size_class(size)]++;
+    if (statistics.live_bytes > statistics.peak_bytes) {
+        statistics.peak_bytes = statistics.live_bytes;
+    }
+}
+
+void remove(Statistics &statistics, size_t size) {
+    statistics.live_bytes -= size;
+    statistics.live_allocations--;
+    statistics.frees++;
+}
+
+// Must be called with the tracking mutex locked.
+void track(Tracking &state, void *p, size_t size, Category category) {
+    if (p == nullptr) {
+        return;
+    }
+    state.allocations[p] = {size, category};
+    add(state.categories[static_cast<size_t>(category)], size);
+    add(state.total, size);
+}
+
+// Must be called with the tracking mutex locked.
+void untrack(Tracking &state, void *p) {
+    auto it = state.allocations.find(p);
+    if (it == state.allocations.end()) {
+        return;
+    }
+    const auto &allocation = it->second;
+    remove(state.categories[static_cast<size_t>(allocation.category)], allocation.size);
+    remove(state.total, allocation.size);
+    state.allocations.erase(it);
+}
+
 }  // namespace
 
 // Global allocation overridable functions.
@@ -49,19 +120,112 @@ void reset_overrides() {
 }
 
 void *alloc(size_t bytes) {
-    assert(_alloc);
-    void *p = _alloc(bytes);
-    assert(p != nullptr);
-    return p;
+    return alloc(bytes, Category::general);
 }
 
 void free(void *p) {
     assert(_free);
+    auto &state = tracking();
+    if (state.is_enabled.load(std::memory_order_relaxed)) {
+        // Untracked before being freed, so that the address cannot be reused
+        // by another thread and tracked first.
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        untrack(state, p);
+    }
     _free(p);
 }
 
 void *realloc(void *p, size_t s) {
-    return _realloc(p, s);
+    return realloc(p, s, Category::general);
+}
+
+size_t size_class(size_t bytes) {
+    size_t result = 0;
+    size_t limit = 16;
+    while (bytes > limit && result < size_class_count - 1) {
+        limit <<= 1;
+        ++result;
+    }
+    return result;
+}
+
+void set_tracking(bool enabled) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    if (enabled) {
+        std::memset(state.categories, 0, sizeof(state.categories));
+        std::memset(&state.total, 0, sizeof(state.total));
+    }
+    state.allocations.clear();
+    state.is_enabled = enabled;
+}
+
+bool is_tracking() {
+    return tracking().is_enabled;
+}
+
+void statistics(Category category, Statistics &statistics) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    const auto index = static_cast<size_t>(category);
+    if (index >= category_count) {
+        std::memset(&statistics, 0, sizeof(statistics));
+        return;
+    }
+    statistics = state.categories[index];
+}
+
+void total_statistics(Statistics &statistics) {
+    auto &state = tracking();
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    statistics = state.total;
+}
+
+void *alloc(size_t bytes, Category category) {
+    assert(_alloc);
+    void *p = _alloc(bytes);
+    assert(p != nullptr);
+    auto &state = tracking();
+    if (state.is_enabled.load(std::memory_order_relaxed)) {
+        const std::lock_guard<std::mutex> lock(state.mutex);
+        track(state, p, bytes, resolve(category));
+    }
+    return p;
+}
+
+void *realloc(void *p, size_t s, Category category) {
+    auto &state = tracking();
+    if (!state.is_enabled.load(std::memory_order_relaxed)) {
+        return _realloc(p, s);
+    }
+
+    // Locked across the reallocation, for the same reason as in free.
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.allocations.find(p);
+    if (it != state.allocations.end()) {
+        // Keeps the category of the original allocation.
+        category = it->second.category;
+    } else {
+        category = resolve(category);
+    }
+    void *reallocated = _realloc(p, s);
+    if (reallocated == nullptr && s != 0) {
+        // The original memory is left untouched.
+        return nullptr;
+    }
+    if (p != nullptr) {
+        untrack(state, p);
+    }
+    track(state, reallocated, s, category);
+    return reallocated;
+}
+
+ScopedCategory::ScopedCategory(Category category) : _previous(_scoped_category) {
+    _scoped_category = category;
+}
+
+ScopedCategory::~ScopedCategory() {
+    _scoped_category = _previous;
 }
 
 }  // namespace allocator
@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <functional>
+#include <type_traits>
 
 namespace i3d {
 namespace ping {
@@ -32,6 +33,59 @@ void free(void *);
 // Reallocate existing memory with new size. Must match standard c behavior.
 void *realloc(void *p, size_t s);
 
+//---------
+// Tracking.
+
+// Subsystems that allocations are attributed to. Must match
+// I3dPingAllocationCategory in c_api.h.
+enum class Category { general = 0, json, string, container, count };
+
+// Allocation sizes are counted in power of two classes: class 0 holds sizes up
+// to 16 bytes, class i sizes up to 16 << i bytes and the last class all larger
+// sizes.
+constexpr size_t size_class_count = 14;
+size_t size_class(size_t bytes);
+
+struct Statistics {
+    size_t live_bytes;
+    size_t peak_bytes;
+    size_t live_allocations;
+    size_t allocations;  // Since tracking was enabled.
+    size_t frees;        // Since tracking was enabled.
+    size_t size_classes[size_class_count];
+};
+
+// Enables or disables allocation tracking. Enabling resets the statistics,
+// which remain readable once disabled. Memory allocated while tracking was
+// disabled is ignored when freed. Tracking adds a lock and a hash table update
+// to each allocation and free, it is intended for diagnostics.
+void set_tracking(bool enabled);
+bool is_tracking();
+
+void statistics(Category category, Statistics &statistics);
+// Statistics of all categories together.
+void total_statistics(Statistics &statistics);
+
+// Same as alloc and realloc, attributing the allocation to the category. The
+// general category is replaced by the category of the innermost
+// ScopedCategory of the calling thread, if any.
+void *alloc(size_t, Category category);
+void *realloc(void *p, size_t s, Category category);
+
+// Attributes the allocations of the current thread made without an explicit
+// category to the given category while in scope.
+class ScopedCategory final {
+public:
+    explicit ScopedCategory(Category category);
+    ~ScopedCategory();
+
+    ScopedCategory(const ScopedCategory &) = delete;
+    ScopedCategory &operator=(const ScopedCategory &) = delete;
+
+private:
+    Category _previous;
+};
+
 // Equivalent to the new operator, but using the function set by set_alloc.
 template <class T, class... Args>
 T *create(Args &&...args) {
@@ -110,7 +164,8 @@ public:
 
     value_type *  // Use pointer if pointer is not a value_type*
     allocate(std::size_t n) {
-        return static_cast<value_type *>(allocator::alloc(n * sizeof(value_type)));
+        return static_cast<value_type *>(
+            allocator::alloc(n * sizeof(value_type), category()));
     }
 
     void deallocate(value_type *p,
@@ -118,6 +173,12 @@ public:
     {
         allocator::free(p);
     }
+
+private:
+    static constexpr allocator::Category category() {
+        return std::is_same<T, char>::value ? allocator::Category::string
+                                            : allocator::Category::container;
+    }
 };
 
 template <class T, class U>
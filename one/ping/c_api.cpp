@@ -34,6 +34,44 @@ void allocator_set_realloc(void *(*callback)(void *, unsigned int size)) {
     allocator::set_realloc(wrapper);
 }
 
+static_assert(static_cast<int>(allocator::Category::count) ==
+                  I3D_PING_ALLOCATION_CATEGORY_TOTAL,
+              "allocation categories must match");
+static_assert(allocator::size_class_count == I3D_PING_ALLOCATION_SIZE_CLASS_COUNT,
+              "allocation size classes must match");
+
+void allocator_set_tracking(bool enabled) {
+    allocator::set_tracking(enabled);
+}
+
+I3dPingError allocator_statistics(I3dPingAllocationCategory category,
+                                  I3dPingAllocationStatistics *statistics) {
+    if (statistics == nullptr) {
+        return I3D_PING_ERROR_VALIDATION_PARAM_IS_NULLPTR;
+    }
+    if (category < I3D_PING_ALLOCATION_CATEGORY_GENERAL ||
+        category > I3D_PING_ALLOCATION_CATEGORY_TOTAL) {
+        return I3D_PING_ERROR_VALIDATION_CATEGORY_IS_INVALID;
+    }
+
+    allocator::Statistics result;
+    if (category == I3D_PING_ALLOCATION_CATEGORY_TOTAL) {
+        allocator::total_statistics(result);
+    } else {
+        allocator::statistics(static_cast<allocator::Category>(category), result);
+    }
+
+    statistics->live_bytes = result.live_bytes;
+    statistics->peak_bytes = result.peak_bytes;
+    statistics->live_allocations = result.live_allocations;
+    statistics->allocations = result.allocations;
+    statistics->frees = result.frees;
+    for (size_t i = 0; i < allocator::size_class_count; ++i) {
+        statistics->size_classes[i] = result.size_classes[i];
+    }
+    return I3D_PING_ERROR_NONE;
+}
+
 I3dPingError sites_getter_create(
     I3dSitesGetterPtr *sites_getter,
     void (*callback)(const char *url,
@@ -712,6 +750,15 @@ void i3d_ping_allocator_set_realloc(void *(*callback)(void *, unsigned int size)
     ping::allocator_set_realloc(callback);
 }
 
+void i3d_ping_allocator_set_tracking(bool enabled) {
+    ping::allocator_set_tracking(enabled);
+}
+
+I3dPingError i3d_ping_allocator_statistics(I3dPingAllocationCategory category,
+                                           I3dPingAllocationStatistics *statistics) {
+    return ping::allocator_statistics(category, statistics);
+}
+
 I3dPingError i3d_ping_sites_getter_create(
     I3dSitesGetterPtr *sites_getter,
     void (*callback)(const char *url,
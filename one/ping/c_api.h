@@ -92,6 +92,50 @@ I3D_PING_EXPORT void i3d_ping_allocator_set_free(void (*callback)(void *));
 I3D_PING_EXPORT void i3d_ping_allocator_set_realloc(void *(*callback)(void *,
                                                                       unsigned int size));
 
+/// Subsystems that memory allocations are attributed to by allocation tracking.
+/// @sa i3d_ping_allocator_statistics
+typedef enum I3dPingAllocationCategory {
+    I3D_PING_ALLOCATION_CATEGORY_GENERAL = 0,
+    I3D_PING_ALLOCATION_CATEGORY_JSON,       ///< Sites JSON documents.
+    I3D_PING_ALLOCATION_CATEGORY_STRING,     ///< Strings.
+    I3D_PING_ALLOCATION_CATEGORY_CONTAINER,  ///< Vectors and lists, e.g. of pingers.
+    I3D_PING_ALLOCATION_CATEGORY_TOTAL       ///< All categories, for statistics.
+} I3dPingAllocationCategory;
+
+/// Number of allocation size classes. Class 0 counts allocations of up to 16
+/// bytes, class i allocations of up to 16 << i bytes and the last class all
+/// larger allocations.
+#define I3D_PING_ALLOCATION_SIZE_CLASS_COUNT 14
+
+/// Allocation statistics of a category, since tracking was enabled.
+typedef struct I3dPingAllocationStatistics {
+    size_t live_bytes;        ///< Bytes currently allocated.
+    size_t peak_bytes;        ///< Highest live_bytes value.
+    size_t live_allocations;  ///< Allocations not yet freed.
+    size_t allocations;       ///< Number of allocations.
+    size_t frees;             ///< Number of frees.
+    /// Allocations per size class.
+    size_t size_classes[I3D_PING_ALLOCATION_SIZE_CLASS_COUNT];
+} I3dPingAllocationStatistics;
+
+/// Optional allocation tracking, for diagnostics. When enabled, every allocation
+/// made by the SDK is accounted per category, whether or not custom allocation
+/// functions are set. Enabling resets the statistics, which remain readable
+/// after disabling. Memory allocated while tracking is disabled is not accounted.
+/// Tracking adds a lock and a hash table update to each allocation and free, so
+/// it should not be left enabled in production. Thread-safe.
+/// @param enabled Whether to track allocations.
+I3D_PING_EXPORT void i3d_ping_allocator_set_tracking(bool enabled);
+
+/// Copies the allocation statistics of the given category. Statistics of
+/// allocations made between two calls can be obtained by subtracting the
+/// results, e.g. to find which update phases allocate. Thread-safe.
+/// @param category The category, or I3D_PING_ALLOCATION_CATEGORY_TOTAL for all
+/// categories.
+/// @param statistics A non-null pointer to the statistics to set.
+I3D_PING_EXPORT I3dPingError i3d_ping_allocator_statistics(
+    I3dPingAllocationCategory category, I3dPingAllocationStatistics *statistics);
+
 //------------------------------------------------------------------------------
 ///@}
 ///@name PingSites interface.
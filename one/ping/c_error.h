@@ -17,6 +17,7 @@ typedef enum I3dPingError {
     I3D_PING_ERROR_NONE = 0,
     I3D_PING_ERROR_VALIDATION_PARAM_IS_NULLPTR = 100,
     I3D_PING_ERROR_VALIDATION_BUFFER_IS_TOO_SMALL = 101,
+    I3D_PING_ERROR_VALIDATION_CATEGORY_IS_INVALID = 102,
     I3D_PING_ERROR_DATA_PARSE_FAILED = 200,
     I3D_PING_ERROR_DATA_JSON_PAYLOAD_IS_INVALID = 201,
     I3D_PING_ERROR_DATA_JSON_SERVER_INFORMATION_IS_INVALID = 202,
@@ -17,6 +17,8 @@ const char *error_text(I3dPingError err) {
         {I3D_PING_ERROR_SYMBOL_STRING_PAIR(I3D_PING_ERROR_VALIDATION_PARAM_IS_NULLPTR)},
         {I3D_PING_ERROR_SYMBOL_STRING_PAIR(
             I3D_PING_ERROR_VALIDATION_BUFFER_IS_TOO_SMALL)},
+        {I3D_PING_ERROR_SYMBOL_STRING_PAIR(
+            I3D_PING_ERROR_VALIDATION_CATEGORY_IS_INVALID)},
         {I3D_PING_ERROR_SYMBOL_STRING_PAIR(I3D_PING_ERROR_DATA_PARSE_FAILED)},
         {I3D_PING_ERROR_SYMBOL_STRING_PAIR(I3D_PING_ERROR_DATA_JSON_PAYLOAD_IS_INVALID)},
         {I3D_PING_ERROR_SYMBOL_STRING_PAIR(
@@ -651,13 +651,15 @@ RAPIDJSON_NAMESPACE_END
 ///! customization point for global \c malloc
 // i3d::one change
 //#define RAPIDJSON_MALLOC(size) std::malloc(size)
-#define RAPIDJSON_MALLOC(size) i3d::ping::allocator::alloc(size)
+#define RAPIDJSON_MALLOC(size) \
+    i3d::ping::allocator::alloc(size, i3d::ping::allocator::Category::json)
 #endif
 #ifndef RAPIDJSON_REALLOC
 ///! customization point for global \c realloc
 // i3d::one change
 //#define RAPIDJSON_REALLOC(ptr, new_size) std::realloc(ptr, new_size)
-#define RAPIDJSON_REALLOC(ptr, new_size) i3d::ping::allocator::realloc(ptr, new_size)
+#define RAPIDJSON_REALLOC(ptr, new_size) \
+    i3d::ping::allocator::realloc(ptr, new_size, i3d::ping::allocator::Category::json)
 #endif
 #ifndef RAPIDJSON_FREE
 ///! customization point for global \c free
@@ -50,3 +50,32 @@ TEST_CASE("accumulator", "[arcus]") {
     accumulator.peek(quarter.size(), reinterpret_cast<void **>(&data));
     REQUIRE(std::strncmp(data, quarter.data(), quarter.size()) == 0);
 }
+
+TEST_CASE("accumulator growth", "[arcus]") {
+    Accumulator accumulator(4, 20);
+    REQUIRE(accumulator.capacity() == 20);
+    REQUIRE(accumulator.reserved() == 4);
+
+    const auto data = std::string("0123456789");
+    REQUIRE(accumulator.put(data.data(), 3));
+    REQUIRE(accumulator.reserved() == 4);
+
+    // Doubles until the data fits.
+    REQUIRE(accumulator.put(data.data(), data.size()));
+    REQUIRE(accumulator.reserved() == 16);
+    REQUIRE(accumulator.size() == 13);
+
+    // Capped at the capacity.
+    REQUIRE(accumulator.put(data.data(), 7));
+    REQUIRE(accumulator.reserved() == 20);
+    REQUIRE(accumulator.size() == accumulator.capacity());
+
+    char *read = nullptr;
+    accumulator.peek(accumulator.size(), reinterpret_cast<void **>(&read));
+    REQUIRE(std::strncmp(read, "01201234567890123456", 20) == 0);
+
+    // Trimming keeps the allocation.
+    accumulator.clear();
+    REQUIRE(accumulator.size() == 0);
+    REQUIRE(accumulator.reserved() == 20);
+}
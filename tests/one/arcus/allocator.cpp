@@ -1,8 +1,21 @@
 #include <catch.hpp>
 #include <one/arcus/allocator.h>
+#include <one/arcus/c_api.h>
 #include <one/arcus/c_platform.h>
+#include <one/arcus/internal/json.h>
+#include <one/arcus/internal/pool.h>
+#include <one/arcus/object.h>
+#include <one/arcus/server.h>
 #include <one/arcus/types.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
 using namespace i3d::one;
 
 namespace {
@@ -144,3 +157,297 @@ TEST_CASE("custom string", "[arcus]") {
     }
 #endif
 }
+
+TEST_CASE("allocator override callables", "[arcus]") {
+    SECTION("plain functions are called directly") {
+        Callback<void *(size_t)> alloc = [](size_t bytes) { return std::malloc(bytes); };
+        REQUIRE(alloc);
+        REQUIRE(alloc.function() != nullptr);
+        REQUIRE(!alloc.wrapped());
+
+        ScopedAllocationSetter setter;
+        void *p = allocator::alloc(8);
+        REQUIRE(p == _last_allocated);
+        allocator::free(p);
+        REQUIRE(p == _last_freed);
+    }
+
+    SECTION("other callables are wrapped") {
+        size_t allocations = 0;
+        size_t frees = 0;
+        Callback<void *(size_t)> alloc = [&](size_t bytes) {
+            ++allocations;
+            return std::malloc(bytes);
+        };
+        REQUIRE(alloc);
+        REQUIRE(alloc.function() == nullptr);
+        REQUIRE(alloc.wrapped());
+
+        allocator::set_alloc(alloc);
+        allocator::set_free([&](void *p) {
+            ++frees;
+            std::free(p);
+        });
+        allocator::free(allocator::alloc(8));
+        allocator::reset_overrides();
+        REQUIRE(allocations == 1);
+        REQUIRE(frees == 1);
+
+        // No longer called once reset.
+        allocator::free(allocator::alloc(8));
+        REQUIRE(allocations == 1);
+        REQUIRE(frees == 1);
+    }
+
+    SECTION("empty") {
+        Callback<void(void *, int)> callback;
+        REQUIRE(!callback);
+        callback = nullptr;
+        REQUIRE(!callback);
+        callback = std::function<void(void *, int)>();
+        REQUIRE(!callback);
+    }
+}
+
+TEST_CASE("allocator size classes", "[arcus]") {
+    REQUIRE(allocator::size_class(0) == 0);
+    REQUIRE(allocator::size_class(16) == 0);
+    REQUIRE(allocator::size_class(17) == 1);
+    REQUIRE(allocator::size_class(32) == 1);
+    REQUIRE(allocator::size_class(1024) == 6);
+    REQUIRE(allocator::size_class(16 << 12) == 12);
+    REQUIRE(allocator::size_class((16 << 12) + 1) == allocator::size_class_count - 1);
+    REQUIRE(allocator::size_class(size_t(-1)) == allocator::size_class_count - 1);
+}
+
+TEST_CASE("allocator tracking", "[arcus]") {
+    allocator::Statistics stats;
+
+    SECTION("alloc, realloc and free") {
+        allocator::set_tracking(true);
+        REQUIRE(allocator::is_tracking());
+
+        void *p = allocator::alloc(100);
+        allocator::statistics(allocator::Category::general, stats);
+        REQUIRE(stats.live_bytes == 100);
+        REQUIRE(stats.live_allocations == 1);
+        REQUIRE(stats.allocations == 1);
+        REQUIRE(stats.size_classes[allocator::size_class(100)] == 1);
+
+        p = allocator::realloc(p, 300);
+        allocator::statistics(allocator::Category::general, stats);
+        REQUIRE(stats.live_bytes == 300);
+        REQUIRE(stats.peak_bytes == 300);
+        REQUIRE(stats.live_allocations == 1);
+
+        allocator::free(p);
+        allocator::statistics(allocator::Category::general, stats);
+        REQUIRE(stats.live_bytes == 0);
+        REQUIRE(stats.live_allocations == 0);
+        REQUIRE(stats.peak_bytes == 300);
+        REQUIRE(stats.frees == 2);
+
+        allocator::set_tracking(false);
+        REQUIRE(!allocator::is_tracking());
+        // Statistics remain readable.
+        allocator::statistics(allocator::Category::general, stats);
+        REQUIRE(stats.peak_bytes == 300);
+    }
+
+    SECTION("untracked memory is ignored") {
+        void *p = allocator::alloc(64);
+        allocator::set_tracking(true);
+        allocator::free(p);
+        allocator::total_statistics(stats);
+        REQUIRE(stats.live_bytes == 0);
+        REQUIRE(stats.frees == 0);
+        allocator::set_tracking(false);
+    }
+
+    SECTION("categories") {
+        allocator::set_tracking(true);
+
+        void *p = nullptr;
+        {
+            allocator::ScopedCategory scope(allocator::Category::connection);
+            p = allocator::alloc(10);
+            // Explicit categories take precedence over the scope.
+            void *json = allocator::alloc(20, allocator::Category::json);
+            allocator::statistics(allocator::Category::json, stats);
+            REQUIRE(stats.live_bytes == 20);
+            allocator::free(json);
+        }
+        allocator::statistics(allocator::Category::connection, stats);
+        REQUIRE(stats.live_bytes == 10);
+        allocator::free(p);
+
+        {
+            String val(200, 'x');
+            allocator::statistics(allocator::Category::string, stats);
+            REQUIRE(stats.live_bytes >= 200);
+        }
+        allocator::statistics(allocator::Category::string, stats);
+        REQUIRE(stats.live_bytes == 0);
+
+        allocator::total_statistics(stats);
+        REQUIRE(stats.live_bytes == 0);
+        REQUIRE(stats.allocations >= 3);
+        REQUIRE(stats.peak_bytes >= 200);
+
+        allocator::set_tracking(false);
+    }
+
+    SECTION("c api") {
+        OneAllocationStatistics c_stats;
+        REQUIRE(one_allocator_statistics(ONE_ALLOCATION_CATEGORY_TOTAL, nullptr) ==
+                ONE_ERROR_VALIDATION_STATISTICS_IS_NULLPTR);
+        REQUIRE(one_allocator_statistics(static_cast<OneAllocationCategory>(-1),
+                                         &c_stats) ==
+                ONE_ERROR_VALIDATION_CATEGORY_IS_INVALID);
+
+        one_allocator_set_tracking(true);
+        OneServerPtr server = nullptr;
+        REQUIRE(!one_is_error(one_server_create(19160, &server)));
+
+        REQUIRE(!one_is_error(
+            one_allocator_statistics(ONE_ALLOCATION_CATEGORY_CONNECTION, &c_stats)));
+        REQUIRE(c_stats.live_bytes > 0);
+        REQUIRE(!one_is_error(
+            one_allocator_statistics(ONE_ALLOCATION_CATEGORY_TOTAL, &c_stats)));
+        const size_t live_bytes = c_stats.live_bytes;
+        REQUIRE(live_bytes > 0);
+
+        one_server_destroy(server);
+        REQUIRE(!one_is_error(
+            one_allocator_statistics(ONE_ALLOCATION_CATEGORY_TOTAL, &c_stats)));
+        REQUIRE(c_stats.live_bytes == 0);
+        REQUIRE(c_stats.peak_bytes >= live_bytes);
+        one_allocator_set_tracking(false);
+    }
+}
+
+TEST_CASE("json cache", "[arcus]") {
+    REQUIRE(!allocator::is_pool());
+    one_allocator_flush_json_cache();
+    REQUIRE(json::cached_size() == 0);
+
+    SECTION("bounded") {
+        std::vector<void *> blocks;
+        for (size_t size = 16; size <= 4096; size *= 2) {
+            for (int i = 0; i < 100; ++i) {
+                blocks.push_back(json::alloc(size));
+            }
+        }
+        for (auto block : blocks) {
+            json::free(block);
+        }
+        const size_t cached = json::cached_size();
+        REQUIRE(cached > 0);
+        // 16 KiB, plus the headers of at most 16 blocks per class.
+        REQUIRE(cached <= 20 * 1024);
+
+        one_allocator_flush_json_cache();
+        REQUIRE(json::cached_size() == 0);
+    }
+
+    SECTION("flushed on shutdown") {
+        Server server;
+        REQUIRE(!is_error(server.init(19161)));
+        for (int i = 0; i < 10; ++i) {
+            Object object;
+            REQUIRE(!is_error(object.set_val_string("name", "a name that is long")));
+        }
+        REQUIRE(json::cached_size() > 0);
+        REQUIRE(!is_error(server.shutdown()));
+        REQUIRE(json::cached_size() == 0);
+    }
+}
+
+TEST_CASE("pool allocator", "[arcus]") {
+    SECTION("sizes and alignment") {
+        const size_t sizes[] = {0,   1,    15,   16,   17,    100,   4096,
+                                4097, 32767, 32768, 32769, 100000};
+        std::vector<void *> blocks;
+        for (auto size : sizes) {
+            void *p = pool::alloc(size);
+            REQUIRE(p != nullptr);
+            REQUIRE(reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t) == 0);
+            std::memset(p, 0xab, size);
+            blocks.push_back(p);
+        }
+        for (auto p : blocks) {
+            pool::free(p);
+        }
+        pool::free(nullptr);
+    }
+
+    SECTION("reuse") {
+        void *p = pool::alloc(24);
+        pool::free(p);
+        // The thread cache hands out the most recently freed block first.
+        REQUIRE(pool::alloc(20) == p);
+        pool::free(p);
+    }
+
+    SECTION("realloc") {
+        auto p = reinterpret_cast<char *>(pool::realloc(nullptr, 10));
+        REQUIRE(p != nullptr);
+        std::memcpy(p, "0123456789", 10);
+        // Stays in place within its size class.
+        REQUIRE(pool::realloc(p, 16) == p);
+        p = reinterpret_cast<char *>(pool::realloc(p, 50000));
+        REQUIRE(std::memcmp(p, "0123456789", 10) == 0);
+        // Large blocks grow through malloc.
+        p[49999] = 'x';
+        p = reinterpret_cast<char *>(pool::realloc(p, 1000000));
+        REQUIRE(p != nullptr);
+        REQUIRE(std::memcmp(p, "0123456789", 10) == 0);
+        REQUIRE(p[49999] == 'x');
+        REQUIRE(pool::realloc(p, 0) == nullptr);
+    }
+
+    SECTION("blocks freed by other threads") {
+        std::vector<void *> blocks(1000, nullptr);
+        std::thread producer([&]() {
+            for (auto &p : blocks) {
+                p = pool::alloc(64);
+            }
+        });
+        producer.join();
+        for (auto p : blocks) {
+            REQUIRE(p != nullptr);
+            pool::free(p);
+        }
+
+        pool::Statistics statistics;
+        pool::statistics(statistics);
+        REQUIRE(statistics.slab_bytes > 0);
+    }
+
+    SECTION("selected for the sdk") {
+        REQUIRE(!allocator::is_pool());
+        allocator::use_pool();
+        REQUIRE(allocator::is_pool());
+        {
+            // Json blocks go to the pool rather than the json cache.
+            const size_t cached = json::cached_size();
+            for (int i = 0; i < 10; ++i) {
+                Object object;
+                REQUIRE(!is_error(object.set_val_string("name", "a name that is long")));
+            }
+            REQUIRE(json::cached_size() == cached);
+
+            String text;
+            for (int i = 0; i < 1000; ++i) {
+                text += 'x';
+            }
+            std::vector<int, StandardAllocator<int>> values(100, 1);
+            void *p = allocator::realloc(allocator::alloc(10), 1000);
+            allocator::free(p);
+            REQUIRE(text.size() == 1000);
+            REQUIRE(values.size() == 100);
+        }
+        allocator::reset_overrides();
+        REQUIRE(!allocator::is_pool());
+    }
+}
@@ -31,8 +31,6 @@ TEST_CASE("customer logger", "[capi]") {
 
 #ifdef ONE_WINDOWS  // On linux, listen may succeed even if already listened on.
 TEST_CASE("server port retry", "[capi]") {
-    i3d::one::server::set_listen_retry_delay(1);
-
     constexpr auto port = 9002;
 
     // Block a port.
@@ -40,9 +38,12 @@ TEST_CASE("server port retry", "[capi]") {
     auto err = one_server_create(port, &a);
     REQUIRE(!one_is_error(err));
 
-    // Start a new server on same
+    // Start a new server on same, retrying at least every second.
+    OneServerOptions options;
+    REQUIRE(!one_is_error(one_server_default_options(&options)));
+    options.retry_max_delay_ms = 1000;
     OneServerPtr b;
-    err = one_server_create(port, &b);
+    err = one_server_create_with_options(port, &options, &b);
     REQUIRE(!one_is_error(err));
 
     // Pump updates.
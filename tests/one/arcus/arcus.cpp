@@ -1,18 +1,28 @@
 #include <catch.hpp>
 #include <tests/one/arcus/util.h>
 
+#include <cstdio>
+#include <cstring>
 #include <functional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <one/arcus/allocator.h>
 #include <one/arcus/array.h>
+#include <one/arcus/c_api.h>
+#include <one/arcus/client.h>
+#include <one/arcus/internal/capture.h>
 #include <one/arcus/internal/codec.h>
 #include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/connection_impl.h>
 #include <one/arcus/internal/socket.h>
 #include <one/arcus/internal/version.h>
 #include <one/arcus/error.h>
 #include <one/arcus/message.h>
 #include <one/arcus/object.h>
 #include <one/arcus/opcode.h>
+#include <one/arcus/server.h>
 #include <one/arcus/c_platform.h>
 #include <one/arcus/types.h>
 
@@ -25,10 +35,13 @@ TEST_CASE("current arcus version", "[arcus]") {
 TEST_CASE("opcode version V2 validation", "[arcus]") {
     REQUIRE(is_opcode_supported_v2(Opcode::health));
     REQUIRE(is_opcode_supported_v2(Opcode::hello));
+    REQUIRE(is_opcode_supported_v2(Opcode::features));
     REQUIRE(is_opcode_supported_v2(Opcode::soft_stop));
     REQUIRE(is_opcode_supported_v2(Opcode::allocated));
     REQUIRE(is_opcode_supported_v2(Opcode::metadata));
     REQUIRE(is_opcode_supported_v2(Opcode::reverse_metadata));
+    REQUIRE(is_opcode_supported_v2(Opcode::live_state));
+    REQUIRE(is_opcode_supported_v2(Opcode::live_state_delta));
     REQUIRE(is_opcode_supported_v2(Opcode::host_information));
     REQUIRE(is_opcode_supported_v2(Opcode::application_instance_information));
     REQUIRE(is_opcode_supported_v2(Opcode::application_instance_status));
@@ -39,10 +52,13 @@ TEST_CASE("opcode version V2 validation", "[arcus]") {
 TEST_CASE("opcode current version validation", "[arcus]") {
     REQUIRE(is_opcode_supported(Opcode::health));
     REQUIRE(is_opcode_supported(Opcode::hello));
+    REQUIRE(is_opcode_supported(Opcode::features));
     REQUIRE(is_opcode_supported(Opcode::soft_stop));
     REQUIRE(is_opcode_supported(Opcode::allocated));
     REQUIRE(is_opcode_supported(Opcode::metadata));
     REQUIRE(is_opcode_supported(Opcode::reverse_metadata));
+    REQUIRE(is_opcode_supported(Opcode::live_state));
+    REQUIRE(is_opcode_supported(Opcode::live_state_delta));
     REQUIRE(is_opcode_supported(Opcode::host_information));
     REQUIRE(is_opcode_supported(Opcode::application_instance_information));
     REQUIRE(is_opcode_supported(Opcode::application_instance_status));
@@ -481,3 +497,658 @@ TEST_CASE("message send bad json", "[arcus]") {
 
     shutdown_client_server_test(objects);
 }
+
+TEST_CASE("live state delta", "[arcus]") {
+    const char *path = "live_state_delta.cap";
+    const unsigned int port = 19180;
+
+    REQUIRE(one_server_set_live_state_delta(nullptr, true) ==
+            ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    server.set_live_state_delta(true);
+    REQUIRE(!is_error(server.enable_capture(path, 1024 * 1024, 1)));
+
+    Client client;
+    client.set_live_state_delta(true);
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int updates = 0;
+    int players = 0;
+    int max_players = 0;
+    String name, map, mode, version;
+    client.set_live_state_callback(
+        [&](void *, int p, int m, const String &n, const String &ma, const String &mo,
+            const String &v) {
+            ++updates;
+            players = p;
+            max_players = m;
+            name = n;
+            map = ma;
+            mode = mo;
+            version = v;
+        },
+        nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+    // Let the features message arrive.
+    for_sleep(20, 5, [&]() {
+        server.update();
+        client.update();
+        return false;
+    });
+
+    Object additional_data;
+    REQUIRE(!is_error(additional_data.set_val_string("region", "eu")));
+    REQUIRE(!is_error(additional_data.set_val_int("tick", 60)));
+
+    // Full state, then only the player count and one additional key changes.
+    const int expected_updates[] = {1, 2, 3};
+    const int player_counts[] = {1, 2, 3};
+    for (int i = 0; i < 3; ++i) {
+        if (i == 2) {
+            REQUIRE(!is_error(additional_data.remove_key("region")));
+            REQUIRE(!is_error(additional_data.set_val_int("tick", 30)));
+        }
+        REQUIRE(!is_error(server.set_live_state(player_counts[i], 16, "name", "map",
+                                                "mode", "version", &additional_data)));
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return updates == expected_updates[i];
+        }));
+        REQUIRE(players == player_counts[i]);
+        REQUIRE(max_players == 16);
+        REQUIRE(name == "name");
+        REQUIRE(map == "map");
+        REQUIRE(mode == "mode");
+        REQUIRE(version == "version");
+    }
+    server.disable_capture();
+
+    CaptureReader reader;
+    REQUIRE(!is_error(reader.open(path)));
+    // Payloads point into the reader data, so they are copied.
+    std::vector<std::string> full;
+    std::vector<std::string> deltas;
+    while (true) {
+        CaptureRecord record;
+        bool is_end = false;
+        REQUIRE(!is_error(reader.read(record, is_end)));
+        if (is_end) {
+            break;
+        }
+        if (record.direction != CaptureDirection::outgoing) {
+            continue;
+        }
+        if (record.opcode == static_cast<char>(Opcode::live_state)) {
+            full.emplace_back(record.payload, record.length);
+        } else if (record.opcode == static_cast<char>(Opcode::live_state_delta)) {
+            deltas.emplace_back(record.payload, record.length);
+        }
+    }
+    reader.close();
+    std::remove(path);
+
+    REQUIRE(full.size() == 1);
+    REQUIRE(deltas.size() == 2);
+    REQUIRE(deltas[0] == "{\"players\":2}");
+    REQUIRE(deltas[1] == "{\"tick\":30,\"players\":3,\"removedKeys\":[\"region\"]}");
+    REQUIRE(deltas[1].size() < full[0].size());
+}
+
+TEST_CASE("live state coalescing", "[arcus]") {
+    const unsigned int port = 19181;
+
+    REQUIRE(one_server_set_min_send_interval(nullptr, 10) ==
+            ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+    REQUIRE(one_server_flush(nullptr) == ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int updates = 0;
+    int players = 0;
+    client.set_live_state_callback(
+        [&](void *, int p, int, const String &, const String &, const String &,
+            const String &) {
+            ++updates;
+            players = p;
+        },
+        nullptr);
+    int statuses = 0;
+    int status = 0;
+    client.set_application_instance_status_callback(
+        [&](void *, int s) {
+            ++statuses;
+            status = s;
+        },
+        nullptr);
+
+    auto pump = [&](int count) {
+        for_sleep(count, 2, [&]() {
+            server.update();
+            client.update();
+            return false;
+        });
+    };
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready && statuses == 1;
+    }));
+
+    // The first live state is sent right away, later ones are held back.
+    server.set_min_send_interval(60 * 1000);
+    REQUIRE(!is_error(server.set_live_state(1, 16, "name", "map", "mode", "version",
+                                            nullptr)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 1;
+    }));
+    for (int i = 2; i <= 10; ++i) {
+        REQUIRE(!is_error(server.set_live_state(i, 16, "name", "map", "mode",
+                                                "version", nullptr)));
+        REQUIRE(!is_error(server.set_application_instance_status(
+            (i % 2 == 0) ? Server::ApplicationInstanceStatus::online
+                         : Server::ApplicationInstanceStatus::allocated)));
+        pump(2);
+    }
+    pump(20);
+    REQUIRE(updates == 1);
+    REQUIRE(players == 1);
+    REQUIRE(statuses == 1);
+
+    // Flushing sends only the latest of the coalesced changes.
+    REQUIRE(!is_error(server.flush()));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 2 && statuses == 2;
+    }));
+    pump(20);
+    REQUIRE(updates == 2);
+    REQUIRE(players == 10);
+    REQUIRE(statuses == 2);
+    REQUIRE(status == static_cast<int>(Server::ApplicationInstanceStatus::online));
+
+    // Changes to the additional data alone are sent too.
+    server.set_min_send_interval(0);
+    Object additional_data;
+    REQUIRE(!is_error(additional_data.set_val_int("tick", 60)));
+    REQUIRE(!is_error(server.set_live_state(10, 16, "name", "map", "mode", "version",
+                                            &additional_data)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 3;
+    }));
+    REQUIRE(!is_error(additional_data.set_val_int("tick", 30)));
+    REQUIRE(!is_error(server.set_live_state(10, 16, "name", "map", "mode", "version",
+                                            &additional_data)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 4;
+    }));
+
+    // Setting the same state again sends nothing.
+    REQUIRE(!is_error(server.set_live_state(10, 16, "name", "map", "mode", "version",
+                                            &additional_data)));
+    pump(20);
+    REQUIRE(updates == 4);
+}
+
+TEST_CASE("live state field setters", "[arcus]") {
+    const unsigned int port = 19182;
+
+    REQUIRE(one_server_set_players(nullptr, 1) == ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+    REQUIRE(one_server_set_map(nullptr, "map") == ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+    REQUIRE(one_server_set_additional_data(nullptr, nullptr) ==
+            ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    auto s = reinterpret_cast<OneServerPtr>(&server);
+    REQUIRE(one_server_set_name(s, nullptr) == ONE_ERROR_VALIDATION_NAME_IS_NULLPTR);
+    REQUIRE(one_server_set_version(s, nullptr) ==
+            ONE_ERROR_VALIDATION_VERSION_IS_NULLPTR);
+    const std::string too_long(Server::max_live_state_string_length + 1, 'a');
+    REQUIRE(one_server_set_mode(s, too_long.c_str()) ==
+            ONE_ERROR_VALIDATION_STRING_IS_TOO_LONG);
+    // Only the per-field setters limit the length, the bulk setter never did.
+    REQUIRE(!is_error(server.set_live_state(1, 16, "name", too_long.c_str(), "mode",
+                                            "version", nullptr)));
+    const std::string longest(Server::max_live_state_string_length, 'a');
+    REQUIRE(!is_error(one_server_set_map(s, longest.c_str())));
+
+    int updates = 0;
+    int players = 0;
+    int max_players = 0;
+    String name, map, mode, version;
+    client.set_live_state_callback(
+        [&](void *, int p, int m, const String &n, const String &ma, const String &mo,
+            const String &v) {
+            ++updates;
+            players = p;
+            max_players = m;
+            name = n;
+            map = ma;
+            mode = mo;
+            version = v;
+        },
+        nullptr);
+
+    auto pump = [&](int count) {
+        for_sleep(count, 2, [&]() {
+            server.update();
+            client.update();
+            return false;
+        });
+    };
+
+    REQUIRE(!is_error(one_server_set_players(s, 4)));
+    REQUIRE(!is_error(one_server_set_max_players(s, 16)));
+    REQUIRE(!is_error(one_server_set_name(s, "name")));
+    REQUIRE(!is_error(one_server_set_mode(s, "mode")));
+    REQUIRE(!is_error(one_server_set_version(s, "version")));
+
+    // Fields set before the connection is ready are sent once it is.
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 1;
+    }));
+    REQUIRE(players == 4);
+    REQUIRE(max_players == 16);
+    REQUIRE(name == "name");
+    REQUIRE(map == longest.c_str());
+    REQUIRE(mode == "mode");
+    REQUIRE(version == "version");
+
+    // Changing one field sends it with the others unchanged.
+    REQUIRE(!is_error(one_server_set_players(s, 5)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 2;
+    }));
+    REQUIRE(players == 5);
+    REQUIRE(name == "name");
+
+    REQUIRE(!is_error(server.set_map("map")));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 3;
+    }));
+    REQUIRE(map == "map");
+    REQUIRE(players == 5);
+
+    // Setting unchanged values sends nothing, through either setter.
+    REQUIRE(!is_error(one_server_set_players(s, 5)));
+    REQUIRE(!is_error(server.set_live_state(5, 16, "name", "map", "mode", "version",
+                                            nullptr)));
+    pump(20);
+    REQUIRE(updates == 3);
+
+    Object additional_data;
+    REQUIRE(!is_error(additional_data.set_val_int("tick", 60)));
+    REQUIRE(!is_error(one_server_set_additional_data(
+        s, reinterpret_cast<OneObjectPtr>(&additional_data))));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 4;
+    }));
+    REQUIRE(!is_error(one_server_set_additional_data(s, nullptr)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 5;
+    }));
+
+    const std::string very_long(4 * Server::max_live_state_string_length, 'b');
+    REQUIRE(!is_error(one_server_set_live_state(s, 5, 16, "name", very_long.c_str(),
+                                                "mode", "version", nullptr)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 6;
+    }));
+    REQUIRE(map == very_long.c_str());
+    REQUIRE(name == "name");
+
+    // A short string replaces the long one.
+    REQUIRE(!is_error(server.set_map("map")));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return updates == 7;
+    }));
+    REQUIRE(map == "map");
+}
+
+TEST_CASE("connection options", "[arcus]") {
+    const unsigned int port = 19184;
+
+    ConnectionOptions invalid;
+    invalid.initial_stream_size = 1024;
+    invalid.max_stream_size = 512;
+    REQUIRE(!invalid.is_valid());
+    {
+        Server server;
+        REQUIRE(server.init(port, invalid) == ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+        Client client;
+        REQUIRE(client.init("127.0.0.1", port, invalid) ==
+                ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+    }
+
+    OneServerOptions c_options;
+    REQUIRE(one_server_default_options(nullptr) ==
+            ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.max_incoming_messages == ConnectionOptions().max_incoming_messages);
+    REQUIRE(c_options.max_stream_size == ConnectionOptions().max_stream_size);
+    OneServerPtr c_server = nullptr;
+    REQUIRE(one_server_create_with_options(port, nullptr, &c_server) ==
+            ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR);
+    c_options.max_outgoing_messages = 0;
+    REQUIRE(one_server_create_with_options(port, &c_options, &c_server) ==
+            ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+    REQUIRE(c_server == nullptr);
+
+    // Small streams grow to fit messages larger than their initial size.
+    ConnectionOptions options;
+    options.max_incoming_messages = 4;
+    options.max_outgoing_messages = 4;
+    options.initial_stream_size = 64;
+    options.max_stream_size = 8 * 1024;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port, options)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port, options)));
+
+    int received = 0;
+    client.set_reverse_metadata_callback([&](void *, Array *) { ++received; }, nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    Array data;
+    data.push_back_string(std::string(4 * 1024, 'a').c_str());
+    REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return received == 1;
+    }));
+
+    // Messages larger than the maximum stream size cannot be sent.
+    Array too_big;
+    too_big.push_back_string(std::string(16 * 1024, 'a').c_str());
+    REQUIRE(!is_error(server.send_reverse_metadata(&too_big)));
+    REQUIRE(server.update() == ONE_ERROR_CONNECTION_OUT_MESSAGE_TOO_BIG_FOR_STREAM);
+}
+
+TEST_CASE("flow control", "[arcus]") {
+    const unsigned int port = 19185;
+    constexpr int burst = 40;
+
+    ConnectionOptions options;
+    options.max_incoming_messages = 4;
+    options.max_outgoing_messages = 4;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port, options)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int commands = 0;
+    server.set_custom_command_callback([&](void *, Array *) { ++commands; }, nullptr);
+    int metadata = 0;
+    client.set_reverse_metadata_callback([&](void *, Array *) { ++metadata; }, nullptr);
+    int writable = 0;
+    REQUIRE(server.set_writable_callback(nullptr, nullptr) ==
+            ONE_ERROR_SERVER_CALLBACK_IS_NULLPTR);
+    REQUIRE(
+        !is_error(server.set_writable_callback([&](void *) { ++writable; }, nullptr)));
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    // A burst larger than the incoming queue pauses reading instead of
+    // dropping the connection.
+    Array command;
+    command.push_back_int(1);
+    for (int i = 0; i < burst; ++i) {
+        REQUIRE(!is_error(client.send_custom_command(command)));
+    }
+    REQUIRE(!is_error(client.update()));
+
+    bool was_paused = false;
+    REQUIRE(wait_until(2000, [&]() {
+        REQUIRE(!is_error(server.update()));
+        QueuePressure pressure;
+        REQUIRE(!is_error(server.queue_pressure(pressure)));
+        REQUIRE(pressure.incoming_capacity == 4);
+        was_paused = was_paused || pressure.is_reading_paused;
+        client.update();
+        return commands == burst;
+    }));
+    REQUIRE(was_paused);
+    REQUIRE(server.status() == Server::Status::ready);
+
+    // Sends fail once the outgoing class is full, and the writable callback
+    // is invoked once it has drained.
+    Array data;
+    data.push_back_int(1);
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+    }
+    REQUIRE(server.send_reverse_metadata(&data) ==
+            ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE);
+
+    OneQueuePressure c_pressure;
+    auto c_server = reinterpret_cast<OneServerPtr>(&server);
+    REQUIRE(one_server_queue_pressure(c_server, nullptr) ==
+            ONE_ERROR_VALIDATION_QUEUE_PRESSURE_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_queue_pressure(c_server, &c_pressure)));
+    REQUIRE(c_pressure.outgoing_bulk == 4);
+    REQUIRE(c_pressure.outgoing_capacity == 4);
+
+    REQUIRE(writable == 0);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return writable == 1 && metadata == 4;
+    }));
+    REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return metadata == 5;
+    }));
+    REQUIRE(writable == 1);
+}
+
+TEST_CASE("memory footprint", "[arcus]") {
+    const unsigned int port = 19186;
+    constexpr size_t target = 32 * 1024;
+
+    const auto options = ConnectionOptions::small_footprint();
+    REQUIRE(options.is_valid());
+
+    Server server;
+    MemoryFootprint footprint;
+    REQUIRE(server.memory_footprint(footprint) ==
+            ONE_ERROR_SERVER_SOCKET_NOT_INITIALIZED);
+    REQUIRE(!is_error(server.init(port, options)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port, options)));
+
+    // Queues and state are only allocated once used.
+    REQUIRE(!is_error(server.memory_footprint(footprint)));
+    REQUIRE(footprint.streams == 2 * options.initial_stream_size);
+    REQUIRE(footprint.queues == 0);
+    REQUIRE(footprint.messages == 0);
+    REQUIRE(footprint.state == 0);
+    REQUIRE(footprint.total() < target);
+
+    int players = 0;
+    client.set_live_state_callback(
+        [&](void *, int p, int, const String &, const String &, const String &,
+            const String &) { players = p; },
+        nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    Object additional_data;
+    additional_data.set_val_string("region", "a region name that is not short");
+    REQUIRE(!is_error(server.set_live_state(4, 16, "name", "map", "mode", "version",
+                                            &additional_data)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return players == 4;
+    }));
+
+    REQUIRE(!is_error(server.memory_footprint(footprint)));
+    REQUIRE(footprint.queues > 0);
+    REQUIRE(footprint.state > 0);
+    REQUIRE(footprint.total() ==
+            footprint.instance + footprint.streams + footprint.queues +
+                footprint.messages + footprint.state);
+    REQUIRE(footprint.total() < target);
+
+    REQUIRE(!is_error(client.memory_footprint(footprint)));
+    REQUIRE(footprint.total() < target);
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_small_footprint_options(&c_options)));
+    REQUIRE(c_options.initial_stream_size == options.initial_stream_size);
+    OneMemoryFootprint c_footprint;
+    auto c_server = reinterpret_cast<OneServerPtr>(&server);
+    REQUIRE(one_server_memory_footprint(c_server, nullptr) ==
+            ONE_ERROR_VALIDATION_FOOTPRINT_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_memory_footprint(c_server, &c_footprint)));
+    REQUIRE(c_footprint.total > 0);
+    REQUIRE(c_footprint.total < target);
+}
+
+namespace {
+
+// Small inline streams and queues, without health checks or capturing.
+struct MinimalConnectionPolicy : DefaultConnectionPolicy {
+    static constexpr size_t max_messages = 4;
+    static constexpr size_t stream_send_buffer_size = 1024;
+    static constexpr size_t stream_receive_buffer_size = 1024;
+    static constexpr bool is_storage_inline = true;
+    static constexpr bool is_health_enabled = false;
+    static constexpr bool is_capture_enabled = false;
+};
+
+using MinimalConnection = BasicConnection<MinimalConnectionPolicy>;
+
+}  // namespace
+
+TEST_CASE("connection policy", "[arcus]") {
+    init_socket_system();
+    Socket server;
+    Socket out_client;
+    Socket in_client;
+    unsigned int server_port;
+    listen(server, server_port);
+    connect(out_client, server_port);
+    accept(server, in_client);
+
+    // The storage is part of the connection, nothing is allocated for it.
+    allocator::set_tracking(true);
+    MinimalConnection server_connection(MinimalConnection::max_message_default,
+                                        MinimalConnection::max_message_default);
+    server_connection.init(in_client);
+    MinimalConnection client_connection(ConnectionOptions{});
+    client_connection.init(out_client);
+    allocator::set_tracking(false);
+    allocator::Statistics statistics;
+    allocator::statistics(allocator::Category::connection, statistics);
+    REQUIRE(statistics.allocations == 0);
+    REQUIRE(server_connection.outgoing_capacity() == 4);
+    REQUIRE(client_connection.incoming_capacity() == 4);
+    REQUIRE(sizeof(MinimalConnection) > 2 * 1024 + 4 * 4 * sizeof(Message));
+    MemoryFootprint footprint;
+    server_connection.footprint(footprint);
+    REQUIRE(footprint.instance == sizeof(MinimalConnection));
+    REQUIRE(footprint.streams == 0);
+    REQUIRE(footprint.queues == 0);
+
+    const char *capture_path = "connection_policy.cap";
+    CaptureWriter capture;
+    REQUIRE(!is_error(capture.open(capture_path)));
+    client_connection.set_capture(&capture);
+
+    server_connection.initiate_handshake();
+    for_sleep(10, 1, [&]() {
+        REQUIRE(!is_error(server_connection.update()));
+        REQUIRE(!is_error(client_connection.update()));
+        return server_connection.status() == MinimalConnection::Status::ready &&
+               client_connection.status() == MinimalConnection::Status::ready;
+    });
+    REQUIRE(server_connection.status() == MinimalConnection::Status::ready);
+    REQUIRE(client_connection.status() == MinimalConnection::Status::ready);
+
+    Message message;
+    messages::prepare_soft_stop(1000, message);
+    REQUIRE(!is_error(client_connection.add_outgoing(message)));
+    unsigned int count = 0;
+    for_sleep(10, 1, [&]() {
+        REQUIRE(!is_error(server_connection.update()));
+        REQUIRE(!is_error(client_connection.update()));
+        REQUIRE(!is_error(server_connection.incoming_count(count)));
+        return count == 1;
+    });
+    REQUIRE(count == 1);
+    auto err = server_connection.remove_incoming([](const Message &message) {
+        REQUIRE(message.code() == Opcode::soft_stop);
+        return ONE_ERROR_NONE;
+    });
+    REQUIRE(!is_error(err));
+
+    // Capturing is compiled out.
+    REQUIRE(capture.records_written() == 0);
+    capture.close();
+    std::remove(capture_path);
+
+    server.close();
+    out_client.close();
+    in_client.close();
+    shutdown_socket_system();
+}
@@ -0,0 +1,271 @@
+#include <catch.hpp>
+#include <tests/one/arcus/util.h>
+
+#include <one/arcus/c_api.h>
+#include <one/arcus/client.h>
+#include <one/arcus/internal/capture.h>
+#include <one/arcus/internal/codec.h>
+#include <one/arcus/opcode.h>
+#include <one/arcus/server.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace i3d::one;
+
+namespace {
+
+codec::Header make_header(Opcode opcode, uint32_t packet_id, size_t length) {
+    codec::Header header{};
+    header.opcode = static_cast<char>(opcode);
+    header.packet_id = packet_id;
+    header.length = static_cast<uint32_t>(length);
+    return header;
+}
+
+std::vector<CaptureRecord> read_all(CaptureReader &reader) {
+    std::vector<CaptureRecord> records;
+    while (true) {
+        CaptureRecord record;
+        bool is_end = false;
+        REQUIRE(!is_error(reader.read(record, is_end)));
+        if (is_end) break;
+        records.push_back(record);
+    }
+    return records;
+}
+
+bool file_exists(const std::string &path) {
+    std::ifstream file(path.c_str());
+    return file.good();
+}
+
+}  // namespace
+
+TEST_CASE("capture write and read", "[capture]") {
+    const char *path = "capture_roundtrip.cap";
+
+    CaptureWriter writer;
+    REQUIRE(writer.write(CaptureDirection::incoming, make_header(Opcode::hello, 0, 0),
+                         nullptr) == ONE_ERROR_CAPTURE_NOT_OPEN);
+    REQUIRE(writer.open(nullptr) == ONE_ERROR_VALIDATION_PATH_IS_NULLPTR);
+    REQUIRE(!is_error(writer.open(path)));
+    REQUIRE(writer.open(path) == ONE_ERROR_CAPTURE_ALREADY_OPEN);
+
+    const std::string payload = "{\"timeout\":1000}";  // Not a multiple of 8.
+    REQUIRE(!is_error(writer.write(CaptureDirection::outgoing,
+                                   make_header(Opcode::hello, 0, 0), nullptr)));
+    REQUIRE(!is_error(writer.write(CaptureDirection::incoming,
+                                   make_header(Opcode::soft_stop, 7, payload.size()),
+                                   payload.data())));
+    REQUIRE(!is_error(writer.write(CaptureDirection::outgoing,
+                                   make_header(Opcode::live_state, 8, payload.size()),
+                                   payload.data())));
+    REQUIRE(writer.records_written() == 3);
+    writer.close();
+
+    CaptureReader reader;
+    REQUIRE(reader.open("capture_does_not_exist.cap") == ONE_ERROR_CAPTURE_OPEN_FAILED);
+    REQUIRE(!is_error(reader.open(path)));
+    REQUIRE(reader.wall_clock_ns() > 0);
+
+    auto records = read_all(reader);
+    REQUIRE(records.size() == 3);
+    REQUIRE(!reader.is_truncated());
+
+    REQUIRE(records[0].direction == CaptureDirection::outgoing);
+    REQUIRE(records[0].opcode == static_cast<char>(Opcode::hello));
+    REQUIRE(records[0].length == 0);
+
+    REQUIRE(records[1].direction == CaptureDirection::incoming);
+    REQUIRE(records[1].opcode == static_cast<char>(Opcode::soft_stop));
+    REQUIRE(records[1].packet_id == 7);
+    REQUIRE(std::string(records[1].payload, records[1].length) == payload);
+
+    REQUIRE(records[2].direction == CaptureDirection::outgoing);
+    REQUIRE(records[2].packet_id == 8);
+    REQUIRE(std::string(records[2].payload, records[2].length) == payload);
+    REQUIRE(records[0].timestamp_ns <= records[1].timestamp_ns);
+    REQUIRE(records[1].timestamp_ns <= records[2].timestamp_ns);
+
+    // Records start on aligned offsets.
+    REQUIRE(reinterpret_cast<uintptr_t>(records[2].payload) % capture::record_alignment ==
+            reinterpret_cast<uintptr_t>(records[1].payload) % capture::record_alignment);
+
+    reader.rewind();
+    REQUIRE(read_all(reader).size() == 3);
+    reader.close();
+
+    std::remove(path);
+}
+
+TEST_CASE("capture truncated and invalid files", "[capture]") {
+    const char *path = "capture_truncated.cap";
+    const char *cut_path = "capture_truncated_cut.cap";
+
+    const std::string payload(100, 'x');
+    {
+        CaptureWriter writer;
+        REQUIRE(!is_error(writer.open(path)));
+        for (uint32_t i = 0; i < 3; ++i) {
+            REQUIRE(!is_error(writer.write(CaptureDirection::outgoing,
+                                           make_header(Opcode::live_state, i, payload.size()),
+                                           payload.data())));
+        }
+    }
+
+    // Copy all but the last few bytes, as if the process died mid-write.
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+        std::ofstream out(cut_path, std::ios::binary);
+        out.write(data.data(), data.size() - 10);
+    }
+
+    CaptureReader reader;
+    REQUIRE(!is_error(reader.open(cut_path)));
+    REQUIRE(read_all(reader).size() == 2);
+    REQUIRE(reader.is_truncated());
+    reader.close();
+
+    // Not a capture.
+    {
+        std::ofstream out(cut_path, std::ios::binary);
+        const std::string text(64, 'a');
+        out.write(text.data(), text.size());
+    }
+    REQUIRE(reader.open(cut_path) == ONE_ERROR_CAPTURE_INVALID_FILE);
+
+    std::remove(path);
+    std::remove(cut_path);
+}
+
+TEST_CASE("capture rotation", "[capture]") {
+    const std::string path = "capture_rotation.cap";
+    const size_t max_files = 3;
+    const std::string payload(200, 'x');
+    const size_t record_size = capture::record_header_size + payload.size();
+    // Room for two records per file.
+    const size_t max_file_size = capture::file_header_size + record_size * 2;
+
+    {
+        CaptureWriter writer;
+        REQUIRE(!is_error(writer.open(path.c_str(), max_file_size, max_files)));
+        for (uint32_t i = 0; i < 9; ++i) {
+            REQUIRE(!is_error(writer.write(CaptureDirection::outgoing,
+                                           make_header(Opcode::live_state, i, payload.size()),
+                                           payload.data())));
+        }
+    }
+
+    // 9 records, 2 per file: the oldest files were dropped.
+    REQUIRE(file_exists(path));
+    REQUIRE(file_exists(path + ".1"));
+    REQUIRE(file_exists(path + ".2"));
+    REQUIRE(!file_exists(path + ".3"));
+
+    // Oldest to newest.
+    const std::vector<std::string> files = {path + ".2", path + ".1", path};
+    std::vector<uint32_t> packet_ids;
+    for (auto &file : files) {
+        CaptureReader reader;
+        REQUIRE(!is_error(reader.open(file.c_str())));
+        for (auto &record : read_all(reader)) {
+            packet_ids.push_back(record.packet_id);
+        }
+    }
+    REQUIRE(packet_ids == std::vector<uint32_t>({4, 5, 6, 7, 8}));
+
+    for (auto &file : files) {
+        std::remove(file.c_str());
+    }
+}
+
+TEST_CASE("capture server and client traffic", "[capture]") {
+    const char *server_path = "capture_server.cap";
+    const char *client_path = "capture_client.cap";
+    const unsigned int port = 19130;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    REQUIRE(server.enable_capture(nullptr, 1024, 1) == ONE_ERROR_VALIDATION_PATH_IS_NULLPTR);
+    REQUIRE(!is_error(server.enable_capture(server_path, 1024 * 1024, 1)));
+    REQUIRE(server.enable_capture(server_path, 1024 * 1024, 1) ==
+            ONE_ERROR_CAPTURE_ALREADY_OPEN);
+
+    Client client;
+    REQUIRE(!is_error(client.enable_capture(client_path, 1024 * 1024, 1)));
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int players = 0;
+    client.set_live_state_callback(
+        [&](void *, int p, int, const String &, const String &, const String &,
+            const String &) { players = p; },
+        nullptr);
+
+    REQUIRE(!is_error(server.set_live_state(5, 10, "name", "map", "mode", "version",
+                                            nullptr)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return players == 5;
+    }));
+
+    server.disable_capture();
+    client.disable_capture();
+
+    auto find = [](const std::vector<CaptureRecord> &records, CaptureDirection direction,
+                   Opcode opcode) -> const CaptureRecord * {
+        for (auto &record : records) {
+            if (record.direction == direction &&
+                record.opcode == static_cast<char>(opcode)) {
+                return &record;
+            }
+        }
+        return nullptr;
+    };
+
+    CaptureReader server_reader;
+    REQUIRE(!is_error(server_reader.open(server_path)));
+    auto server_records = read_all(server_reader);
+    REQUIRE(find(server_records, CaptureDirection::incoming, Opcode::hello) != nullptr);
+    auto sent = find(server_records, CaptureDirection::outgoing, Opcode::live_state);
+    REQUIRE(sent != nullptr);
+
+    CaptureReader client_reader;
+    REQUIRE(!is_error(client_reader.open(client_path)));
+    auto client_records = read_all(client_reader);
+    REQUIRE(find(client_records, CaptureDirection::outgoing, Opcode::hello) != nullptr);
+    auto received = find(client_records, CaptureDirection::incoming, Opcode::live_state);
+    REQUIRE(received != nullptr);
+
+    REQUIRE(sent->packet_id == received->packet_id);
+    REQUIRE(std::string(sent->payload, sent->length) ==
+            std::string(received->payload, received->length));
+
+    server_reader.close();
+    client_reader.close();
+    std::remove(server_path);
+    std::remove(client_path);
+}
+
+TEST_CASE("capture c api", "[capture]") {
+    REQUIRE(one_server_enable_capture(nullptr, "capture_api.cap", 1024, 1) ==
+            ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+    REQUIRE(one_server_disable_capture(nullptr) == ONE_ERROR_VALIDATION_SERVER_IS_NULLPTR);
+
+    OneServerPtr server = nullptr;
+    REQUIRE(!one_is_error(one_server_create(19131, &server)));
+    REQUIRE(!one_is_error(one_server_enable_capture(server, "capture_api.cap", 1024, 1)));
+    REQUIRE(!one_is_error(one_server_disable_capture(server)));
+    one_server_destroy(server);
+
+    CaptureReader reader;
+    REQUIRE(!is_error(reader.open("capture_api.cap")));
+    reader.close();
+    std::remove("capture_api.cap");
+}
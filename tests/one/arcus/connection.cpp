@@ -1,12 +1,29 @@
 #include <catch.hpp>
 #include <tests/one/arcus/util.h>
 
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <one/fake/arcus/agent/agent.h>
+#include <one/arcus/array.h>
+#include <one/arcus/c_api.h>
 #include <one/arcus/c_error.h>
+#include <one/arcus/client.h>
+#include <one/arcus/internal/codec.h>
+#include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/connection_impl.h>
+#include <one/arcus/internal/health.h>
+#include <one/arcus/internal/loopback.h>
+#include <one/arcus/internal/messages.h>
+#include <one/arcus/internal/socket.h>
+#include <one/arcus/internal/time.h>
+#include <one/arcus/message.h>
+#include <one/arcus/server.h>
 #include <one/fake/arcus/game/log.h>
 #include <one/fake/arcus/game/game.h>
 #include <one/fake/arcus/game/one_server_wrapper.h>
@@ -135,3 +152,574 @@ TEST_CASE("connect:multiple agents connecting to multiple games", "[concurrency]
         delete game;
     }
 }
+
+TEST_CASE("health checking", "[arcus]") {
+    // Timers are not rounded to seconds.
+    IntervalTimer timer(milliseconds(50));
+    timer.sync_now();
+    REQUIRE(!timer.update());
+    sleep(60);
+    REQUIRE(timer.update());
+    REQUIRE(!timer.update());
+
+    HealthOptions invalid;
+    invalid.send_interval_ms = 0;
+    REQUIRE(!invalid.is_valid());
+    invalid = HealthOptions();
+    invalid.min_receive_timeout_ms = invalid.receive_timeout_ms + 1;
+    REQUIRE(!invalid.is_valid());
+    REQUIRE(HealthOptions::fast_failover().is_valid());
+
+    // A health message is only sent when nothing else was sent for the
+    // interval.
+    HealthOptions options;
+    options.send_interval_ms = 100;
+    HealthChecker sending(options);
+    int sent = 0;
+    auto sender = [&](const Message &message) {
+        REQUIRE(message.code() == Opcode::health);
+        ++sent;
+        return ONE_ERROR_NONE;
+    };
+    for (int i = 0; i < 5; ++i) {
+        sleep(40);
+        sending.reset_send_timer();
+        REQUIRE(!is_error(sending.process_send(sender)));
+    }
+    REQUIRE(sent == 0);
+    sleep(110);
+    REQUIRE(!is_error(sending.process_send(sender)));
+    REQUIRE(sent == 1);
+
+    // The receive timeout adapts to the interval between health messages,
+    // bounded by the options.
+    options.receive_timeout_ms = 10000;
+    options.min_receive_timeout_ms = 100;
+    options.is_adaptive = true;
+    HealthChecker receiving(options);
+    REQUIRE(receiving.receive_timeout() == milliseconds(10000));
+    for (int i = 0; i < 3; ++i) {
+        sleep(20);
+        receiving.reset_receive_timer(false);
+        REQUIRE(receiving.receive_timeout() == milliseconds(10000));
+        sleep(20);
+        receiving.reset_receive_timer(true);
+    }
+    REQUIRE(receiving.receive_timeout() >= milliseconds(120));
+    REQUIRE(receiving.receive_timeout() < milliseconds(10000));
+    REQUIRE(!receiving.process_receive());
+    receiving.reset();
+    REQUIRE(receiving.receive_timeout() == milliseconds(10000));
+
+    // The C API sets the profile.
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.health_send_interval_ms == 5000);
+    REQUIRE(c_options.health_receive_timeout_ms == 20000);
+    REQUIRE(!c_options.health_adaptive);
+    REQUIRE(one_server_fast_failover_options(nullptr) ==
+            ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_fast_failover_options(&c_options)));
+    REQUIRE(c_options.health_send_interval_ms == 250);
+    REQUIRE(c_options.health_receive_timeout_ms == 1000);
+    REQUIRE(c_options.health_adaptive);
+
+    // With the profile on both ends, a peer that stops responding is detected
+    // within a second.
+    ConnectionOptions connection_options;
+    connection_options.health = HealthOptions::fast_failover();
+    LoopbackPipe pipe;
+    REQUIRE(!is_error(pipe.init()));
+    Connection server(connection_options);
+    server.init(pipe.first());
+    Connection client(connection_options);
+    client.init(pipe.second());
+    server.initiate_handshake();
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Connection::Status::ready &&
+               client.status() == Connection::Status::ready;
+    }));
+
+    // Idle, the connection is kept alive by health messages alone.
+    const auto idle = steady_clock::now();
+    while (steady_clock::now() - idle < milliseconds(1500)) {
+        REQUIRE(!is_error(server.update()));
+        REQUIRE(!is_error(client.update()));
+        sleep(10);
+    }
+    REQUIRE(server.status() == Connection::Status::ready);
+
+    const auto stopped = steady_clock::now();
+    OneError err = ONE_ERROR_NONE;
+    REQUIRE(wait_until(2000, [&]() {
+        err = server.update();
+        return is_error(err);
+    }));
+    REQUIRE(err == ONE_ERROR_CONNECTION_HEALTH_TIMEOUT);
+    REQUIRE(steady_clock::now() - stopped <= milliseconds(1100));
+}
+
+TEST_CASE("kernel liveness", "[arcus]") {
+    const unsigned int port = 19191;
+
+    HealthOptions health;
+    health.liveness = Liveness::kernel;
+    ConnectionOptions options;
+    options.health = health;
+    auto socket_options = options.applied_socket_options(Liveness::kernel);
+    REQUIRE(socket_options.is_keepalive_enabled);
+    REQUIRE(socket_options.keepalive_idle_seconds == 5);
+    REQUIRE(socket_options.keepalive_interval_seconds == 5);
+    REQUIRE(socket_options.keepalive_count == 3);
+    REQUIRE(socket_options.user_timeout_ms == 20000);
+    // Until agreed with the peer, only the socket options apply.
+    REQUIRE(!options.applied_socket_options(Liveness::health_messages)
+                 .is_keepalive_enabled);
+#ifdef __linux__
+    REQUIRE(Socket::is_supported(socket_options));
+#endif
+
+    // Kernel liveness is used only if requested by both ends, the receive
+    // timeout then no longer applying.
+    auto connect = [](Liveness initiator, Liveness responder,
+                      std::function<void(Connection &, Connection &)> check) {
+        ConnectionOptions options;
+        options.health = HealthOptions::fast_failover();
+        options.health.liveness = initiator;
+        LoopbackPipe pipe;
+        REQUIRE(!is_error(pipe.init()));
+        Connection server(options);
+        server.init(pipe.first());
+        options.health.liveness = responder;
+        Connection client(options);
+        client.init(pipe.second());
+        server.initiate_handshake();
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return server.status() == Connection::Status::ready &&
+                   client.status() == Connection::Status::ready;
+        }));
+        check(server, client);
+    };
+    connect(Liveness::kernel, Liveness::kernel,
+            [](Connection &server, Connection &client) {
+                REQUIRE(server.liveness() == Liveness::kernel);
+                REQUIRE(client.liveness() == Liveness::kernel);
+                const auto start = steady_clock::now();
+                while (steady_clock::now() - start < milliseconds(1500)) {
+                    REQUIRE(!is_error(server.update()));
+                    sleep(10);
+                }
+                REQUIRE(!is_error(client.update()));
+            });
+    connect(Liveness::kernel, Liveness::health_messages,
+            [](Connection &server, Connection &client) {
+                REQUIRE(server.liveness() == Liveness::health_messages);
+                REQUIRE(client.liveness() == Liveness::health_messages);
+            });
+    connect(Liveness::health_messages, Liveness::kernel,
+            [](Connection &server, Connection &client) {
+                REQUIRE(server.liveness() == Liveness::health_messages);
+                REQUIRE(client.liveness() == Liveness::health_messages);
+                REQUIRE(wait_until(2000, [&]() {
+                    return server.update() == ONE_ERROR_CONNECTION_HEALTH_TIMEOUT;
+                }));
+            });
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(!c_options.kernel_liveness);
+    c_options.kernel_liveness = true;
+    OneServerPtr c_server = nullptr;
+#ifdef __linux__
+    REQUIRE(!is_error(one_server_create_with_options(port, &c_options, &c_server)));
+    one_server_destroy(c_server);
+
+    // Over TCP, with the socket options applied on both ends.
+    Server server;
+    REQUIRE(!is_error(server.init(port, options)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port, options)));
+    int timeout = 0;
+    server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+    REQUIRE(!is_error(client.send_soft_stop(1000)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return timeout == 1000;
+    }));
+    client.shutdown();
+    server.shutdown();
+#else
+    REQUIRE(one_server_create_with_options(port, &c_options, &c_server) ==
+            ONE_ERROR_SOCKET_OPTION_UNSUPPORTED);
+#endif
+}
+
+TEST_CASE("session resumption", "[arcus]") {
+    ConnectionOptions options;
+    options.session_replay_size = 1024;
+    REQUIRE(options.is_valid());
+    ConnectionOptions invalid;
+    invalid.session_replay_size = invalid.max_stream_size;
+    REQUIRE(!invalid.is_valid());
+
+    LoopbackPipe pipe;
+    auto connect = [&](Connection &server, Connection &client) {
+        REQUIRE(!is_error(pipe.init()));
+        server.init(pipe.first());
+        client.init(pipe.second());
+        server.initiate_handshake();
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return server.status() == Connection::Status::ready &&
+                   client.status() == Connection::Status::ready;
+        }));
+    };
+    // Drops the connection, with the bytes in flight.
+    auto drop = [&](Connection &server, Connection &client) {
+        pipe.shutdown();
+        server.suspend();
+        client.suspend();
+    };
+    auto send = [](Connection &connection, int first, int last) {
+        for (int i = first; i <= last; ++i) {
+            Message message;
+            REQUIRE(!is_error(messages::prepare_soft_stop(i, message)));
+            REQUIRE(!is_error(connection.add_outgoing(message)));
+        }
+    };
+    // Returns the soft stop timeouts received.
+    auto receive = [](Connection &connection) {
+        std::vector<int> timeouts;
+        unsigned int count = 0;
+        while (!is_error(connection.incoming_count(count)) && count > 0) {
+            connection.remove_incoming([&](const Message &message) {
+                int timeout = 0;
+                message.payload().val_int("timeout", timeout);
+                timeouts.push_back(timeout);
+                return ONE_ERROR_NONE;
+            });
+        }
+        return timeouts;
+    };
+
+    Connection server(options);
+    Connection client(options);
+    connect(server, client);
+    REQUIRE(!server.is_resumed());
+    REQUIRE(!client.is_resumed());
+
+    // Messages received before the drop are not sent again, those in flight
+    // are, in both directions.
+    send(server, 1, 3);
+    server.update();
+    client.update();
+    REQUIRE(receive(client) == std::vector<int>{1, 2, 3});
+    send(server, 4, 5);
+    send(client, 10, 11);
+    server.update();
+    client.update();
+    drop(server, client);
+
+    connect(server, client);
+    REQUIRE(server.is_resumed());
+    REQUIRE(client.is_resumed());
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        unsigned int client_count = 0;
+        client.incoming_count(client_count);
+        unsigned int server_count = 0;
+        server.incoming_count(server_count);
+        return client_count == 2 && server_count == 2;
+    }));
+    REQUIRE(receive(client) == std::vector<int>{4, 5});
+    REQUIRE(receive(server) == std::vector<int>{10, 11});
+
+    // More than kept by the replay, the session starts over.
+    send(server, 100, 140);
+    for (int i = 0; i < 10; ++i) {
+        server.update();
+    }
+    drop(server, client);
+    connect(server, client);
+    REQUIRE(!server.is_resumed());
+    REQUIRE(!client.is_resumed());
+
+    // A peer without the session, e.g. after a restart, starts a new one.
+    server.update();
+    client.update();
+    receive(client);
+    drop(server, client);
+    Connection restarted(options);
+    connect(server, restarted);
+    REQUIRE(!server.is_resumed());
+    REQUIRE(!restarted.is_resumed());
+    send(server, 7, 7);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        restarted.update();
+        unsigned int count = 0;
+        restarted.incoming_count(count);
+        return count == 1;
+    }));
+    REQUIRE(receive(restarted) == std::vector<int>{7});
+
+    // Without the session on both ends, nothing is resumed and nothing kept.
+    drop(server, restarted);
+    Connection disabled(ConnectionOptions{});
+    connect(server, disabled);
+    REQUIRE(!server.is_resumed());
+    send(disabled, 20, 20);
+    disabled.update();
+    disabled.suspend();
+    REQUIRE(disabled.status() == Connection::Status::uninitialized);
+    unsigned int count = 0;
+    REQUIRE(disabled.incoming_count(count) == ONE_ERROR_CONNECTION_UNINITIALIZED);
+    REQUIRE(disabled.outgoing_count(Priority::bulk) == 0);
+    pipe.shutdown();
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.session_replay_size == 0);
+}
+
+TEST_CASE("session restarted by a new client", "[arcus]") {
+    const unsigned int port = 19193;
+
+    // Small socket buffers, so that a large message keeps those after it queued.
+    ConnectionOptions options;
+    options.session_replay_size = 1024;
+    options.socket.send_buffer_size = 4096;
+    options.socket.receive_buffer_size = 4096;
+
+    Server server;
+    server.set_live_state_delta(true);
+    REQUIRE(!is_error(server.init(port, options)));
+    REQUIRE(!is_error(server.set_live_state(1, 16, "name", "map", "mode", "version",
+                                            nullptr)));
+
+    // Connects the client and waits until it received the players count.
+    int players = 0;
+    auto connect = [&](Client &client, int expected) {
+        client.set_live_state_delta(true);
+        REQUIRE(!is_error(client.init("127.0.0.1", port, options)));
+        REQUIRE(!is_error(client.set_live_state_callback(
+            [&](void *, int p, int, const String &, const String &, const String &,
+                const String &) { players = p; },
+            nullptr)));
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            REQUIRE(!is_error(client.update()));
+            return players == expected;
+        }));
+    };
+
+    {
+        Client client;
+        connect(client, 1);
+        REQUIRE(!is_error(server.set_players(2)));
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            REQUIRE(!is_error(client.update()));
+            return players == 2;
+        }));
+
+        // A delta stays queued behind a message the client does not read.
+        Array data;
+        data.push_back_string(std::string(100 * 1024, 'a').c_str());
+        REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+        REQUIRE(!is_error(server.update()));
+        REQUIRE(!is_error(server.set_players(3)));
+        REQUIRE(!is_error(server.update()));
+        QueuePressure pressure;
+        REQUIRE(!is_error(server.queue_pressure(pressure)));
+        REQUIRE(pressure.outgoing[static_cast<int>(Priority::state)] == 1);
+        client.shutdown();
+    }
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        return server.status() != Server::Status::ready;
+    }));
+
+    // The restarted client has no session and gets the whole live state, not
+    // the delta queued for the previous one.
+    Client restarted;
+    players = 0;
+    connect(restarted, 3);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(!is_error(server.update()));
+        REQUIRE(!is_error(restarted.update()));
+    }
+    REQUIRE(restarted.status() == Client::Status::ready);
+    restarted.shutdown();
+    server.shutdown();
+}
+
+TEST_CASE("handshake with older peers", "[arcus]") {
+    // Peers predating the features compare the whole Hello and the whole hello
+    // reply, and skip the offer as a health message. Both ends then fall back
+    // to no features.
+    ConnectionOptions options;
+    options.health.liveness = Liveness::kernel;
+    options.session_replay_size = 1024;
+
+    LoopbackPipe pipe;
+    REQUIRE(!is_error(pipe.init()));
+    auto &older = pipe.second();
+    size_t size = 0;
+
+    // An older responder sends the plain hello reply.
+    {
+        Connection initiator(options);
+        initiator.init(pipe.first());
+        initiator.initiate_handshake();
+        codec::Hello hello{};
+        REQUIRE(wait_until(2000, [&]() {
+            REQUIRE(!is_error(initiator.update()));
+            REQUIRE(!is_error(older.receive(&hello, codec::hello_size(), size)));
+            return size > 0;
+        }));
+        REQUIRE(size == codec::hello_size());
+        REQUIRE(codec::validate_hello(hello));
+
+        const auto &reply = connection::hello_message();
+        REQUIRE(!is_error(older.send(&reply, codec::header_size(), size)));
+        REQUIRE(wait_until(2000, [&]() {
+            REQUIRE(!is_error(initiator.update()));
+            return initiator.status() == Connection::Status::ready;
+        }));
+        REQUIRE(initiator.liveness() == Liveness::health_messages);
+        REQUIRE(!initiator.is_resumed());
+
+        codec::Header offer{};
+        REQUIRE(!is_error(older.receive(&offer, codec::header_size(), size)));
+        REQUIRE(size == codec::header_size());
+        REQUIRE(offer.opcode == static_cast<char>(Opcode::health));
+        REQUIRE(offer.reserved[0] ==
+                (codec::feature_kernel_liveness | codec::feature_session));
+    }
+    pipe.shutdown();
+
+    // An older initiator gets the plain reply once no offer followed its Hello.
+    {
+        REQUIRE(!is_error(pipe.init()));
+        Connection responder(options);
+        responder.init(pipe.first());
+        const auto &hello = codec::valid_hello();
+        REQUIRE(!is_error(older.send(&hello, codec::hello_size(), size)));
+        const auto start = steady_clock::now();
+        codec::Header reply{};
+        REQUIRE(wait_until(2000, [&]() {
+            REQUIRE(!is_error(responder.update()));
+            REQUIRE(!is_error(older.receive(&reply, codec::header_size(), size)));
+            return size > 0;
+        }));
+        const int wait_ms = DefaultConnectionPolicy::feature_offer_wait_ms;
+        REQUIRE(steady_clock::now() - start >= milliseconds(wait_ms));
+        REQUIRE(size == codec::header_size());
+        REQUIRE(std::memcmp(&reply, &connection::hello_message(),
+                            codec::header_size()) == 0);
+        REQUIRE(responder.status() == Connection::Status::ready);
+        REQUIRE(responder.liveness() == Liveness::health_messages);
+        REQUIRE(!responder.is_resumed());
+    }
+    pipe.shutdown();
+}
+
+TEST_CASE("retry backoff", "[arcus]") {
+    RetryOptions invalid;
+    invalid.initial_delay_ms = invalid.max_delay_ms + 1;
+    REQUIRE(!invalid.is_valid());
+    invalid = RetryOptions();
+    invalid.multiplier = 0;
+    REQUIRE(!invalid.is_valid());
+    invalid = RetryOptions();
+    invalid.jitter_percent = 101;
+    REQUIRE(!invalid.is_valid());
+    REQUIRE(RetryOptions::fixed(100).is_valid());
+
+    // The first attempt is immediate, the delay then doubling up to the
+    // maximum, shortened by the jitter.
+    RetryOptions options;
+    options.initial_delay_ms = 20;
+    options.max_delay_ms = 80;
+    options.jitter_percent = 50;
+    Backoff backoff(options);
+    REQUIRE(backoff.update());
+    REQUIRE(backoff.delay() == milliseconds(40));
+    REQUIRE(!backoff.update());
+    sleep(25);
+    REQUIRE(backoff.update());
+    REQUIRE(backoff.delay() == milliseconds(80));
+    sleep(45);
+    REQUIRE(backoff.update());
+    REQUIRE(backoff.delay() == milliseconds(80));
+    REQUIRE(!backoff.update());
+
+    // A success starts over.
+    backoff.reset();
+    REQUIRE(backoff.update());
+    REQUIRE(backoff.delay() == milliseconds(40));
+
+    backoff.set_options(RetryOptions::fixed(30));
+    REQUIRE(backoff.update());
+    sleep(20);
+    REQUIRE(!backoff.update());
+    sleep(15);
+    REQUIRE(backoff.update());
+    REQUIRE(backoff.delay() == milliseconds(30));
+
+    // A client started before its server connects within the backoff, rather
+    // than after a fixed delay of seconds.
+    const unsigned int port = 19192;
+    ConnectionOptions connection_options;
+    connection_options.health = HealthOptions::fast_failover();
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port, connection_options)));
+    for (int i = 0; i < 10; ++i) {
+        client.update();
+        sleep(20);
+    }
+    Server server;
+    REQUIRE(!is_error(server.init(port, connection_options)));
+    REQUIRE(wait_until(1500, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    // The client reconnects at once when it detects the dropped connection,
+    // within the receive timeout.
+    server.shutdown();
+    REQUIRE(!is_error(server.init(port, connection_options)));
+    REQUIRE(wait_until(3000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+    client.shutdown();
+    server.shutdown();
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.retry_initial_delay_ms == 50);
+    REQUIRE(c_options.retry_max_delay_ms == 5000);
+    c_options.retry_multiplier = 0;
+    OneServerPtr c_server = nullptr;
+    REQUIRE(one_server_create_with_options(port, &c_options, &c_server) ==
+            ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+}
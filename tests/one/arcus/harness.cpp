@@ -16,8 +16,30 @@ Harness::Harness(const char *address, unsigned int port)
     , _uniform_dist(0, 100) {
     _game.init(port, 16, "test name", "test map", "test mode", "test version",
                seconds(0));
-    _game.set_quiet(true);
     _agent.init(address, port);
+    init_defaults();
+}
+
+Harness::Harness()
+    : _before_game_update_callback(nullptr)
+    , _before_agent_update_callback(nullptr)
+    , _game_error_tally{0}
+    , _agent_error_tally{0}
+    , _rd()
+    , _re(_rd())
+    , _uniform_dist(0, 100) {
+    if (is_error(_pipe.init())) {
+        L_ERROR("failed to init loopback pipe");
+        return;
+    }
+    _game.init(_pipe.first(), 16, "test name", "test map", "test mode", "test version",
+               seconds(0));
+    _agent.init(_pipe.second());
+    init_defaults();
+}
+
+void Harness::init_defaults() {
+    _game.set_quiet(true);
     _agent.set_quiet(true);
     set_game_callback_probability(100);
     set_agent_callback_probability(100);
@@ -208,6 +230,8 @@ bool Harness::agent_need_update() {
 StressHarness::StressHarness(const char *address, unsigned int port)
     : Harness(address, port) {}
 
+StressHarness::StressHarness() : Harness() {}
+
 void StressHarness::set_stress_game_callback(
     std::function<OneError(one_integration::Game &, int)> callback) {
     _stress_game_callback = callback;
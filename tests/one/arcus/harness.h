@@ -2,6 +2,7 @@
 
 #include <one/fake/arcus/agent/agent.h>
 #include <one/arcus/error.h>
+#include <one/arcus/internal/loopback.h>
 #include <one/fake/arcus/game/game.h>
 
 #include <unordered_map>
@@ -16,6 +17,9 @@ namespace one {
 class Harness {
 public:
     Harness(const char *address, unsigned int port);
+    // Connects the game and agent over a LoopbackPipe instead, so that no port
+    // is used. The connection is not reestablished once it fails.
+    Harness();
     Harness(const Harness &) = delete;
     Harness &operator=(const Harness &) = delete;
     virtual ~Harness();
@@ -90,6 +94,10 @@ protected:
     bool set_probability(int probability, int &output);
 
 private:
+    // Quiets the game and agent and sets the default probabilities, once they
+    // are initialized.
+    void init_defaults();
+
     bool game_need_callback();
     bool agent_need_callback();
 
@@ -102,6 +110,7 @@ private:
     int _game_update_probability;
     int _agent_update_probability;
 
+    LoopbackPipe _pipe;  // Outlives the game and agent, when used.
     one_integration::Game _game;
     Agent _agent;
 
@@ -121,6 +130,8 @@ private:
 class StressHarness final : public Harness {
 public:
     StressHarness(const char *address, unsigned int port);
+    // Over a LoopbackPipe, see Harness().
+    StressHarness();
     StressHarness(const StressHarness &) = delete;
     StressHarness &operator=(const StressHarness &) = delete;
     virtual ~StressHarness() override = default;
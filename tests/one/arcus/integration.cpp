@@ -93,7 +93,7 @@ TEST_CASE("long:Reconnection", "[integration]") {
     // Sleep for long enough such that the next update should result in the agent
     // realizing that the game server is no longer there and the agent should
     // enter a state of reconnecting to the server.
-    sleep(HealthChecker::health_check_receive_interval_seconds * 1000);
+    sleep(HealthChecker::health_check_receive_interval_ms);
     REQUIRE(agent.update() == ONE_ERROR_CONNECTION_HEALTH_TIMEOUT);
     REQUIRE(agent.client().status() == Client::Status::connecting);
 
@@ -125,8 +125,8 @@ TEST_CASE("long:Maintain connection", "[integration]") {
     // Service both game and agent updates for a longer period of time (2x
     // health checks +1 second) so that keeping the connections alive requires
     // health messages.
-    while (duration_cast<seconds>(steady_clock::now() - start).count() <
-           HealthChecker::health_check_receive_interval_seconds * 2 + 1) {
+    while (duration_cast<milliseconds>(steady_clock::now() - start).count() <
+           HealthChecker::health_check_receive_interval_ms * 2 + 1000) {
         pump_updates(10, 1, agent, game);
         REQUIRE(game.one_server_wrapper().status() == OneServerWrapper::Status::ready);
         REQUIRE(agent.client().status() == Client::Status::ready);
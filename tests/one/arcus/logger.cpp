@@ -0,0 +1,184 @@
+#include <catch.hpp>
+#include <tests/one/arcus/util.h>
+
+#include <one/arcus/c_api.h>
+#include <one/arcus/internal/async_logger.h>
+#include <one/arcus/logger.h>
+#include <one/arcus/server.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace i3d::one;
+
+TEST_CASE("logger level threshold", "[logger]") {
+    Logger empty;
+    REQUIRE(!empty.is_enabled(LogLevel::Info));
+    REQUIRE(!empty.is_enabled(LogLevel::Error));
+    empty.Log(LogLevel::Error, "nobody is listening");
+
+    int info_count = 0;
+    int error_count = 0;
+    auto fn = [&](void *, LogLevel level, const String &) {
+        if (level == LogLevel::Info) info_count++;
+        if (level == LogLevel::Error) error_count++;
+    };
+    Logger logger(fn, nullptr);
+    REQUIRE(logger.level() == LogLevel::Info);
+    REQUIRE(logger.is_enabled(LogLevel::Info));
+    REQUIRE(logger.is_enabled(LogLevel::Error));
+
+    logger.Log(LogLevel::Info, "info");
+    logger.Log(LogLevel::Error, "error");
+    REQUIRE(info_count == 1);
+    REQUIRE(error_count == 1);
+
+    logger.set_level(LogLevel::Error);
+    REQUIRE(!logger.is_enabled(LogLevel::Info));
+    REQUIRE(logger.is_enabled(LogLevel::Error));
+    logger.Log(LogLevel::Info, "info");
+    logger.Log(LogLevel::Error, "error");
+    REQUIRE(info_count == 1);
+    REQUIRE(error_count == 2);
+}
+
+TEST_CASE("async logger forwards in order", "[logger]") {
+    std::vector<String> received;
+    std::thread::id drain_thread;
+    auto fn = [&](void *, LogLevel, const String &message) {
+        drain_thread = std::this_thread::get_id();
+        received.push_back(message);
+    };
+
+    AsyncLogger async_logger;
+    REQUIRE(!is_error(async_logger.init(Logger(fn, nullptr), 16)));
+    REQUIRE(async_logger.init(Logger(fn, nullptr)) == ONE_ERROR_LOGGER_ALREADY_INITIALIZED);
+
+    auto front = async_logger.front();
+    for (int i = 0; i < 10; ++i) {
+        front.Log(LogLevel::Info, String("message ") + std::to_string(i).c_str());
+    }
+    async_logger.flush();
+
+    REQUIRE(received.size() == 10);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(received[i] == String("message ") + std::to_string(i).c_str());
+    }
+    REQUIRE(drain_thread != std::this_thread::get_id());
+    REQUIRE(async_logger.dropped() == 0);
+
+    // Long messages are truncated.
+    const String long_message(AsyncLogger::max_record_length * 2, 'x');
+    front.Log(LogLevel::Info, long_message);
+    async_logger.flush();
+    REQUIRE(received.size() == 11);
+    REQUIRE(received.back() == long_message.substr(0, AsyncLogger::max_record_length));
+
+    async_logger.shutdown();
+    REQUIRE(!async_logger.push(LogLevel::Info, "after shutdown"));
+}
+
+TEST_CASE("async logger drops when full", "[logger]") {
+    std::mutex blocker;
+    std::atomic<int> count(0);
+    auto fn = [&](void *, LogLevel, const String &) {
+        const std::lock_guard<std::mutex> lock(blocker);
+        count++;
+    };
+
+    AsyncLogger async_logger;
+    constexpr size_t capacity = 8;
+    REQUIRE(!is_error(async_logger.init(Logger(fn, nullptr), capacity)));
+
+    {
+        // Block the drain thread inside the sink, then overfill the ring.
+        const std::lock_guard<std::mutex> lock(blocker);
+        size_t accepted = 0;
+        for (size_t i = 0; i < capacity * 4; ++i) {
+            if (async_logger.push(LogLevel::Info, "message")) {
+                accepted++;
+            }
+        }
+        // The drain thread may hold one record while blocked.
+        REQUIRE(accepted <= capacity + 1);
+        REQUIRE(async_logger.dropped() == capacity * 4 - accepted);
+    }
+
+    async_logger.flush();
+    REQUIRE(count.load() + async_logger.dropped() == capacity * 4);
+}
+
+TEST_CASE("async logger concurrent producers", "[logger]") {
+    std::atomic<int> count(0);
+    auto fn = [&](void *, LogLevel, const String &) { count++; };
+
+    AsyncLogger async_logger;
+    REQUIRE(!is_error(async_logger.init(Logger(fn, nullptr), 1024)));
+
+    constexpr int thread_count = 4;
+    constexpr int per_thread = 200;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < per_thread; ++i) {
+                async_logger.push(LogLevel::Info, "message");
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    async_logger.flush();
+
+    REQUIRE(count.load() + async_logger.dropped() == thread_count * per_thread);
+}
+
+TEST_CASE("server log level and async logging", "[logger]") {
+    std::atomic<int> info_count(0);
+    auto fn = [&](void *, LogLevel level, const String &) {
+        if (level == LogLevel::Info) info_count++;
+    };
+
+    Server server;
+    server.set_logger(Logger(fn, nullptr));
+
+    // Info logs are discarded below the threshold.
+    server.set_log_level(LogLevel::Error);
+    REQUIRE(!is_error(server.shutdown()));
+    REQUIRE(info_count == 0);
+
+    // Async logs are forwarded at the latest when async logging is disabled.
+    server.set_log_level(LogLevel::Info);
+    REQUIRE(!is_error(server.set_async_logging(true)));
+    REQUIRE(!is_error(server.set_async_logging(true)));
+    REQUIRE(!is_error(server.shutdown()));
+    REQUIRE(!is_error(server.set_async_logging(false)));
+    REQUIRE(info_count == 1);
+
+    // The level set before enabling async logging is kept.
+    server.set_log_level(LogLevel::Error);
+    REQUIRE(!is_error(server.set_async_logging(true)));
+    REQUIRE(!is_error(server.shutdown()));
+    REQUIRE(!is_error(server.set_async_logging(false)));
+    REQUIRE(info_count == 1);
+}
+
+TEST_CASE("server async logging c api", "[logger]") {
+    REQUIRE(one_is_error(one_server_set_log_level(nullptr, ONE_LOG_LEVEL_ERROR)));
+    REQUIRE(one_is_error(one_server_set_async_logging(nullptr, true)));
+
+    OneServerPtr server = nullptr;
+    REQUIRE(!one_is_error(one_server_create(19120, &server)));
+    REQUIRE(!one_is_error(one_server_set_log_level(server, ONE_LOG_LEVEL_INFO)));
+    REQUIRE(one_server_set_log_level(server, static_cast<OneLogLevel>(2)) ==
+            ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID);
+    REQUIRE(one_server_set_log_level(server, static_cast<OneLogLevel>(-1)) ==
+            ONE_ERROR_VALIDATION_LOG_LEVEL_IS_INVALID);
+    REQUIRE(!one_is_error(one_server_set_async_logging(server, true)));
+    // Clearing the logger is allowed.
+    REQUIRE(!one_is_error(one_server_set_logger(server, nullptr, nullptr)));
+    // Destroying the server with async logging enabled stops the drain thread.
+    one_server_destroy(server);
+}
@@ -1,9 +1,13 @@
 #include <catch.hpp>
 #include <tests/one/arcus/util.h>
 
+#include <thread>
+
+#include <one/arcus/allocator.h>
 #include <one/arcus/error.h>
 #include <one/arcus/array.h>
 #include <one/arcus/c_api.h>
+#include <one/arcus/internal/json.h>
 #include <one/arcus/internal/rapidjson/document.h>
 #include <one/arcus/message.h>
 #include <one/arcus/object.h>
@@ -167,6 +171,111 @@ TEST_CASE("payload unit tests", "[payload]") {
     REQUIRE(o.get() == o_copy.get());
 }
 
+TEST_CASE("payload truncated json", "[payload]") {
+    Payload p;
+    REQUIRE(!is_error(p.set_val_string("name", "a fairly long server name")));
+    REQUIRE(!is_error(p.set_val_int("players", 16)));
+    const String full = p.to_json();
+
+    // Fits.
+    {
+        char buffer[256];
+        bool truncated = true;
+        const size_t length = p.to_json(buffer, sizeof(buffer), truncated);
+        REQUIRE(!truncated);
+        REQUIRE(String(buffer, length) == full);
+    }
+
+    // Exact fit.
+    {
+        char buffer[256];
+        bool truncated = true;
+        const size_t length = p.to_json(buffer, full.size(), truncated);
+        REQUIRE(!truncated);
+        REQUIRE(String(buffer, length) == full);
+    }
+
+    // Truncated.
+    {
+        char buffer[10];
+        bool truncated = false;
+        const size_t length = p.to_json(buffer, sizeof(buffer), truncated);
+        REQUIRE(truncated);
+        REQUIRE(length == sizeof(buffer));
+        REQUIRE(String(buffer, length) == full.substr(0, sizeof(buffer)));
+    }
+}
+
+TEST_CASE("payload delta", "[payload]") {
+    const String previous_json =
+        "{\"players\":1,\"name\":\"a\",\"gone\":true,\"nested\":{\"x\":1}}";
+    const String current_json =
+        "{\"players\":2,\"name\":\"a\",\"nested\":{\"x\":2},\"added\":3}";
+    Payload previous;
+    REQUIRE(!is_error(previous.from_json({previous_json.c_str(), previous_json.size()})));
+    Payload current;
+    REQUIRE(!is_error(current.from_json({current_json.c_str(), current_json.size()})));
+
+    Payload delta;
+    REQUIRE(delta.set_delta(previous, current, nullptr) ==
+            ONE_ERROR_PAYLOAD_KEY_IS_NULLPTR);
+    REQUIRE(!is_error(delta.set_delta(previous, current, "removed")));
+    REQUIRE(delta.to_json() ==
+            "{\"players\":2,\"nested\":{\"x\":2},\"added\":3,\"removed\":[\"gone\"]}");
+
+    Payload merged = previous;
+    REQUIRE(!is_error(merged.apply_delta(delta, "removed")));
+    REQUIRE(merged.get() == current.get());
+
+    // No changes.
+    REQUIRE(!is_error(delta.set_delta(current, current, "removed")));
+    REQUIRE(delta.is_empty());
+
+    const String bad_json = "{\"removed\":1}";
+    Payload bad;
+    REQUIRE(!is_error(bad.from_json({bad_json.c_str(), bad_json.size()})));
+    REQUIRE(merged.apply_delta(bad, "removed") ==
+            ONE_ERROR_PAYLOAD_WRONG_TYPE_IS_EXPECTING_ARRAY);
+}
+
+TEST_CASE("payload footprint", "[payload]") {
+    Payload empty;
+    REQUIRE(empty.footprint() == 0);
+
+    // Run on a new thread, so that the JSON blocks cached for reuse are only
+    // those freed while building the payload.
+    bool is_set = false;
+    size_t footprint = 0;
+    size_t live_bytes = 0;
+    size_t expected_bytes = 0;
+    std::thread thread([&]() {
+        allocator::set_tracking(true);
+        {
+            Payload payload;
+            Array array;
+            array.push_back_string("another string that is not stored inline");
+            array.push_back_int(2);
+            is_set = !is_error(payload.set_val_int("players", 1)) &&
+                     !is_error(payload.set_val_string("short", "a")) &&
+                     !is_error(payload.set_val_string(
+                         "long", "a string that is not stored inline")) &&
+                     !is_error(payload.set_val_array("array", array));
+            footprint = payload.footprint();
+
+            allocator::Statistics statistics;
+            allocator::statistics(allocator::Category::json, statistics);
+            live_bytes = statistics.live_bytes;
+            expected_bytes =
+                footprint + Payload::footprint(array.get()) + json::cached_size();
+        }
+        allocator::set_tracking(false);
+    });
+    thread.join();
+    REQUIRE(is_set);
+    REQUIRE(footprint > 0);
+    REQUIRE(live_bytes == expected_bytes);
+}
+
 TEST_CASE("message unit tests", "[message]") {
     Message m;
     REQUIRE(m.code() == Opcode::invalid);
@@ -0,0 +1,161 @@
+#include <catch.hpp>
+
+#include <one/arcus/array.h>
+#include <one/arcus/internal/capture.h>
+#include <one/arcus/internal/codec.h>
+#include <one/arcus/message.h>
+#include <one/arcus/object.h>
+#include <one/fake/arcus/replay/replay.h>
+
+#include <cstdio>
+
+using namespace i3d::one;
+
+namespace {
+
+void write_frame(CaptureWriter &writer, CaptureDirection direction, const Message &message) {
+    const String json = message.payload().to_json();
+    codec::Header header{};
+    header.opcode = static_cast<char>(message.code());
+    header.length = static_cast<uint32_t>(json.size());
+    REQUIRE(!is_error(writer.write(direction, header, json.data())));
+}
+
+// A capture as recorded by a Server: agent requests received, live states and
+// statuses sent.
+void write_server_capture(const char *path, int count) {
+    CaptureWriter writer;
+    REQUIRE(!is_error(writer.open(path)));
+
+    for (int i = 0; i < count; ++i) {
+        Message message;
+        REQUIRE(!is_error(messages::prepare_soft_stop(1000 + i, message)));
+        write_frame(writer, CaptureDirection::incoming, message);
+
+        Array array;
+        Object object;
+        object.set_val_string("key", "value");
+        array.push_back_object(object);
+        REQUIRE(!is_error(messages::prepare_custom_command(array, message)));
+        write_frame(writer, CaptureDirection::incoming, message);
+
+        REQUIRE(!is_error(messages::prepare_live_state(i, 16, "name", "map", "mode",
+                                                       "version", nullptr, message)));
+        write_frame(writer, CaptureDirection::outgoing, message);
+
+        REQUIRE(!is_error(messages::prepare_application_instance_status(
+            i % 2 == 0 ? 4 : 5, message)));
+        write_frame(writer, CaptureDirection::outgoing, message);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("replay load", "[replay]") {
+    const char *path = "replay_load.cap";
+    write_server_capture(path, 5);
+
+    Replayer replayer;
+    REQUIRE(replayer.load("replay_does_not_exist.cap", ReplayTarget::server) ==
+            ONE_ERROR_CAPTURE_OPEN_FAILED);
+
+    REQUIRE(!is_error(replayer.load(path, ReplayTarget::server)));
+    REQUIRE(replayer.frames().size() == 10);
+    uint64_t previous = 0;
+    for (auto &frame : replayer.frames()) {
+        REQUIRE(Replayer::is_replayed(ReplayTarget::server, frame.message.code()));
+        REQUIRE(frame.offset_ns >= previous);
+        previous = frame.offset_ns;
+    }
+
+    replayer.clear();
+    REQUIRE(!is_error(replayer.load(path, ReplayTarget::client)));
+    REQUIRE(replayer.frames().size() == 10);
+    REQUIRE(replayer.frames()[0].message.code() == Opcode::live_state);
+    REQUIRE(replayer.frames()[1].message.code() == Opcode::application_instance_status);
+
+    ReplayOptions options;
+    ReplayReport report;
+    options.connections = 0;
+    REQUIRE(replayer.run(options, report) == ReplayResult::invalid_options);
+
+    replayer.clear();
+    REQUIRE(replayer.run(ReplayOptions(), report) == ReplayResult::no_frames);
+
+    std::remove(path);
+}
+
+TEST_CASE("replay against servers", "[replay]") {
+    const char *path = "replay_servers.cap";
+    write_server_capture(path, 10);
+
+    Replayer replayer;
+    REQUIRE(!is_error(replayer.load(path, ReplayTarget::server)));
+
+    ReplayOptions options;
+    options.target = ReplayTarget::server;
+    options.speed = 0.0;
+    options.connections = 2;
+    options.port = 19140;
+    options.timeout_ms = 5000;
+
+    // Open loop sends all frames at once, which must fit in the Server's
+    // incoming queue.
+    SECTION("open loop") {
+        options.mode = ReplayMode::open_loop;
+        options.iterations = 1;
+    }
+    SECTION("closed loop") {
+        options.mode = ReplayMode::closed_loop;
+        options.iterations = 3;
+    }
+
+    ReplayReport report;
+    REQUIRE(replayer.run(options, report) == ReplayResult::ok);
+    REQUIRE(report.connections_ready == 2);
+    REQUIRE(report.connections_lost == 0);
+    REQUIRE(report.sent == 20 * options.iterations * 2);
+    REQUIRE(report.delivered == report.sent);
+    REQUIRE(report.duration_seconds > 0.0);
+    REQUIRE(report.delivered_per_second > 0.0);
+    REQUIRE(report.latency_p50_us <= report.latency_p90_us);
+    REQUIRE(report.latency_p90_us <= report.latency_p99_us);
+    REQUIRE(report.latency_p99_us <= report.latency_max_us);
+
+    std::remove(path);
+}
+
+TEST_CASE("replay against clients", "[replay]") {
+    const char *path = "replay_clients.cap";
+    write_server_capture(path, 10);
+
+    Replayer replayer;
+    REQUIRE(!is_error(replayer.load(path, ReplayTarget::client)));
+
+    ReplayOptions options;
+    options.target = ReplayTarget::client;
+    options.speed = 0.0;
+    options.connections = 2;
+    options.port = 19150;
+    options.timeout_ms = 5000;
+
+    // Open loop queues all frames at once, none of them replacing the queued
+    // live states and statuses.
+    SECTION("open loop") {
+        options.mode = ReplayMode::open_loop;
+        options.iterations = 1;
+    }
+    SECTION("closed loop") {
+        options.mode = ReplayMode::closed_loop;
+        options.iterations = 3;
+    }
+
+    ReplayReport report;
+    REQUIRE(replayer.run(options, report) == ReplayResult::ok);
+    REQUIRE(report.connections_ready == 2);
+    REQUIRE(report.connections_lost == 0);
+    REQUIRE(report.sent == 20 * options.iterations * 2);
+    REQUIRE(report.delivered == report.sent);
+
+    std::remove(path);
+}
@@ -1,6 +1,9 @@
 #include <catch.hpp>
 
+#include <one/arcus/internal/outgoing_queue.h>
 #include <one/arcus/internal/ring.h>
+#include <one/arcus/message.h>
+#include <one/arcus/opcode.h>
 
 using namespace i3d::one;
 
@@ -10,9 +13,13 @@ TEST_CASE("ring", "[arcus]") {
     REQUIRE(ring.capacity() == capacity);
 
     REQUIRE(ring.peek() == nullptr);
+    // Slots are allocated on first use.
+    REQUIRE(ring.allocated_size() == 0);
+    REQUIRE(ring.slots() == nullptr);
 
     int i = 1;
     ring.push(i);
+    REQUIRE(ring.allocated_size() == sizeof(size_t) + capacity * sizeof(int));
     REQUIRE(*ring.peek() == 1);
     REQUIRE(ring.pop() == 1);
 
@@ -41,6 +48,95 @@ TEST_CASE("ring", "[arcus]") {
     i = 4;
     ring.push(i);
     REQUIRE(*ring.peek() == 3);
+    REQUIRE(ring.at(0) == 3);
+    REQUIRE(ring.at(1) == 4);
     REQUIRE(ring.pop() == 3);
     REQUIRE(ring.pop() == 4);
+
+    // Inline slots ignore the capacity given at construction.
+    Ring<int, 2> inline_ring(100);
+    REQUIRE(inline_ring.capacity() == 2);
+    REQUIRE(inline_ring.allocated_size() == 0);
+    REQUIRE(inline_ring.slots() != nullptr);
+    i = 1;
+    inline_ring.push(i);
+    i = 2;
+    inline_ring.push(i);
+    REQUIRE(inline_ring.pop() == 1);
+    i = 3;
+    inline_ring.push(i);
+    REQUIRE(inline_ring.pop() == 2);
+    REQUIRE(inline_ring.pop() == 3);
+}
+
+namespace {
+
+Message message_with(Opcode code, int value) {
+    Payload payload;
+    payload.set_val_int("value", value);
+    Message message;
+    message.init(code, payload);
+    return message;
+}
+
+int value_of(const Message &message) {
+    int value = 0;
+    message.payload().val_int("value", value);
+    return value;
+}
+
+}  // namespace
+
+TEST_CASE("outgoing queue", "[arcus]") {
+    OutgoingQueue queue(2);
+    REQUIRE(queue.capacity_per_priority() == 2);
+    REQUIRE(queue.priority(Opcode::health) == Priority::control);
+    REQUIRE(queue.priority(Opcode::application_instance_status) == Priority::control);
+    REQUIRE(queue.priority(Opcode::live_state) == Priority::state);
+    REQUIRE(queue.priority(Opcode::reverse_metadata) == Priority::bulk);
+    REQUIRE(queue.replace_in_queue(Opcode::live_state));
+    REQUIRE(!queue.replace_in_queue(Opcode::live_state_delta));
+
+    // Higher classes are popped first, in FIFO order within a class.
+    REQUIRE(!is_error(queue.push(message_with(Opcode::reverse_metadata, 1))));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::live_state, 2))));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::reverse_metadata, 3))));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::health, 4))));
+
+    // Each class is bounded on its own.
+    REQUIRE(queue.push(message_with(Opcode::custom_command, 5)) ==
+            ONE_ERROR_CONNECTION_OUTGOING_QUEUE_INSUFFICIENT_SPACE);
+    REQUIRE(!is_error(queue.push(message_with(Opcode::hello, 6))));
+    REQUIRE(queue.size() == 5);
+    REQUIRE(queue.size(Priority::control) == 2);
+    REQUIRE(queue.size(Priority::state) == 1);
+    REQUIRE(queue.size(Priority::bulk) == 2);
+
+    // State opcodes replace the queued message in place.
+    REQUIRE(!is_error(queue.push(message_with(Opcode::live_state, 7))));
+    REQUIRE(queue.size(Priority::state) == 1);
+
+    const int expected[] = {4, 6, 7, 1, 3};
+    for (int value : expected) {
+        auto &message = queue.pop();
+        REQUIRE(value_of(message) == value);
+    }
+    REQUIRE(queue.size() == 0);
+
+    // Policies can be changed per opcode.
+    REQUIRE(queue.set_policy(Opcode::invalid, Priority::bulk, false) ==
+            ONE_ERROR_MESSAGE_OPCODE_NOT_SUPPORTED);
+    REQUIRE(queue.set_policy(Opcode::custom_command, static_cast<Priority>(7), false) ==
+            ONE_ERROR_CONNECTION_PRIORITY_IS_INVALID);
+    REQUIRE(!is_error(queue.set_policy(Opcode::custom_command, Priority::control, true)));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::reverse_metadata, 1))));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::custom_command, 2))));
+    REQUIRE(!is_error(queue.push(message_with(Opcode::custom_command, 3))));
+    REQUIRE(queue.size() == 2);
+    REQUIRE(value_of(queue.pop()) == 3);
+    REQUIRE(value_of(queue.pop()) == 1);
+
+    queue.clear();
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.priority(Opcode::custom_command) == Priority::control);
 }
@@ -0,0 +1,230 @@
+#include <catch.hpp>
+#include <tests/one/arcus/util.h>
+
+#include <cstdlib>
+#include <new>
+
+#include <one/arcus/allocator.h>
+#include <one/arcus/array.h>
+#include <one/arcus/client.h>
+#include <one/arcus/object.h>
+#include <one/arcus/server.h>
+
+using namespace i3d::one;
+
+namespace {
+
+// Counts the allocations made through the arcus allocator or the global
+// operator new, e.g. by copying a std::function, by the thread that armed it.
+// Allocations of other threads, or made while disarmed, are not counted.
+thread_local bool _is_armed = false;
+thread_local size_t _allocations = 0;
+
+}  // namespace
+
+// Replaced for the steady_state_tests executable, which only holds this file,
+// counting only while armed. The array, sized and nothrow forms forward to
+// these.
+void *operator new(std::size_t size) {
+    if (_is_armed) {
+        ++_allocations;
+    }
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+class AllocationGuard final {
+public:
+    AllocationGuard() {
+        allocator::set_alloc([](size_t size) -> void * {
+            if (_is_armed) {
+                ++_allocations;
+            }
+            return std::malloc(size);
+        });
+        allocator::set_realloc([](void *p, size_t size) -> void * {
+            if (_is_armed) {
+                ++_allocations;
+            }
+            return std::realloc(p, size);
+        });
+    }
+    ~AllocationGuard() {
+        _is_armed = false;
+        allocator::reset_overrides();
+    }
+
+    void arm() {
+        _is_armed = true;
+    }
+    void disarm() {
+        _is_armed = false;
+    }
+
+    // Number of allocations while armed.
+    size_t allocations() const {
+        return _allocations;
+    }
+
+    void reset() {
+        _allocations = 0;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("server steady state updates do not allocate", "[arcus]") {
+    constexpr unsigned int port = 19170;
+    constexpr int warm_up_iterations = 10;
+    constexpr int iterations = 50;
+
+    AllocationGuard guard;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    // Callbacks capturing more than fits the std::function small buffer, so
+    // that copying them would allocate.
+    int counts[4] = {};
+    const char padding[32] = {};
+    server.set_soft_stop_callback(
+        [&, padding](void *, int) {
+            (void)padding;
+            ++counts[0];
+        },
+        nullptr);
+    server.set_allocated_callback(
+        [&, padding](void *, Array *) {
+            (void)padding;
+            ++counts[1];
+        },
+        nullptr);
+    server.set_host_information_callback(
+        [&, padding](void *, Object *) {
+            (void)padding;
+            ++counts[2];
+        },
+        nullptr);
+    client.set_live_state_callback(
+        [&](void *, int, int, const String &, const String &, const String &,
+            const String &) { ++counts[3]; },
+        nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    // Strings longer than the small string buffer.
+    Object additional_data;
+    additional_data.set_val_string("region", "a region name that is not short");
+    additional_data.set_val_int("tick", 60);
+    Array allocated;
+    allocated.push_back_string("an allocation value that is not short");
+    allocated.push_back_int(4);
+    Object host;
+    host.set_val_string("hostname", "a host name that is not short either");
+    host.set_val_int("id", 1);
+
+    for (int i = 0; i < warm_up_iterations + iterations; ++i) {
+        if (i == warm_up_iterations) {
+            guard.reset();
+        }
+
+        // Only the server calls are checked, the client runs on the same
+        // thread. Results are checked once disarmed, as Catch may allocate.
+        guard.arm();
+        OneError set_err = server.set_live_state(
+            i, 16, "a server name that is long", "a map name that is long",
+            "a mode name that is long", "a version that is long", &additional_data);
+        OneError update_err = server.update();
+        guard.disarm();
+        REQUIRE(!is_error(set_err));
+        REQUIRE(!is_error(update_err));
+
+        REQUIRE(!is_error(client.send_soft_stop(i)));
+        REQUIRE(!is_error(client.send_allocated(allocated)));
+        REQUIRE(!is_error(client.send_host_information(host)));
+        REQUIRE(!is_error(client.update()));
+
+        guard.arm();
+        update_err = server.update();
+        guard.disarm();
+        REQUIRE(!is_error(update_err));
+
+        REQUIRE(!is_error(client.update()));
+    }
+
+    REQUIRE(guard.allocations() == 0);
+    // Messages were actually exchanged during the checked iterations.
+    REQUIRE(counts[0] > warm_up_iterations);
+    REQUIRE(counts[1] > warm_up_iterations);
+    REQUIRE(counts[2] > warm_up_iterations);
+    REQUIRE(counts[3] > warm_up_iterations);
+}
+
+TEST_CASE("server player count updates do not allocate", "[arcus]") {
+    constexpr unsigned int port = 19171;
+    constexpr int warm_up_iterations = 10;
+    constexpr int iterations = 50;
+
+    AllocationGuard guard;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int players = -1;
+    client.set_live_state_callback(
+        [&](void *, int p, int, const String &, const String &, const String &,
+            const String &) { players = p; },
+        nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    REQUIRE(!is_error(server.set_live_state(0, 16, "a server name that is long",
+                                            "a map name that is long",
+                                            "a mode name that is long",
+                                            "a version that is long", nullptr)));
+
+    for (int i = 0; i < warm_up_iterations + iterations; ++i) {
+        if (i == warm_up_iterations) {
+            guard.reset();
+        }
+
+        guard.arm();
+        const OneError set_err = server.set_players(i);
+        const OneError update_err = server.update();
+        guard.disarm();
+        REQUIRE(!is_error(set_err));
+        REQUIRE(!is_error(update_err));
+
+        REQUIRE(!is_error(client.update()));
+    }
+
+    REQUIRE(guard.allocations() == 0);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return players == warm_up_iterations + iterations - 1;
+    }));
+}
@@ -1,8 +1,14 @@
 #include <catch.hpp>
 #include <tests/one/arcus/util.h>
 
+#include <string>
 #include <thread>
+#include <vector>
 
+#include <one/arcus/array.h>
+#include <one/arcus/client.h>
+#include <one/arcus/object.h>
+#include <one/arcus/server.h>
 #include <tests/one/arcus/harness.h>
 #include <one/fake/arcus/game/log.h>
 
@@ -15,9 +21,7 @@ void run(StressHarness *harness, seconds duration, milliseconds sleep) {
 }
 
 TEST_CASE("soak:test high usage over a long period", "[stress]") {
-    const auto address = "127.0.0.1";
-    const unsigned int port = 18000;
-    StressHarness stress(address, port);
+    StressHarness stress;
 
     stress.set_stress_game_callback([](Game &game, int random) {
         for (int i = 0; i < random; ++i) {
@@ -49,9 +53,7 @@ TEST_CASE("soak:test high usage over a long period", "[stress]") {
 }
 
 TEST_CASE("soak:test very high usage over a long period", "[stress]") {
-    const auto address = "127.0.0.1";
-    const unsigned int port = 18000;
-    StressHarness stress(address, port);
+    StressHarness stress;
 
     stress.set_stress_game_callback([](Game &game, int random) {
         for (int i = 0; i < random; ++i) {
@@ -91,9 +93,7 @@ TEST_CASE("soak:test very high usage over a long period", "[stress]") {
 }
 
 TEST_CASE("soak:test high usage over a long period on multiple threads", "[stress]") {
-    const auto address = "127.0.0.1";
-    const unsigned int port = 18000;
-    StressHarness stress(address, port);
+    StressHarness stress;
 
     stress.set_stress_game_callback([](Game &game, int random) {
         for (int i = 0; i < random; ++i) {
@@ -132,9 +132,7 @@ TEST_CASE("soak:test high usage over a long period on multiple threads", "[stres
 
 TEST_CASE("soak:test very high usage over a very long period on multiple threads",
           "[stress]") {
-    const auto address = "127.0.0.1";
-    const unsigned int port = 18000;
-    StressHarness stress(address, port);
+    StressHarness stress;
 
     stress.set_stress_game_callback([](Game &game, int random) {
         for (int i = 0; i < random; ++i) {
@@ -184,9 +182,7 @@ TEST_CASE("soak:test very high usage over a very long period on multiple threads
 }
 
 TEST_CASE("soak-days:test normal load over many days", "[stress]") {
-    const auto address = "127.0.0.1";
-    const unsigned int port = 18000;
-    StressHarness stress(address, port);
+    StressHarness stress;
     stress.set_game_callback_probability(5);
     stress.set_agent_callback_probability(5);
     stress.set_game_update_probability(100);
@@ -219,3 +215,67 @@ TEST_CASE("soak-days:test normal load over many days", "[stress]") {
     stress.log_game_error_tally();
     REQUIRE(true);
 }
+
+TEST_CASE("head of line blocking", "[stress]") {
+    const unsigned int port = 19183;
+    const int rounds = 20;
+    const int bulk_per_round = 40;
+
+    Server server;
+    REQUIRE(!is_error(server.init(port)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port)));
+
+    int bulk_received = 0;
+    int statuses = 0;
+    int status = 0;
+    // Bulk messages received before each status.
+    std::vector<int> bulk_before_status;
+    client.set_reverse_metadata_callback([&](void *, Array *) { ++bulk_received; },
+                                         nullptr);
+    client.set_application_instance_status_callback(
+        [&](void *, int s) {
+            ++statuses;
+            status = s;
+            bulk_before_status.push_back(bulk_received);
+        },
+        nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready && statuses == 1;
+    }));
+
+    // Large bulk payloads.
+    Array data;
+    Object entry;
+    REQUIRE(!is_error(entry.set_val_string("key", std::string(1024, 'k').c_str())));
+    data.push_back_object(entry);
+
+    for (int round = 0; round < rounds; ++round) {
+        bulk_received = 0;
+        bulk_before_status.clear();
+
+        // Fill the bulk class, then change the status behind it.
+        for (int i = 0; i < bulk_per_round; ++i) {
+            REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+        }
+        const auto expected = (round % 2 == 0)
+                                  ? Server::ApplicationInstanceStatus::allocated
+                                  : Server::ApplicationInstanceStatus::online;
+        REQUIRE(!is_error(server.set_application_instance_status(expected)));
+
+        REQUIRE(wait_until(5000, [&]() {
+            server.update();
+            client.update();
+            return bulk_received == bulk_per_round && !bulk_before_status.empty();
+        }));
+
+        // The status overtook the queued bulk messages.
+        REQUIRE(bulk_before_status.size() == 1);
+        REQUIRE(bulk_before_status[0] == 0);
+        REQUIRE(status == static_cast<int>(expected));
+    }
+}
@@ -0,0 +1,1075 @@
+#include <catch.hpp>
+#include <tests/one/arcus/util.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <one/arcus/array.h>
+#include <one/arcus/c_api.h>
+#include <one/arcus/c_platform.h>
+#include <one/arcus/client.h>
+#include <one/arcus/internal/connection.h>
+#include <one/arcus/internal/io_uring.h>
+#include <one/arcus/internal/loopback.h>
+#include <one/arcus/internal/shared_memory.h>
+#include <one/arcus/internal/socket.h>
+#include <one/arcus/message.h>
+#include <one/arcus/server.h>
+
+#ifndef ONE_WINDOWS
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+using namespace i3d::one;
+
+namespace {
+
+// Updates both connections until both are ready.
+bool handshake(Connection &server, Connection &client) {
+    server.initiate_handshake();
+    return wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Connection::Status::ready &&
+               client.status() == Connection::Status::ready;
+    });
+}
+
+void wait_ready_for_read(Socket &socket) {
+    bool is_ready;
+    REQUIRE(!is_error(socket.ready_for_read(0.1f, is_ready)));
+    REQUIRE(is_ready);
+}
+
+// Listens on any address, on a port chosen by the system.
+void listen(Socket &server, unsigned int &port) {
+    REQUIRE(!is_error(server.init()));
+    REQUIRE(!is_error(server.bind(0)));
+    String server_ip;
+    REQUIRE(!is_error(server.address(server_ip, port)));
+    REQUIRE(port != 0);
+    REQUIRE(!is_error(server.listen(1)));
+}
+
+// Returns the soft stop timeout of the first incoming message, or -1.
+int receive_soft_stop(Connection &connection) {
+    unsigned int count = 0;
+    if (is_error(connection.incoming_count(count)) || count == 0) {
+        return -1;
+    }
+    int timeout = -1;
+    connection.remove_incoming([&](const Message &message) {
+        message.payload().val_int("timeout", timeout);
+        return ONE_ERROR_NONE;
+    });
+    return timeout;
+}
+
+}  // namespace
+
+TEST_CASE("loopback transport", "[transport]") {
+    LoopbackPipe pipe;
+    LoopbackOptions options;
+    options.capacity = 0;
+    REQUIRE(pipe.init(options) == ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID);
+
+    auto &first = pipe.first();
+    auto &second = pipe.second();
+    size_t length = 0;
+    unsigned char data[256] = {};
+    REQUIRE(first.send(data, 1, length) == ONE_ERROR_TRANSPORT_NOT_INITIALIZED);
+
+    options.capacity = 100;
+    options.max_send_size = 30;
+    options.max_receive_size = 20;
+    REQUIRE(!is_error(pipe.init(options)));
+    REQUIRE(pipe.init(options) == ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED);
+
+    String address;
+    unsigned int port = 0;
+    REQUIRE(!is_error(second.address(address, port)));
+    REQUIRE(address == "loopback");
+    REQUIRE(port == 1);
+
+    bool is_ready = true;
+    REQUIRE(!is_error(second.ready_for_read(0.f, is_ready)));
+    REQUIRE(!is_ready);
+
+    // Sends and receives are partial, and wrap around the end of the buffer.
+    REQUIRE(!is_error(first.send(data, 10, length)));
+    REQUIRE(!is_error(second.receive(data, 10, length)));
+    REQUIRE(length == 10);
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < sizeof(data); ++i) {
+            data[i] = static_cast<unsigned char>(i + round);
+        }
+        size_t sent = 0;
+        while (sent < sizeof(data)) {
+            REQUIRE(!is_error(first.send(data + sent, sizeof(data) - sent, length)));
+            if (length == 0) {
+                break;
+            }
+            REQUIRE(length <= 30);
+            sent += length;
+        }
+        REQUIRE(sent == 100);
+        REQUIRE(!is_error(first.ready_for_send(0.f, is_ready)));
+        REQUIRE(!is_ready);
+
+        unsigned char received[256] = {};
+        size_t total = 0;
+        do {
+            REQUIRE(!is_error(second.receive(received + total, 256, length)));
+            REQUIRE(length <= 20);
+            total += length;
+        } while (length > 0);
+        REQUIRE(total == 100);
+        for (size_t i = 0; i < total; ++i) {
+            REQUIRE(received[i] == data[i]);
+        }
+    }
+
+    // Data sent before closing is received before the close is reported.
+    REQUIRE(!is_error(second.send(data, 10, length)));
+    second.close();
+    REQUIRE(!second.is_initialized());
+    REQUIRE(first.send(data, 1, length) == ONE_ERROR_TRANSPORT_PEER_CLOSED);
+    REQUIRE(!is_error(first.receive(data, sizeof(data), length)));
+    REQUIRE(length == 10);
+    REQUIRE(first.receive(data, sizeof(data), length) ==
+            ONE_ERROR_TRANSPORT_PEER_CLOSED);
+}
+
+TEST_CASE("loopback latency and bandwidth", "[transport]") {
+    using namespace std::chrono;
+
+    LoopbackPipe pipe;
+    LoopbackOptions options;
+    options.latency = milliseconds(50);
+    REQUIRE(!is_error(pipe.init(options)));
+
+    unsigned char data[1000] = {};
+    size_t length = 0;
+    const auto start = steady_clock::now();
+    REQUIRE(!is_error(pipe.first().send(data, 1, length)));
+    REQUIRE(length == 1);
+    REQUIRE(!is_error(pipe.second().receive(data, 1, length)));
+    REQUIRE(length == 0);
+
+    // A waiting reader wakes when the bytes arrive.
+    bool is_ready = false;
+    REQUIRE(!is_error(pipe.second().ready_for_read(5.f, is_ready)));
+    REQUIRE(is_ready);
+    REQUIRE(steady_clock::now() - start >= milliseconds(50));
+    REQUIRE(!is_error(pipe.second().receive(data, 1, length)));
+    REQUIRE(length == 1);
+    pipe.shutdown();
+
+    // 1000 bytes at 10000 bytes per second take 100 milliseconds.
+    options.latency = milliseconds(0);
+    options.bytes_per_second = 10000;
+    REQUIRE(!is_error(pipe.init(options)));
+    const auto sent = steady_clock::now();
+    REQUIRE(!is_error(pipe.first().send(data, sizeof(data), length)));
+    REQUIRE(length == sizeof(data));
+    size_t total = 0;
+    REQUIRE(wait_until(5000, [&]() {
+        pipe.second().receive(data, sizeof(data), length);
+        total += length;
+        return total == sizeof(data);
+    }));
+    REQUIRE(steady_clock::now() - sent >= milliseconds(100));
+}
+
+TEST_CASE("loopback connection", "[transport]") {
+    // Every frame is split into single byte writes and reads.
+    LoopbackOptions options;
+    options.max_send_size = 1;
+    options.max_receive_size = 1;
+    options.latency = std::chrono::microseconds(100);
+
+    LoopbackPipe pipe;
+    REQUIRE(!is_error(pipe.init(options)));
+    Connection server(4, 4);
+    server.init(pipe.first());
+    Connection client(4, 4);
+    client.init(pipe.second());
+    REQUIRE(handshake(server, client));
+
+    for (int i = 0; i < 10; ++i) {
+        Message message;
+        REQUIRE(!is_error(messages::prepare_soft_stop(i, message)));
+        REQUIRE(!is_error(server.add_outgoing(message)));
+        int timeout = -1;
+        REQUIRE(wait_until(5000, [&]() {
+            server.update();
+            client.update();
+            timeout = receive_soft_stop(client);
+            return timeout != -1;
+        }));
+        REQUIRE(timeout == i);
+    }
+}
+
+TEST_CASE("loopback server and client", "[transport]") {
+    LoopbackPipe pipe;
+    Server server;
+    REQUIRE(server.init_transport(pipe.first()) == ONE_ERROR_TRANSPORT_NOT_INITIALIZED);
+    REQUIRE(server.status() == Server::Status::uninitialized);
+
+    REQUIRE(!is_error(pipe.init()));
+    REQUIRE(!is_error(server.init_transport(pipe.first())));
+    REQUIRE(server.init_transport(pipe.first()) == ONE_ERROR_SERVER_ALREADY_INITIALIZED);
+    REQUIRE(server.init(19191) == ONE_ERROR_SERVER_ALREADY_INITIALIZED);
+    REQUIRE(server.status() == Server::Status::handshake);
+    Client client;
+    REQUIRE(!is_error(client.init_transport(pipe.second())));
+    REQUIRE(client.status() == Client::Status::handshake);
+
+    int timeout = 0;
+    server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+    REQUIRE(!is_error(client.send_soft_stop(1000)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return timeout == 1000;
+    }));
+
+    // The transport is not reconnected once it fails.
+    pipe.second().close();
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        return server.status() == Server::Status::error;
+    }));
+    REQUIRE(!is_error(server.update()));
+    REQUIRE(server.status() == Server::Status::error);
+
+    // The transport may be given again after shutdown.
+    client.shutdown();
+    REQUIRE(!is_error(server.shutdown()));
+    REQUIRE(server.status() == Server::Status::uninitialized);
+    pipe.shutdown();
+    REQUIRE(!is_error(pipe.init()));
+    REQUIRE(!is_error(server.init_transport(pipe.first())));
+    REQUIRE(!is_error(client.init_transport(pipe.second())));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+}
+
+TEST_CASE("loopback connections in parallel", "[transport]") {
+    // Connections on separate threads, without ports to share, under partial
+    // writes and reads of varying sizes.
+    constexpr int threads_count = 8;
+    constexpr int messages_count = 200;
+    std::vector<std::thread> threads;
+    std::vector<int> received(threads_count, 0);
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([t, &received]() {
+            LoopbackOptions options;
+            options.capacity = 256 + t * 64;
+            options.max_send_size = 7 + t;
+            options.max_receive_size = 13 + t;
+            LoopbackPipe pipe;
+            if (is_error(pipe.init(options))) {
+                return;
+            }
+            Connection server(4, 4);
+            server.init(pipe.first());
+            Connection client(4, 4);
+            client.init(pipe.second());
+            if (!handshake(server, client)) {
+                return;
+            }
+            for (int i = 0; i < messages_count; ++i) {
+                Message message;
+                messages::prepare_soft_stop(i, message);
+                client.add_outgoing(message);
+                const bool is_received = wait_until(5000, [&]() {
+                    client.update();
+                    server.update();
+                    return receive_soft_stop(server) == i;
+                });
+                if (!is_received) {
+                    return;
+                }
+                received[t]++;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < threads_count; ++t) {
+        REQUIRE(received[t] == messages_count);
+    }
+}
+
+#ifndef ONE_WINDOWS
+
+TEST_CASE("shared memory transport", "[transport]") {
+    const char *name = "/one-arcus-test-transport";
+
+    SharedMemoryTransport server;
+    SharedMemoryTransport client;
+    REQUIRE(server.create(nullptr) == ONE_ERROR_VALIDATION_NAME_IS_NULLPTR);
+    REQUIRE(server.create(name, 100) == ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID);
+    REQUIRE(server.create(name, 32) == ONE_ERROR_TRANSPORT_CAPACITY_IS_INVALID);
+    REQUIRE(client.open(name) == ONE_ERROR_TRANSPORT_OPEN_FAILED);
+
+    size_t length = 0;
+    unsigned char data[256] = {};
+    REQUIRE(server.send(data, 1, length) == ONE_ERROR_TRANSPORT_NOT_INITIALIZED);
+
+    REQUIRE(!is_error(server.create(name, 128)));
+    REQUIRE(server.create(name) == ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED);
+    REQUIRE(!server.is_peer_open());
+    REQUIRE(!is_error(client.open(name)));
+    REQUIRE(server.is_peer_open());
+    REQUIRE(client.is_peer_open());
+
+    // Only one side may open the region.
+    {
+        SharedMemoryTransport other;
+        REQUIRE(other.open(name) == ONE_ERROR_TRANSPORT_OPEN_FAILED);
+    }
+
+    String address;
+    unsigned int port = 1;
+    REQUIRE(!is_error(server.address(address, port)));
+    REQUIRE(address == name);
+    REQUIRE(port == 0);
+
+    bool is_ready = true;
+    REQUIRE(!is_error(client.ready_for_read(0.f, is_ready)));
+    REQUIRE(!is_ready);
+    REQUIRE(!is_error(client.ready_for_send(0.f, is_ready)));
+    REQUIRE(is_ready);
+
+    // Sends are partial once the ring is full, and wrap around its end.
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < sizeof(data); ++i) {
+            data[i] = static_cast<unsigned char>(i + round);
+        }
+        REQUIRE(!is_error(server.send(data, 100, length)));
+        REQUIRE(length == 100);
+        REQUIRE(!is_error(server.send(data + 100, 100, length)));
+        REQUIRE(length == 28);
+        REQUIRE(!is_error(server.ready_for_send(0.f, is_ready)));
+        REQUIRE(!is_ready);
+
+        unsigned char received[256] = {};
+        REQUIRE(!is_error(client.ready_for_read(0.f, is_ready)));
+        REQUIRE(is_ready);
+        REQUIRE(!is_error(client.receive(received, 60, length)));
+        REQUIRE(length == 60);
+        REQUIRE(!is_error(client.receive(received + 60, 200, length)));
+        REQUIRE(length == 68);
+        for (size_t i = 0; i < 128; ++i) {
+            REQUIRE(received[i] == data[i]);
+        }
+        REQUIRE(!is_error(client.receive(received, 1, length)));
+        REQUIRE(length == 0);
+    }
+
+    // A waiting reader is woken by the peer.
+    std::thread writer([&]() {
+        sleep(50);
+        size_t sent = 0;
+        server.send(data, 1, sent);
+    });
+    REQUIRE(!is_error(client.ready_for_read(5.f, is_ready)));
+    REQUIRE(is_ready);
+    writer.join();
+    REQUIRE(!is_error(client.receive(data, 1, length)));
+    REQUIRE(length == 1);
+
+    // Data sent before closing is received before the close is reported.
+    REQUIRE(!is_error(client.send(data, 10, length)));
+    client.close();
+    REQUIRE(server.send(data, 1, length) == ONE_ERROR_TRANSPORT_PEER_CLOSED);
+    REQUIRE(!is_error(server.ready_for_read(0.f, is_ready)));
+    REQUIRE(is_ready);
+    REQUIRE(!is_error(server.receive(data, sizeof(data), length)));
+    REQUIRE(length == 10);
+    REQUIRE(server.receive(data, sizeof(data), length) ==
+            ONE_ERROR_TRANSPORT_PEER_CLOSED);
+
+    // The name is removed once the creator closes.
+    server.close();
+    REQUIRE(client.open(name) == ONE_ERROR_TRANSPORT_OPEN_FAILED);
+
+    // A waiting reader is woken by the peer closing, well before its timeout.
+    REQUIRE(!is_error(server.create(name, 128)));
+    REQUIRE(!is_error(client.open(name)));
+    std::thread closer([&]() {
+        sleep(50);
+        client.close();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(!is_error(server.ready_for_read(30.f, is_ready)));
+    REQUIRE(is_ready);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    closer.join();
+    server.close();
+}
+
+TEST_CASE("shared memory connection", "[transport]") {
+    const char *name = "/one-arcus-test-connection";
+
+    SharedMemoryTransport server_transport;
+    REQUIRE(!is_error(server_transport.create(name)));
+    SharedMemoryTransport client_transport;
+    REQUIRE(!is_error(client_transport.open(name)));
+
+    Connection server(4, 4);
+    server.init(server_transport);
+    Connection client(4, 4);
+    client.init(client_transport);
+    REQUIRE(handshake(server, client));
+
+    // Messages are relayed through the rings.
+    for (int i = 0; i < 100; ++i) {
+        Message message;
+        REQUIRE(!is_error(messages::prepare_soft_stop(i, message)));
+        REQUIRE(!is_error(client.add_outgoing(message)));
+        int timeout = -1;
+        REQUIRE(wait_until(2000, [&]() {
+            client.update();
+            server.update();
+            timeout = receive_soft_stop(server);
+            return timeout != -1;
+        }));
+        REQUIRE(timeout == i);
+    }
+
+    // A message larger than the rings is sent in parts.
+    Array data;
+    data.push_back_string(std::string(100 * 1024, 'a').c_str());
+    Message message;
+    REQUIRE(!is_error(messages::prepare_reverse_metadata(data, message)));
+    REQUIRE(!is_error(server.add_outgoing(message)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        unsigned int count = 0;
+        client.incoming_count(count);
+        return count == 1;
+    }));
+}
+
+TEST_CASE("shared memory connection across processes", "[transport]") {
+    const char *name = "/one-arcus-test-processes";
+    constexpr int messages_count = 50;
+
+    SharedMemoryTransport server_transport;
+    REQUIRE(!is_error(server_transport.create(name)));
+
+    const pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        // Echoes soft stops back until the creator closes.
+        SharedMemoryTransport transport;
+        if (is_error(transport.open(name))) {
+            _exit(1);
+        }
+        Connection connection(4, 4);
+        connection.init(transport);
+        while (true) {
+            bool is_ready = false;
+            transport.ready_for_read(1.f, is_ready);
+            if (is_error(connection.update())) {
+                // The connection fails once the creator closes.
+                _exit(transport.is_peer_open() ? 2 : 0);
+            }
+            const int timeout = receive_soft_stop(connection);
+            if (timeout != -1) {
+                Message message;
+                messages::prepare_soft_stop(timeout, message);
+                connection.add_outgoing(message);
+            }
+        }
+    }
+
+    Connection server(4, 4);
+    server.init(server_transport);
+    server.initiate_handshake();
+    REQUIRE(wait_until(5000, [&]() {
+        server.update();
+        return server.status() == Connection::Status::ready;
+    }));
+
+    for (int i = 0; i < messages_count; ++i) {
+        Message message;
+        REQUIRE(!is_error(messages::prepare_soft_stop(i, message)));
+        REQUIRE(!is_error(server.add_outgoing(message)));
+        int timeout = -1;
+        REQUIRE(wait_until(5000, [&]() {
+            bool is_ready = false;
+            server_transport.ready_for_read(0.01f, is_ready);
+            server.update();
+            timeout = receive_soft_stop(server);
+            return timeout != -1;
+        }));
+        REQUIRE(timeout == i);
+    }
+
+    server.shutdown();
+    server_transport.close();
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+#else
+
+TEST_CASE("shared memory transport", "[transport]") {
+    SharedMemoryTransport transport;
+    REQUIRE(transport.create("/one-arcus-test-transport") ==
+            ONE_ERROR_TRANSPORT_UNSUPPORTED);
+}
+
+#endif
+
+TEST_CASE("io_uring transport", "[transport]") {
+    if (!IoUringTransport::is_supported()) {
+        IoUringTransport transport;
+        bool is_ready = false;
+        REQUIRE(transport.ready_for_read(0.f, is_ready) ==
+                ONE_ERROR_TRANSPORT_NOT_INITIALIZED);
+        WARN("io_uring is not available");
+        return;
+    }
+
+    REQUIRE(!is_error(init_socket_system()));
+    Socket listen_socket;
+    REQUIRE(!is_error(listen_socket.init()));
+    REQUIRE(!is_error(listen_socket.bind("127.0.0.1", 19190)));
+    REQUIRE(!is_error(listen_socket.listen(1)));
+    Socket client;
+    REQUIRE(!is_error(client.init()));
+    REQUIRE(!is_error(client.connect("127.0.0.1", 19190)));
+    Socket accepted;
+    REQUIRE(wait_until(2000, [&]() {
+        String ip;
+        unsigned int port;
+        listen_socket.accept(accepted, ip, port);
+        return accepted.is_initialized();
+    }));
+
+    IoUringTransport transport;
+    REQUIRE(!is_error(transport.init()));
+    REQUIRE(transport.footprint() > 0);
+    REQUIRE(!is_error(transport.attach(accepted)));
+    REQUIRE(transport.attach(accepted) == ONE_ERROR_TRANSPORT_ALREADY_INITIALIZED);
+
+    // More than the staging and receive buffers hold, in both directions.
+    std::vector<unsigned char> data(256 * 1024);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 7 + i / 251);
+    }
+    std::vector<unsigned char> received(data.size());
+    size_t sent = 0;
+    size_t total = 0;
+    REQUIRE(wait_until(5000, [&]() {
+        size_t length = 0;
+        REQUIRE(!is_error(
+            transport.send(data.data() + sent, std::min<size_t>(1000, data.size() - sent),
+                           length)));
+        sent += length;
+        REQUIRE(!is_error(
+            client.receive(received.data() + total, received.size() - total, length)));
+        total += length;
+        return total == data.size();
+    }));
+    REQUIRE(received == data);
+
+    sent = 0;
+    total = 0;
+    std::fill(received.begin(), received.end(), 0);
+    REQUIRE(wait_until(5000, [&]() {
+        size_t length = 0;
+        REQUIRE(!is_error(client.send(data.data() + sent, data.size() - sent, length)));
+        sent += length;
+        bool is_ready = false;
+        REQUIRE(!is_error(transport.ready_for_read(0.001f, is_ready)));
+        if (is_ready) {
+            REQUIRE(!is_error(transport.receive(
+                received.data() + total,
+                std::min<size_t>(777, received.size() - total), length)));
+            total += length;
+        }
+        return total == data.size();
+    }));
+    REQUIRE(received == data);
+
+    // The end of the stream is a ready receive of zero bytes, as for sockets.
+    client.close();
+    bool is_ready = false;
+    REQUIRE(!is_error(transport.ready_for_read(1.f, is_ready)));
+    REQUIRE(is_ready);
+    unsigned char byte = 0;
+    size_t length = 1;
+    REQUIRE(!is_error(transport.receive(&byte, 1, length)));
+    REQUIRE(length == 0);
+
+    transport.detach();
+    REQUIRE(!transport.is_initialized());
+    REQUIRE(transport.receive(&byte, 1, length) == ONE_ERROR_TRANSPORT_NOT_INITIALIZED);
+    shutdown_socket_system();
+}
+
+TEST_CASE("local socket", "[transport]") {
+    const char *path = "arcus_local.sock";
+    const std::string too_long(Socket::local_path_size, 'a');
+
+    Server server;
+    Client client;
+    REQUIRE(server.init_local(nullptr) == ONE_ERROR_VALIDATION_PATH_IS_NULLPTR);
+    REQUIRE(server.init_local(too_long.c_str()) == ONE_ERROR_SOCKET_PATH_TOO_LONG);
+    REQUIRE(client.init_local(too_long.c_str()) == ONE_ERROR_SOCKET_PATH_TOO_LONG);
+
+    OneServerPtr c_server = nullptr;
+    REQUIRE(one_server_create_local(nullptr, &c_server) ==
+            ONE_ERROR_VALIDATION_PATH_IS_NULLPTR);
+    REQUIRE(one_server_create_local_with_options(path, nullptr, &c_server) ==
+            ONE_ERROR_VALIDATION_OPTIONS_IS_NULLPTR);
+
+#ifdef ONE_WINDOWS
+    REQUIRE(server.init_local(path) == ONE_ERROR_SOCKET_LOCAL_UNSUPPORTED);
+#else
+    REQUIRE(!is_error(one_server_create_local(path, &c_server)));
+    REQUIRE(c_server != nullptr);
+    one_server_destroy(c_server);
+
+    // A socket file left behind by a socket that was not shut down cleanly.
+    init_socket_system();
+    {
+        Socket stale;
+        REQUIRE(!is_error(stale.init_local()));
+        REQUIRE(!is_error(stale.bind_local(path)));
+    }
+
+    REQUIRE(!is_error(server.init_local(path)));
+    REQUIRE(!is_error(server.update()));
+    REQUIRE(server.status() == Server::Status::waiting_for_client);
+
+    // The file of a listening socket is not taken over. Its server sees the
+    // probe as a connection that closes.
+    {
+        Socket duplicate;
+        REQUIRE(!is_error(duplicate.init_local()));
+        REQUIRE(duplicate.bind_local(path) == ONE_ERROR_SOCKET_BIND_FAILED);
+    }
+
+    REQUIRE(!is_error(client.init_local(path)));
+
+    int timeout = 0;
+    server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+
+    REQUIRE(!is_error(client.send_soft_stop(1000)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return timeout == 1000;
+    }));
+
+    client.shutdown();
+    server.shutdown();
+    shutdown_socket_system();
+#endif
+}
+
+TEST_CASE("socket options", "[transport]") {
+    const unsigned int port = 19187;
+
+    SocketOptions options;
+    options.is_no_delay = true;
+    options.send_buffer_size = 64 * 1024;
+    options.receive_buffer_size = 64 * 1024;
+    options.is_keepalive_enabled = true;
+    options.keepalive_idle_seconds = 30;
+    options.keepalive_interval_seconds = 5;
+    options.keepalive_count = 3;
+    REQUIRE(options.is_valid());
+
+    SocketOptions invalid;
+    invalid.user_timeout_ms = 0x80000000u;
+    REQUIRE(!invalid.is_valid());
+    ConnectionOptions invalid_connection;
+    invalid_connection.socket = invalid;
+    REQUIRE(!invalid_connection.is_valid());
+
+    init_socket_system();
+    {
+        Socket socket;
+        REQUIRE(!is_error(socket.init()));
+        REQUIRE(socket.set_options(invalid) == ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+        REQUIRE(!is_error(socket.set_options(options)));
+        REQUIRE(!is_error(socket.set_options(SocketOptions())));
+
+        SocketOptions linux_only;
+        linux_only.user_timeout_ms = 10000;
+#ifdef __linux__
+        REQUIRE(!is_error(socket.set_options(linux_only)));
+#else
+        REQUIRE(socket.set_options(linux_only) == ONE_ERROR_SOCKET_OPTION_UNSUPPORTED);
+#endif
+    }
+#ifndef ONE_WINDOWS
+    {
+        // TCP options are ignored for Unix domain sockets.
+        Socket socket;
+        REQUIRE(!is_error(socket.init_local()));
+        REQUIRE(!is_error(socket.set_options(options)));
+    }
+#endif
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(!c_options.no_delay);
+    REQUIRE(!c_options.keepalive);
+    REQUIRE(c_options.send_buffer_size == 0);
+    REQUIRE(c_options.busy_poll_us == 0);
+    c_options.user_timeout_ms = 0x80000000u;
+    OneServerPtr c_server = nullptr;
+    REQUIRE(one_server_create_with_options(port, &c_options, &c_server) ==
+            ONE_ERROR_VALIDATION_OPTIONS_ARE_INVALID);
+    c_options.user_timeout_ms = 0;
+    c_options.no_delay = true;
+    c_options.keepalive = true;
+    REQUIRE(!is_error(one_server_create_with_options(port, &c_options, &c_server)));
+    one_server_destroy(c_server);
+
+    // Messages are exchanged with the options applied on both ends.
+    ConnectionOptions connection_options;
+    connection_options.socket = options;
+    Server server;
+    REQUIRE(!is_error(server.init(port, connection_options)));
+    Client client;
+    REQUIRE(!is_error(client.init("127.0.0.1", port, connection_options)));
+
+    int timeout = 0;
+    server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return server.status() == Server::Status::ready &&
+               client.status() == Client::Status::ready;
+    }));
+    REQUIRE(!is_error(client.send_soft_stop(1000)));
+    REQUIRE(wait_until(2000, [&]() {
+        server.update();
+        client.update();
+        return timeout == 1000;
+    }));
+
+    client.shutdown();
+    server.shutdown();
+    shutdown_socket_system();
+}
+
+TEST_CASE("ipv6 dual stack", "[transport]") {
+    const unsigned int port = 19188;
+    init_socket_system();
+
+    {
+        Socket socket;
+        REQUIRE(!is_error(socket.init()));
+        REQUIRE(socket.bind("not an ip", 0) == ONE_ERROR_SOCKET_ADDRESS_INVALID);
+        REQUIRE(socket.bind("[::1", 0) == ONE_ERROR_SOCKET_ADDRESS_INVALID);
+        REQUIRE(socket.connect("256.0.0.1", port) == ONE_ERROR_SOCKET_ADDRESS_INVALID);
+    }
+
+    // Hosts without IPv6 only support IPv4 addresses.
+    bool is_ipv6_available = false;
+    {
+        Socket socket;
+        REQUIRE(!is_error(socket.init()));
+        is_ipv6_available = socket.bind("::1", 0) != ONE_ERROR_SOCKET_ADDRESS_INVALID;
+    }
+
+    // A listener on any address accepts both families. IPv4 peers are reported
+    // as IPv4.
+    Socket listener;
+    unsigned int listen_port = 0;
+    listen(listener, listen_port);
+    std::vector<std::string> ips = {"127.0.0.1"};
+    if (is_ipv6_available) {
+        ips.push_back("::1");
+        ips.push_back("[::1]");
+    }
+    for (const auto &ip : ips) {
+        Socket out_client;
+        REQUIRE(!is_error(out_client.init()));
+        REQUIRE(!is_error(out_client.connect(ip.c_str(), listen_port)));
+
+        Socket in_client;
+        wait_ready_for_read(listener);
+        String client_ip;
+        unsigned int client_port = 0;
+        REQUIRE(!is_error(listener.accept(in_client, client_ip, client_port)));
+        REQUIRE(in_client.is_initialized());
+        REQUIRE(client_ip == (ip == "127.0.0.1" ? "127.0.0.1" : "::1"));
+        REQUIRE(client_port != 0);
+    }
+
+    if (is_ipv6_available) {
+        Server server;
+        REQUIRE(!is_error(server.init(port)));
+        Client client;
+        REQUIRE(!is_error(client.init("::1", port)));
+
+        int timeout = 0;
+        server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return server.status() == Server::Status::ready &&
+                   client.status() == Client::Status::ready;
+        }));
+        REQUIRE(!is_error(client.send_soft_stop(1000)));
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return timeout == 1000;
+        }));
+    }
+
+    shutdown_socket_system();
+}
+
+TEST_CASE("io_uring backend", "[transport]") {
+    const unsigned int port = 19189;
+    const bool is_supported = IoUringTransport::is_supported();
+    const auto expected = is_supported ? IoBackend::io_uring : IoBackend::select;
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.io_backend == ONE_IO_BACKEND_SELECT);
+    c_options.io_backend = ONE_IO_BACKEND_IO_URING;
+    OneServerPtr c_server = nullptr;
+    REQUIRE(!is_error(one_server_create_with_options(port, &c_options, &c_server)));
+    OneIoBackend c_backend = ONE_IO_BACKEND_SELECT;
+    REQUIRE(one_server_io_backend(c_server, nullptr) ==
+            ONE_ERROR_VALIDATION_IO_BACKEND_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_io_backend(c_server, &c_backend)));
+    const auto c_expected =
+        is_supported ? ONE_IO_BACKEND_IO_URING : ONE_IO_BACKEND_SELECT;
+    REQUIRE(c_backend == c_expected);
+    one_server_destroy(c_server);
+
+    init_socket_system();
+    ConnectionOptions options;
+    options.io_backend = IoBackend::io_uring;
+    Server server;
+    REQUIRE(server.io_backend() == IoBackend::select);
+    REQUIRE(!is_error(server.init(port, options)));
+    REQUIRE(server.io_backend() == expected);
+
+    int timeout = 0;
+    server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+
+    // The ring is reused by the next client connection.
+    for (int connection = 0; connection < 2; ++connection) {
+        Client client;
+        REQUIRE(!is_error(client.init("127.0.0.1", port, options)));
+        REQUIRE(client.io_backend() == expected);
+        size_t metadata_size = 0;
+        client.set_reverse_metadata_callback(
+            [&](void *, Array *data) {
+                String value;
+                data->val_string(0, value);
+                metadata_size = value.size();
+            },
+            nullptr);
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return server.status() == Server::Status::ready &&
+                   client.status() == Client::Status::ready;
+        }));
+
+        for (int i = 1; i <= 20; ++i) {
+            REQUIRE(!is_error(client.send_soft_stop(i)));
+        }
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return timeout == 20;
+        }));
+
+        // Larger than the receive buffers the kernel fills.
+        Array data;
+        data.push_back_string(std::string(100 * 1024, 'a').c_str());
+        REQUIRE(!is_error(server.send_reverse_metadata(&data)));
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return metadata_size == 100 * 1024;
+        }));
+        timeout = 0;
+    }
+
+    MemoryFootprint footprint;
+    REQUIRE(!is_error(server.memory_footprint(footprint)));
+    if (is_supported) {
+        REQUIRE(footprint.streams > IoUringTransport::send_buffer_size);
+    }
+
+    server.shutdown();
+    shutdown_socket_system();
+}
+
+TEST_CASE("shared memory negotiation", "[transport]") {
+    const unsigned int port = 19192;
+
+    ConnectionOptions options;
+    options.shared_memory_capacity = 64 * 1024;
+    options.session_replay_size = 1024;
+    options.health.liveness = Liveness::kernel;
+    REQUIRE(options.is_valid());
+    ConnectionOptions invalid;
+    invalid.shared_memory_capacity = 1000;
+    REQUIRE(!invalid.is_valid());
+    invalid.shared_memory_capacity = 32;
+    REQUIRE(!invalid.is_valid());
+
+    LoopbackPipe pipe;
+    auto connect = [&](Connection &server, Connection &client) {
+        REQUIRE(!is_error(pipe.init()));
+        server.init(pipe.first());
+        client.init(pipe.second());
+        server.initiate_handshake();
+        REQUIRE(wait_until(2000, [&]() {
+            server.update();
+            client.update();
+            return server.status() == Connection::Status::ready &&
+                   client.status() == Connection::Status::ready;
+        }));
+    };
+    // Sends a soft stop each way and waits for both.
+    auto exchange = [](Connection &server, Connection &client, int timeout) {
+        Message message;
+        REQUIRE(!is_error(messages::prepare_soft_stop(timeout, message)));
+        REQUIRE(!is_error(server.add_outgoing(message)));
+        REQUIRE(!is_error(client.add_outgoing(message)));
+        REQUIRE(wait_until(2000, [&]() {
+            REQUIRE(!is_error(server.update()));
+            REQUIRE(!is_error(client.update()));
+            unsigned int client_count = 0;
+            client.incoming_count(client_count);
+            unsigned int server_count = 0;
+            server.incoming_count(server_count);
+            return client_count == 1 && server_count == 1;
+        }));
+        for (auto connection : {&server, &client}) {
+            connection->remove_incoming([&](const Message &message) {
+                int received = 0;
+                message.payload().val_int("timeout", received);
+                REQUIRE(received == timeout);
+                return ONE_ERROR_NONE;
+            });
+        }
+    };
+
+#ifndef ONE_WINDOWS
+    // Once switched, messages no longer go through the socket, and kernel
+    // liveness gives way to health messages.
+    Connection server(options);
+    Connection client(options);
+    connect(server, client);
+    REQUIRE(server.is_shared_memory());
+    REQUIRE(client.is_shared_memory());
+    REQUIRE(server.liveness() == Liveness::health_messages);
+    REQUIRE(client.liveness() == Liveness::health_messages);
+    pipe.shutdown();
+    exchange(server, client, 1000);
+
+    // A resumed session gets new rings.
+    server.suspend();
+    client.suspend();
+    REQUIRE(!server.is_shared_memory());
+    connect(server, client);
+    REQUIRE(server.is_resumed());
+    REQUIRE(client.is_resumed());
+    REQUIRE(server.is_shared_memory());
+    REQUIRE(client.is_shared_memory());
+    exchange(server, client, 2000);
+    server.shutdown();
+    client.shutdown();
+    pipe.shutdown();
+#endif
+
+    // Without it on both ends, messages keep going through the socket.
+    {
+        Connection enabled(options);
+        Connection disabled(ConnectionOptions{});
+        connect(enabled, disabled);
+        REQUIRE(!enabled.is_shared_memory());
+        REQUIRE(!disabled.is_shared_memory());
+        exchange(enabled, disabled, 3000);
+    }
+    pipe.shutdown();
+
+    OneServerOptions c_options;
+    REQUIRE(!is_error(one_server_default_options(&c_options)));
+    REQUIRE(c_options.shared_memory_capacity == 0);
+    c_options.shared_memory_capacity = 64 * 1024;
+    OneServerPtr c_server = nullptr;
+    REQUIRE(!is_error(one_server_create_with_options(port, &c_options, &c_server)));
+    bool c_is_shared_memory = true;
+    REQUIRE(one_server_is_shared_memory(c_server, nullptr) ==
+            ONE_ERROR_VALIDATION_RESULT_IS_NULLPTR);
+    REQUIRE(!is_error(one_server_is_shared_memory(c_server, &c_is_shared_memory)));
+    REQUIRE(!c_is_shared_memory);
+    one_server_destroy(c_server);
+
+#ifndef ONE_WINDOWS
+    // Over TCP, the Server creating the rings for the Client.
+    options.health.liveness = Liveness::health_messages;
+    Server tcp_server;
+    REQUIRE(!is_error(tcp_server.init(port, options)));
+    Client tcp_client;
+    REQUIRE(!is_error(tcp_client.init("127.0.0.1", port, options)));
+    int timeout = 0;
+    tcp_server.set_soft_stop_callback([&](void *, int t) { timeout = t; }, nullptr);
+    REQUIRE(wait_until(2000, [&]() {
+        tcp_server.update();
+        tcp_client.update();
+        return tcp_server.status() == Server::Status::ready &&
+               tcp_client.status() == Client::Status::ready;
+    }));
+    REQUIRE(tcp_server.is_shared_memory());
+    REQUIRE(tcp_client.is_shared_memory());
+    REQUIRE(!is_error(tcp_client.send_soft_stop(1000)));
+    REQUIRE(wait_until(2000, [&]() {
+        tcp_server.update();
+        tcp_client.update();
+        return timeout == 1000;
+    }));
+    tcp_client.shutdown();
+    tcp_server.shutdown();
+#endif
+}
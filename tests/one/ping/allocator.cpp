@@ -0,0 +1,40 @@
+#include <catch.hpp>
+
+#include <one/ping/allocator.h>
+#include <one/ping/c_api.h>
+#include <one/ping/types.h>
+
+TEST_CASE("ping allocator tracking", "[allocator]") {
+    I3dPingAllocationStatistics stats;
+    REQUIRE(i3d_ping_allocator_statistics(I3D_PING_ALLOCATION_CATEGORY_TOTAL, nullptr) ==
+            I3D_PING_ERROR_VALIDATION_PARAM_IS_NULLPTR);
+    REQUIRE(i3d_ping_allocator_statistics(static_cast<I3dPingAllocationCategory>(-1),
+                                          &stats) ==
+            I3D_PING_ERROR_VALIDATION_CATEGORY_IS_INVALID);
+
+    i3d_ping_allocator_set_tracking(true);
+
+    I3dIpListPtr ip_list = nullptr;
+    REQUIRE(!i3d_ping_is_error(i3d_ping_ip_list_create(&ip_list)));
+    for (int i = 0; i < 16; ++i) {
+        REQUIRE(!i3d_ping_is_error(i3d_ping_ip_list_push_back(ip_list, "213.163.66.59")));
+    }
+
+    REQUIRE(!i3d_ping_is_error(
+        i3d_ping_allocator_statistics(I3D_PING_ALLOCATION_CATEGORY_CONTAINER, &stats)));
+    REQUIRE(stats.live_allocations > 0);
+    REQUIRE(stats.live_bytes >= 16 * sizeof(i3d::ping::String));
+
+    I3dPingAllocationStatistics total;
+    REQUIRE(!i3d_ping_is_error(
+        i3d_ping_allocator_statistics(I3D_PING_ALLOCATION_CATEGORY_TOTAL, &total)));
+    REQUIRE(total.live_bytes >= stats.live_bytes);
+
+    i3d_ping_ip_list_destroy(ip_list);
+    REQUIRE(!i3d_ping_is_error(
+        i3d_ping_allocator_statistics(I3D_PING_ALLOCATION_CATEGORY_TOTAL, &total)));
+    REQUIRE(total.live_bytes == 0);
+    REQUIRE(total.live_allocations == 0);
+
+    i3d_ping_allocator_set_tracking(false);
+}